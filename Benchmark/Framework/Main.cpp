@@ -0,0 +1,636 @@
+/*
+* Copyright (c) 2013 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "Test.h"
+#include "../../Testbed/Tests/RayCast.h"
+#include <Box2D/Common/b2ThreadPool.h>
+#include <Box2D/Common/b2Profiler.h>
+#include <Box2D/Common/b2Simd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+using namespace std;
+
+// Runs the scenes of TestEntries.cpp for a fixed number of steps without a
+// display and writes the results as JSON to stdout. Times are in milliseconds.
+//
+// With -trace the scopes of the most recent steps are written to a file in the
+// Chrome trace event format (chrome://tracing).
+//
+// With -split the worlds keep static, awake and sleeping proxies in separate
+// broad-phase trees.
+//
+// With -batchedBroadPhase the broad-phase finds the pairs of moved proxies in
+// batches, on the thread pool of -threads.
+//
+// With -speculative the worlds use speculative contacts, so time of impact
+// events are only solved for bullets.
+//
+// With -batchedJoints the joints of each island are solved in batches of one
+// joint type.
+//
+// With -simd the contact velocities are solved by the SIMD solver.
+//
+// With -collide only the polygon narrow-phase is timed, on random overlapping
+// pairs, and the manifolds per second are written instead of the scenes. Run a
+// build with B2_NO_SIMD defined for the scalar numbers.
+//
+// With -queries the scene of the RayCast test is filled and many ray casts and
+// AABB queries are timed, one at a time with callbacks and with the batch calls
+// of b2World. The batch calls use the thread pool of -threads.
+//
+// With -checksums the world checksum after every step is written to a file, one
+// line per step. Diffing the files of two machines shows the first step where
+// they diverge; build with BOX2D_DETERMINISTIC for them to match.
+//
+// Usage: Benchmark [-steps n] [-threads n] [-split] [-batchedBroadPhase] [-speculative] [-batchedJoints] [-simd] [-test name] [-trace file] [-checksums file] [-collide] [-queries] [-list]
+
+namespace
+{
+	int32 stepCount = 600;
+	int32 threadCount = 1;
+	bool splitBroadPhase = false;
+	bool batchedBroadPhase = false;
+	bool speculativeContacts = false;
+	bool batchedJoints = false;
+	bool simdContactSolver = false;
+	const char* testName = NULL;
+	const char* traceName = NULL;
+	const char* checksumName = NULL;
+	bool collideOnly = false;
+	bool queriesOnly = false;
+}
+
+// Writes the checksum of each step of the current test.
+class ChecksumWriter : public b2ChecksumListener
+{
+public:
+	ChecksumWriter(FILE* file) : m_file(file), m_testName(NULL), m_step(0) {}
+
+	void BeginTest(const char* name)
+	{
+		m_testName = name;
+		m_step = 0;
+	}
+
+	void ReportChecksum(uint64 checksum)
+	{
+		fprintf(m_file, "%s %d %016llx\n", m_testName, m_step, checksum);
+		++m_step;
+	}
+
+private:
+	FILE* m_file;
+	const char* m_testName;
+	int32 m_step;
+};
+
+enum Phase
+{
+	e_stepPhase,
+	e_collidePhase,
+	e_solvePhase,
+	e_solveTOIPhase,
+	e_broadphasePhase,
+	e_phaseCount
+};
+
+static const char* s_phaseNames[e_phaseCount] =
+{
+	"step",
+	"collide",
+	"solve",
+	"solveTOI",
+	"broadphase"
+};
+
+static void PrintStats(const char* name, vector<float32>& samples, bool last)
+{
+	float32 mean = 0.0f;
+	for (size_t i = 0; i < samples.size(); ++i)
+	{
+		mean += samples[i];
+	}
+
+	size_t n = samples.size();
+	mean /= float32(n);
+
+	sort(samples.begin(), samples.end());
+	float32 p50 = samples[n / 2];
+	float32 p99 = samples[b2Min(n - 1, (n * 99) / 100)];
+
+	printf("\t\t\t\t\"%s\": {\"mean\": %.4f, \"p50\": %.4f, \"p99\": %.4f}%s\n",
+		name, mean, p50, p99, last ? "" : ",");
+}
+
+static void RunTest(const TestEntry* entry, b2ThreadPool* threadPool, b2Profiler* profiler, ChecksumWriter* checksums, bool last)
+{
+	srand(0);
+	Test* test = entry->createFcn();
+	b2World* world = test->GetWorld();
+	world->SetThreadPool(threadPool);
+	world->SetProfiler(profiler);
+	world->SetSplitBroadPhase(splitBroadPhase);
+	world->SetBatchedBroadPhase(batchedBroadPhase);
+	world->SetSpeculativeContacts(speculativeContacts);
+	world->SetBatchedJoints(batchedJoints);
+	world->SetSimdContactSolver(simdContactSolver);
+	if (checksums)
+	{
+		checksums->BeginTest(entry->name);
+		world->SetChecksumListener(checksums);
+	}
+
+	Settings settings;
+	vector<float32> samples[e_phaseCount];
+	for (int32 i = 0; i < e_phaseCount; ++i)
+	{
+		samples[i].reserve(stepCount);
+	}
+
+	int32 cacheHits = 0;
+	int32 cacheMisses = 0;
+
+	b2Timer timer;
+	for (int32 i = 0; i < stepCount; ++i)
+	{
+		test->Step(&settings);
+
+		const b2Profile& p = world->GetProfile();
+		cacheHits += p.polygonCacheHits;
+		cacheMisses += p.polygonCacheMisses;
+		samples[e_stepPhase].push_back(p.step);
+		samples[e_collidePhase].push_back(p.collide);
+		samples[e_solvePhase].push_back(p.solve);
+		samples[e_solveTOIPhase].push_back(p.solveTOI);
+		samples[e_broadphasePhase].push_back(p.broadphase);
+	}
+	float32 elapsed = timer.GetMilliseconds();
+
+	b2AllocatorStats stats = world->GetAllocatorStats();
+
+	printf("\t\t{\n");
+	printf("\t\t\t\"name\": \"%s\",\n", entry->name);
+	printf("\t\t\t\"bodies\": %d,\n", world->GetBodyCount());
+	printf("\t\t\t\"contacts\": %d,\n", world->GetContactCount());
+	printf("\t\t\t\"joints\": %d,\n", world->GetJointCount());
+	printf("\t\t\t\"stepsPerSecond\": %.1f,\n", elapsed > 0.0f ? 1000.0f * stepCount / elapsed : 0.0f);
+	printf("\t\t\t\"checksum\": \"%016llx\",\n", world->GetChecksum());
+	printf("\t\t\t\"phases\": {\n");
+	for (int32 i = 0; i < e_phaseCount; ++i)
+	{
+		PrintStats(s_phaseNames[i], samples[i], i == e_phaseCount - 1);
+	}
+	printf("\t\t\t},\n");
+	printf("\t\t\t\"polygonCache\": {\"hits\": %d, \"misses\": %d},\n", cacheHits, cacheMisses);
+	printf("\t\t\t\"allocator\": {\"stackCapacity\": %d, \"stackPeak\": %d, \"stackFallbacks\": %d, \"blockPeak\": %d, \"blockFallbacks\": %d}\n",
+		stats.stackCapacity, stats.stackPeak, stats.stackFallbacks, stats.blockPeak, stats.blockFallbacks);
+	printf("\t\t}%s\n", last ? "" : ",");
+
+	world->SetThreadPool(NULL);
+	world->SetProfiler(NULL);
+	world->SetChecksumListener(NULL);
+	delete test;
+}
+
+// A random convex polygon of 3 to 8 vertices, about a meter across.
+static void RandomPolygon(b2PolygonShape* shape)
+{
+	int32 count = 3 + rand() % (b2_maxPolygonVertices - 2);
+	b2Vec2 vertices[b2_maxPolygonVertices];
+	float32 angle = RandomFloat(0.0f, 2.0f * b2_pi);
+	for (int32 i = 0; i < count; ++i)
+	{
+		float32 radius = RandomFloat(0.4f, 0.6f);
+		angle += 2.0f * b2_pi / count;
+		vertices[i].Set(radius * cosf(angle), radius * sinf(angle));
+	}
+	shape->Set(vertices, count);
+}
+
+static void RandomTransform(b2Transform* xf)
+{
+	xf->Set(b2Vec2(RandomFloat(-0.6f, 0.6f), RandomFloat(-0.6f, 0.6f)), RandomFloat(-b2_pi, b2_pi));
+}
+
+// Counts the fixtures found by b2World::QueryAABB. Polygon 0 is filtered, like
+// the callbacks of the RayCast test.
+class QueryCountCallback : public b2QueryCallback
+{
+public:
+	QueryCountCallback() : m_count(0) {}
+
+	bool ReportFixture(b2Fixture* fixture)
+	{
+		void* userData = fixture->GetBody()->GetUserData();
+		if (userData && *(int32*)userData == 0)
+		{
+			return true;
+		}
+
+		++m_count;
+		return true;
+	}
+
+	int32 m_count;
+};
+
+static void PrintQueries(const char* name, int32 queryCount, int32 hits, int32 mismatches, int32 calls, float32 elapsed, bool last)
+{
+	printf("\t\t{\"name\": \"%s\", \"queries\": %d, \"hits\": %d, \"mismatches\": %d, \"queriesPerSecond\": %.0f}%s\n",
+		name, queryCount, hits, mismatches, elapsed > 0.0f ? 1000.0f * calls / elapsed : 0.0f, last ? "" : ",");
+}
+
+// Times ray casts and AABB queries in the scene of the RayCast test, filled with
+// its shapes. The batch calls filter polygon 0 by category instead of user data
+// and must find the same fixtures as the callbacks.
+static void RunQueries(b2ThreadPool* threadPool)
+{
+	const int32 queryCount = 4096;
+	const int32 maxFixtures = 64;
+	const int32 rounds = b2Max(stepCount / 10, 1);
+
+	srand(0);
+	RayCast* test = new RayCast;
+	for (int32 i = 0; i < RayCast::e_maxBodies; ++i)
+	{
+		test->Create(i % 5);
+	}
+
+	b2World* world = test->GetWorld();
+	for (b2Body* b = world->GetBodyList(); b; b = b->GetNext())
+	{
+		void* userData = b->GetUserData();
+		if (userData && *(int32*)userData == 0)
+		{
+			b2Filter filter;
+			filter.categoryBits = 0x0002;
+			b->GetFixtureList()->SetFilterData(filter);
+		}
+	}
+
+	b2QueryFilter queryFilter;
+	queryFilter.maskBits = 0xFFFF & ~0x0002;
+
+	// Rays as long as the one of the test, from anywhere in the scene.
+	const float32 L = 11.0f;
+	vector<b2RayCastInput> rays(queryCount);
+	vector<b2AABB> aabbs(queryCount);
+	for (int32 i = 0; i < queryCount; ++i)
+	{
+		b2Vec2 p1(RandomFloat(-12.0f, 12.0f), RandomFloat(0.0f, 22.0f));
+		float32 angle = RandomFloat(-b2_pi, b2_pi);
+		rays[i].p1 = p1;
+		rays[i].p2 = p1 + L * b2Vec2(cosf(angle), sinf(angle));
+		rays[i].maxFraction = 1.0f;
+
+		b2Vec2 c(RandomFloat(-12.0f, 12.0f), RandomFloat(0.0f, 22.0f));
+		b2Vec2 h(RandomFloat(0.5f, 2.0f), RandomFloat(0.5f, 2.0f));
+		aabbs[i].lowerBound = c - h;
+		aabbs[i].upperBound = c + h;
+	}
+
+	printf("\t\"queries\": [\n");
+
+	vector<RayCastClosestCallback> closest(queryCount);
+	b2Timer timer;
+	for (int32 round = 0; round < rounds; ++round)
+	{
+		for (int32 i = 0; i < queryCount; ++i)
+		{
+			closest[i] = RayCastClosestCallback();
+			world->RayCast(&closest[i], rays[i].p1, rays[i].p2);
+		}
+	}
+	float32 elapsed = timer.GetMilliseconds();
+
+	int32 hits = 0;
+	for (int32 i = 0; i < queryCount; ++i)
+	{
+		hits += closest[i].m_hit ? 1 : 0;
+	}
+	PrintQueries("rayCast", queryCount, hits, 0, rounds * queryCount, elapsed, false);
+
+	world->SetThreadPool(threadPool);
+
+	vector<b2RayCastHit> rayHits(queryCount);
+	timer.Reset();
+	for (int32 round = 0; round < rounds; ++round)
+	{
+		world->RayCasts(&rays[0], queryCount, queryFilter, &rayHits[0]);
+	}
+	elapsed = timer.GetMilliseconds();
+
+	hits = 0;
+	int32 mismatches = 0;
+	for (int32 i = 0; i < queryCount; ++i)
+	{
+		bool hit = rayHits[i].fixture != NULL;
+		hits += hit ? 1 : 0;
+		if (hit != closest[i].m_hit || (hit && (rayHits[i].point == closest[i].m_point) == false))
+		{
+			++mismatches;
+		}
+	}
+	PrintQueries("rayCasts", queryCount, hits, mismatches, rounds * queryCount, elapsed, false);
+
+	world->SetThreadPool(NULL);
+
+	vector<int32> counts(queryCount);
+	timer.Reset();
+	for (int32 round = 0; round < rounds; ++round)
+	{
+		for (int32 i = 0; i < queryCount; ++i)
+		{
+			QueryCountCallback callback;
+			world->QueryAABB(&callback, aabbs[i]);
+			counts[i] = callback.m_count;
+		}
+	}
+	elapsed = timer.GetMilliseconds();
+
+	hits = 0;
+	for (int32 i = 0; i < queryCount; ++i)
+	{
+		hits += counts[i];
+	}
+	PrintQueries("queryAABB", queryCount, hits, 0, rounds * queryCount, elapsed, false);
+
+	world->SetThreadPool(threadPool);
+
+	vector<b2Fixture*> fixtures(queryCount * maxFixtures);
+	vector<int32> batchCounts(queryCount);
+	timer.Reset();
+	for (int32 round = 0; round < rounds; ++round)
+	{
+		world->QueryAABBs(&aabbs[0], queryCount, queryFilter, &fixtures[0], maxFixtures, &batchCounts[0]);
+	}
+	elapsed = timer.GetMilliseconds();
+
+	hits = 0;
+	mismatches = 0;
+	for (int32 i = 0; i < queryCount; ++i)
+	{
+		hits += batchCounts[i];
+		mismatches += batchCounts[i] != counts[i] ? 1 : 0;
+	}
+	PrintQueries("queryAABBs", queryCount, hits, mismatches, rounds * queryCount, elapsed, true);
+
+	printf("\t]\n");
+
+	world->SetThreadPool(NULL);
+	delete test;
+}
+
+static void PrintCollide(const char* name, int32 pairCount, int32 touching, int32 calls, float32 elapsed, bool last)
+{
+	printf("\t\t{\"name\": \"%s\", \"pairs\": %d, \"touching\": %d, \"manifoldsPerSecond\": %.0f}%s\n",
+		name, pairCount, touching, elapsed > 0.0f ? 1000.0f * calls / elapsed : 0.0f, last ? "" : ",");
+}
+
+// Times b2CollidePolygons and b2CollideEdgeAndPolygon over pairs whose
+// centers are within a polygon size, so most of them touch.
+static void RunCollide()
+{
+	const int32 pairCount = 4096;
+	const int32 rounds = b2Max(stepCount / 10, 1);
+
+	srand(0);
+	vector<b2PolygonShape> polygonsA(pairCount), polygonsB(pairCount);
+	vector<b2EdgeShape> edges(pairCount);
+	vector<b2Transform> transforms(pairCount);
+	b2Transform identity;
+	identity.SetIdentity();
+	for (int32 i = 0; i < pairCount; ++i)
+	{
+		RandomPolygon(&polygonsA[i]);
+		RandomPolygon(&polygonsB[i]);
+		edges[i].Set(b2Vec2(RandomFloat(-1.0f, -0.5f), RandomFloat(-0.2f, 0.2f)), b2Vec2(RandomFloat(0.5f, 1.0f), RandomFloat(-0.2f, 0.2f)));
+		RandomTransform(&transforms[i]);
+	}
+
+	printf("\t\"collide\": [\n");
+
+	b2Manifold manifold;
+	int32 touching = 0;
+	b2Timer timer;
+	for (int32 round = 0; round < rounds; ++round)
+	{
+		for (int32 i = 0; i < pairCount; ++i)
+		{
+			b2CollidePolygons(&manifold, &polygonsA[i], identity, &polygonsB[i], transforms[i]);
+			touching += manifold.pointCount > 0 ? 1 : 0;
+		}
+	}
+	PrintCollide("polygons", pairCount, touching / rounds, rounds * pairCount, timer.GetMilliseconds(), false);
+
+	touching = 0;
+	timer.Reset();
+	for (int32 round = 0; round < rounds; ++round)
+	{
+		for (int32 i = 0; i < pairCount; ++i)
+		{
+			b2CollideEdgeAndPolygon(&manifold, &edges[i], identity, &polygonsB[i], transforms[i]);
+			touching += manifold.pointCount > 0 ? 1 : 0;
+		}
+	}
+	PrintCollide("edgeAndPolygon", pairCount, touching / rounds, rounds * pairCount, timer.GetMilliseconds(), true);
+
+	printf("\t]\n");
+}
+
+static bool IsSelected(const TestEntry* entry)
+{
+	return testName == NULL || strcmp(testName, entry->name) == 0;
+}
+
+int main(int argc, char** argv)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "-list") == 0)
+		{
+			for (const TestEntry* e = g_testEntries; e->createFcn; ++e)
+			{
+				printf("%s\n", e->name);
+			}
+			return 0;
+		}
+		else if (strcmp(argv[i], "-steps") == 0 && i + 1 < argc)
+		{
+			stepCount = b2Max(atoi(argv[++i]), 1);
+		}
+		else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+		{
+			threadCount = b2Max(atoi(argv[++i]), 1);
+		}
+		else if (strcmp(argv[i], "-split") == 0)
+		{
+			splitBroadPhase = true;
+		}
+		else if (strcmp(argv[i], "-batchedBroadPhase") == 0)
+		{
+			batchedBroadPhase = true;
+		}
+		else if (strcmp(argv[i], "-speculative") == 0)
+		{
+			speculativeContacts = true;
+		}
+		else if (strcmp(argv[i], "-batchedJoints") == 0)
+		{
+			batchedJoints = true;
+		}
+		else if (strcmp(argv[i], "-simd") == 0)
+		{
+			simdContactSolver = true;
+		}
+		else if (strcmp(argv[i], "-test") == 0 && i + 1 < argc)
+		{
+			testName = argv[++i];
+		}
+		else if (strcmp(argv[i], "-trace") == 0 && i + 1 < argc)
+		{
+			traceName = argv[++i];
+		}
+		else if (strcmp(argv[i], "-checksums") == 0 && i + 1 < argc)
+		{
+			checksumName = argv[++i];
+		}
+		else if (strcmp(argv[i], "-collide") == 0)
+		{
+			collideOnly = true;
+		}
+		else if (strcmp(argv[i], "-queries") == 0)
+		{
+			queriesOnly = true;
+		}
+		else
+		{
+			fprintf(stderr, "Usage: %s [-steps n] [-threads n] [-split] [-batchedBroadPhase] [-speculative] [-batchedJoints] [-simd] [-test name] [-trace file] [-checksums file] [-collide] [-queries] [-list]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (collideOnly)
+	{
+		printf("{\n");
+		printf("\t\"steps\": %d,\n", stepCount);
+#if defined(B2_SIMD_AVX2)
+		printf("\t\"simd\": \"avx2\",\n");
+#elif defined(B2_SIMD_SSE2)
+		printf("\t\"simd\": \"sse2\",\n");
+#else
+		printf("\t\"simd\": \"scalar\",\n");
+#endif
+		RunCollide();
+		printf("}\n");
+		return 0;
+	}
+
+	if (queriesOnly)
+	{
+		b2ThreadPool* threadPool = threadCount > 1 ? new b2ThreadPool(threadCount) : NULL;
+		printf("{\n");
+		printf("\t\"steps\": %d,\n", stepCount);
+		printf("\t\"threads\": %d,\n", threadCount);
+		RunQueries(threadPool);
+		printf("}\n");
+		delete threadPool;
+		return 0;
+	}
+
+	int32 selectedCount = 0;
+	for (const TestEntry* e = g_testEntries; e->createFcn; ++e)
+	{
+		if (IsSelected(e))
+		{
+			++selectedCount;
+		}
+	}
+
+	if (selectedCount == 0)
+	{
+		fprintf(stderr, "No test named \"%s\", see -list.\n", testName);
+		return 1;
+	}
+
+	b2ThreadPool* threadPool = threadCount > 1 ? new b2ThreadPool(threadCount) : NULL;
+	b2Profiler* profiler = traceName ? new b2Profiler(65536) : NULL;
+
+	FILE* checksumFile = NULL;
+	ChecksumWriter* checksums = NULL;
+	if (checksumName)
+	{
+		checksumFile = fopen(checksumName, "w");
+		if (checksumFile == NULL)
+		{
+			fprintf(stderr, "Could not write \"%s\".\n", checksumName);
+			delete profiler;
+			delete threadPool;
+			return 1;
+		}
+		checksums = new ChecksumWriter(checksumFile);
+	}
+
+	printf("{\n");
+	printf("\t\"steps\": %d,\n", stepCount);
+	printf("\t\"threads\": %d,\n", threadCount);
+	printf("\t\"split\": %s,\n", splitBroadPhase ? "true" : "false");
+	printf("\t\"batchedBroadPhase\": %s,\n", batchedBroadPhase ? "true" : "false");
+	printf("\t\"speculative\": %s,\n", speculativeContacts ? "true" : "false");
+	printf("\t\"batchedJoints\": %s,\n", batchedJoints ? "true" : "false");
+	printf("\t\"simd\": %s,\n", simdContactSolver ? "true" : "false");
+#if defined(B2_DETERMINISTIC)
+	printf("\t\"deterministic\": true,\n");
+#else
+	printf("\t\"deterministic\": false,\n");
+#endif
+	printf("\t\"tests\": [\n");
+
+	int32 index = 0;
+	for (const TestEntry* e = g_testEntries; e->createFcn; ++e)
+	{
+		if (IsSelected(e))
+		{
+			++index;
+			RunTest(e, threadPool, profiler, checksums, index == selectedCount);
+		}
+	}
+
+	printf("\t]\n");
+	printf("}\n");
+
+	int32 status = 0;
+	if (profiler && profiler->WriteChromeTrace(traceName) == false)
+	{
+		fprintf(stderr, "Could not write \"%s\".\n", traceName);
+		status = 1;
+	}
+
+	if (checksumFile)
+	{
+		fclose(checksumFile);
+	}
+
+	delete checksums;
+	delete profiler;
+	delete threadPool;
+	return status;
+}
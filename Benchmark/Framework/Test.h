@@ -0,0 +1,169 @@
+/*
+* Copyright (c) 2013 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BENCHMARK_TEST_H
+#define BENCHMARK_TEST_H
+
+#include <Box2D/Box2D.h>
+
+#include <cstdlib>
+
+// A headless stand-in for the Testbed framework, so the Testbed scenes
+// under Testbed/Tests can be built and stepped without GL.
+
+class Test;
+struct Settings;
+
+typedef Test* TestCreateFcn();
+
+#define	RAND_LIMIT	32767
+
+/// Random number in range [-1,1]
+inline float32 RandomFloat()
+{
+	float32 r = (float32)(std::rand() & (RAND_LIMIT));
+	r /= RAND_LIMIT;
+	r = 2.0f * r - 1.0f;
+	return r;
+}
+
+/// Random floating point number in range [lo, hi]
+inline float32 RandomFloat(float32 lo, float32 hi)
+{
+	float32 r = (float32)(std::rand() & (RAND_LIMIT));
+	r /= RAND_LIMIT;
+	r = (hi - lo) * r + lo;
+	return r;
+}
+
+/// The Testbed settings that affect the simulation.
+struct Settings
+{
+	Settings() :
+		viewCenter(0.0f, 20.0f),
+		hz(60.0f),
+		velocityIterations(8),
+		positionIterations(3),
+		enableWarmStarting(1),
+		enableContinuous(1),
+		enableSubStepping(0),
+		pause(0),
+		singleStep(0)
+		{}
+
+	b2Vec2 viewCenter;
+	float32 hz;
+	int32 velocityIterations;
+	int32 positionIterations;
+	int32 enableWarmStarting;
+	int32 enableContinuous;
+	int32 enableSubStepping;
+	int32 pause;
+	int32 singleStep;
+};
+
+struct TestEntry
+{
+	const char *name;
+	TestCreateFcn *createFcn;
+};
+
+extern TestEntry g_testEntries[];
+
+/// Test text and drawing are dropped.
+class DebugDraw : public b2Draw
+{
+public:
+	void DrawPolygon(const b2Vec2* vertices, int32 vertexCount, const b2Color& color)
+	{
+		B2_NOT_USED(vertices);
+		B2_NOT_USED(vertexCount);
+		B2_NOT_USED(color);
+	}
+
+	void DrawSolidPolygon(const b2Vec2* vertices, int32 vertexCount, const b2Color& color)
+	{
+		B2_NOT_USED(vertices);
+		B2_NOT_USED(vertexCount);
+		B2_NOT_USED(color);
+	}
+
+	void DrawCircle(const b2Vec2& center, float32 radius, const b2Color& color)
+	{
+		B2_NOT_USED(center);
+		B2_NOT_USED(radius);
+		B2_NOT_USED(color);
+	}
+
+	void DrawSolidCircle(const b2Vec2& center, float32 radius, const b2Vec2& axis, const b2Color& color)
+	{
+		B2_NOT_USED(center);
+		B2_NOT_USED(radius);
+		B2_NOT_USED(axis);
+		B2_NOT_USED(color);
+	}
+
+	void DrawSegment(const b2Vec2& p1, const b2Vec2& p2, const b2Color& color)
+	{
+		B2_NOT_USED(p1);
+		B2_NOT_USED(p2);
+		B2_NOT_USED(color);
+	}
+
+	void DrawTransform(const b2Transform& xf)
+	{
+		B2_NOT_USED(xf);
+	}
+
+	void DrawPoint(const b2Vec2& p, float32 size, const b2Color& color)
+	{
+		B2_NOT_USED(p);
+		B2_NOT_USED(size);
+		B2_NOT_USED(color);
+	}
+
+	void DrawString(int x, int y, const char* string, ...)
+	{
+		B2_NOT_USED(x);
+		B2_NOT_USED(y);
+		B2_NOT_USED(string);
+	}
+};
+
+class Test : public b2ContactListener
+{
+public:
+
+	Test();
+	virtual ~Test();
+
+	virtual void Step(Settings* settings);
+	virtual void Keyboard(unsigned char key) { B2_NOT_USED(key); }
+
+	b2World* GetWorld() { return m_world; }
+
+protected:
+
+	b2Body* m_groundBody;
+	DebugDraw m_debugDraw;
+	int32 m_textLine;
+	b2World* m_world;
+	int32 m_stepCount;
+};
+
+#endif
@@ -0,0 +1,67 @@
+/*
+* Copyright (c) 2013 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "Test.h"
+
+#include <cstring>
+using namespace std;
+
+// The Testbed scenes that only need the simulation parts of the framework.
+#include "../../Testbed/Tests/AddPair.h"
+#include "../../Testbed/Tests/Bridge.h"
+#include "../../Testbed/Tests/BulletTest.h"
+#include "../../Testbed/Tests/Cantilever.h"
+#include "../../Testbed/Tests/Car.h"
+#include "../../Testbed/Tests/Chain.h"
+#include "../../Testbed/Tests/Confined.h"
+#include "../../Testbed/Tests/ContinuousTest.h"
+#include "../../Testbed/Tests/Dominos.h"
+#include "../../Testbed/Tests/Particles.h"
+#include "../../Testbed/Tests/Pyramid.h"
+#include "../../Testbed/Tests/SphereStack.h"
+#include "../../Testbed/Tests/TheoJansen.h"
+#include "../../Testbed/Tests/Tiles.h"
+#include "../../Testbed/Tests/Tumbler.h"
+#include "../../Testbed/Tests/VaryingFriction.h"
+#include "../../Testbed/Tests/VerticalStack.h"
+#include "../../Testbed/Tests/Vines.h"
+#include "../../Testbed/Tests/Web.h"
+
+TestEntry g_testEntries[] =
+{
+	{"Pyramid", Pyramid::Create},
+	{"Vertical Stack", VerticalStack::Create},
+	{"Tumbler", Tumbler::Create},
+	{"Web", Web::Create},
+	{"Dominos", Dominos::Create},
+	{"Bullet Test", BulletTest::Create},
+	{"Continuous Test", ContinuousTest::Create},
+	{"Tiles", Tiles::Create},
+	{"Confined", Confined::Create},
+	{"Sphere Stack", SphereStack::Create},
+	{"Car", Car::Create},
+	{"Theo Jansen's Walker", TheoJansen::Create},
+	{"Bridge", Bridge::Create},
+	{"Chain", Chain::Create},
+	{"Cantilever", Cantilever::Create},
+	{"Varying Friction", VaryingFriction::Create},
+	{"Add Pair Stress Test", AddPair::Create},
+	{"Vines", Vines::Create},
+	{"Particles", Particles::Create},
+	{NULL, NULL}
+};
@@ -24,7 +24,10 @@ using namespace std;
 
 b2ChainShape::~b2ChainShape()
 {
-	b2Free(m_vertices);
+	if (m_ownsVertices)
+	{
+		b2Free(m_vertices);
+	}
 	m_vertices = NULL;
 	m_count = 0;
 }
@@ -54,6 +57,17 @@ void b2ChainShape::CreateChain(const b2Vec2* vertices, int32 count)
 	m_hasNextVertex = false;
 }
 
+void b2ChainShape::ReferenceChain(const b2Vec2* vertices, int32 count)
+{
+	b2Assert(m_vertices == NULL && m_count == 0);
+	b2Assert(count >= 2);
+	m_count = count;
+	m_vertices = const_cast<b2Vec2*>(vertices);
+	m_ownsVertices = false;
+	m_hasPrevVertex = false;
+	m_hasNextVertex = false;
+}
+
 void b2ChainShape::SetPrevVertex(const b2Vec2& prevVertex)
 {
 	m_prevVertex = prevVertex;
@@ -70,7 +84,14 @@ b2Shape* b2ChainShape::Clone(b2BlockAllocator* allocator) const
 {
 	void* mem = allocator->Allocate(sizeof(b2ChainShape));
 	b2ChainShape* clone = new (mem) b2ChainShape;
-	clone->CreateChain(m_vertices, m_count);
+	if (m_ownsVertices)
+	{
+		clone->CreateChain(m_vertices, m_count);
+	}
+	else
+	{
+		clone->ReferenceChain(m_vertices, m_count);
+	}
 	clone->m_prevVertex = m_prevVertex;
 	clone->m_nextVertex = m_nextVertex;
 	clone->m_hasPrevVertex = m_hasPrevVertex;
@@ -143,6 +164,26 @@ bool b2ChainShape::RayCast(b2RayCastOutput* output, const b2RayCastInput& input,
 	return edgeShape.RayCast(output, input, xf, 0);
 }
 
+void b2ChainShape::ComputeDistance(const b2Transform& xf, const b2Vec2& p, float32* distance,
+								   b2Vec2* normal, int32 childIndex) const
+{
+	b2Assert(childIndex < m_count);
+
+	b2EdgeShape edgeShape;
+
+	int32 i1 = childIndex;
+	int32 i2 = childIndex + 1;
+	if (i2 == m_count)
+	{
+		i2 = 0;
+	}
+
+	edgeShape.m_vertex1 = m_vertices[i1];
+	edgeShape.m_vertex2 = m_vertices[i2];
+
+	edgeShape.ComputeDistance(xf, p, distance, normal, 0);
+}
+
 void b2ChainShape::ComputeAABB(b2AABB* aabb, const b2Transform& xf, int32 childIndex) const
 {
 	b2Assert(childIndex < m_count);
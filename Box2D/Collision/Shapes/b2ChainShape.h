@@ -34,7 +34,7 @@ class b2ChainShape : public b2Shape
 public:
 	b2ChainShape();
 
-	/// The destructor frees the vertices using b2Free.
+	/// The destructor frees the vertices using b2Free, if they are owned.
 	~b2ChainShape();
 
 	/// Create a loop. This automatically adjusts connectivity.
@@ -47,6 +47,13 @@ public:
 	/// @param count the vertex count
 	void CreateChain(const b2Vec2* vertices, int32 count);
 
+	/// Create a chain that uses the vertices in place instead of copying them,
+	/// for example vertices in a memory mapped file. Clones use the same vertices,
+	/// so they must stay valid as long as the shape and its fixtures exist.
+	/// @param vertices an array of vertices, the last one repeats the first for loops
+	/// @param count the vertex count
+	void ReferenceChain(const b2Vec2* vertices, int32 count);
+
 	/// Establish connectivity to a vertex that precedes the first vertex.
 	/// Don't call this for loops.
 	void SetPrevVertex(const b2Vec2& prevVertex);
@@ -75,11 +82,15 @@ public:
 	/// @see b2Shape::ComputeAABB
 	void ComputeAABB(b2AABB* aabb, const b2Transform& transform, int32 childIndex) const;
 
+	/// @see b2Shape::ComputeDistance
+	void ComputeDistance(const b2Transform& transform, const b2Vec2& p, float32* distance,
+						 b2Vec2* normal, int32 childIndex) const;
+
 	/// Chains have zero mass.
 	/// @see b2Shape::ComputeMass
 	void ComputeMass(b2MassData* massData, float32 density) const;
 
-	/// The vertices. Owned by this class.
+	/// The vertices. Owned by this class, unless the chain was created by ReferenceChain.
 	b2Vec2* m_vertices;
 
 	/// The vertex count.
@@ -87,6 +98,9 @@ public:
 
 	b2Vec2 m_prevVertex, m_nextVertex;
 	bool m_hasPrevVertex, m_hasNextVertex;
+
+	/// Are the vertices freed by the destructor?
+	bool m_ownsVertices;
 };
 
 inline b2ChainShape::b2ChainShape()
@@ -97,6 +111,7 @@ inline b2ChainShape::b2ChainShape()
 	m_count = 0;
 	m_hasPrevVertex = NULL;
 	m_hasNextVertex = NULL;
+	m_ownsVertices = true;
 }
 
 #endif
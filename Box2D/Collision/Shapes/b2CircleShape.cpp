@@ -90,6 +90,24 @@ void b2CircleShape::ComputeAABB(b2AABB* aabb, const b2Transform& transform, int3
 	aabb->upperBound.Set(p.x + m_radius, p.y + m_radius);
 }
 
+void b2CircleShape::ComputeDistance(const b2Transform& transform, const b2Vec2& p, float32* distance,
+									b2Vec2* normal, int32 childIndex) const
+{
+	B2_NOT_USED(childIndex);
+
+	b2Vec2 center = transform.p + b2Mul(transform.q, m_p);
+	b2Vec2 d = p - center;
+	float32 length = d.Normalize();
+	if (length < b2_epsilon)
+	{
+		// Any direction works at the center.
+		d.Set(0.0f, 1.0f);
+	}
+
+	*distance = length - m_radius;
+	*normal = d;
+}
+
 void b2CircleShape::ComputeMass(b2MassData* massData, float32 density) const
 {
 	massData->mass = density * b2_pi * m_radius * m_radius;
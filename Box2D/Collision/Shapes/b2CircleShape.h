@@ -43,6 +43,10 @@ public:
 	/// @see b2Shape::ComputeAABB
 	void ComputeAABB(b2AABB* aabb, const b2Transform& transform, int32 childIndex) const;
 
+	/// @see b2Shape::ComputeDistance
+	void ComputeDistance(const b2Transform& transform, const b2Vec2& p, float32* distance,
+						 b2Vec2* normal, int32 childIndex) const;
+
 	/// @see b2Shape::ComputeMass
 	void ComputeMass(b2MassData* massData, float32 density) const;
 
@@ -129,6 +129,36 @@ void b2EdgeShape::ComputeAABB(b2AABB* aabb, const b2Transform& xf, int32 childIn
 	aabb->upperBound = upper + r;
 }
 
+void b2EdgeShape::ComputeDistance(const b2Transform& xf, const b2Vec2& p, float32* distance,
+								  b2Vec2* normal, int32 childIndex) const
+{
+	B2_NOT_USED(childIndex);
+
+	b2Vec2 v1 = b2Mul(xf, m_vertex1);
+	b2Vec2 v2 = b2Mul(xf, m_vertex2);
+
+	// Closest point on the segment.
+	b2Vec2 e = v2 - v1;
+	b2Vec2 d = p - v1;
+	float32 ee = b2Dot(e, e);
+	if (ee > 0.0f)
+	{
+		float32 s = b2Clamp(b2Dot(d, e) / ee, 0.0f, 1.0f);
+		d -= s * e;
+	}
+
+	float32 length = d.Normalize();
+	if (length < b2_epsilon)
+	{
+		// On the segment, use the side of the edge normal.
+		d.Set(e.y, -e.x);
+		d.Normalize();
+	}
+
+	*distance = length - m_radius;
+	*normal = d;
+}
+
 void b2EdgeShape::ComputeMass(b2MassData* massData, float32 density) const
 {
 	B2_NOT_USED(density);
@@ -277,6 +277,63 @@ void b2PolygonShape::ComputeAABB(b2AABB* aabb, const b2Transform& xf, int32 chil
 	aabb->upperBound = upper + r;
 }
 
+void b2PolygonShape::ComputeDistance(const b2Transform& xf, const b2Vec2& p, float32* distance,
+									 b2Vec2* normal, int32 childIndex) const
+{
+	B2_NOT_USED(childIndex);
+
+	b2Vec2 pLocal = b2MulT(xf.q, p - xf.p);
+
+	// The face of maximum separation.
+	float32 maxSeparation = -b2_maxFloat;
+	int32 bestIndex = 0;
+	for (int32 i = 0; i < m_vertexCount; ++i)
+	{
+		float32 s = b2Dot(m_normals[i], pLocal - m_vertices[i]);
+		if (s > maxSeparation)
+		{
+			maxSeparation = s;
+			bestIndex = i;
+		}
+	}
+
+	if (maxSeparation <= 0.0f)
+	{
+		// Inside, push out through the closest face.
+		*distance = maxSeparation - m_radius;
+		*normal = b2Mul(xf.q, m_normals[bestIndex]);
+		return;
+	}
+
+	// Outside, find the closest point on the boundary.
+	float32 minDistanceSquared = b2_maxFloat;
+	b2Vec2 minDelta = m_normals[bestIndex];
+	for (int32 i = 0; i < m_vertexCount; ++i)
+	{
+		b2Vec2 v1 = m_vertices[i];
+		b2Vec2 e = m_vertices[i + 1 < m_vertexCount ? i + 1 : 0] - v1;
+		b2Vec2 d = pLocal - v1;
+		float32 s = b2Clamp(b2Dot(d, e) / b2Dot(e, e), 0.0f, 1.0f);
+		d -= s * e;
+
+		float32 distanceSquared = b2Dot(d, d);
+		if (distanceSquared < minDistanceSquared)
+		{
+			minDistanceSquared = distanceSquared;
+			minDelta = d;
+		}
+	}
+
+	float32 length = minDelta.Normalize();
+	if (length < b2_epsilon)
+	{
+		minDelta = m_normals[bestIndex];
+	}
+
+	*distance = length - m_radius;
+	*normal = b2Mul(xf.q, minDelta);
+}
+
 void b2PolygonShape::ComputeMass(b2MassData* massData, float32 density) const
 {
 	// Polygon mass, centroid, and inertia.
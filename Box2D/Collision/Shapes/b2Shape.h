@@ -83,6 +83,16 @@ public:
 	/// @param childIndex the child shape
 	virtual void ComputeAABB(b2AABB* aabb, const b2Transform& xf, int32 childIndex) const = 0;
 
+	/// Compute the distance from a child shape to a point, including the radius
+	/// of the shape. The distance is negative for points inside a polygon.
+	/// @param xf the world transform of the shape.
+	/// @param p a point in world coordinates.
+	/// @param distance returns the distance.
+	/// @param normal returns the unit direction from the shape to the point.
+	/// @param childIndex the child shape
+	virtual void ComputeDistance(const b2Transform& xf, const b2Vec2& p, float32* distance,
+								 b2Vec2* normal, int32 childIndex) const = 0;
+
 	/// Compute the mass properties of this shape using its dimensions and density.
 	/// The inertia tensor is computed about the local origin.
 	/// @param massData returns the mass data for this shape.
@@ -17,13 +17,68 @@
 */
 
 #include <Box2D/Collision/b2BroadPhase.h>
+#include <Box2D/Common/b2ThreadPool.h>
 #include <cstring>
+#include <new>
 using namespace std;
 
-b2BroadPhase::b2BroadPhase()
+// Pairs found by one thread during batched pair finding.
+struct b2PairList
 {
+	b2Pair* pairs;
+	int32 count;
+	int32 capacity;
+};
+
+// The pairs of one group of moved proxies, as a range in a thread's pair list.
+struct b2PairGroup
+{
+	int32 threadIndex;
+	int32 start;
+	int32 count;
+};
+
+// Scratch buffers for batched pair finding, kept between calls.
+struct b2BatchedPairs
+{
+	b2PairList lists[b2_maxThreads];
+
+	b2PairGroup* groups;
+	int32 groupCapacity;
+
+	// Open addressing hash set of the reported pairs.
+	b2Pair* slots;
+	int32 slotCapacity;
+};
+
+b2BroadPhase::b2BroadPhase(b2BroadPhaseTree treeType)
+{
+	m_treeType = treeType;
+	m_trees = NULL;
+	m_wideTrees = NULL;
+	if (m_treeType == b2_wideTree)
+	{
+		m_wideTrees = (b2WideTree*)b2Alloc(b2_proxyTypeCount * sizeof(b2WideTree));
+		for (int32 i = 0; i < b2_proxyTypeCount; ++i)
+		{
+			new (m_wideTrees + i) b2WideTree;
+		}
+	}
+	else
+	{
+		m_trees = (b2DynamicTree*)b2Alloc(b2_proxyTypeCount * sizeof(b2DynamicTree));
+		for (int32 i = 0; i < b2_proxyTypeCount; ++i)
+		{
+			new (m_trees + i) b2DynamicTree;
+		}
+	}
+
 	m_proxyCount = 0;
 
+	m_splitTrees = false;
+	m_staticCount = 0;
+	m_staticInsertCount = 0;
+
 	m_pairCapacity = 16;
 	m_pairCount = 0;
 	m_pairBuffer = (b2Pair*)b2Alloc(m_pairCapacity * sizeof(b2Pair));
@@ -31,32 +86,199 @@ b2BroadPhase::b2BroadPhase()
 	m_moveCapacity = 16;
 	m_moveCount = 0;
 	m_moveBuffer = (int32*)b2Alloc(m_moveCapacity * sizeof(int32));
+
+	m_batchedPairs = false;
+	m_batch = NULL;
+	m_threadPool = NULL;
 }
 
 b2BroadPhase::~b2BroadPhase()
 {
+	if (m_batch)
+	{
+		for (int32 i = 0; i < b2_maxThreads; ++i)
+		{
+			b2Free(m_batch->lists[i].pairs);
+		}
+		b2Free(m_batch->groups);
+		b2Free(m_batch->slots);
+		b2Free(m_batch);
+	}
+
 	b2Free(m_moveBuffer);
 	b2Free(m_pairBuffer);
+
+	for (int32 i = 0; i < b2_proxyTypeCount; ++i)
+	{
+		if (m_wideTrees)
+		{
+			m_wideTrees[i].~b2WideTree();
+		}
+		else
+		{
+			m_trees[i].~b2DynamicTree();
+		}
+	}
+	b2Free(m_wideTrees);
+	b2Free(m_trees);
 }
 
-int32 b2BroadPhase::CreateProxy(const b2AABB& aabb, void* userData)
+void b2BroadPhase::SetBatchedPairs(bool flag)
 {
-	int32 proxyId = m_tree.CreateProxy(aabb, userData);
+	m_batchedPairs = flag;
+
+	if (flag && m_batch == NULL)
+	{
+		m_batch = (b2BatchedPairs*)b2Alloc(sizeof(b2BatchedPairs));
+		for (int32 i = 0; i < b2_maxThreads; ++i)
+		{
+			b2PairList* list = m_batch->lists + i;
+			list->capacity = 16;
+			list->count = 0;
+			list->pairs = (b2Pair*)b2Alloc(list->capacity * sizeof(b2Pair));
+		}
+
+		m_batch->groupCapacity = 16;
+		m_batch->groups = (b2PairGroup*)b2Alloc(m_batch->groupCapacity * sizeof(b2PairGroup));
+
+		m_batch->slotCapacity = 16;
+		m_batch->slots = (b2Pair*)b2Alloc(m_batch->slotCapacity * sizeof(b2Pair));
+	}
+}
+
+void b2BroadPhase::SetSplitTrees(bool flag)
+{
+	b2Assert(m_proxyCount == 0);
+	m_splitTrees = flag;
+}
+
+int32 b2BroadPhase::CreateProxy(const b2AABB& aabb, void* userData, b2ProxyType type)
+{
+	if (m_splitTrees == false)
+	{
+		type = b2_dynamicProxy;
+	}
+
+	int32 treeProxyId;
+	if (m_treeType == b2_wideTree)
+	{
+		treeProxyId = m_wideTrees[type].CreateProxy(aabb, userData);
+	}
+	else
+	{
+		treeProxyId = m_trees[type].CreateProxy(aabb, userData);
+	}
+
+	if (type == b2_staticProxy)
+	{
+		++m_staticCount;
+		++m_staticInsertCount;
+	}
+
+	int32 proxyId = MakeProxyId(treeProxyId, type);
 	++m_proxyCount;
 	BufferMove(proxyId);
 	return proxyId;
 }
 
+void b2BroadPhase::CreateProxies(const b2AABB* aabbs, void* const* userData, const b2ProxyType* types, int32 count, int32* proxyIds)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	b2AABB* typeAABBs = (b2AABB*)b2Alloc(count * sizeof(b2AABB));
+	void** typeUserData = (void**)b2Alloc(count * sizeof(void*));
+	int32* typeProxyIds = (int32*)b2Alloc(count * sizeof(int32));
+	int32* indices = (int32*)b2Alloc(count * sizeof(int32));
+
+	for (int32 type = 0; type < b2_proxyTypeCount; ++type)
+	{
+		// Gather the proxies that go to this tree.
+		int32 typeCount = 0;
+		for (int32 i = 0; i < count; ++i)
+		{
+			int32 proxyType = m_splitTrees && types ? types[i] : b2_dynamicProxy;
+			if (proxyType == type)
+			{
+				typeAABBs[typeCount] = aabbs[i];
+				typeUserData[typeCount] = userData[i];
+				indices[typeCount] = i;
+				++typeCount;
+			}
+		}
+
+		if (typeCount == 0)
+		{
+			continue;
+		}
+
+		if (m_treeType == b2_wideTree)
+		{
+			m_wideTrees[type].CreateProxies(typeAABBs, typeUserData, typeCount, typeProxyIds);
+		}
+		else
+		{
+			m_trees[type].CreateProxies(typeAABBs, typeUserData, typeCount, typeProxyIds);
+		}
+
+		if (type == b2_staticProxy)
+		{
+			m_staticCount += typeCount;
+			m_staticInsertCount += typeCount;
+		}
+
+		for (int32 i = 0; i < typeCount; ++i)
+		{
+			int32 proxyId = MakeProxyId(typeProxyIds[i], type);
+			proxyIds[indices[i]] = proxyId;
+			BufferMove(proxyId);
+		}
+	}
+
+	m_proxyCount += count;
+
+	b2Free(indices);
+	b2Free(typeProxyIds);
+	b2Free(typeUserData);
+	b2Free(typeAABBs);
+}
+
 void b2BroadPhase::DestroyProxy(int32 proxyId)
 {
 	UnBufferMove(proxyId);
 	--m_proxyCount;
-	m_tree.DestroyProxy(proxyId);
+
+	int32 type = GetProxyType(proxyId);
+	if (type == b2_staticProxy)
+	{
+		--m_staticCount;
+	}
+
+	if (m_treeType == b2_wideTree)
+	{
+		m_wideTrees[type].DestroyProxy(GetTreeProxyId(proxyId));
+	}
+	else
+	{
+		m_trees[type].DestroyProxy(GetTreeProxyId(proxyId));
+	}
 }
 
 void b2BroadPhase::MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& displacement)
 {
-	bool buffer = m_tree.MoveProxy(proxyId, aabb, displacement);
+	int32 type = GetProxyType(proxyId);
+	bool buffer;
+	if (m_treeType == b2_wideTree)
+	{
+		buffer = m_wideTrees[type].MoveProxy(GetTreeProxyId(proxyId), aabb, displacement);
+	}
+	else
+	{
+		buffer = m_trees[type].MoveProxy(GetTreeProxyId(proxyId), aabb, displacement);
+	}
+
 	if (buffer)
 	{
 		BufferMove(proxyId);
@@ -68,6 +290,75 @@ void b2BroadPhase::TouchProxy(int32 proxyId)
 	BufferMove(proxyId);
 }
 
+int32 b2BroadPhase::SetProxyType(int32 proxyId, b2ProxyType type)
+{
+	int32 oldType = GetProxyType(proxyId);
+	if (m_splitTrees == false || type == oldType)
+	{
+		return proxyId;
+	}
+
+	// Keep the fat AABB. The pairs found with it are still valid.
+	int32 oldTreeProxyId = GetTreeProxyId(proxyId);
+	int32 treeProxyId;
+	if (m_treeType == b2_wideTree)
+	{
+		b2AABB fatAABB = m_wideTrees[oldType].GetFatAABB(oldTreeProxyId);
+		void* userData = m_wideTrees[oldType].GetUserData(oldTreeProxyId);
+		m_wideTrees[oldType].DestroyProxy(oldTreeProxyId);
+		treeProxyId = m_wideTrees[type].CreateFatProxy(fatAABB, userData);
+	}
+	else
+	{
+		b2AABB fatAABB = m_trees[oldType].GetFatAABB(oldTreeProxyId);
+		void* userData = m_trees[oldType].GetUserData(oldTreeProxyId);
+		m_trees[oldType].DestroyProxy(oldTreeProxyId);
+		treeProxyId = m_trees[type].CreateFatProxy(fatAABB, userData);
+	}
+
+	if (oldType == b2_staticProxy)
+	{
+		--m_staticCount;
+	}
+
+	if (type == b2_staticProxy)
+	{
+		++m_staticCount;
+		++m_staticInsertCount;
+	}
+
+	int32 newProxyId = MakeProxyId(treeProxyId, type);
+
+	// A pending move keeps its place under the new id.
+	for (int32 i = 0; i < m_moveCount; ++i)
+	{
+		if (m_moveBuffer[i] == proxyId)
+		{
+			m_moveBuffer[i] = newProxyId;
+			break;
+		}
+	}
+
+	return newProxyId;
+}
+
+void b2BroadPhase::UpdateStaticTree()
+{
+	// A few insertions into a large static tree are cheaper than a rebuild.
+	if (m_staticInsertCount == 0 || 4 * m_staticInsertCount < m_staticCount)
+	{
+		return;
+	}
+
+	// The wide tree has no bulk build and keeps its incremental insertions.
+	if (m_treeType == b2_binaryTree)
+	{
+		m_trees[b2_staticProxy].RebuildTopDown();
+	}
+
+	m_staticInsertCount = 0;
+}
+
 void b2BroadPhase::BufferMove(int32 proxyId)
 {
 	if (m_moveCount == m_moveCapacity)
@@ -83,6 +374,82 @@ void b2BroadPhase::BufferMove(int32 proxyId)
 	++m_moveCount;
 }
 
+void b2BroadPhase::ShiftOrigin(const b2Vec2& newOrigin)
+{
+	for (int32 i = 0; i < b2_proxyTypeCount; ++i)
+	{
+		if (m_treeType == b2_wideTree)
+		{
+			m_wideTrees[i].ShiftOrigin(newOrigin);
+		}
+		else
+		{
+			m_trees[i].ShiftOrigin(newOrigin);
+		}
+	}
+}
+
+void b2BroadPhase::Save(b2Snapshot* snapshot) const
+{
+	snapshot->Write(m_treeType);
+	snapshot->Write(m_splitTrees);
+	for (int32 i = 0; i < b2_proxyTypeCount; ++i)
+	{
+		if (m_treeType == b2_wideTree)
+		{
+			m_wideTrees[i].Save(snapshot);
+		}
+		else
+		{
+			m_trees[i].Save(snapshot);
+		}
+	}
+
+	snapshot->Write(m_proxyCount);
+	snapshot->Write(m_staticCount);
+	snapshot->Write(m_staticInsertCount);
+	snapshot->Write(m_moveCount);
+	snapshot->Write(m_moveBuffer, m_moveCount * sizeof(int32));
+}
+
+void b2BroadPhase::Restore(const b2Snapshot* snapshot)
+{
+	b2BroadPhaseTree treeType;
+	snapshot->Read(&treeType);
+	b2Assert(treeType == m_treeType);
+
+	bool splitTrees;
+	snapshot->Read(&splitTrees);
+	b2Assert(splitTrees == m_splitTrees);
+
+	for (int32 i = 0; i < b2_proxyTypeCount; ++i)
+	{
+		if (m_treeType == b2_wideTree)
+		{
+			m_wideTrees[i].Restore(snapshot);
+		}
+		else
+		{
+			m_trees[i].Restore(snapshot);
+		}
+	}
+
+	int32 moveCount;
+	snapshot->Read(&m_proxyCount);
+	snapshot->Read(&m_staticCount);
+	snapshot->Read(&m_staticInsertCount);
+	snapshot->Read(&moveCount);
+
+	m_moveCount = 0;
+	const int32* moveBuffer = (const int32*)snapshot->Read(moveCount * sizeof(int32));
+	for (int32 i = 0; i < moveCount; ++i)
+	{
+		int32 proxyId;
+		memcpy(&proxyId, moveBuffer + i, sizeof(int32));
+		BufferMove(proxyId);
+	}
+}
+
 void b2BroadPhase::UnBufferMove(int32 proxyId)
 {
 	for (int32 i = 0; i < m_moveCount; ++i)
@@ -95,7 +462,7 @@ void b2BroadPhase::UnBufferMove(int32 proxyId)
 	}
 }
 
-// This is called from b2DynamicTree::Query when we are gathering pairs.
+// This is called from b2DynamicTree::Query or b2WideTree::Query when we are gathering pairs.
 bool b2BroadPhase::QueryCallback(int32 proxyId)
 {
 	// A proxy cannot form a pair with itself.
@@ -120,3 +487,222 @@ bool b2BroadPhase::QueryCallback(int32 proxyId)
 
 	return true;
 }
+
+// Tree callback for one group of moved proxies.
+struct b2PairGroupQuery
+{
+	bool QueryCallback(int32 index, int32 treeProxyId)
+	{
+		int32 proxyId = b2BroadPhase::MakeProxyId(treeProxyId, type);
+		int32 queryProxyId = proxies[index];
+
+		// A proxy cannot form a pair with itself.
+		if (proxyId == queryProxyId)
+		{
+			return true;
+		}
+
+		// Grow the pair list as needed.
+		if (list->count == list->capacity)
+		{
+			b2Pair* oldPairs = list->pairs;
+			list->capacity *= 2;
+			list->pairs = (b2Pair*)b2Alloc(list->capacity * sizeof(b2Pair));
+			memcpy(list->pairs, oldPairs, list->count * sizeof(b2Pair));
+			b2Free(oldPairs);
+		}
+
+		list->pairs[list->count].proxyIdA = b2Min(proxyId, queryProxyId);
+		list->pairs[list->count].proxyIdB = b2Max(proxyId, queryProxyId);
+		++list->count;
+
+		return true;
+	}
+
+	const int32* proxies;
+	int32 type;
+	b2PairList* list;
+};
+
+struct b2FindPairsTask : public b2ParallelTask
+{
+	void Execute(int32 index, int32 threadIndex)
+	{
+		int32 first = index * b2_simdWidth;
+		int32 count = b2Min(moveCount - first, int32(b2_simdWidth));
+
+		b2AABB aabbs[b2_simdWidth];
+		int32 proxies[b2_simdWidth];
+
+		b2PairGroupQuery query;
+		query.proxies = proxies;
+		query.list = batch->lists + threadIndex;
+
+		b2PairGroup* group = batch->groups + index;
+		group->threadIndex = threadIndex;
+		group->start = query.list->count;
+
+		for (int32 type = 0; type < b2_proxyTypeCount; ++type)
+		{
+			// Gather the moved proxies that pair with this tree.
+			int32 queryCount = 0;
+			for (int32 i = 0; i < count; ++i)
+			{
+				int32 proxyId = moveBuffer[first + i];
+				if (broadPhase->ShouldQueryTree(broadPhase->GetProxyType(proxyId), type))
+				{
+					// Query with the fat AABB so that we don't fail to create a pair
+					// that may touch later.
+					aabbs[queryCount] = broadPhase->GetFatAABB(proxyId);
+					proxies[queryCount] = proxyId;
+					++queryCount;
+				}
+			}
+
+			if (queryCount == 0)
+			{
+				continue;
+			}
+
+			query.type = type;
+			if (broadPhase->m_treeType == b2_wideTree)
+			{
+				broadPhase->m_wideTrees[type].QueryBatch(&query, aabbs, queryCount);
+			}
+			else
+			{
+				broadPhase->m_trees[type].QueryBatch(&query, aabbs, queryCount);
+			}
+		}
+
+		group->count = query.list->count - group->start;
+	}
+
+	const b2BroadPhase* broadPhase;
+	const int32* moveBuffer;
+	int32 moveCount;
+	b2BatchedPairs* batch;
+};
+
+inline uint32 b2HashPair(int32 proxyIdA, int32 proxyIdB)
+{
+	uint32 h = uint32(proxyIdA) * 0x9E3779B1u + uint32(proxyIdB);
+	h ^= h >> 16;
+	h *= 0x85EBCA6Bu;
+	h ^= h >> 13;
+	return h;
+}
+
+void b2BroadPhase::FindPairsBatched()
+{
+	b2Assert(m_batch != NULL);
+
+	UpdateStaticTree();
+
+	// Drop the proxies that were destroyed after they moved.
+	int32 moveCount = 0;
+	for (int32 i = 0; i < m_moveCount; ++i)
+	{
+		if (m_moveBuffer[i] != e_nullProxy)
+		{
+			m_moveBuffer[moveCount++] = m_moveBuffer[i];
+		}
+	}
+	m_moveCount = 0;
+
+	int32 groupCount = (moveCount + b2_simdWidth - 1) / b2_simdWidth;
+	if (groupCount > m_batch->groupCapacity)
+	{
+		b2Free(m_batch->groups);
+		m_batch->groupCapacity = b2Max(groupCount, 2 * m_batch->groupCapacity);
+		m_batch->groups = (b2PairGroup*)b2Alloc(m_batch->groupCapacity * sizeof(b2PairGroup));
+	}
+
+	int32 threadCount = m_threadPool ? m_threadPool->GetThreadCount() : 1;
+	for (int32 i = 0; i < threadCount; ++i)
+	{
+		m_batch->lists[i].count = 0;
+	}
+
+	b2FindPairsTask task;
+	task.broadPhase = this;
+	task.moveBuffer = m_moveBuffer;
+	task.moveCount = moveCount;
+	task.batch = m_batch;
+
+	if (m_threadPool)
+	{
+		m_threadPool->Run(&task, groupCount);
+	}
+	else
+	{
+		for (int32 i = 0; i < groupCount; ++i)
+		{
+			task.Execute(i, 0);
+		}
+	}
+
+	int32 candidateCount = 0;
+	for (int32 i = 0; i < threadCount; ++i)
+	{
+		candidateCount += m_batch->lists[i].count;
+	}
+
+	if (candidateCount > m_pairCapacity)
+	{
+		b2Free(m_pairBuffer);
+		m_pairCapacity = b2Max(candidateCount, 2 * m_pairCapacity);
+		m_pairBuffer = (b2Pair*)b2Alloc(m_pairCapacity * sizeof(b2Pair));
+	}
+
+	// Keep the hash set at most half full.
+	int32 slotCount = 16;
+	while (slotCount < 2 * candidateCount)
+	{
+		slotCount *= 2;
+	}
+
+	if (slotCount > m_batch->slotCapacity)
+	{
+		b2Free(m_batch->slots);
+		m_batch->slotCapacity = slotCount;
+		m_batch->slots = (b2Pair*)b2Alloc(m_batch->slotCapacity * sizeof(b2Pair));
+	}
+
+	b2Pair* slots = m_batch->slots;
+	for (int32 i = 0; i < slotCount; ++i)
+	{
+		slots[i].proxyIdA = e_nullProxy;
+	}
+
+	// Gather the groups in move order, skipping duplicates.
+	m_pairCount = 0;
+	uint32 slotMask = uint32(slotCount - 1);
+	for (int32 i = 0; i < groupCount; ++i)
+	{
+		const b2PairGroup* group = m_batch->groups + i;
+		const b2Pair* pairs = m_batch->lists[group->threadIndex].pairs + group->start;
+		for (int32 j = 0; j < group->count; ++j)
+		{
+			const b2Pair* pair = pairs + j;
+
+			uint32 slot = b2HashPair(pair->proxyIdA, pair->proxyIdB) & slotMask;
+			while (slots[slot].proxyIdA != e_nullProxy)
+			{
+				if (slots[slot].proxyIdA == pair->proxyIdA && slots[slot].proxyIdB == pair->proxyIdB)
+				{
+					break;
+				}
+				slot = (slot + 1) & slotMask;
+			}
+
+			if (slots[slot].proxyIdA != e_nullProxy)
+			{
+				continue;
+			}
+
+			slots[slot] = *pair;
+			m_pairBuffer[m_pairCount++] = *pair;
+		}
+	}
+}
@@ -22,8 +22,12 @@
 #include <Box2D/Common/b2Settings.h>
 #include <Box2D/Collision/b2Collision.h>
 #include <Box2D/Collision/b2DynamicTree.h>
+#include <Box2D/Collision/b2WideTree.h>
 #include <algorithm>
 
+class b2ThreadPool;
+struct b2BatchedPairs;
+
 struct b2Pair
 {
 	int32 proxyIdA;
@@ -31,6 +35,22 @@ struct b2Pair
 	int32 next;
 };
 
+/// The tree that holds the broad-phase proxies.
+enum b2BroadPhaseTree
+{
+	b2_binaryTree = 0,	///< b2DynamicTree
+	b2_wideTree			///< b2WideTree, four children per node tested with SIMD
+};
+
+/// The kind of body a proxy belongs to. With split trees each type has its own tree.
+enum b2ProxyType
+{
+	b2_staticProxy = 0,		///< static bodies, bulk built
+	b2_dynamicProxy,		///< awake kinematic and dynamic bodies
+	b2_sleepingProxy,		///< sleeping kinematic and dynamic bodies
+	b2_proxyTypeCount
+};
+
 /// The broad-phase is used for computing pairs and performing volume queries and ray casts.
 /// This broad-phase does not persist pairs. Instead, this reports potentially new pairs.
 /// It is up to the client to consume the new pairs and to track subsequent overlap.
@@ -43,12 +63,18 @@ public:
 		e_nullProxy = -1
 	};
 
-	b2BroadPhase();
+	/// The tree type cannot be changed after construction.
+	b2BroadPhase(b2BroadPhaseTree treeType = b2_binaryTree);
 	~b2BroadPhase();
 
 	/// Create a proxy with an initial AABB. Pairs are not reported until
-	/// UpdatePairs is called.
-	int32 CreateProxy(const b2AABB& aabb, void* userData);
+	/// UpdatePairs is called. The type selects the tree when the trees are split.
+	int32 CreateProxy(const b2AABB& aabb, void* userData, b2ProxyType type = b2_dynamicProxy);
+
+	/// Create many proxies at once. Each tree inserts its share in bulk.
+	/// @param types the type of each proxy, or NULL if they are all dynamic.
+	/// @param proxyIds receives the ids of the new proxies.
+	void CreateProxies(const b2AABB* aabbs, void* const* userData, const b2ProxyType* types, int32 count, int32* proxyIds);
 
 	/// Destroy a proxy. It is up to the client to remove any pairs.
 	void DestroyProxy(int32 proxyId);
@@ -60,6 +86,14 @@ public:
 	/// Call to trigger a re-processing of it's pairs on the next call to UpdatePairs.
 	void TouchProxy(int32 proxyId);
 
+	/// Move a proxy to the tree of another type, keeping its fat AABB so that no
+	/// pairs are lost. This does nothing unless the trees are split.
+	/// @return the new proxy id, which replaces the old one.
+	int32 SetProxyType(int32 proxyId, b2ProxyType type);
+
+	/// Get the type of the tree holding a proxy.
+	b2ProxyType GetProxyType(int32 proxyId) const;
+
 	/// Get the fat AABB for a proxy.
 	const b2AABB& GetFatAABB(int32 proxyId) const;
 
@@ -76,11 +110,36 @@ public:
 	template <typename T>
 	void UpdatePairs(T* callback);
 
+	/// Enable/disable batched pair finding. Moved proxies are queried in groups
+	/// of b2_simdWidth that share one tree walk, the groups run on the thread pool
+	/// if there is one, and duplicate pairs are removed with a hash set instead of
+	/// a sort. Pairs are then reported in move order instead of proxy id order.
+	void SetBatchedPairs(bool flag);
+	bool GetBatchedPairs() const;
+
+	/// Set the thread pool used by batched pair finding. NULL finds the pairs on
+	/// the calling thread.
+	void SetThreadPool(b2ThreadPool* threadPool);
+
+	/// Enable/disable separate trees for static, dynamic and sleeping proxies.
+	/// The static tree is rebuilt in bulk before pairs are found once enough static
+	/// proxies were added, and moved static proxies skip it because static pairs
+	/// never collide. Moving proxies then update and walk smaller trees. This can
+	/// only be changed while there are no proxies.
+	void SetSplitTrees(bool flag);
+	bool GetSplitTrees() const;
+
 	/// Query an AABB for overlapping proxies. The callback class
 	/// is called for each proxy that overlaps the supplied AABB.
 	template <typename T>
 	void Query(T* callback, const b2AABB& aabb) const;
 
+	/// Query up to b2_simdWidth AABBs with one walk of each tree. The callback
+	/// class is called with bool QueryCallback(int32 index, int32 proxyId) for
+	/// each proxy that overlaps aabbs[index]. Returning false stops all of them.
+	template <typename T>
+	void QueryBatch(T* callback, const b2AABB* aabbs, int32 count) const;
+
 	/// Ray-cast against the proxies in the tree. This relies on the callback
 	/// to perform a exact ray-cast in the case were the proxy contains a shape.
 	/// The callback also performs the any collision filtering. This has performance
@@ -91,28 +150,83 @@ public:
 	template <typename T>
 	void RayCast(T* callback, const b2RayCastInput& input) const;
 
-	/// Get the height of the embedded tree.
-	int32 GetTreeHeight() const;
+	/// Get the type of the embedded tree.
+	b2BroadPhaseTree GetTreeType() const;
+
+	/// Get the height of an embedded tree. Without split trees all
+	/// proxies are in the dynamic tree.
+	int32 GetTreeHeight(b2ProxyType type = b2_dynamicProxy) const;
+
+	/// Get the balance of an embedded tree.
+	int32 GetTreeBalance(b2ProxyType type = b2_dynamicProxy) const;
 
-	/// Get the balance of the embedded tree.
-	int32 GetTreeBalance() const;
+	/// Get the quality metric of an embedded tree.
+	float32 GetTreeQuality(b2ProxyType type = b2_dynamicProxy) const;
 
-	/// Get the quality metric of the embedded tree.
-	float32 GetTreeQuality() const;
+	/// Shift the world origin. Useful for large worlds.
+	/// The shift formula is: position -= newOrigin
+	/// @param newOrigin the new origin with respect to the old origin
+	void ShiftOrigin(const b2Vec2& newOrigin);
+
+	/// Write the trees and the moved proxies to a snapshot.
+	void Save(b2Snapshot* snapshot) const;
+
+	/// Replace the trees and the moved proxies with ones read from a snapshot.
+	/// The tree type and the split setting must match.
+	void Restore(const b2Snapshot* snapshot);
 
 private:
 
-	friend class b2DynamicTree;
+	template <typename T> friend struct b2TreeQueryWrapper;
+	template <typename T> friend struct b2TreeQueryBatchWrapper;
+	template <typename T> friend struct b2TreeRayCastWrapper;
+	friend struct b2PairGroupQuery;
+	friend struct b2FindPairsTask;
+
+	// A proxy id holds the id in its tree and the tree type in the low bits.
+	enum
+	{
+		e_typeBits = 2,
+		e_typeMask = (1 << e_typeBits) - 1
+	};
+
+	static int32 MakeProxyId(int32 treeProxyId, int32 type);
+	static int32 GetTreeProxyId(int32 proxyId);
+
+	template <typename T>
+	void QueryTree(int32 type, T* callback, const b2AABB& aabb) const;
+
+	template <typename T>
+	void QueryBatchTree(int32 type, T* callback, const b2AABB* aabbs, int32 count) const;
+
+	template <typename T>
+	void RayCastTree(int32 type, T* callback, const b2RayCastInput& input) const;
+
+	// Moved static proxies only pair with proxies of the other trees.
+	bool ShouldQueryTree(int32 queryType, int32 treeType) const;
 
 	void BufferMove(int32 proxyId);
 	void UnBufferMove(int32 proxyId);
 
 	bool QueryCallback(int32 proxyId);
 
-	b2DynamicTree m_tree;
+	// Bulk build the static tree if enough static proxies were added.
+	void UpdateStaticTree();
+
+	// Fill the pair buffer with the unique pairs of the moved proxies.
+	void FindPairsBatched();
+
+	// Only the trees of the chosen type are created, the other array is NULL.
+	b2BroadPhaseTree m_treeType;
+	b2DynamicTree* m_trees;
+	b2WideTree* m_wideTrees;
 
 	int32 m_proxyCount;
 
+	bool m_splitTrees;
+	int32 m_staticCount;
+	int32 m_staticInsertCount;
+
 	int32* m_moveBuffer;
 	int32 m_moveCapacity;
 	int32 m_moveCount;
@@ -122,6 +236,10 @@ private:
 	int32 m_pairCount;
 
 	int32 m_queryProxyId;
+
+	bool m_batchedPairs;
+	b2BatchedPairs* m_batch;
+	b2ThreadPool* m_threadPool;
 };
 
 /// This is used to sort pairs.
@@ -140,21 +258,53 @@ inline bool b2PairLessThan(const b2Pair& pair1, const b2Pair& pair2)
 	return false;
 }
 
+inline int32 b2BroadPhase::MakeProxyId(int32 treeProxyId, int32 type)
+{
+	return (treeProxyId << e_typeBits) | type;
+}
+
+inline int32 b2BroadPhase::GetTreeProxyId(int32 proxyId)
+{
+	return proxyId >> e_typeBits;
+}
+
+inline b2ProxyType b2BroadPhase::GetProxyType(int32 proxyId) const
+{
+	return b2ProxyType(proxyId & e_typeMask);
+}
+
+inline bool b2BroadPhase::ShouldQueryTree(int32 queryType, int32 treeType) const
+{
+	return m_splitTrees == false || queryType != b2_staticProxy || treeType != b2_staticProxy;
+}
+
 inline void* b2BroadPhase::GetUserData(int32 proxyId) const
 {
-	return m_tree.GetUserData(proxyId);
+	int32 type = GetProxyType(proxyId);
+	if (m_treeType == b2_wideTree)
+	{
+		return m_wideTrees[type].GetUserData(GetTreeProxyId(proxyId));
+	}
+
+	return m_trees[type].GetUserData(GetTreeProxyId(proxyId));
 }
 
 inline bool b2BroadPhase::TestOverlap(int32 proxyIdA, int32 proxyIdB) const
 {
-	const b2AABB& aabbA = m_tree.GetFatAABB(proxyIdA);
-	const b2AABB& aabbB = m_tree.GetFatAABB(proxyIdB);
+	const b2AABB& aabbA = GetFatAABB(proxyIdA);
+	const b2AABB& aabbB = GetFatAABB(proxyIdB);
 	return b2TestOverlap(aabbA, aabbB);
 }
 
 inline const b2AABB& b2BroadPhase::GetFatAABB(int32 proxyId) const
 {
-	return m_tree.GetFatAABB(proxyId);
+	int32 type = GetProxyType(proxyId);
+	if (m_treeType == b2_wideTree)
+	{
+		return m_wideTrees[type].GetFatAABB(GetTreeProxyId(proxyId));
+	}
+
+	return m_trees[type].GetFatAABB(GetTreeProxyId(proxyId));
 }
 
 inline int32 b2BroadPhase::GetProxyCount() const
@@ -162,27 +312,136 @@ inline int32 b2BroadPhase::GetProxyCount() const
 	return m_proxyCount;
 }
 
-inline int32 b2BroadPhase::GetTreeHeight() const
+inline b2BroadPhaseTree b2BroadPhase::GetTreeType() const
+{
+	return m_treeType;
+}
+
+inline int32 b2BroadPhase::GetTreeHeight(b2ProxyType type) const
+{
+	if (m_treeType == b2_wideTree)
+	{
+		return m_wideTrees[type].GetHeight();
+	}
+
+	return m_trees[type].GetHeight();
+}
+
+inline int32 b2BroadPhase::GetTreeBalance(b2ProxyType type) const
+{
+	if (m_treeType == b2_wideTree)
+	{
+		return m_wideTrees[type].GetMaxBalance();
+	}
+
+	return m_trees[type].GetMaxBalance();
+}
+
+inline float32 b2BroadPhase::GetTreeQuality(b2ProxyType type) const
 {
-	return m_tree.GetHeight();
+	if (m_treeType == b2_wideTree)
+	{
+		return m_wideTrees[type].GetAreaRatio();
+	}
+
+	return m_trees[type].GetAreaRatio();
 }
 
-inline int32 b2BroadPhase::GetTreeBalance() const
+inline bool b2BroadPhase::GetBatchedPairs() const
 {
-	return m_tree.GetMaxBalance();
+	return m_batchedPairs;
 }
 
-inline float32 b2BroadPhase::GetTreeQuality() const
+inline void b2BroadPhase::SetThreadPool(b2ThreadPool* threadPool)
 {
-	return m_tree.GetAreaRatio();
+	m_threadPool = threadPool;
 }
 
+inline bool b2BroadPhase::GetSplitTrees() const
+{
+	return m_splitTrees;
+}
+
+// Forwards tree callbacks with the proxy ids of the broad-phase.
+template <typename T>
+struct b2TreeQueryWrapper
+{
+	bool QueryCallback(int32 treeProxyId)
+	{
+		proceed = callback->QueryCallback(b2BroadPhase::MakeProxyId(treeProxyId, type));
+		return proceed;
+	}
+
+	T* callback;
+	int32 type;
+	bool proceed;
+};
+
+template <typename T>
+struct b2TreeQueryBatchWrapper
+{
+	bool QueryCallback(int32 index, int32 treeProxyId)
+	{
+		proceed = callback->QueryCallback(index, b2BroadPhase::MakeProxyId(treeProxyId, type));
+		return proceed;
+	}
+
+	T* callback;
+	int32 type;
+	bool proceed;
+};
+
+// Also keeps the clipped fraction so that the next tree starts with it.
+template <typename T>
+struct b2TreeRayCastWrapper
+{
+	float32 RayCastCallback(const b2RayCastInput& input, int32 treeProxyId)
+	{
+		float32 value = callback->RayCastCallback(input, b2BroadPhase::MakeProxyId(treeProxyId, type));
+		if (value == 0.0f)
+		{
+			proceed = false;
+		}
+		else if (value > 0.0f)
+		{
+			maxFraction = value;
+		}
+		return value;
+	}
+
+	T* callback;
+	int32 type;
+	bool proceed;
+	float32 maxFraction;
+};
+
 template <typename T>
 void b2BroadPhase::UpdatePairs(T* callback)
 {
+	if (m_batchedPairs)
+	{
+		// The pairs are already unique.
+		FindPairsBatched();
+
+		for (int32 i = 0; i < m_pairCount; ++i)
+		{
+			b2Pair* pair = m_pairBuffer + i;
+			void* userDataA = GetUserData(pair->proxyIdA);
+			void* userDataB = GetUserData(pair->proxyIdB);
+			callback->AddPair(userDataA, userDataB);
+		}
+
+		return;
+	}
+
+	UpdateStaticTree();
+
 	// Reset pair buffer
 	m_pairCount = 0;
 
+	b2TreeQueryWrapper<b2BroadPhase> wrapper;
+	wrapper.callback = this;
+
 	// Perform tree queries for all moving proxies.
 	for (int32 i = 0; i < m_moveCount; ++i)
 	{
@@ -194,10 +453,18 @@ void b2BroadPhase::UpdatePairs(T* callback)
 
 		// We have to query the tree with the fat AABB so that
 		// we don't fail to create a pair that may touch later.
-		const b2AABB& fatAABB = m_tree.GetFatAABB(m_queryProxyId);
+		const b2AABB& fatAABB = GetFatAABB(m_queryProxyId);
 
-		// Query tree, create pairs and add them pair buffer.
-		m_tree.Query(this, fatAABB);
+		// Query the trees, create pairs and add them pair buffer.
+		int32 queryType = GetProxyType(m_queryProxyId);
+		for (int32 type = 0; type < b2_proxyTypeCount; ++type)
+		{
+			if (ShouldQueryTree(queryType, type))
+			{
+				wrapper.type = type;
+				QueryTree(type, &wrapper, fatAABB);
+			}
+		}
 	}
 
 	// Reset move buffer
@@ -211,8 +478,8 @@ void b2BroadPhase::UpdatePairs(T* callback)
 	while (i < m_pairCount)
 	{
 		b2Pair* primaryPair = m_pairBuffer + i;
-		void* userDataA = m_tree.GetUserData(primaryPair->proxyIdA);
-		void* userDataB = m_tree.GetUserData(primaryPair->proxyIdB);
+		void* userDataA = GetUserData(primaryPair->proxyIdA);
+		void* userDataB = GetUserData(primaryPair->proxyIdB);
 
 		callback->AddPair(userDataA, userDataB);
 		++i;
@@ -233,16 +500,85 @@ void b2BroadPhase::UpdatePairs(T* callback)
 	//m_tree.Rebalance(4);
 }
 
+template <typename T>
+inline void b2BroadPhase::QueryTree(int32 type, T* callback, const b2AABB& aabb) const
+{
+	if (m_treeType == b2_wideTree)
+	{
+		m_wideTrees[type].Query(callback, aabb);
+		return;
+	}
+
+	m_trees[type].Query(callback, aabb);
+}
+
+template <typename T>
+inline void b2BroadPhase::QueryBatchTree(int32 type, T* callback, const b2AABB* aabbs, int32 count) const
+{
+	if (m_treeType == b2_wideTree)
+	{
+		m_wideTrees[type].QueryBatch(callback, aabbs, count);
+		return;
+	}
+
+	m_trees[type].QueryBatch(callback, aabbs, count);
+}
+
+template <typename T>
+inline void b2BroadPhase::RayCastTree(int32 type, T* callback, const b2RayCastInput& input) const
+{
+	if (m_treeType == b2_wideTree)
+	{
+		m_wideTrees[type].RayCast(callback, input);
+		return;
+	}
+
+	m_trees[type].RayCast(callback, input);
+}
+
 template <typename T>
 inline void b2BroadPhase::Query(T* callback, const b2AABB& aabb) const
 {
-	m_tree.Query(callback, aabb);
+	b2TreeQueryWrapper<T> wrapper;
+	wrapper.callback = callback;
+	wrapper.proceed = true;
+
+	for (int32 type = 0; type < b2_proxyTypeCount && wrapper.proceed; ++type)
+	{
+		wrapper.type = type;
+		QueryTree(type, &wrapper, aabb);
+	}
+}
+
+template <typename T>
+inline void b2BroadPhase::QueryBatch(T* callback, const b2AABB* aabbs, int32 count) const
+{
+	b2TreeQueryBatchWrapper<T> wrapper;
+	wrapper.callback = callback;
+	wrapper.proceed = true;
+
+	for (int32 type = 0; type < b2_proxyTypeCount && wrapper.proceed; ++type)
+	{
+		wrapper.type = type;
+		QueryBatchTree(type, &wrapper, aabbs, count);
+	}
 }
 
 template <typename T>
 inline void b2BroadPhase::RayCast(T* callback, const b2RayCastInput& input) const
 {
-	m_tree.RayCast(callback, input);
+	b2TreeRayCastWrapper<T> wrapper;
+	wrapper.callback = callback;
+	wrapper.proceed = true;
+	wrapper.maxFraction = input.maxFraction;
+
+	b2RayCastInput treeInput = input;
+	for (int32 type = 0; type < b2_proxyTypeCount && wrapper.proceed; ++type)
+	{
+		wrapper.type = type;
+		treeInput.maxFraction = wrapper.maxFraction;
+		RayCastTree(type, &wrapper, treeInput);
+	}
 }
 
 #endif
@@ -20,13 +20,15 @@
 #include <Box2D/Collision/Shapes/b2CircleShape.h>
 #include <Box2D/Collision/Shapes/b2EdgeShape.h>
 #include <Box2D/Collision/Shapes/b2PolygonShape.h>
+#include <Box2D/Common/b2Simd.h>
 
 
 // Compute contact points for edge versus circle.
 // This accounts for edge connectivity.
 void b2CollideEdgeAndCircle(b2Manifold* manifold,
 							const b2EdgeShape* edgeA, const b2Transform& xfA,
-							const b2CircleShape* circleB, const b2Transform& xfB)
+							const b2CircleShape* circleB, const b2Transform& xfB,
+							float32 speculativeDistance)
 {
 	manifold->pointCount = 0;
 	
@@ -40,7 +42,7 @@ void b2CollideEdgeAndCircle(b2Manifold* manifold,
 	float32 u = b2Dot(e, B - Q);
 	float32 v = b2Dot(e, Q - A);
 	
-	float32 radius = edgeA->m_radius + circleB->m_radius;
+	float32 radius = edgeA->m_radius + circleB->m_radius + speculativeDistance;
 	
 	b2ContactFeature cf;
 	cf.indexB = 0;
@@ -194,7 +196,7 @@ struct b2ReferenceFace
 struct b2EPCollider
 {
 	void Collide(b2Manifold* manifold, const b2EdgeShape* edgeA, const b2Transform& xfA,
-				 const b2PolygonShape* polygonB, const b2Transform& xfB);
+				 const b2PolygonShape* polygonB, const b2Transform& xfB, float32 speculativeDistance);
 	b2EPAxis ComputeEdgeSeparation();
 	b2EPAxis ComputePolygonSeparation();
 	
@@ -228,7 +230,7 @@ struct b2EPCollider
 // 7. Return if _any_ axis indicates separation
 // 8. Clip
 void b2EPCollider::Collide(b2Manifold* manifold, const b2EdgeShape* edgeA, const b2Transform& xfA,
-						   const b2PolygonShape* polygonB, const b2Transform& xfB)
+						   const b2PolygonShape* polygonB, const b2Transform& xfB, float32 speculativeDistance)
 {
 	m_xf = b2MulT(xfA, xfB);
 	
@@ -426,13 +428,26 @@ void b2EPCollider::Collide(b2Manifold* manifold, const b2EdgeShape* edgeA, const
 	
 	// Get polygonB in frameA
 	m_polygonB.count = polygonB->m_vertexCount;
+#if defined(B2_SIMD_SCALAR)
 	for (int32 i = 0; i < polygonB->m_vertexCount; ++i)
 	{
 		m_polygonB.vertices[i] = b2Mul(m_xf, polygonB->m_vertices[i]);
 		m_polygonB.normals[i] = b2Mul(m_xf.q, polygonB->m_normals[i]);
 	}
+#else
+	b2FloatW c = b2SplatW(m_xf.q.c), s = b2SplatW(m_xf.q.s);
+	b2FloatW px = b2SplatW(m_xf.p.x), py = b2SplatW(m_xf.p.y);
+	for (int32 base = 0; base < polygonB->m_vertexCount; base += b2_simdWidth)
+	{
+		b2FloatW vx, vy, nx, ny;
+		b2LoadXYW(&polygonB->m_vertices[base].x, &vx, &vy);
+		b2LoadXYW(&polygonB->m_normals[base].x, &nx, &ny);
+		b2StoreXYW(&m_polygonB.vertices[base].x, (c * vx - s * vy) + px, (s * vx + c * vy) + py);
+		b2StoreXYW(&m_polygonB.normals[base].x, c * nx - s * ny, s * nx + c * ny);
+	}
+#endif
 	
-	m_radius = 2.0f * b2_polygonRadius;
+	m_radius = 2.0f * b2_polygonRadius + speculativeDistance;
 	
 	manifold->pointCount = 0;
 	
@@ -617,6 +632,8 @@ void b2EPCollider::Collide(b2Manifold* manifold, const b2EdgeShape* edgeA, const
 	manifold->pointCount = pointCount;
 }
 
+#if defined(B2_SIMD_SCALAR)
+
 b2EPAxis b2EPCollider::ComputeEdgeSeparation()
 {
 	b2EPAxis axis;
@@ -689,10 +706,116 @@ b2EPAxis b2EPCollider::ComputePolygonSeparation()
 	return axis;
 }
 
+#else
+
+// The SIMD versions put the vertices and normals of polygon B in the lanes and
+// repeat the arithmetic of the scalar versions above lane by lane.
+
+b2EPAxis b2EPCollider::ComputeEdgeSeparation()
+{
+	b2EPAxis axis;
+	axis.type = b2EPAxis::e_edgeA;
+	axis.index = m_front ? 0 : 1;
+	axis.separation = FLT_MAX;
+
+	b2FloatW normalX = b2SplatW(m_normal.x), normalY = b2SplatW(m_normal.y);
+	b2FloatW v1x = b2SplatW(m_v1.x), v1y = b2SplatW(m_v1.y);
+	for (int32 base = 0; base < m_polygonB.count; base += b2_simdWidth)
+	{
+		b2FloatW vx, vy;
+		b2LoadXYW(&m_polygonB.vertices[base].x, &vx, &vy);
+		b2FloatW sep = normalX * (vx - v1x) + normalY * (vy - v1y);
+
+		b2FloatW valid = b2GreaterW(b2SplatW(float32(m_polygonB.count - base)), b2LaneIndexW());
+		float32 s = b2ReduceMinW(b2SelectW(valid, sep, b2SplatW(FLT_MAX)));
+		if (s < axis.separation)
+		{
+			axis.separation = s;
+		}
+	}
+
+	return axis;
+}
+
+b2EPAxis b2EPCollider::ComputePolygonSeparation()
+{
+	b2EPAxis axis;
+	axis.type = b2EPAxis::e_unknown;
+	axis.index = -1;
+	axis.separation = -FLT_MAX;
+
+	b2Vec2 perp(-m_normal.y, m_normal.x);
+
+	b2FloatW normalX = b2SplatW(m_normal.x), normalY = b2SplatW(m_normal.y);
+	b2FloatW perpX = b2SplatW(perp.x), perpY = b2SplatW(perp.y);
+	b2FloatW v1x = b2SplatW(m_v1.x), v1y = b2SplatW(m_v1.y);
+	b2FloatW v2x = b2SplatW(m_v2.x), v2y = b2SplatW(m_v2.y);
+	b2FloatW upperX = b2SplatW(m_upperLimit.x), upperY = b2SplatW(m_upperLimit.y);
+	b2FloatW lowerX = b2SplatW(m_lowerLimit.x), lowerY = b2SplatW(m_lowerLimit.y);
+	b2FloatW radius = b2SplatW(m_radius);
+	b2FloatW slop = b2SplatW(-b2_angularSlop);
+
+	for (int32 base = 0; base < m_polygonB.count; base += b2_simdWidth)
+	{
+		b2FloatW vx, vy, nx, ny;
+		b2LoadXYW(&m_polygonB.vertices[base].x, &vx, &vy);
+		b2LoadXYW(&m_polygonB.normals[base].x, &nx, &ny);
+		nx = -nx;
+		ny = -ny;
+
+		b2FloatW s1 = nx * (vx - v1x) + ny * (vy - v1y);
+		b2FloatW s2 = nx * (vx - v2x) + ny * (vy - v2y);
+		b2FloatW s = b2MinW(s1, s2);
+
+		b2FloatW valid = b2GreaterW(b2SplatW(float32(m_polygonB.count - base)), b2LaneIndexW());
+
+		// No collision, the first such normal is reported.
+		int32 separated = b2MaskBitsW(b2AndW(valid, b2GreaterW(s, radius)));
+		if (separated)
+		{
+			float32 lanes[b2_simdWidth];
+			b2StoreW(lanes, s);
+			int32 lane = b2FirstLane(separated);
+			axis.type = b2EPAxis::e_edgeB;
+			axis.index = base + lane;
+			axis.separation = lanes[lane];
+			return axis;
+		}
+
+		// Adjacency
+		b2FloatW upper = b2GreaterEqualW(nx * perpX + ny * perpY, b2ZeroW());
+		b2FloatW upperDot = (nx - upperX) * normalX + (ny - upperY) * normalY;
+		b2FloatW lowerDot = (nx - lowerX) * normalX + (ny - lowerY) * normalY;
+		b2FloatW skip = b2GreaterW(slop, b2SelectW(upper, upperDot, lowerDot));
+		int32 accepted = b2MaskBitsW(valid) & ~b2MaskBitsW(skip);
+		if (accepted == 0)
+		{
+			continue;
+		}
+
+		float32 lanes[b2_simdWidth];
+		b2StoreW(lanes, s);
+		for (int32 lane = 0; lane < b2_simdWidth; ++lane)
+		{
+			if ((accepted & (1 << lane)) && lanes[lane] > axis.separation)
+			{
+				axis.type = b2EPAxis::e_edgeB;
+				axis.index = base + lane;
+				axis.separation = lanes[lane];
+			}
+		}
+	}
+
+	return axis;
+}
+
+#endif
+
 void b2CollideEdgeAndPolygon(	b2Manifold* manifold,
 							 const b2EdgeShape* edgeA, const b2Transform& xfA,
-							 const b2PolygonShape* polygonB, const b2Transform& xfB)
+							 const b2PolygonShape* polygonB, const b2Transform& xfB,
+							 float32 speculativeDistance)
 {
 	b2EPCollider collider;
-	collider.Collide(manifold, edgeA, xfA, polygonB, xfB);
+	collider.Collide(manifold, edgeA, xfA, polygonB, xfB, speculativeDistance);
 }
@@ -18,124 +18,231 @@
 
 #include <Box2D/Collision/b2Collision.h>
 #include <Box2D/Collision/Shapes/b2PolygonShape.h>
+#include <Box2D/Common/b2Simd.h>
 
-// Find the separation between poly1 and poly2 for a give edge normal on poly1.
-static float32 b2EdgeSeparation(const b2PolygonShape* poly1, const b2Transform& xf1, int32 edge1,
-							  const b2PolygonShape* poly2, const b2Transform& xf2)
-{
-	const b2Vec2* vertices1 = poly1->m_vertices;
-	const b2Vec2* normals1 = poly1->m_normals;
+#if defined(B2_SIMD_SCALAR)
 
+// Find the max separation between poly1 and poly2 using edge normals from poly1.
+// Every edge normal is tested against every vertex of poly2, in the frame of poly2.
+// If margin is not NULL, it gets the max separation minus the separation of the
+// next best edge.
+static float32 b2FindMaxSeparation(int32* edgeIndex,
+								 const b2PolygonShape* poly1, const b2Transform& xf1,
+								 const b2PolygonShape* poly2, const b2Transform& xf2,
+								 float32* margin)
+{
+	int32 count1 = poly1->m_vertexCount;
 	int32 count2 = poly2->m_vertexCount;
-	const b2Vec2* vertices2 = poly2->m_vertices;
-
-	b2Assert(0 <= edge1 && edge1 < poly1->m_vertexCount);
-
-	// Convert normal from poly1's frame into poly2's frame.
-	b2Vec2 normal1World = b2Mul(xf1.q, normals1[edge1]);
-	b2Vec2 normal1 = b2MulT(xf2.q, normal1World);
+	const b2Vec2* n1s = poly1->m_normals;
+	const b2Vec2* v1s = poly1->m_vertices;
+	const b2Vec2* v2s = poly2->m_vertices;
+	b2Transform xf = b2MulT(xf2, xf1);
+
+	int32 bestIndex = 0;
+	float32 maxSeparation = -b2_maxFloat;
+	float32 nextSeparation = -b2_maxFloat;
+	for (int32 i = 0; i < count1; ++i)
+	{
+		// Get poly1 normal and vertex in frame2.
+		b2Vec2 n = b2Mul(xf.q, n1s[i]);
+		b2Vec2 v1 = b2Mul(xf, v1s[i]);
 
-	// Find support vertex on poly2 for -normal.
-	int32 index = 0;
-	float32 minDot = b2_maxFloat;
+		// Find the deepest point of poly2 for this normal.
+		float32 si = b2_maxFloat;
+		for (int32 j = 0; j < count2; ++j)
+		{
+			float32 sij = b2Dot(n, v2s[j] - v1);
+			if (sij < si)
+			{
+				si = sij;
+			}
+		}
 
-	for (int32 i = 0; i < count2; ++i)
-	{
-		float32 dot = b2Dot(vertices2[i], normal1);
-		if (dot < minDot)
+		if (si > maxSeparation)
 		{
-			minDot = dot;
-			index = i;
+			nextSeparation = maxSeparation;
+			maxSeparation = si;
+			bestIndex = i;
+		}
+		else if (si > nextSeparation)
+		{
+			nextSeparation = si;
 		}
 	}
 
-	b2Vec2 v1 = b2Mul(xf1, vertices1[edge1]);
-	b2Vec2 v2 = b2Mul(xf2, vertices2[index]);
-	float32 separation = b2Dot(v2 - v1, normal1World);
-	return separation;
+	if (margin)
+	{
+		*margin = maxSeparation - nextSeparation;
+	}
+
+	*edgeIndex = bestIndex;
+	return maxSeparation;
 }
 
-// Find the max separation between poly1 and poly2 using edge normals from poly1.
+#else
+
+// The same search with the edges of poly1 in the lanes, so all the normals of
+// a polygon are tested in one pass over the vertices of poly2. Each lane does
+// the arithmetic of the scalar version in the same order.
 static float32 b2FindMaxSeparation(int32* edgeIndex,
 								 const b2PolygonShape* poly1, const b2Transform& xf1,
-								 const b2PolygonShape* poly2, const b2Transform& xf2)
+								 const b2PolygonShape* poly2, const b2Transform& xf2,
+								 float32* margin)
 {
 	int32 count1 = poly1->m_vertexCount;
-	const b2Vec2* normals1 = poly1->m_normals;
+	int32 count2 = poly2->m_vertexCount;
+	const b2Vec2* v2s = poly2->m_vertices;
+	b2Transform xf = b2MulT(xf2, xf1);
 
-	// Vector pointing from the centroid of poly1 to the centroid of poly2.
-	b2Vec2 d = b2Mul(xf2, poly2->m_centroid) - b2Mul(xf1, poly1->m_centroid);
-	b2Vec2 dLocal1 = b2MulT(xf1.q, d);
+	b2FloatW c = b2SplatW(xf.q.c), s = b2SplatW(xf.q.s);
+	b2FloatW px = b2SplatW(xf.p.x), py = b2SplatW(xf.p.y);
 
-	// Find edge normal on poly1 that has the largest projection onto d.
-	int32 edge = 0;
-	float32 maxDot = -b2_maxFloat;
-	for (int32 i = 0; i < count1; ++i)
+	// The separation of each edge, kept to find the next best edge.
+	float32 separations[b2_maxPolygonVertices + b2_simdWidth];
+
+	int32 bestIndex = 0;
+	float32 maxSeparation = -b2_maxFloat;
+	for (int32 base = 0; base < count1; base += b2_simdWidth)
+	{
+		b2FloatW nx, ny, vx, vy;
+		b2LoadXYW(&poly1->m_normals[base].x, &nx, &ny);
+		b2LoadXYW(&poly1->m_vertices[base].x, &vx, &vy);
+
+		// Get poly1 normals and vertices in frame2.
+		b2FloatW n2x = c * nx - s * ny;
+		b2FloatW n2y = s * nx + c * ny;
+		b2FloatW v2x = (c * vx - s * vy) + px;
+		b2FloatW v2y = (s * vx + c * vy) + py;
+
+		b2FloatW si = b2SplatW(b2_maxFloat);
+		for (int32 j = 0; j < count2; ++j)
+		{
+			b2FloatW sij = n2x * (b2SplatW(v2s[j].x) - v2x) + n2y * (b2SplatW(v2s[j].y) - v2y);
+			si = b2MinW(si, sij);
+		}
+
+		// Lanes past the last edge never win, ties keep the first edge.
+		b2FloatW valid = b2GreaterW(b2SplatW(float32(count1 - base)), b2LaneIndexW());
+		si = b2SelectW(valid, si, b2SplatW(-b2_maxFloat));
+		if (margin)
+		{
+			b2StoreW(separations + base, si);
+		}
+
+		float32 m = b2ReduceMaxW(si);
+		if (m > maxSeparation)
+		{
+			maxSeparation = m;
+			bestIndex = base + b2FirstLane(b2MaskBitsW(b2AndW(valid, b2GreaterEqualW(si, b2SplatW(m)))));
+		}
+	}
+
+	if (margin)
 	{
-		float32 dot = b2Dot(normals1[i], dLocal1);
-		if (dot > maxDot)
+		float32 nextSeparation = -b2_maxFloat;
+		for (int32 i = 0; i < count1; ++i)
 		{
-			maxDot = dot;
-			edge = i;
+			if (i != bestIndex)
+			{
+				nextSeparation = b2Max(nextSeparation, separations[i]);
+			}
 		}
+
+		*margin = maxSeparation - nextSeparation;
 	}
 
-	// Get the separation for the edge normal.
-	float32 s = b2EdgeSeparation(poly1, xf1, edge, poly2, xf2);
+	*edgeIndex = bestIndex;
+	return maxSeparation;
+}
+
+#endif
 
-	// Check the separation for the previous edge normal.
-	int32 prevEdge = edge - 1 >= 0 ? edge - 1 : count1 - 1;
-	float32 sPrev = b2EdgeSeparation(poly1, xf1, prevEdge, poly2, xf2);
+// The separation of poly2 from edge1 of poly1. This is the arithmetic of one
+// edge of b2FindMaxSeparation, so the result is the same.
+static float32 b2EdgeSeparation(const b2PolygonShape* poly1, const b2Transform& xf1, int32 edge1,
+								const b2PolygonShape* poly2, const b2Transform& xf2)
+{
+	int32 count2 = poly2->m_vertexCount;
+	const b2Vec2* v2s = poly2->m_vertices;
+	b2Transform xf = b2MulT(xf2, xf1);
 
-	// Check the separation for the next edge normal.
-	int32 nextEdge = edge + 1 < count1 ? edge + 1 : 0;
-	float32 sNext = b2EdgeSeparation(poly1, xf1, nextEdge, poly2, xf2);
+	b2Assert(0 <= edge1 && edge1 < poly1->m_vertexCount);
 
-	// Find the best edge and the search direction.
-	int32 bestEdge;
-	float32 bestSeparation;
-	int32 increment;
-	if (sPrev > s && sPrev > sNext)
+	// Get poly1 normal and vertex in frame2.
+	b2Vec2 n = b2Mul(xf.q, poly1->m_normals[edge1]);
+	b2Vec2 v1 = b2Mul(xf, poly1->m_vertices[edge1]);
+
+	float32 separation = b2_maxFloat;
+	for (int32 j = 0; j < count2; ++j)
 	{
-		increment = -1;
-		bestEdge = prevEdge;
-		bestSeparation = sPrev;
+		float32 sj = b2Dot(n, v2s[j] - v1);
+		if (sj < separation)
+		{
+			separation = sj;
+		}
 	}
-	else if (sNext > s)
+
+	return separation;
+}
+
+static float32 b2ComputeVertexRadius(const b2PolygonShape* poly)
+{
+	float32 radiusSquared = 0.0f;
+	for (int32 i = 0; i < poly->m_vertexCount; ++i)
 	{
-		increment = 1;
-		bestEdge = nextEdge;
-		bestSeparation = sNext;
+		radiusSquared = b2Max(radiusSquared, b2Dot(poly->m_vertices[i], poly->m_vertices[i]));
 	}
-	else
+	return b2Sqrt(radiusSquared);
+}
+
+// Rounding differs between the searches of two steps by much less than this.
+#define b2_polygonCacheTolerance	(0.1f * b2_linearSlop)
+
+// Try to find the edges of max separation from the cache. Returns true if the
+// polygons are separated or if edgeA and edgeB are the edges the full search
+// would find.
+static bool b2UsePolygonCache(b2PolygonCache* cache, float32 maxSeparation,
+							  const b2PolygonShape* polyA, const b2Transform& xfA, int32* edgeA, float32* separationA,
+							  const b2PolygonShape* polyB, const b2Transform& xfB, int32* edgeB, float32* separationB)
+{
+	if (cache->edgeA < 0)
 	{
-		*edgeIndex = edge;
-		return s;
+		return false;
 	}
 
-	// Perform a local search for the best edge normal.
-	for ( ; ; )
+	// An edge that still separates the polygons proves them apart, whichever
+	// edge separates them most.
+	*edgeA = cache->edgeA;
+	*separationA = b2EdgeSeparation(polyA, xfA, *edgeA, polyB, xfB);
+	if (*separationA > maxSeparation)
 	{
-		if (increment == -1)
-			edge = bestEdge - 1 >= 0 ? bestEdge - 1 : count1 - 1;
-		else
-			edge = bestEdge + 1 < count1 ? bestEdge + 1 : 0;
+		return true;
+	}
 
-		s = b2EdgeSeparation(poly1, xf1, edge, poly2, xf2);
+	if (cache->edgeB < 0)
+	{
+		return false;
+	}
 
-		if (s > bestSeparation)
-		{
-			bestEdge = edge;
-			bestSeparation = s;
-		}
-		else
-		{
-			break;
-		}
+	*edgeB = cache->edgeB;
+	*separationB = b2EdgeSeparation(polyB, xfB, *edgeB, polyA, xfA);
+	if (*separationB > maxSeparation)
+	{
+		return true;
 	}
 
-	*edgeIndex = bestEdge;
-	return bestSeparation;
+	// Bound how far the vertices of each polygon have moved in the frame of the
+	// other one since the last search. The separation of every edge changes by
+	// at most that much, so the best edges stay the best while their margins
+	// are more than twice as large. The 1-norms bound the lengths.
+	b2Transform xf = b2MulT(xfA, xfB);
+	float32 dp = b2Abs(xf.p.x - cache->xf.p.x) + b2Abs(xf.p.y - cache->xf.p.y);
+	float32 dq = b2Abs(xf.q.c - cache->xf.q.c) + b2Abs(xf.q.s - cache->xf.q.s);
+	float32 driftA = dp + dq * cache->radiusB;
+	float32 driftB = dp + dq * (cache->radiusA + b2Abs(cache->xf.p.x) + b2Abs(cache->xf.p.y));
+
+	return cache->marginA > 2.0f * driftA + b2_polygonCacheTolerance &&
+		   cache->marginB > 2.0f * driftB + b2_polygonCacheTolerance;
 }
 
 static void b2FindIncidentEdge(b2ClipVertex c[2],
@@ -192,20 +299,52 @@ static void b2FindIncidentEdge(b2ClipVertex c[2],
 // The normal points from 1 to 2
 void b2CollidePolygons(b2Manifold* manifold,
 					  const b2PolygonShape* polyA, const b2Transform& xfA,
-					  const b2PolygonShape* polyB, const b2Transform& xfB)
+					  const b2PolygonShape* polyB, const b2Transform& xfB,
+					  float32 speculativeDistance, b2PolygonCache* cache)
 {
 	manifold->pointCount = 0;
 	float32 totalRadius = polyA->m_radius + polyB->m_radius;
+	float32 maxSeparation = totalRadius + speculativeDistance;
 
 	int32 edgeA = 0;
-	float32 separationA = b2FindMaxSeparation(&edgeA, polyA, xfA, polyB, xfB);
-	if (separationA > totalRadius)
-		return;
-
 	int32 edgeB = 0;
-	float32 separationB = b2FindMaxSeparation(&edgeB, polyB, xfB, polyA, xfA);
-	if (separationB > totalRadius)
-		return;
+	float32 separationA, separationB;
+	if (cache && b2UsePolygonCache(cache, maxSeparation, polyA, xfA, &edgeA, &separationA, polyB, xfB, &edgeB, &separationB))
+	{
+		cache->hit = true;
+		if (separationA > maxSeparation || separationB > maxSeparation)
+		{
+			return;
+		}
+	}
+	else if (cache)
+	{
+		cache->hit = false;
+		cache->xf = b2MulT(xfA, xfB);
+		cache->radiusA = b2ComputeVertexRadius(polyA);
+		cache->radiusB = b2ComputeVertexRadius(polyB);
+		cache->edgeB = -1;
+
+		separationA = b2FindMaxSeparation(&edgeA, polyA, xfA, polyB, xfB, &cache->marginA);
+		cache->edgeA = (int8)edgeA;
+		if (separationA > maxSeparation)
+			return;
+
+		separationB = b2FindMaxSeparation(&edgeB, polyB, xfB, polyA, xfA, &cache->marginB);
+		cache->edgeB = (int8)edgeB;
+		if (separationB > maxSeparation)
+			return;
+	}
+	else
+	{
+		separationA = b2FindMaxSeparation(&edgeA, polyA, xfA, polyB, xfB, NULL);
+		if (separationA > maxSeparation)
+			return;
+
+		separationB = b2FindMaxSeparation(&edgeB, polyB, xfB, polyA, xfA, NULL);
+		if (separationB > maxSeparation)
+			return;
+	}
 
 	const b2PolygonShape* poly1;	// reference polygon
 	const b2PolygonShape* poly2;	// incident polygon
@@ -295,7 +434,7 @@ void b2CollidePolygons(b2Manifold* manifold,
 	{
 		float32 separation = b2Dot(normal, clipPoints2[i].v) - frontOffset;
 
-		if (separation <= totalRadius)
+		if (separation <= maxSeparation)
 		{
 			b2ManifoldPoint* cp = manifold->points + pointCount;
 			cp->localPoint = b2MulT(xf2, clipPoints2[i].v);
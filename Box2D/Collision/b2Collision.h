@@ -119,6 +119,7 @@ struct b2WorldManifold
 
 	b2Vec2 normal;							///< world vector pointing from A to B
 	b2Vec2 points[b2_maxManifoldPoints];	///< world contact point (point of intersection)
+	float32 separations[b2_maxManifoldPoints];	///< a negative value indicates overlap, in meters
 };
 
 /// This is used for determining the state of contact points.
@@ -215,29 +216,55 @@ struct b2AABB
 };
 
 /// Compute the collision manifold between two circles.
+/// The collide functions keep points whose separation is at most speculativeDistance,
+/// so separated shapes can get points before they touch.
 void b2CollideCircles(b2Manifold* manifold,
 					  const b2CircleShape* circleA, const b2Transform& xfA,
-					  const b2CircleShape* circleB, const b2Transform& xfB);
+					  const b2CircleShape* circleB, const b2Transform& xfB,
+					  float32 speculativeDistance = 0.0f);
 
 /// Compute the collision manifold between a polygon and a circle.
 void b2CollidePolygonAndCircle(b2Manifold* manifold,
 							   const b2PolygonShape* polygonA, const b2Transform& xfA,
-							   const b2CircleShape* circleB, const b2Transform& xfB);
+							   const b2CircleShape* circleB, const b2Transform& xfB,
+							   float32 speculativeDistance = 0.0f);
+
+/// Used to warm start b2CollidePolygons between steps. The cache keeps the edges
+/// of most separation found by the last full search, how far ahead of the other
+/// edges they were and the relative transform of the polygons at that time.
+/// Set edgeA and edgeB to -1 on the first call.
+struct b2PolygonCache
+{
+	b2Transform xf;		///< the transform of polygon B in the frame of polygon A
+	float32 marginA;	///< separation of edgeA minus that of the next best edge of A
+	float32 marginB;	///< separation of edgeB minus that of the next best edge of B
+	float32 radiusA;	///< the largest vertex distance from the origin of polygon A
+	float32 radiusB;	///< the largest vertex distance from the origin of polygon B
+	int8 edgeA;			///< the edge of most separation on A, -1 if unknown
+	int8 edgeB;			///< the edge of most separation on B, -1 if unknown
+	bool hit;			///< set if the last call skipped the full search
+};
 
-/// Compute the collision manifold between two polygons.
+/// Compute the collision manifold between two polygons. With a cache, an edge
+/// that still separates the polygons ends the search early, and the full search
+/// is skipped while the polygons have moved too little relative to each other
+/// to change its outcome. The manifold is the same with or without a cache.
 void b2CollidePolygons(b2Manifold* manifold,
 					   const b2PolygonShape* polygonA, const b2Transform& xfA,
-					   const b2PolygonShape* polygonB, const b2Transform& xfB);
+					   const b2PolygonShape* polygonB, const b2Transform& xfB,
+					   float32 speculativeDistance = 0.0f, b2PolygonCache* cache = NULL);
 
 /// Compute the collision manifold between an edge and a circle.
 void b2CollideEdgeAndCircle(b2Manifold* manifold,
 							   const b2EdgeShape* polygonA, const b2Transform& xfA,
-							   const b2CircleShape* circleB, const b2Transform& xfB);
+							   const b2CircleShape* circleB, const b2Transform& xfB,
+							   float32 speculativeDistance = 0.0f);
 
 /// Compute the collision manifold between an edge and a circle.
 void b2CollideEdgeAndPolygon(b2Manifold* manifold,
 							   const b2EdgeShape* edgeA, const b2Transform& xfA,
-							   const b2PolygonShape* circleB, const b2Transform& xfB);
+							   const b2PolygonShape* circleB, const b2Transform& xfB,
+							   float32 speculativeDistance = 0.0f);
 
 /// Clipping for contact manifolds.
 int32 b2ClipSegmentToLine(b2ClipVertex vOut[2], const b2ClipVertex vIn[2],
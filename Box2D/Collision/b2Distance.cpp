@@ -25,6 +25,59 @@
 // GJK using Voronoi regions (Christer Ericson) and Barycentric coordinates.
 int32 b2_gjkCalls, b2_gjkIters, b2_gjkMaxIters;
 
+// Defined in b2TimeOfImpact.cpp.
+extern int32 b2_toiCalls, b2_toiIters, b2_toiMaxIters;
+extern int32 b2_toiRootIters, b2_toiMaxRootIters;
+
+// NULL while the thread counts into the globals.
+static thread_local b2CollisionCounters* b2_threadCounters = NULL;
+
+void b2CollisionCounters::SetZero()
+{
+	gjkCalls = 0;
+	gjkIters = 0;
+	gjkMaxIters = 0;
+	toiCalls = 0;
+	toiIters = 0;
+	toiMaxIters = 0;
+	toiRootIters = 0;
+	toiMaxRootIters = 0;
+}
+
+void b2CollisionCounters::Add(const b2CollisionCounters& other)
+{
+	gjkCalls += other.gjkCalls;
+	gjkIters += other.gjkIters;
+	gjkMaxIters = b2Max(gjkMaxIters, other.gjkMaxIters);
+	toiCalls += other.toiCalls;
+	toiIters += other.toiIters;
+	toiMaxIters = b2Max(toiMaxIters, other.toiMaxIters);
+	toiRootIters += other.toiRootIters;
+	toiMaxRootIters = b2Max(toiMaxRootIters, other.toiMaxRootIters);
+}
+
+void b2SetThreadCounters(b2CollisionCounters* counters)
+{
+	b2_threadCounters = counters;
+}
+
+b2CollisionCounters* b2GetThreadCounters()
+{
+	return b2_threadCounters;
+}
+
+void b2AddGlobalCounters(const b2CollisionCounters& counters)
+{
+	b2_gjkCalls += counters.gjkCalls;
+	b2_gjkIters += counters.gjkIters;
+	b2_gjkMaxIters = b2Max(b2_gjkMaxIters, counters.gjkMaxIters);
+	b2_toiCalls += counters.toiCalls;
+	b2_toiIters += counters.toiIters;
+	b2_toiMaxIters = b2Max(b2_toiMaxIters, counters.toiMaxIters);
+	b2_toiRootIters += counters.toiRootIters;
+	b2_toiMaxRootIters = b2Max(b2_toiMaxRootIters, counters.toiMaxRootIters);
+}
+
 void b2DistanceProxy::Set(const b2Shape* shape, int32 index)
 {
 	switch (shape->GetType())
@@ -444,8 +497,6 @@ void b2Distance(b2DistanceOutput* output,
 				b2SimplexCache* cache,
 				const b2DistanceInput* input)
 {
-	++b2_gjkCalls;
-
 	const b2DistanceProxy* proxyA = &input->proxyA;
 	const b2DistanceProxy* proxyB = &input->proxyB;
 
@@ -541,7 +592,6 @@ void b2Distance(b2DistanceOutput* output,
 
 		// Iteration count is equated to the number of support point calls.
 		++iter;
-		++b2_gjkIters;
 
 		// Check for duplicate support points. This is the main termination criteria.
 		bool duplicate = false;
@@ -564,7 +614,19 @@ void b2Distance(b2DistanceOutput* output,
 		++simplex.m_count;
 	}
 
-	b2_gjkMaxIters = b2Max(b2_gjkMaxIters, iter);
+	b2CollisionCounters* counters = b2_threadCounters;
+	if (counters)
+	{
+		++counters->gjkCalls;
+		counters->gjkIters += iter;
+		counters->gjkMaxIters = b2Max(counters->gjkMaxIters, iter);
+	}
+	else
+	{
+		++b2_gjkCalls;
+		b2_gjkIters += iter;
+		b2_gjkMaxIters = b2Max(b2_gjkMaxIters, iter);
+	}
 
 	// Prepare output.
 	simplex.GetWitnessPoints(&output->pointA, &output->pointB);
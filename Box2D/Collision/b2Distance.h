@@ -90,6 +90,32 @@ void b2Distance(b2DistanceOutput* output,
 				b2SimplexCache* cache, 
 				const b2DistanceInput* input);
 
+/// Call and iteration counts of b2Distance and b2TimeOfImpact. These are the
+/// same statistics as the global counters b2_gjkCalls, b2_toiCalls and so on.
+struct b2CollisionCounters
+{
+	void SetZero();
+
+	/// Add the counts of other to these, keeping the larger maxima.
+	void Add(const b2CollisionCounters& other);
+
+	int32 gjkCalls, gjkIters, gjkMaxIters;
+	int32 toiCalls, toiIters, toiMaxIters;
+	int32 toiRootIters, toiMaxRootIters;
+};
+
+/// Make the calling thread count into counters instead of the global counters.
+/// Pass NULL to count into the global counters again. Tasks running on pool
+/// threads use this so they don't race on the globals, and the thread that
+/// called b2ThreadPool::Run adds their counts with b2AddGlobalCounters.
+void b2SetThreadCounters(b2CollisionCounters* counters);
+
+/// Get the counters of the calling thread, NULL if it uses the global counters.
+b2CollisionCounters* b2GetThreadCounters();
+
+/// Add counters to the global counters.
+void b2AddGlobalCounters(const b2CollisionCounters& counters);
+
 
 //////////////////////////////////////////////////////////////////////////
 
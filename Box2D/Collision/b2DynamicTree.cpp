@@ -107,12 +107,20 @@ void b2DynamicTree::FreeNode(int32 nodeId)
 // the node pool.
 int32 b2DynamicTree::CreateProxy(const b2AABB& aabb, void* userData)
 {
-	int32 proxyId = AllocateNode();
-
 	// Fatten the aabb.
+	b2AABB fatAABB;
 	b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
-	m_nodes[proxyId].aabb.lowerBound = aabb.lowerBound - r;
-	m_nodes[proxyId].aabb.upperBound = aabb.upperBound + r;
+	fatAABB.lowerBound = aabb.lowerBound - r;
+	fatAABB.upperBound = aabb.upperBound + r;
+
+	return CreateFatProxy(fatAABB, userData);
+}
+
+int32 b2DynamicTree::CreateFatProxy(const b2AABB& fatAABB, void* userData)
+{
+	int32 proxyId = AllocateNode();
+
+	m_nodes[proxyId].aabb = fatAABB;
 	m_nodes[proxyId].userData = userData;
 	m_nodes[proxyId].height = 0;
 
@@ -121,6 +129,37 @@ int32 b2DynamicTree::CreateProxy(const b2AABB& aabb, void* userData)
 	return proxyId;
 }
 
+void b2DynamicTree::CreateProxies(const b2AABB* aabbs, void* const* userData, int32 count, int32* proxyIds)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	int32* leaves = (int32*)b2Alloc(count * sizeof(int32));
+
+	b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
+	for (int32 i = 0; i < count; ++i)
+	{
+		int32 proxyId = AllocateNode();
+
+		// Fatten the aabb.
+		m_nodes[proxyId].aabb.lowerBound = aabbs[i].lowerBound - r;
+		m_nodes[proxyId].aabb.upperBound = aabbs[i].upperBound + r;
+		m_nodes[proxyId].userData = userData[i];
+		m_nodes[proxyId].height = 0;
+
+		proxyIds[i] = proxyId;
+		leaves[i] = proxyId;
+	}
+
+	// The subtree is inserted like a leaf. The walk back up fixes the heights.
+	int32 root = BuildTopDown(leaves, count);
+	InsertLeaf(root);
+
+	b2Free(leaves);
+}
+
 void b2DynamicTree::DestroyProxy(int32 proxyId)
 {
 	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
@@ -769,3 +808,230 @@ void b2DynamicTree::RebuildBottomUp()
 
 	Validate();
 }
+
+// Centroids are sorted into this many bins along the split axis.
+#define b2_treeBinCount 16
+
+// Build a subtree over the given leaves and return its root.
+int32 b2DynamicTree::BuildTopDown(int32* leaves, int32 count)
+{
+	if (count == 1)
+	{
+		return leaves[0];
+	}
+
+	// Split along the longest axis of the centroid bounds.
+	b2Vec2 lower = m_nodes[leaves[0]].aabb.GetCenter();
+	b2Vec2 upper = lower;
+	for (int32 i = 1; i < count; ++i)
+	{
+		b2Vec2 c = m_nodes[leaves[i]].aabb.GetCenter();
+		lower = b2Min(lower, c);
+		upper = b2Max(upper, c);
+	}
+
+	b2Vec2 extent = upper - lower;
+	int32 axis = extent.x >= extent.y ? 0 : 1;
+	float32 axisLower = axis == 0 ? lower.x : lower.y;
+	float32 axisExtent = axis == 0 ? extent.x : extent.y;
+
+	int32 splitCount = count / 2;
+	if (axisExtent > b2_epsilon)
+	{
+		b2AABB binAABBs[b2_treeBinCount];
+		int32 binCounts[b2_treeBinCount] = {0};
+		float32 scale = b2_treeBinCount / axisExtent;
+
+		for (int32 i = 0; i < count; ++i)
+		{
+			const b2AABB& aabb = m_nodes[leaves[i]].aabb;
+			b2Vec2 c = aabb.GetCenter();
+			int32 bin = b2Min(int32(((axis == 0 ? c.x : c.y) - axisLower) * scale), b2_treeBinCount - 1);
+			if (binCounts[bin] == 0)
+			{
+				binAABBs[bin] = aabb;
+			}
+			else
+			{
+				binAABBs[bin].Combine(aabb);
+			}
+			++binCounts[bin];
+		}
+
+		// Sweep from the right to get the cost of each right side.
+		float32 rightCosts[b2_treeBinCount];
+		b2AABB rightAABB;
+		rightAABB.lowerBound.SetZero();
+		rightAABB.upperBound.SetZero();
+		int32 rightCount = 0;
+		for (int32 i = b2_treeBinCount - 1; i > 0; --i)
+		{
+			if (binCounts[i] > 0)
+			{
+				if (rightCount == 0)
+				{
+					rightAABB = binAABBs[i];
+				}
+				else
+				{
+					rightAABB.Combine(binAABBs[i]);
+				}
+				rightCount += binCounts[i];
+			}
+			rightCosts[i] = rightCount > 0 ? rightCount * rightAABB.GetPerimeter() : 0.0f;
+		}
+
+		// Sweep from the left and pick the split with the smallest summed cost.
+		float32 minCost = b2_maxFloat;
+		int32 bestBin = -1;
+		b2AABB leftAABB;
+		leftAABB.lowerBound.SetZero();
+		leftAABB.upperBound.SetZero();
+		int32 leftCount = 0;
+		for (int32 i = 0; i < b2_treeBinCount - 1; ++i)
+		{
+			if (binCounts[i] > 0)
+			{
+				if (leftCount == 0)
+				{
+					leftAABB = binAABBs[i];
+				}
+				else
+				{
+					leftAABB.Combine(binAABBs[i]);
+				}
+				leftCount += binCounts[i];
+			}
+
+			if (leftCount == 0 || leftCount == count)
+			{
+				continue;
+			}
+
+			float32 cost = leftCount * leftAABB.GetPerimeter() + rightCosts[i + 1];
+			if (cost < minCost)
+			{
+				minCost = cost;
+				bestBin = i;
+			}
+		}
+
+		if (bestBin != -1)
+		{
+			// Partition the leaves in place.
+			int32 left = 0;
+			int32 right = count - 1;
+			while (left <= right)
+			{
+				b2Vec2 c = m_nodes[leaves[left]].aabb.GetCenter();
+				int32 bin = b2Min(int32(((axis == 0 ? c.x : c.y) - axisLower) * scale), b2_treeBinCount - 1);
+				if (bin <= bestBin)
+				{
+					++left;
+				}
+				else
+				{
+					b2Swap(leaves[left], leaves[right]);
+					--right;
+				}
+			}
+
+			splitCount = left;
+		}
+	}
+
+	int32 child1 = BuildTopDown(leaves, splitCount);
+	int32 child2 = BuildTopDown(leaves + splitCount, count - splitCount);
+
+	int32 parentIndex = AllocateNode();
+	b2TreeNode* parent = m_nodes + parentIndex;
+	parent->child1 = child1;
+	parent->child2 = child2;
+	parent->height = 1 + b2Max(m_nodes[child1].height, m_nodes[child2].height);
+	parent->aabb.Combine(m_nodes[child1].aabb, m_nodes[child2].aabb);
+	parent->parent = b2_nullNode;
+
+	m_nodes[child1].parent = parentIndex;
+	m_nodes[child2].parent = parentIndex;
+
+	return parentIndex;
+}
+
+void b2DynamicTree::RebuildTopDown()
+{
+	if (m_root == b2_nullNode)
+	{
+		return;
+	}
+
+	int32* leaves = (int32*)b2Alloc(m_nodeCount * sizeof(int32));
+	int32 count = 0;
+
+	// Build array of leaves. Free the rest.
+	for (int32 i = 0; i < m_nodeCapacity; ++i)
+	{
+		if (m_nodes[i].height < 0)
+		{
+			// free node in pool
+			continue;
+		}
+
+		if (m_nodes[i].IsLeaf())
+		{
+			m_nodes[i].parent = b2_nullNode;
+			leaves[count] = i;
+			++count;
+		}
+		else
+		{
+			FreeNode(i);
+		}
+	}
+
+	m_root = BuildTopDown(leaves, count);
+	m_nodes[m_root].parent = b2_nullNode;
+	b2Free(leaves);
+
+	Validate();
+}
+
+void b2DynamicTree::ShiftOrigin(const b2Vec2& newOrigin)
+{
+	// Build in place with the new origin.
+	for (int32 i = 0; i < m_nodeCapacity; ++i)
+	{
+		m_nodes[i].aabb.lowerBound -= newOrigin;
+		m_nodes[i].aabb.upperBound -= newOrigin;
+	}
+}
+
+void b2DynamicTree::Save(b2Snapshot* snapshot) const
+{
+	snapshot->Write(m_root);
+	snapshot->Write(m_nodeCount);
+	snapshot->Write(m_nodeCapacity);
+	snapshot->Write(m_freeList);
+	snapshot->Write(m_path);
+	snapshot->Write(m_insertionCount);
+	snapshot->Write(m_nodes, m_nodeCapacity * sizeof(b2TreeNode));
+}
+
+void b2DynamicTree::Restore(const b2Snapshot* snapshot)
+{
+	int32 nodeCapacity;
+	snapshot->Read(&m_root);
+	snapshot->Read(&m_nodeCount);
+	snapshot->Read(&nodeCapacity);
+	snapshot->Read(&m_freeList);
+	snapshot->Read(&m_path);
+	snapshot->Read(&m_insertionCount);
+
+	if (nodeCapacity != m_nodeCapacity)
+	{
+		b2Free(m_nodes);
+		m_nodeCapacity = nodeCapacity;
+		m_nodes = (b2TreeNode*)b2Alloc(m_nodeCapacity * sizeof(b2TreeNode));
+	}
+
+	memcpy(m_nodes, snapshot->Read(m_nodeCapacity * sizeof(b2TreeNode)), m_nodeCapacity * sizeof(b2TreeNode));
+}
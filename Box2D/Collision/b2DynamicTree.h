@@ -21,6 +21,8 @@
 
 #include <Box2D/Collision/b2Collision.h>
 #include <Box2D/Common/b2GrowableStack.h>
+#include <Box2D/Common/b2Simd.h>
+#include <Box2D/Common/b2Snapshot.h>
 
 #define b2_nullNode (-1)
 
@@ -70,6 +72,17 @@ public:
 	/// Create a proxy. Provide a tight fitting AABB and a userData pointer.
 	int32 CreateProxy(const b2AABB& aabb, void* userData);
 
+	/// Create a proxy with an AABB that is already fattened, such as the fat AABB
+	/// of a proxy that moves over from another tree.
+	int32 CreateFatProxy(const b2AABB& fatAABB, void* userData);
+
+	/// Create many proxies at once. The new leaves are built into a subtree with
+	/// the heuristic of RebuildTopDown, which is then inserted like a single leaf.
+	/// This works best when the proxies are close together or outnumber the
+	/// proxies already in the tree.
+	/// @param proxyIds receives the ids of the new proxies.
+	void CreateProxies(const b2AABB* aabbs, void* const* userData, int32 count, int32* proxyIds);
+
 	/// Destroy a proxy. This asserts if the id is invalid.
 	void DestroyProxy(int32 proxyId);
 
@@ -91,6 +104,13 @@ public:
 	template <typename T>
 	void Query(T* callback, const b2AABB& aabb) const;
 
+	/// Query up to b2_simdWidth AABBs with a single walk of the tree. Each node is
+	/// tested against all of them at once. The callback class is called with the
+	/// index of the query AABB for each overlapping proxy:
+	/// bool QueryCallback(int32 index, int32 proxyId).
+	template <typename T>
+	void QueryBatch(T* callback, const b2AABB* aabbs, int32 count) const;
+
 	/// Ray-cast against the proxies in the tree. This relies on the callback
 	/// to perform a exact ray-cast in the case were the proxy contains a shape.
 	/// The callback also performs the any collision filtering. This has performance
@@ -118,6 +138,22 @@ public:
 	/// Build an optimal tree. Very expensive. For testing.
 	void RebuildBottomUp();
 
+	/// Build the tree from scratch with a binned surface area heuristic in
+	/// O(n log n) time. This suits proxies that rarely move, such as static
+	/// geometry. Proxy ids are kept.
+	void RebuildTopDown();
+
+	/// Shift the world origin. Useful for large worlds.
+	/// The shift formula is: position -= newOrigin
+	/// @param newOrigin the new origin with respect to the old origin
+	void ShiftOrigin(const b2Vec2& newOrigin);
+
+	/// Write the tree to a snapshot. The user data is written as is.
+	void Save(b2Snapshot* snapshot) const;
+
+	/// Replace the tree with one read from a snapshot.
+	void Restore(const b2Snapshot* snapshot);
+
 private:
 
 	int32 AllocateNode();
@@ -128,6 +164,8 @@ private:
 
 	int32 Balance(int32 index);
 
+	int32 BuildTopDown(int32* leaves, int32 count);
+
 	int32 ComputeHeight() const;
 	int32 ComputeHeight(int32 nodeId) const;
 
@@ -195,6 +233,80 @@ inline void b2DynamicTree::Query(T* callback, const b2AABB& aabb) const
 	}
 }
 
+template <typename T>
+inline void b2DynamicTree::QueryBatch(T* callback, const b2AABB* aabbs, int32 count) const
+{
+	b2Assert(0 < count && count <= b2_simdWidth);
+
+	// Unused lanes get an inverted box that overlaps nothing.
+	float32 lowerX[b2_simdWidth], lowerY[b2_simdWidth];
+	float32 upperX[b2_simdWidth], upperY[b2_simdWidth];
+	for (int32 i = 0; i < b2_simdWidth; ++i)
+	{
+		if (i < count)
+		{
+			lowerX[i] = aabbs[i].lowerBound.x;
+			lowerY[i] = aabbs[i].lowerBound.y;
+			upperX[i] = aabbs[i].upperBound.x;
+			upperY[i] = aabbs[i].upperBound.y;
+		}
+		else
+		{
+			lowerX[i] = lowerY[i] = b2_maxFloat;
+			upperX[i] = upperY[i] = -b2_maxFloat;
+		}
+	}
+
+	b2FloatW queryLowerX = b2LoadW(lowerX), queryLowerY = b2LoadW(lowerY);
+	b2FloatW queryUpperX = b2LoadW(upperX), queryUpperY = b2LoadW(upperY);
+
+	b2GrowableStack<int32, 256> stack;
+	stack.Push(m_root);
+
+	while (stack.GetCount() > 0)
+	{
+		int32 nodeId = stack.Pop();
+		if (nodeId == b2_nullNode)
+		{
+			continue;
+		}
+
+		const b2TreeNode* node = m_nodes + nodeId;
+
+		// Same test as b2TestOverlap, for every query at once.
+		b2FloatW overlap = b2GreaterEqualW(b2SplatW(node->aabb.upperBound.x), queryLowerX);
+		overlap = b2AndW(overlap, b2GreaterEqualW(b2SplatW(node->aabb.upperBound.y), queryLowerY));
+		overlap = b2AndW(overlap, b2GreaterEqualW(queryUpperX, b2SplatW(node->aabb.lowerBound.x)));
+		overlap = b2AndW(overlap, b2GreaterEqualW(queryUpperY, b2SplatW(node->aabb.lowerBound.y)));
+
+		int32 mask = b2MaskBitsW(overlap);
+		if (mask == 0)
+		{
+			continue;
+		}
+
+		if (node->IsLeaf())
+		{
+			for (int32 i = 0; i < count; ++i)
+			{
+				if (mask & (1 << i))
+				{
+					bool proceed = callback->QueryCallback(i, nodeId);
+					if (proceed == false)
+					{
+						return;
+					}
+				}
+			}
+		}
+		else
+		{
+			stack.Push(node->child1);
+			stack.Push(node->child2);
+		}
+	}
+}
+
 template <typename T>
 inline void b2DynamicTree::RayCast(T* callback, const b2RayCastInput& input) const
 {
@@ -256,8 +256,6 @@ struct b2SeparationFunction
 // by computing the largest time at which separation is maintained.
 void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 {
-	++b2_toiCalls;
-
 	output->state = b2TOIOutput::e_unknown;
 	output->t = input->tMax;
 
@@ -282,6 +280,8 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 	float32 t1 = 0.0f;
 	const int32 k_maxIterations = 20;	// TODO_ERIN b2Settings
 	int32 iter = 0;
+	int32 rootIters = 0;
+	int32 maxRootIters = 0;
 
 	// Prepare input for distance query.
 	b2SimplexCache cache;
@@ -444,7 +444,7 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 				}
 
 				++rootIterCount;
-				++b2_toiRootIters;
+				++rootIters;
 
 				if (rootIterCount == 50)
 				{
@@ -452,7 +452,7 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 				}
 			}
 
-			b2_toiMaxRootIters = b2Max(b2_toiMaxRootIters, rootIterCount);
+			maxRootIters = b2Max(maxRootIters, rootIterCount);
 
 			++pushBackIter;
 
@@ -463,7 +463,6 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 		}
 
 		++iter;
-		++b2_toiIters;
 
 		if (done)
 		{
@@ -479,5 +478,21 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 		}
 	}
 
-	b2_toiMaxIters = b2Max(b2_toiMaxIters, iter);
+	b2CollisionCounters* counters = b2GetThreadCounters();
+	if (counters)
+	{
+		++counters->toiCalls;
+		counters->toiIters += iter;
+		counters->toiMaxIters = b2Max(counters->toiMaxIters, iter);
+		counters->toiRootIters += rootIters;
+		counters->toiMaxRootIters = b2Max(counters->toiMaxRootIters, maxRootIters);
+	}
+	else
+	{
+		++b2_toiCalls;
+		b2_toiIters += iter;
+		b2_toiMaxIters = b2Max(b2_toiMaxIters, iter);
+		b2_toiRootIters += rootIters;
+		b2_toiMaxRootIters = b2Max(b2_toiMaxRootIters, maxRootIters);
+	}
 }
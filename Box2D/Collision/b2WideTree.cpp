@@ -0,0 +1,827 @@
+/*
+* Copyright (c) 2013 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Collision/b2WideTree.h>
+#include <cstring>
+using namespace std;
+
+b2WideTree::b2WideTree()
+{
+	m_root = b2_nullNode;
+
+	m_nodeCapacity = 16;
+	m_nodeCount = 0;
+	m_nodes = (b2WideTreeNode*)b2Alloc(m_nodeCapacity * sizeof(b2WideTreeNode));
+	memset(m_nodes, 0, m_nodeCapacity * sizeof(b2WideTreeNode));
+
+	// Build a linked list for the free list.
+	for (int32 i = 0; i < m_nodeCapacity - 1; ++i)
+	{
+		m_nodes[i].next = i + 1;
+		m_nodes[i].height = -1;
+	}
+	m_nodes[m_nodeCapacity-1].next = b2_nullNode;
+	m_nodes[m_nodeCapacity-1].height = -1;
+	m_freeNode = 0;
+
+	m_proxyCapacity = 16;
+	m_proxyCount = 0;
+	m_proxies = (b2WideTreeProxy*)b2Alloc(m_proxyCapacity * sizeof(b2WideTreeProxy));
+
+	for (int32 i = 0; i < m_proxyCapacity; ++i)
+	{
+		m_proxies[i].aabb.lowerBound.SetZero();
+		m_proxies[i].aabb.upperBound.SetZero();
+		m_proxies[i].userData = NULL;
+		m_proxies[i].next = i + 1;
+		m_proxies[i].slot = -1;
+	}
+	m_proxies[m_proxyCapacity-1].next = b2_nullNode;
+	m_freeProxy = 0;
+}
+
+b2WideTree::~b2WideTree()
+{
+	// This frees the entire tree in one shot.
+	b2Free(m_nodes);
+	b2Free(m_proxies);
+}
+
+// Allocate a node from the pool. Grow the pool if necessary.
+int32 b2WideTree::AllocateNode()
+{
+	// Expand the node pool as needed.
+	if (m_freeNode == b2_nullNode)
+	{
+		b2Assert(m_nodeCount == m_nodeCapacity);
+
+		// The free list is empty. Rebuild a bigger pool.
+		b2WideTreeNode* oldNodes = m_nodes;
+		m_nodeCapacity *= 2;
+		m_nodes = (b2WideTreeNode*)b2Alloc(m_nodeCapacity * sizeof(b2WideTreeNode));
+		memcpy(m_nodes, oldNodes, m_nodeCount * sizeof(b2WideTreeNode));
+		b2Free(oldNodes);
+
+		// Build a linked list for the free list. The parent
+		// index becomes the "next" index.
+		for (int32 i = m_nodeCount; i < m_nodeCapacity - 1; ++i)
+		{
+			m_nodes[i].next = i + 1;
+			m_nodes[i].height = -1;
+		}
+		m_nodes[m_nodeCapacity-1].next = b2_nullNode;
+		m_nodes[m_nodeCapacity-1].height = -1;
+		m_freeNode = m_nodeCount;
+	}
+
+	// Peel a node off the free list.
+	int32 nodeId = m_freeNode;
+	m_freeNode = m_nodes[nodeId].next;
+	m_nodes[nodeId].parent = b2_nullNode;
+	m_nodes[nodeId].slot = -1;
+	m_nodes[nodeId].count = 0;
+	m_nodes[nodeId].height = 1;
+	for (int32 i = 0; i < b2_wideTreeWidth; ++i)
+	{
+		ClearChild(nodeId, i);
+	}
+	++m_nodeCount;
+	return nodeId;
+}
+
+// Return a node to the pool.
+void b2WideTree::FreeNode(int32 nodeId)
+{
+	b2Assert(0 <= nodeId && nodeId < m_nodeCapacity);
+	b2Assert(0 < m_nodeCount);
+	m_nodes[nodeId].next = m_freeNode;
+	m_nodes[nodeId].height = -1;
+	m_freeNode = nodeId;
+	--m_nodeCount;
+}
+
+// Allocate a proxy from the pool. Grow the pool if necessary.
+int32 b2WideTree::AllocateProxy()
+{
+	if (m_freeProxy == b2_nullNode)
+	{
+		b2Assert(m_proxyCount == m_proxyCapacity);
+
+		b2WideTreeProxy* oldProxies = m_proxies;
+		m_proxyCapacity *= 2;
+		m_proxies = (b2WideTreeProxy*)b2Alloc(m_proxyCapacity * sizeof(b2WideTreeProxy));
+		memcpy(m_proxies, oldProxies, m_proxyCount * sizeof(b2WideTreeProxy));
+		b2Free(oldProxies);
+
+		for (int32 i = m_proxyCount; i < m_proxyCapacity - 1; ++i)
+		{
+			m_proxies[i].next = i + 1;
+			m_proxies[i].slot = -1;
+		}
+		m_proxies[m_proxyCapacity-1].next = b2_nullNode;
+		m_proxies[m_proxyCapacity-1].slot = -1;
+		m_freeProxy = m_proxyCount;
+	}
+
+	int32 proxyId = m_freeProxy;
+	m_freeProxy = m_proxies[proxyId].next;
+	m_proxies[proxyId].parent = b2_nullNode;
+	m_proxies[proxyId].slot = -1;
+	m_proxies[proxyId].userData = NULL;
+	++m_proxyCount;
+	return proxyId;
+}
+
+// Return a proxy to the pool.
+void b2WideTree::FreeProxy(int32 proxyId)
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	b2Assert(0 < m_proxyCount);
+	m_proxies[proxyId].next = m_freeProxy;
+	m_proxies[proxyId].slot = -1;
+	m_freeProxy = proxyId;
+	--m_proxyCount;
+}
+
+int32 b2WideTree::CreateProxy(const b2AABB& aabb, void* userData)
+{
+	// Fatten the aabb.
+	b2AABB fatAABB;
+	b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
+	fatAABB.lowerBound = aabb.lowerBound - r;
+	fatAABB.upperBound = aabb.upperBound + r;
+
+	return CreateFatProxy(fatAABB, userData);
+}
+
+int32 b2WideTree::CreateFatProxy(const b2AABB& fatAABB, void* userData)
+{
+	int32 proxyId = AllocateProxy();
+
+	m_proxies[proxyId].aabb = fatAABB;
+	m_proxies[proxyId].userData = userData;
+
+	InsertLeaf(proxyId);
+
+	return proxyId;
+}
+
+void b2WideTree::CreateProxies(const b2AABB* aabbs, void* const* userData, int32 count, int32* proxyIds)
+{
+	for (int32 i = 0; i < count; ++i)
+	{
+		proxyIds[i] = CreateProxy(aabbs[i], userData[i]);
+	}
+}
+
+void b2WideTree::DestroyProxy(int32 proxyId)
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	b2Assert(m_proxies[proxyId].slot != -1);
+
+	RemoveLeaf(proxyId);
+	FreeProxy(proxyId);
+}
+
+bool b2WideTree::MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& displacement)
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	b2Assert(m_proxies[proxyId].slot != -1);
+
+	if (m_proxies[proxyId].aabb.Contains(aabb))
+	{
+		return false;
+	}
+
+	RemoveLeaf(proxyId);
+
+	// Extend AABB.
+	b2AABB b = aabb;
+	b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
+	b.lowerBound = b.lowerBound - r;
+	b.upperBound = b.upperBound + r;
+
+	// Predict AABB displacement.
+	b2Vec2 d = b2_aabbMultiplier * displacement;
+
+	if (d.x < 0.0f)
+	{
+		b.lowerBound.x += d.x;
+	}
+	else
+	{
+		b.upperBound.x += d.x;
+	}
+
+	if (d.y < 0.0f)
+	{
+		b.lowerBound.y += d.y;
+	}
+	else
+	{
+		b.upperBound.y += d.y;
+	}
+
+	m_proxies[proxyId].aabb = b;
+
+	InsertLeaf(proxyId);
+	return true;
+}
+
+void b2WideTree::SetChild(int32 index, int32 slot, int32 child, const b2AABB& aabb)
+{
+	b2WideTreeNode* node = m_nodes + index;
+	node->children[slot] = child;
+	node->lowerX[slot] = aabb.lowerBound.x;
+	node->lowerY[slot] = aabb.lowerBound.y;
+	node->upperX[slot] = aabb.upperBound.x;
+	node->upperY[slot] = aabb.upperBound.y;
+
+	if (IsProxy(child))
+	{
+		b2WideTreeProxy* proxy = m_proxies + DecodeProxy(child);
+		proxy->parent = index;
+		proxy->slot = slot;
+	}
+	else
+	{
+		m_nodes[child].parent = index;
+		m_nodes[child].slot = slot;
+	}
+}
+
+void b2WideTree::ClearChild(int32 index, int32 slot)
+{
+	b2WideTreeNode* node = m_nodes + index;
+	node->children[slot] = b2_nullNode;
+	node->lowerX[slot] = b2_maxFloat;
+	node->lowerY[slot] = b2_maxFloat;
+	node->upperX[slot] = -b2_maxFloat;
+	node->upperY[slot] = -b2_maxFloat;
+}
+
+// Remove a child, keeping the occupied slots packed at the front.
+void b2WideTree::RemoveChild(int32 index, int32 slot)
+{
+	b2WideTreeNode* node = m_nodes + index;
+	b2Assert(0 <= slot && slot < node->count);
+
+	int32 last = node->count - 1;
+	if (slot != last)
+	{
+		SetChild(index, slot, node->children[last], GetChildAABB(index, last));
+	}
+
+	ClearChild(index, last);
+	--node->count;
+}
+
+b2AABB b2WideTree::GetChildAABB(int32 index, int32 slot) const
+{
+	const b2WideTreeNode* node = m_nodes + index;
+	b2AABB aabb;
+	aabb.lowerBound.Set(node->lowerX[slot], node->lowerY[slot]);
+	aabb.upperBound.Set(node->upperX[slot], node->upperY[slot]);
+	return aabb;
+}
+
+b2AABB b2WideTree::ComputeAABB(int32 index) const
+{
+	const b2WideTreeNode* node = m_nodes + index;
+	b2Assert(node->count > 0);
+
+	b2AABB aabb = GetChildAABB(index, 0);
+	for (int32 i = 1; i < node->count; ++i)
+	{
+		aabb.Combine(GetChildAABB(index, i));
+	}
+	return aabb;
+}
+
+// Walk back up the tree fixing the child boxes of the ancestors.
+void b2WideTree::Refit(int32 index)
+{
+	while (m_nodes[index].parent != b2_nullNode)
+	{
+		int32 parent = m_nodes[index].parent;
+		int32 slot = m_nodes[index].slot;
+		b2AABB aabb = ComputeAABB(index);
+
+		b2WideTreeNode* node = m_nodes + parent;
+		node->lowerX[slot] = aabb.lowerBound.x;
+		node->lowerY[slot] = aabb.lowerBound.y;
+		node->upperX[slot] = aabb.upperBound.x;
+		node->upperY[slot] = aabb.upperBound.y;
+
+		index = parent;
+	}
+}
+
+// Pick the child whose box grows the least to hold the AABB. Ties go to the smaller child.
+int32 b2WideTree::ChooseChild(int32 index, const b2AABB& aabb) const
+{
+	const b2WideTreeNode* node = m_nodes + index;
+	b2Assert(node->count > 0);
+
+	int32 bestSlot = 0;
+	float32 bestCost = b2_maxFloat;
+	float32 bestPerimeter = b2_maxFloat;
+	for (int32 i = 0; i < node->count; ++i)
+	{
+		b2AABB childAABB = GetChildAABB(index, i);
+		float32 perimeter = childAABB.GetPerimeter();
+
+		b2AABB combinedAABB;
+		combinedAABB.Combine(childAABB, aabb);
+		float32 cost = combinedAABB.GetPerimeter() - perimeter;
+
+		if (cost < bestCost || (cost == bestCost && perimeter < bestPerimeter))
+		{
+			bestSlot = i;
+			bestCost = cost;
+			bestPerimeter = perimeter;
+		}
+	}
+
+	return node->children[bestSlot];
+}
+
+// Split a full node to make room for one more child. The children are sorted
+// along the axis where their centers spread the most and cut where the two
+// halves have the smallest total perimeter. Returns the new sibling.
+int32 b2WideTree::Split(int32 index, int32 child, const b2AABB& aabb)
+{
+	const int32 count = b2_wideTreeWidth + 1;
+	int32 children[count];
+	b2AABB aabbs[count];
+
+	for (int32 i = 0; i < b2_wideTreeWidth; ++i)
+	{
+		children[i] = m_nodes[index].children[i];
+		aabbs[i] = GetChildAABB(index, i);
+	}
+	children[b2_wideTreeWidth] = child;
+	aabbs[b2_wideTreeWidth] = aabb;
+
+	b2Vec2 lower = aabbs[0].GetCenter();
+	b2Vec2 upper = lower;
+	for (int32 i = 1; i < count; ++i)
+	{
+		b2Vec2 c = aabbs[i].GetCenter();
+		lower = b2Min(lower, c);
+		upper = b2Max(upper, c);
+	}
+
+	int32 axis = (upper.x - lower.x) >= (upper.y - lower.y) ? 0 : 1;
+
+	// Insertion sort on the centers.
+	for (int32 i = 1; i < count; ++i)
+	{
+		int32 c = children[i];
+		b2AABB b = aabbs[i];
+		float32 key = b.lowerBound(axis) + b.upperBound(axis);
+
+		int32 j = i - 1;
+		while (j >= 0 && aabbs[j].lowerBound(axis) + aabbs[j].upperBound(axis) > key)
+		{
+			children[j + 1] = children[j];
+			aabbs[j + 1] = aabbs[j];
+			--j;
+		}
+		children[j + 1] = c;
+		aabbs[j + 1] = b;
+	}
+
+	// Both halves keep at least two children.
+	int32 bestSplit = 2;
+	float32 bestCost = b2_maxFloat;
+	for (int32 split = 2; split <= count - 2; ++split)
+	{
+		b2AABB left = aabbs[0];
+		for (int32 i = 1; i < split; ++i)
+		{
+			left.Combine(aabbs[i]);
+		}
+
+		b2AABB right = aabbs[split];
+		for (int32 i = split + 1; i < count; ++i)
+		{
+			right.Combine(aabbs[i]);
+		}
+
+		float32 cost = left.GetPerimeter() + right.GetPerimeter();
+		if (cost < bestCost)
+		{
+			bestSplit = split;
+			bestCost = cost;
+		}
+	}
+
+	// This may move the node pool.
+	int32 sibling = AllocateNode();
+	m_nodes[sibling].height = m_nodes[index].height;
+
+	for (int32 i = 0; i < b2_wideTreeWidth; ++i)
+	{
+		ClearChild(index, i);
+	}
+
+	for (int32 i = 0; i < bestSplit; ++i)
+	{
+		SetChild(index, i, children[i], aabbs[i]);
+	}
+	m_nodes[index].count = bestSplit;
+
+	for (int32 i = bestSplit; i < count; ++i)
+	{
+		SetChild(sibling, i - bestSplit, children[i], aabbs[i]);
+	}
+	m_nodes[sibling].count = count - bestSplit;
+
+	return sibling;
+}
+
+// Add a child to a node, splitting full nodes on the way back up to the root.
+void b2WideTree::InsertChild(int32 index, int32 child, const b2AABB& aabb)
+{
+	b2AABB childAABB = aabb;
+	for (;;)
+	{
+		b2WideTreeNode* node = m_nodes + index;
+		if (node->count < b2_wideTreeWidth)
+		{
+			SetChild(index, node->count, child, childAABB);
+			++node->count;
+			Refit(index);
+			return;
+		}
+
+		int32 sibling = Split(index, child, childAABB);
+		int32 parent = m_nodes[index].parent;
+
+		if (parent == b2_nullNode)
+		{
+			// The root was split, grow the tree by one level.
+			int32 root = AllocateNode();
+			m_nodes[root].height = m_nodes[index].height + 1;
+			SetChild(root, 0, index, ComputeAABB(index));
+			SetChild(root, 1, sibling, ComputeAABB(sibling));
+			m_nodes[root].count = 2;
+			m_root = root;
+			return;
+		}
+
+		// The node lost children, so shrink its box before the sibling goes into the parent.
+		b2AABB nodeAABB = ComputeAABB(index);
+		SetChild(parent, m_nodes[index].slot, index, nodeAABB);
+
+		child = sibling;
+		childAABB = ComputeAABB(sibling);
+		index = parent;
+	}
+}
+
+// Insert a proxy (height 0) or a detached node so that it stays at its height.
+void b2WideTree::InsertAtLevel(int32 child, int32 height)
+{
+	b2AABB aabb;
+	if (IsProxy(child))
+	{
+		aabb = m_proxies[DecodeProxy(child)].aabb;
+	}
+	else
+	{
+		aabb = ComputeAABB(child);
+	}
+
+	if (m_root == b2_nullNode)
+	{
+		b2Assert(height == 0);
+		m_root = AllocateNode();
+		SetChild(m_root, 0, child, aabb);
+		m_nodes[m_root].count = 1;
+		return;
+	}
+
+	b2Assert(height < m_nodes[m_root].height);
+
+	int32 index = m_root;
+	while (m_nodes[index].height > height + 1)
+	{
+		index = ChooseChild(index, aabb);
+	}
+
+	InsertChild(index, child, aabb);
+}
+
+void b2WideTree::InsertLeaf(int32 proxyId)
+{
+	InsertAtLevel(EncodeProxy(proxyId), 0);
+
+	//Validate();
+}
+
+void b2WideTree::RemoveLeaf(int32 proxyId)
+{
+	int32 index = m_proxies[proxyId].parent;
+	RemoveChild(index, m_proxies[proxyId].slot);
+
+	// Dissolve the nodes that are left with a single child and keep those children
+	// to insert them again. There is at most one per level and with two or more
+	// children per node the tree is never taller than 32 levels.
+	int32 orphans[32];
+	int32 orphanCount = 0;
+
+	while (index != m_root)
+	{
+		int32 parent = m_nodes[index].parent;
+		int32 slot = m_nodes[index].slot;
+
+		if (m_nodes[index].count < 2)
+		{
+			b2Assert(m_nodes[index].count == 1);
+			b2Assert(orphanCount < 32);
+			orphans[orphanCount++] = m_nodes[index].children[0];
+			RemoveChild(parent, slot);
+			FreeNode(index);
+		}
+		else
+		{
+			SetChild(parent, slot, index, ComputeAABB(index));
+		}
+
+		index = parent;
+	}
+
+	b2WideTreeNode* root = m_nodes + m_root;
+	if (root->count == 0)
+	{
+		b2Assert(orphanCount == 0);
+		FreeNode(m_root);
+		m_root = b2_nullNode;
+	}
+	else if (root->count == 1 && root->height > 1)
+	{
+		// Shrink the tree by one level.
+		int32 oldRoot = m_root;
+		m_root = root->children[0];
+		m_nodes[m_root].parent = b2_nullNode;
+		m_nodes[m_root].slot = -1;
+		FreeNode(oldRoot);
+	}
+
+	// Orphans were collected bottom up, so the ones deeper in the tree go in first.
+	for (int32 i = 0; i < orphanCount; ++i)
+	{
+		int32 child = orphans[i];
+		int32 height = IsProxy(child) ? 0 : m_nodes[child].height;
+		InsertAtLevel(child, height);
+	}
+
+	//Validate();
+}
+
+int32 b2WideTree::GetHeight() const
+{
+	if (m_root == b2_nullNode)
+	{
+		return 0;
+	}
+
+	return m_nodes[m_root].height;
+}
+
+int32 b2WideTree::GetMaxBalance() const
+{
+	int32 maxBalance = 0;
+	for (int32 i = 0; i < m_nodeCapacity; ++i)
+	{
+		const b2WideTreeNode* node = m_nodes + i;
+		if (node->height <= 1)
+		{
+			// Free node or a parent of leaves only.
+			continue;
+		}
+
+		int32 minHeight = node->height;
+		int32 maxHeight = 0;
+		for (int32 j = 0; j < node->count; ++j)
+		{
+			int32 child = node->children[j];
+			int32 height = IsProxy(child) ? 0 : m_nodes[child].height;
+			minHeight = b2Min(minHeight, height);
+			maxHeight = b2Max(maxHeight, height);
+		}
+
+		maxBalance = b2Max(maxBalance, maxHeight - minHeight);
+	}
+
+	return maxBalance;
+}
+
+float32 b2WideTree::GetAreaRatio() const
+{
+	if (m_root == b2_nullNode)
+	{
+		return 0.0f;
+	}
+
+	float32 rootArea = ComputeAABB(m_root).GetPerimeter();
+
+	// Every node and proxy box is stored once in its parent, plus the root.
+	float32 totalArea = rootArea;
+	for (int32 i = 0; i < m_nodeCapacity; ++i)
+	{
+		const b2WideTreeNode* node = m_nodes + i;
+		if (node->height < 0)
+		{
+			// Free node in pool
+			continue;
+		}
+
+		for (int32 j = 0; j < node->count; ++j)
+		{
+			totalArea += GetChildAABB(i, j).GetPerimeter();
+		}
+	}
+
+	return totalArea / rootArea;
+}
+
+// Check the links and boxes of a sub-tree. Returns the number of proxies in it.
+int32 b2WideTree::ValidateStructure(int32 index) const
+{
+	const b2WideTreeNode* node = m_nodes + index;
+
+	if (index == m_root)
+	{
+		b2Assert(node->parent == b2_nullNode);
+		b2Assert(node->count >= 1);
+	}
+	else
+	{
+		b2Assert(node->count >= 2);
+		b2AABB aabb = ComputeAABB(index);
+		b2AABB stored = GetChildAABB(node->parent, node->slot);
+		b2Assert(aabb.lowerBound == stored.lowerBound);
+		b2Assert(aabb.upperBound == stored.upperBound);
+		B2_NOT_USED(aabb);
+		B2_NOT_USED(stored);
+	}
+
+	int32 proxyCount = 0;
+	for (int32 i = 0; i < b2_wideTreeWidth; ++i)
+	{
+		int32 child = node->children[i];
+		if (i >= node->count)
+		{
+			b2Assert(child == b2_nullNode);
+			b2Assert(node->lowerX[i] == b2_maxFloat && node->upperX[i] == -b2_maxFloat);
+			continue;
+		}
+
+		if (IsProxy(child))
+		{
+			int32 proxyId = DecodeProxy(child);
+			b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+			const b2WideTreeProxy* proxy = m_proxies + proxyId;
+			b2Assert(node->height == 1);
+			b2Assert(proxy->parent == index && proxy->slot == i);
+			b2Assert(proxy->aabb.lowerBound.x == node->lowerX[i] && proxy->aabb.upperBound.y == node->upperY[i]);
+			B2_NOT_USED(proxy);
+			++proxyCount;
+		}
+		else
+		{
+			b2Assert(0 <= child && child < m_nodeCapacity);
+			b2Assert(m_nodes[child].height == node->height - 1);
+			b2Assert(m_nodes[child].parent == index && m_nodes[child].slot == i);
+			proxyCount += ValidateStructure(child);
+		}
+	}
+
+	return proxyCount;
+}
+
+void b2WideTree::Validate() const
+{
+	if (m_root == b2_nullNode)
+	{
+		b2Assert(m_proxyCount == 0);
+		b2Assert(m_nodeCount == 0);
+		return;
+	}
+
+	int32 proxyCount = ValidateStructure(m_root);
+	b2Assert(proxyCount == m_proxyCount);
+	B2_NOT_USED(proxyCount);
+
+	int32 freeCount = 0;
+	int32 freeIndex = m_freeNode;
+	while (freeIndex != b2_nullNode)
+	{
+		b2Assert(0 <= freeIndex && freeIndex < m_nodeCapacity);
+		freeIndex = m_nodes[freeIndex].next;
+		++freeCount;
+	}
+
+	b2Assert(m_nodeCount + freeCount == m_nodeCapacity);
+}
+
+void b2WideTree::ShiftOrigin(const b2Vec2& newOrigin)
+{
+	for (int32 i = 0; i < m_nodeCapacity; ++i)
+	{
+		b2WideTreeNode* node = m_nodes + i;
+		if (node->height < 0)
+		{
+			continue;
+		}
+
+		// Empty slots keep their inverted box.
+		for (int32 j = 0; j < b2_wideTreeWidth; ++j)
+		{
+			if (node->children[j] == b2_nullNode)
+			{
+				continue;
+			}
+
+			node->lowerX[j] -= newOrigin.x;
+			node->lowerY[j] -= newOrigin.y;
+			node->upperX[j] -= newOrigin.x;
+			node->upperY[j] -= newOrigin.y;
+		}
+	}
+
+	for (int32 i = 0; i < m_proxyCapacity; ++i)
+	{
+		if (m_proxies[i].slot == -1)
+		{
+			continue;
+		}
+
+		m_proxies[i].aabb.lowerBound -= newOrigin;
+		m_proxies[i].aabb.upperBound -= newOrigin;
+	}
+}
+
+void b2WideTree::Save(b2Snapshot* snapshot) const
+{
+	snapshot->Write(m_root);
+	snapshot->Write(m_nodeCount);
+	snapshot->Write(m_nodeCapacity);
+	snapshot->Write(m_freeNode);
+	snapshot->Write(m_nodes, m_nodeCapacity * sizeof(b2WideTreeNode));
+
+	snapshot->Write(m_proxyCount);
+	snapshot->Write(m_proxyCapacity);
+	snapshot->Write(m_freeProxy);
+	snapshot->Write(m_proxies, m_proxyCapacity * sizeof(b2WideTreeProxy));
+}
+
+void b2WideTree::Restore(const b2Snapshot* snapshot)
+{
+	int32 nodeCapacity;
+	snapshot->Read(&m_root);
+	snapshot->Read(&m_nodeCount);
+	snapshot->Read(&nodeCapacity);
+	snapshot->Read(&m_freeNode);
+
+	if (nodeCapacity != m_nodeCapacity)
+	{
+		b2Free(m_nodes);
+		m_nodeCapacity = nodeCapacity;
+		m_nodes = (b2WideTreeNode*)b2Alloc(m_nodeCapacity * sizeof(b2WideTreeNode));
+	}
+
+	memcpy(m_nodes, snapshot->Read(m_nodeCapacity * sizeof(b2WideTreeNode)), m_nodeCapacity * sizeof(b2WideTreeNode));
+
+	int32 proxyCapacity;
+	snapshot->Read(&m_proxyCount);
+	snapshot->Read(&proxyCapacity);
+	snapshot->Read(&m_freeProxy);
+
+	if (proxyCapacity != m_proxyCapacity)
+	{
+		b2Free(m_proxies);
+		m_proxyCapacity = proxyCapacity;
+		m_proxies = (b2WideTreeProxy*)b2Alloc(m_proxyCapacity * sizeof(b2WideTreeProxy));
+	}
+
+	memcpy(m_proxies, snapshot->Read(m_proxyCapacity * sizeof(b2WideTreeProxy)), m_proxyCapacity * sizeof(b2WideTreeProxy));
+}
@@ -0,0 +1,425 @@
+/*
+* Copyright (c) 2013 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_WIDE_TREE_H
+#define B2_WIDE_TREE_H
+
+#include <Box2D/Collision/b2DynamicTree.h>
+
+#define b2_wideTreeWidth	4
+
+/// A node in the wide tree. The child AABBs are stored as four-wide arrays so that
+/// all of them are tested with one SIMD compare. The client does not interact with this directly.
+struct b2WideTreeNode
+{
+	/// Child AABBs. Empty slots hold an inverted box that overlaps nothing.
+	float32 lowerX[b2_wideTreeWidth];
+	float32 lowerY[b2_wideTreeWidth];
+	float32 upperX[b2_wideTreeWidth];
+	float32 upperY[b2_wideTreeWidth];
+
+	/// Child node indices or encoded proxy ids, see b2WideTree::IsProxy.
+	int32 children[b2_wideTreeWidth];
+
+	union
+	{
+		int32 parent;
+		int32 next;
+	};
+
+	/// The slot of this node in its parent.
+	int32 slot;
+
+	int32 count;
+
+	// The parent of a leaf is 1, free node = -1
+	int32 height;
+};
+
+/// A proxy in the wide tree. The client does not interact with this directly.
+struct b2WideTreeProxy
+{
+	/// Enlarged AABB
+	b2AABB aabb;
+
+	void* userData;
+
+	union
+	{
+		int32 parent;
+		int32 next;
+	};
+
+	/// The slot of this proxy in its parent, free proxy = -1
+	int32 slot;
+};
+
+/// A dynamic AABB tree with four children per node. It has the same interface as
+/// b2DynamicTree and can stand in for it in the broad-phase. The tree is kept
+/// balanced like an R-tree: proxies are all at the same depth, full nodes are split
+/// when a proxy is added and under-full nodes are dissolved when one is removed.
+/// Proxy AABBs are fattened by b2_aabbExtension like in b2DynamicTree.
+///
+/// Nodes and proxies are pooled and relocatable, so we use indices rather than pointers.
+class b2WideTree
+{
+public:
+	/// Constructing the tree initializes the node and proxy pools.
+	b2WideTree();
+
+	/// Destroy the tree, freeing the pools.
+	~b2WideTree();
+
+	/// Create a proxy. Provide a tight fitting AABB and a userData pointer.
+	int32 CreateProxy(const b2AABB& aabb, void* userData);
+
+	/// Create a proxy with an AABB that is already fattened.
+	/// See b2DynamicTree::CreateFatProxy.
+	int32 CreateFatProxy(const b2AABB& fatAABB, void* userData);
+
+	/// Create many proxies at once. See b2DynamicTree::CreateProxies. The
+	/// proxies are inserted one by one.
+	void CreateProxies(const b2AABB* aabbs, void* const* userData, int32 count, int32* proxyIds);
+
+	/// Destroy a proxy. This asserts if the id is invalid.
+	void DestroyProxy(int32 proxyId);
+
+	/// Move a proxy with a swepted AABB. If the proxy has moved outside of its fattened AABB,
+	/// then the proxy is removed from the tree and re-inserted. Otherwise
+	/// the function returns immediately.
+	/// @return true if the proxy was re-inserted.
+	bool MoveProxy(int32 proxyId, const b2AABB& aabb1, const b2Vec2& displacement);
+
+	/// Get proxy user data.
+	void* GetUserData(int32 proxyId) const;
+
+	/// Get the fat AABB for a proxy.
+	const b2AABB& GetFatAABB(int32 proxyId) const;
+
+	/// Query an AABB for overlapping proxies. The callback class
+	/// is called for each proxy that overlaps the supplied AABB.
+	template <typename T>
+	void Query(T* callback, const b2AABB& aabb) const;
+
+	/// Query up to b2_simdWidth AABBs with a single walk of the tree.
+	/// See b2DynamicTree::QueryBatch.
+	template <typename T>
+	void QueryBatch(T* callback, const b2AABB* aabbs, int32 count) const;
+
+	/// Ray-cast against the proxies in the tree. See b2DynamicTree::RayCast.
+	template <typename T>
+	void RayCast(T* callback, const b2RayCastInput& input) const;
+
+	/// Validate this tree. For testing.
+	void Validate() const;
+
+	/// Get the height of the tree. Proxies have height zero.
+	int32 GetHeight() const;
+
+	/// Get the maximum balance of a node in the tree. The balance is the difference
+	/// in height of the tallest and the shortest child of a node.
+	int32 GetMaxBalance() const;
+
+	/// Get the ratio of the sum of the node and proxy areas to the root area.
+	float32 GetAreaRatio() const;
+
+	/// Shift the world origin. Useful for large worlds.
+	/// The shift formula is: position -= newOrigin
+	/// @param newOrigin the new origin with respect to the old origin
+	void ShiftOrigin(const b2Vec2& newOrigin);
+
+	/// Write the tree to a snapshot. The user data is written as is.
+	void Save(b2Snapshot* snapshot) const;
+
+	/// Replace the tree with one read from a snapshot.
+	void Restore(const b2Snapshot* snapshot);
+
+private:
+
+	/// Children that are proxies are stored as -2 - proxyId, empty slots as b2_nullNode.
+	static bool IsProxy(int32 child) { return child < b2_nullNode; }
+	static int32 EncodeProxy(int32 proxyId) { return -2 - proxyId; }
+	static int32 DecodeProxy(int32 child) { return -2 - child; }
+
+	int32 AllocateNode();
+	void FreeNode(int32 node);
+
+	int32 AllocateProxy();
+	void FreeProxy(int32 proxyId);
+
+	void InsertLeaf(int32 proxyId);
+	void RemoveLeaf(int32 proxyId);
+
+	void InsertAtLevel(int32 child, int32 height);
+	void InsertChild(int32 index, int32 child, const b2AABB& aabb);
+	int32 ChooseChild(int32 index, const b2AABB& aabb) const;
+	int32 Split(int32 index, int32 child, const b2AABB& aabb);
+
+	void SetChild(int32 index, int32 slot, int32 child, const b2AABB& aabb);
+	void RemoveChild(int32 index, int32 slot);
+	void ClearChild(int32 index, int32 slot);
+	b2AABB GetChildAABB(int32 index, int32 slot) const;
+	b2AABB ComputeAABB(int32 index) const;
+	void Refit(int32 index);
+
+	int32 ValidateStructure(int32 index) const;
+
+	int32 m_root;
+
+	b2WideTreeNode* m_nodes;
+	int32 m_nodeCount;
+	int32 m_nodeCapacity;
+	int32 m_freeNode;
+
+	b2WideTreeProxy* m_proxies;
+	int32 m_proxyCount;
+	int32 m_proxyCapacity;
+	int32 m_freeProxy;
+};
+
+inline void* b2WideTree::GetUserData(int32 proxyId) const
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	return m_proxies[proxyId].userData;
+}
+
+inline const b2AABB& b2WideTree::GetFatAABB(int32 proxyId) const
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	return m_proxies[proxyId].aabb;
+}
+
+template <typename T>
+inline void b2WideTree::Query(T* callback, const b2AABB& aabb) const
+{
+	if (m_root == b2_nullNode)
+	{
+		return;
+	}
+
+	b2Float4 queryLowerX = b2Splat4(aabb.lowerBound.x), queryLowerY = b2Splat4(aabb.lowerBound.y);
+	b2Float4 queryUpperX = b2Splat4(aabb.upperBound.x), queryUpperY = b2Splat4(aabb.upperBound.y);
+
+	b2GrowableStack<int32, 256> stack;
+	stack.Push(m_root);
+
+	while (stack.GetCount() > 0)
+	{
+		const b2WideTreeNode* node = m_nodes + stack.Pop();
+
+		// Same test as b2TestOverlap, for every child at once.
+		b2Float4 overlap = b2GreaterEqual4(b2Load4(node->upperX), queryLowerX);
+		overlap = b2And4(overlap, b2GreaterEqual4(b2Load4(node->upperY), queryLowerY));
+		overlap = b2And4(overlap, b2GreaterEqual4(queryUpperX, b2Load4(node->lowerX)));
+		overlap = b2And4(overlap, b2GreaterEqual4(queryUpperY, b2Load4(node->lowerY)));
+
+		int32 mask = b2MaskBits4(overlap);
+		for (int32 i = 0; mask != 0; ++i, mask >>= 1)
+		{
+			if ((mask & 1) == 0)
+			{
+				continue;
+			}
+
+			int32 child = node->children[i];
+			if (IsProxy(child))
+			{
+				bool proceed = callback->QueryCallback(DecodeProxy(child));
+				if (proceed == false)
+				{
+					return;
+				}
+			}
+			else
+			{
+				stack.Push(child);
+			}
+		}
+	}
+}
+
+template <typename T>
+inline void b2WideTree::QueryBatch(T* callback, const b2AABB* aabbs, int32 count) const
+{
+	b2Assert(0 < count && count <= b2_simdWidth);
+
+	if (m_root == b2_nullNode)
+	{
+		return;
+	}
+
+	// Unused lanes get an inverted box that overlaps nothing.
+	float32 lowerX[b2_simdWidth], lowerY[b2_simdWidth];
+	float32 upperX[b2_simdWidth], upperY[b2_simdWidth];
+	for (int32 i = 0; i < b2_simdWidth; ++i)
+	{
+		if (i < count)
+		{
+			lowerX[i] = aabbs[i].lowerBound.x;
+			lowerY[i] = aabbs[i].lowerBound.y;
+			upperX[i] = aabbs[i].upperBound.x;
+			upperY[i] = aabbs[i].upperBound.y;
+		}
+		else
+		{
+			lowerX[i] = lowerY[i] = b2_maxFloat;
+			upperX[i] = upperY[i] = -b2_maxFloat;
+		}
+	}
+
+	b2FloatW queryLowerX = b2LoadW(lowerX), queryLowerY = b2LoadW(lowerY);
+	b2FloatW queryUpperX = b2LoadW(upperX), queryUpperY = b2LoadW(upperY);
+
+	b2GrowableStack<int32, 256> stack;
+	stack.Push(m_root);
+
+	while (stack.GetCount() > 0)
+	{
+		const b2WideTreeNode* node = m_nodes + stack.Pop();
+
+		for (int32 i = 0; i < node->count; ++i)
+		{
+			// Same test as b2TestOverlap, for every query at once.
+			b2FloatW overlap = b2GreaterEqualW(b2SplatW(node->upperX[i]), queryLowerX);
+			overlap = b2AndW(overlap, b2GreaterEqualW(b2SplatW(node->upperY[i]), queryLowerY));
+			overlap = b2AndW(overlap, b2GreaterEqualW(queryUpperX, b2SplatW(node->lowerX[i])));
+			overlap = b2AndW(overlap, b2GreaterEqualW(queryUpperY, b2SplatW(node->lowerY[i])));
+
+			int32 mask = b2MaskBitsW(overlap);
+			if (mask == 0)
+			{
+				continue;
+			}
+
+			int32 child = node->children[i];
+			if (IsProxy(child) == false)
+			{
+				stack.Push(child);
+				continue;
+			}
+
+			int32 proxyId = DecodeProxy(child);
+			for (int32 j = 0; j < count; ++j)
+			{
+				if (mask & (1 << j))
+				{
+					bool proceed = callback->QueryCallback(j, proxyId);
+					if (proceed == false)
+					{
+						return;
+					}
+				}
+			}
+		}
+	}
+}
+
+template <typename T>
+inline void b2WideTree::RayCast(T* callback, const b2RayCastInput& input) const
+{
+	if (m_root == b2_nullNode)
+	{
+		return;
+	}
+
+	b2Vec2 p1 = input.p1;
+	b2Vec2 p2 = input.p2;
+	b2Vec2 r = p2 - p1;
+	b2Assert(r.LengthSquared() > 0.0f);
+	r.Normalize();
+
+	// v is perpendicular to the segment.
+	b2Vec2 v = b2Cross(1.0f, r);
+	b2Vec2 abs_v = b2Abs(v);
+
+	float32 maxFraction = input.maxFraction;
+
+	// Build a bounding box for the segment.
+	b2AABB segmentAABB;
+	{
+		b2Vec2 t = p1 + maxFraction * (p2 - p1);
+		segmentAABB.lowerBound = b2Min(p1, t);
+		segmentAABB.upperBound = b2Max(p1, t);
+	}
+
+	b2GrowableStack<int32, 256> stack;
+	stack.Push(m_root);
+
+	while (stack.GetCount() > 0)
+	{
+		const b2WideTreeNode* node = m_nodes + stack.Pop();
+
+		// Cull the children against the segment box all at once.
+		b2Float4 overlap = b2GreaterEqual4(b2Load4(node->upperX), b2Splat4(segmentAABB.lowerBound.x));
+		overlap = b2And4(overlap, b2GreaterEqual4(b2Load4(node->upperY), b2Splat4(segmentAABB.lowerBound.y)));
+		overlap = b2And4(overlap, b2GreaterEqual4(b2Splat4(segmentAABB.upperBound.x), b2Load4(node->lowerX)));
+		overlap = b2And4(overlap, b2GreaterEqual4(b2Splat4(segmentAABB.upperBound.y), b2Load4(node->lowerY)));
+
+		int32 mask = b2MaskBits4(overlap);
+		for (int32 i = 0; mask != 0; ++i, mask >>= 1)
+		{
+			if ((mask & 1) == 0)
+			{
+				continue;
+			}
+
+			// Separating axis for segment (Gino, p80).
+			// |dot(v, p1 - c)| > dot(|v|, h)
+			b2Vec2 lower(node->lowerX[i], node->lowerY[i]);
+			b2Vec2 upper(node->upperX[i], node->upperY[i]);
+			b2Vec2 c = 0.5f * (lower + upper);
+			b2Vec2 h = 0.5f * (upper - lower);
+			float32 separation = b2Abs(b2Dot(v, p1 - c)) - b2Dot(abs_v, h);
+			if (separation > 0.0f)
+			{
+				continue;
+			}
+
+			int32 child = node->children[i];
+			if (IsProxy(child) == false)
+			{
+				stack.Push(child);
+				continue;
+			}
+
+			b2RayCastInput subInput;
+			subInput.p1 = input.p1;
+			subInput.p2 = input.p2;
+			subInput.maxFraction = maxFraction;
+
+			float32 value = callback->RayCastCallback(subInput, DecodeProxy(child));
+
+			if (value == 0.0f)
+			{
+				// The client has terminated the ray cast.
+				return;
+			}
+
+			if (value > 0.0f)
+			{
+				// Update segment bounding box.
+				maxFraction = value;
+				b2Vec2 t = p1 + maxFraction * (p2 - p1);
+				segmentAABB.lowerBound = b2Min(p1, t);
+				segmentAABB.upperBound = b2Max(p1, t);
+			}
+		}
+	}
+}
+
+#endif
@@ -17,6 +17,7 @@
 */
 
 #include <Box2D/Common/b2BlockAllocator.h>
+#include <Box2D/Common/b2Math.h>
 #include <cstdlib>
 #include <climits>
 #include <cstring>
@@ -65,6 +66,10 @@ b2BlockAllocator::b2BlockAllocator()
 	memset(m_chunks, 0, m_chunkSpace * sizeof(b2Chunk));
 	memset(m_freeLists, 0, sizeof(m_freeLists));
 
+	m_allocation = 0;
+	m_maxAllocation = 0;
+	m_fallbackCount = 0;
+
 	if (s_blockSizeLookupInitialized == false)
 	{
 		int32 j = 0;
@@ -103,8 +108,12 @@ void* b2BlockAllocator::Allocate(int32 size)
 
 	b2Assert(0 < size);
 
+	m_allocation += size;
+	m_maxAllocation = b2Max(m_maxAllocation, m_allocation);
+
 	if (size > b2_maxBlockSize)
 	{
+		++m_fallbackCount;
 		return b2Alloc(size);
 	}
 
@@ -163,6 +172,8 @@ void b2BlockAllocator::Free(void* p, int32 size)
 
 	b2Assert(0 < size);
 
+	m_allocation -= size;
+
 	if (size > b2_maxBlockSize)
 	{
 		b2Free(p);
@@ -214,4 +225,16 @@ void b2BlockAllocator::Clear()
 	memset(m_chunks, 0, m_chunkSpace * sizeof(b2Chunk));
 
 	memset(m_freeLists, 0, sizeof(m_freeLists));
+
+	m_allocation = 0;
+}
+
+int32 b2BlockAllocator::GetMaxAllocation() const
+{
+	return m_maxAllocation;
+}
+
+int32 b2BlockAllocator::GetFallbackCount() const
+{
+	return m_fallbackCount;
 }
@@ -46,6 +46,12 @@ public:
 
 	void Clear();
 
+	/// Get the peak number of bytes allocated at once.
+	int32 GetMaxAllocation() const;
+
+	/// Get the number of allocations larger than b2_maxBlockSize, which use b2Alloc.
+	int32 GetFallbackCount() const;
+
 private:
 
 	b2Chunk* m_chunks;
@@ -54,6 +60,10 @@ private:
 
 	b2Block* m_freeLists[b2_blockSizes];
 
+	int32 m_allocation;
+	int32 m_maxAllocation;
+	int32 m_fallbackCount;
+
 	static int32 s_blockSizes[b2_blockSizes];
 	static uint8 s_blockSizeLookup[b2_maxBlockSize + 1];
 	static bool s_blockSizeLookupInitialized;
@@ -92,3 +92,119 @@ void b2Mat33::GetSymInverse33(b2Mat33* M) const
 	M->ez.y = M->ey.z;
 	M->ez.z = det * (a11 * a22 - a12 * a12);
 }
+
+#if defined(B2_DETERMINISTIC)
+
+// The polynomials below are the single precision minimax fits from Cephes.
+// Every operation is a plain IEEE add, multiply or divide so the results only
+// depend on evaluation order, which the deterministic build pins down.
+
+float32 b2Atan2(float32 y, float32 x)
+{
+	if (x == 0.0f)
+	{
+		if (y > 0.0f)
+		{
+			return 0.5f * b2_pi;
+		}
+
+		if (y < 0.0f)
+		{
+			return -0.5f * b2_pi;
+		}
+
+		return 0.0f;
+	}
+
+	// Reduce to the arc tangent of a non-negative ratio.
+	float32 t = y / x;
+	bool negative = t < 0.0f;
+	if (negative)
+	{
+		t = -t;
+	}
+
+	// Reduce further to [0, tan(pi/8)].
+	float32 base = 0.0f;
+	if (t > 2.414213562373095f)
+	{
+		base = 0.5f * b2_pi;
+		t = -1.0f / t;
+	}
+	else if (t > 0.4142135623730950f)
+	{
+		base = 0.25f * b2_pi;
+		t = (t - 1.0f) / (t + 1.0f);
+	}
+
+	float32 z = t * t;
+	float32 p = (((8.05374449538e-2f * z - 1.38776856032e-1f) * z + 1.99777106478e-1f) * z - 3.33329491539e-1f) * z * t + t;
+	float32 angle = base + p;
+	if (negative)
+	{
+		angle = -angle;
+	}
+
+	// Move into the quadrant of (x, y). Like atan2, a negative zero y picks
+	// the lower side of the branch cut.
+	if (x < 0.0f)
+	{
+		bool below = y < 0.0f || (y == 0.0f && 1.0f / y < 0.0f);
+		angle += below ? -b2_pi : b2_pi;
+	}
+
+	return angle;
+}
+
+void b2SinCos(float32 angle, float32* s, float32* c)
+{
+	float32 x = angle < 0.0f ? -angle : angle;
+
+	// Find the octant, rounded up to an even one so the remainder lies in
+	// [-pi/4, pi/4].
+	int32 octant = int32(x * 1.27323954473516f);
+	float32 y = float32(octant);
+	if (octant & 1)
+	{
+		octant += 1;
+		y += 1.0f;
+	}
+	octant &= 7;
+
+	// Subtract y * pi/4 in three pieces. The first two are short enough for
+	// the products to be exact.
+	x = ((x - y * 0.78515625f) - y * 2.4187564849853515625e-4f) - y * 3.77489497744594108e-8f;
+
+	float32 z = x * x;
+	float32 sp = ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f) * z * x + x;
+	float32 cp = ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z + 4.166664568298827e-2f) * z * z - 0.5f * z + 1.0f;
+
+	float32 sine, cosine;
+	switch (octant)
+	{
+	case 0:
+		sine = sp;
+		cosine = cp;
+		break;
+
+	case 2:
+		sine = cp;
+		cosine = -sp;
+		break;
+
+	case 4:
+		sine = -sp;
+		cosine = -cp;
+		break;
+
+	default:
+		sine = -cp;
+		cosine = sp;
+		break;
+	}
+
+	*s = angle < 0.0f ? -sine : sine;
+	*c = cosine;
+}
+
+#endif
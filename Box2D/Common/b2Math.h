@@ -57,9 +57,43 @@ inline float32 b2InvSqrt(float32 x)
 	return x;
 }
 
+#if defined(B2_DETERMINISTIC)
+
+#if defined(__FAST_MATH__)
+#error "B2_DETERMINISTIC cannot be combined with -ffast-math."
+#endif
+
+#if (defined(__i386__) && !defined(__SSE2_MATH__)) || (defined(_M_IX86_FP) && _M_IX86_FP < 2)
+#error "B2_DETERMINISTIC needs SSE2 float math, the x87 unit rounds to extended precision."
+#endif
+
+/// IEEE 754 requires square root to be correctly rounded, so the hardware
+/// instruction gives the same bits everywhere once fast-math is ruled out.
+inline float32 b2Sqrt(float32 x)
+{
+	return std::sqrt(x);
+}
+
+/// An arc tangent built from basic arithmetic only, so it does not depend on
+/// the platform libm. The error is within a few ulp.
+float32 b2Atan2(float32 y, float32 x);
+
+/// Sine and cosine built from basic arithmetic only, see b2Atan2.
+void b2SinCos(float32 angle, float32* s, float32* c);
+
+#else
+
 #define	b2Sqrt(x)	std::sqrt(x)
 #define	b2Atan2(y, x)	std::atan2(y, x)
 
+inline void b2SinCos(float32 angle, float32* s, float32* c)
+{
+	*s = sinf(angle);
+	*c = cosf(angle);
+}
+
+#endif
+
 /// A 2D column vector.
 struct b2Vec2
 {
@@ -314,17 +348,13 @@ struct b2Rot
 	/// Initialize from an angle in radians
 	explicit b2Rot(float32 angle)
 	{
-		/// TODO_ERIN optimize
-		s = sinf(angle);
-		c = cosf(angle);
+		b2SinCos(angle, &s, &c);
 	}
 
 	/// Set using an angle in radians.
 	void Set(float32 angle)
 	{
-		/// TODO_ERIN optimize
-		s = sinf(angle);
-		c = cosf(angle);
+		b2SinCos(angle, &s, &c);
 	}
 
 	/// Set to the identity rotation
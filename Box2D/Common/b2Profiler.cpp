@@ -0,0 +1,123 @@
+/*
+* Copyright (c) 2013 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Common/b2Profiler.h>
+#include <cstdio>
+#include <cstring>
+
+b2Profiler::b2Profiler(int32 capacity)
+{
+	b2Assert(capacity > 0);
+	m_capacity = capacity;
+	memset(m_events, 0, sizeof(m_events));
+	memset(m_counts, 0, sizeof(m_counts));
+}
+
+b2Profiler::~b2Profiler()
+{
+	for (int32 i = 0; i < b2_maxThreads; ++i)
+	{
+		b2Free(m_events[i]);
+	}
+}
+
+void b2Profiler::Clear()
+{
+	memset(m_counts, 0, sizeof(m_counts));
+}
+
+void b2Profiler::Record(int32 threadIndex, const char* name, uint64 start, uint64 end, int32 value)
+{
+	b2Assert(0 <= threadIndex && threadIndex < b2_maxThreads);
+
+	// Buffers are allocated when a thread first records, most pools use
+	// only a few of the threads.
+	if (m_events[threadIndex] == NULL)
+	{
+		m_events[threadIndex] = (b2ProfileEvent*)b2Alloc(m_capacity * sizeof(b2ProfileEvent));
+	}
+
+	// The count keeps going once the buffer is full, so it also gives the
+	// position of the oldest event.
+	int32 count = m_counts[threadIndex];
+	b2ProfileEvent* e = m_events[threadIndex] + count % m_capacity;
+	e->name = name;
+	e->start = start;
+	e->duration = end - start;
+	e->value = value;
+
+	++count;
+	if (count == 2 * m_capacity)
+	{
+		count = m_capacity;
+	}
+	m_counts[threadIndex] = count;
+}
+
+bool b2Profiler::WriteChromeTrace(const char* fileName) const
+{
+	FILE* file = fopen(fileName, "w");
+	if (file == NULL)
+	{
+		return false;
+	}
+
+	// Chrome wants microseconds. Make them relative to the earliest start. Events
+	// are recorded when their scope ends, so a parent scope is recorded after its
+	// children but started before them.
+	uint64 origin = 0;
+	bool first = true;
+	for (int32 i = 0; i < b2_maxThreads; ++i)
+	{
+		int32 count = GetEventCount(i);
+		for (int32 j = 0; j < count; ++j)
+		{
+			uint64 start = GetEvent(i, j).start;
+			if (first || start < origin)
+			{
+				origin = start;
+				first = false;
+			}
+		}
+	}
+
+	fprintf(file, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+
+	first = true;
+	for (int32 i = 0; i < b2_maxThreads; ++i)
+	{
+		int32 count = GetEventCount(i);
+		for (int32 j = 0; j < count; ++j)
+		{
+			const b2ProfileEvent& e = GetEvent(i, j);
+			fprintf(file, "%s{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 0, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f",
+				first ? "" : ",\n", e.name, i, float64(e.start - origin) * 1.0e-3, float64(e.duration) * 1.0e-3);
+
+			if (e.value >= 0)
+			{
+				fprintf(file, ", \"args\": {\"value\": %d}", e.value);
+			}
+
+			fprintf(file, "}");
+			first = false;
+		}
+	}
+
+	fprintf(file, "\n]}\n");
+	return fclose(file) == 0;
+}
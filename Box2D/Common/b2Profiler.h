@@ -0,0 +1,122 @@
+/*
+* Copyright (c) 2013 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_PROFILER_H
+#define B2_PROFILER_H
+
+#include <Box2D/Common/b2Math.h>
+#include <Box2D/Common/b2Timer.h>
+#include <Box2D/Common/b2ThreadPool.h>
+
+/// A timed scope recorded by a b2Profiler. Times are b2Timer::GetTicks values.
+struct b2ProfileEvent
+{
+	const char* name;	///< not copied, use string literals
+	uint64 start;
+	uint64 duration;
+	int32 value;		///< scope specific, such as the body count of an island, or -1
+};
+
+/// Records the scopes of a world step per thread, in nanoseconds. Each thread
+/// pool thread has its own ring buffer, so recording needs no locking and the
+/// oldest events are overwritten once a buffer is full. Attach a profiler with
+/// b2World::SetProfiler. Scopes nest: step holds collide, solve and solveTOI,
+/// solve holds the islands and broadphase, and so on.
+class b2Profiler
+{
+public:
+
+	/// @param capacity the number of events kept for each thread.
+	b2Profiler(int32 capacity);
+	~b2Profiler();
+
+	/// Drop all events.
+	void Clear();
+
+	/// Get the number of events kept for a thread.
+	int32 GetEventCount(int32 threadIndex) const;
+
+	/// Get an event of a thread, from the oldest (0) to the newest.
+	const b2ProfileEvent& GetEvent(int32 threadIndex, int32 index) const;
+
+	/// Write the events in the Chrome trace event format, which can be
+	/// opened with chrome://tracing or Perfetto.
+	/// @return false if the file could not be written.
+	bool WriteChromeTrace(const char* fileName) const;
+
+	/// Add an event. This is used by b2ProfileScope.
+	void Record(int32 threadIndex, const char* name, uint64 start, uint64 end, int32 value);
+
+private:
+
+	b2Profiler(const b2Profiler&);
+	b2Profiler& operator=(const b2Profiler&);
+
+	b2ProfileEvent* m_events[b2_maxThreads];
+	int32 m_counts[b2_maxThreads];
+	int32 m_capacity;
+};
+
+/// Records the lifetime of the scope on a profiler. Does nothing if the
+/// profiler is NULL.
+class b2ProfileScope
+{
+public:
+	b2ProfileScope(b2Profiler* profiler, const char* name, int32 threadIndex = 0, int32 value = -1)
+	{
+		m_profiler = profiler;
+		if (profiler != NULL)
+		{
+			m_name = name;
+			m_threadIndex = threadIndex;
+			m_value = value;
+			m_start = b2Timer::GetTicks();
+		}
+	}
+
+	~b2ProfileScope()
+	{
+		if (m_profiler != NULL)
+		{
+			m_profiler->Record(m_threadIndex, m_name, m_start, b2Timer::GetTicks(), m_value);
+		}
+	}
+
+private:
+
+	b2Profiler* m_profiler;
+	const char* m_name;
+	int32 m_threadIndex;
+	int32 m_value;
+	uint64 m_start;
+};
+
+inline int32 b2Profiler::GetEventCount(int32 threadIndex) const
+{
+	b2Assert(0 <= threadIndex && threadIndex < b2_maxThreads);
+	return b2Min(m_counts[threadIndex], m_capacity);
+}
+
+inline const b2ProfileEvent& b2Profiler::GetEvent(int32 threadIndex, int32 index) const
+{
+	b2Assert(0 <= index && index < GetEventCount(threadIndex));
+	int32 first = m_counts[threadIndex] > m_capacity ? m_counts[threadIndex] % m_capacity : 0;
+	return m_events[threadIndex][(first + index) % m_capacity];
+}
+
+#endif
@@ -21,6 +21,7 @@
 
 #include <cassert>
 #include <cmath>
+#include <cstring>
 
 #define B2_NOT_USED(x) ((void)(x))
 #define b2Assert(A) assert(A)
@@ -31,6 +32,7 @@ typedef signed int int32;
 typedef unsigned char uint8;
 typedef unsigned short uint16;
 typedef unsigned int uint32;
+typedef unsigned long long uint64;
 typedef float float32;
 typedef double float64;
 
@@ -75,6 +77,10 @@ typedef double float64;
 /// Making it larger may create artifacts for vertex collision.
 #define b2_polygonRadius		(2.0f * b2_linearSlop)
 
+/// The smallest distance at which speculative contacts generate points. The
+/// relative motion over the step is added to this.
+#define b2_speculativeDistance	(4.0f * b2_linearSlop)
+
 /// Maximum number of sub-steps per contact in continuous physics simulation.
 #define b2_maxSubSteps			8
 
@@ -132,6 +138,24 @@ void* b2Alloc(int32 size);
 /// If you implement b2Alloc, you should also implement this function.
 void b2Free(void* mem);
 
+/// Move an array to a new allocation that holds capacity elements, keeping
+/// the first keepCount elements. The old allocation may be NULL.
+template <typename T>
+inline void b2GrowArray(T** array, int32 keepCount, int32 capacity)
+{
+	b2Assert(keepCount <= capacity);
+	T* newArray = (T*)b2Alloc(capacity * sizeof(T));
+	if (keepCount > 0)
+	{
+		memcpy(newArray, *array, keepCount * sizeof(T));
+	}
+	if (*array)
+	{
+		b2Free(*array);
+	}
+	*array = newArray;
+}
+
 /// Logging function.
 void b2Log(const char* string, ...);
 
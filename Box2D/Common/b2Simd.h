@@ -0,0 +1,303 @@
+/*
+* Copyright (c) 2013 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_SIMD_H
+#define B2_SIMD_H
+
+#include <Box2D/Common/b2Settings.h>
+
+/// @file
+/// A thin wrapper over the widest float vector the compiler targets. The
+/// width is fixed at compile time: AVX2 builds use 8 lanes, SSE2 builds use
+/// 4 lanes and everything else (or B2_NO_SIMD) emulates 4 lanes in scalar code.
+/// Loads and stores are unaligned. B2_DETERMINISTIC builds stay at 4 lanes
+/// because the contact solver groups constraints by width, which changes the
+/// solve order. b2LoadXYW splits b2_simdWidth interleaved (x, y) pairs, such
+/// as an array of b2Vec2, into an x and a y vector and b2StoreXYW joins them.
+
+#if !defined(B2_NO_SIMD) && !defined(B2_DETERMINISTIC) && defined(__AVX2__)
+	#define B2_SIMD_AVX2
+	#define b2_simdWidth	8
+	#include <immintrin.h>
+#elif !defined(B2_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+	#define B2_SIMD_SSE2
+	#define b2_simdWidth	4
+	#include <emmintrin.h>
+#else
+	#define B2_SIMD_SCALAR
+	#define b2_simdWidth	4
+#endif
+
+/// b2_simdWidth floats. Comparisons return lane masks that are only meant to
+/// be combined with b2AndW and consumed by b2SelectW.
+struct b2FloatW
+{
+#if defined(B2_SIMD_AVX2)
+	__m256 v;
+#elif defined(B2_SIMD_SSE2)
+	__m128 v;
+#else
+	float32 v[b2_simdWidth];
+#endif
+};
+
+#if defined(B2_SIMD_AVX2)
+
+inline b2FloatW b2MakeW(__m256 v) { b2FloatW r; r.v = v; return r; }
+inline b2FloatW b2LoadW(const float32* p) { return b2MakeW(_mm256_loadu_ps(p)); }
+inline void b2StoreW(float32* p, b2FloatW a) { _mm256_storeu_ps(p, a.v); }
+inline b2FloatW b2SplatW(float32 s) { return b2MakeW(_mm256_set1_ps(s)); }
+inline b2FloatW b2ZeroW() { return b2MakeW(_mm256_setzero_ps()); }
+inline b2FloatW operator + (b2FloatW a, b2FloatW b) { return b2MakeW(_mm256_add_ps(a.v, b.v)); }
+inline b2FloatW operator - (b2FloatW a, b2FloatW b) { return b2MakeW(_mm256_sub_ps(a.v, b.v)); }
+inline b2FloatW operator * (b2FloatW a, b2FloatW b) { return b2MakeW(_mm256_mul_ps(a.v, b.v)); }
+inline b2FloatW operator / (b2FloatW a, b2FloatW b) { return b2MakeW(_mm256_div_ps(a.v, b.v)); }
+inline b2FloatW b2SqrtW(b2FloatW a) { return b2MakeW(_mm256_sqrt_ps(a.v)); }
+inline b2FloatW operator - (b2FloatW a) { return b2MakeW(_mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f))); }
+inline b2FloatW b2MinW(b2FloatW a, b2FloatW b) { return b2MakeW(_mm256_min_ps(a.v, b.v)); }
+inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b) { return b2MakeW(_mm256_max_ps(a.v, b.v)); }
+inline b2FloatW b2GreaterEqualW(b2FloatW a, b2FloatW b) { return b2MakeW(_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ)); }
+inline b2FloatW b2GreaterW(b2FloatW a, b2FloatW b) { return b2MakeW(_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)); }
+inline b2FloatW b2AndW(b2FloatW a, b2FloatW b) { return b2MakeW(_mm256_and_ps(a.v, b.v)); }
+inline b2FloatW b2OrW(b2FloatW a, b2FloatW b) { return b2MakeW(_mm256_or_ps(a.v, b.v)); }
+inline b2FloatW b2SelectW(b2FloatW mask, b2FloatW a, b2FloatW b) { return b2MakeW(_mm256_blendv_ps(b.v, a.v, mask.v)); }
+inline int32 b2MaskBitsW(b2FloatW mask) { return _mm256_movemask_ps(mask.v); }
+inline b2FloatW b2LaneIndexW() { return b2MakeW(_mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f)); }
+
+inline void b2LoadXYW(const float32* p, b2FloatW* x, b2FloatW* y)
+{
+	// Each 128-bit half picks its x and y, then the 64-bit pairs are put back
+	// in order.
+	__m256 a = _mm256_loadu_ps(p);
+	__m256 b = _mm256_loadu_ps(p + 8);
+	__m256 xs = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+	__m256 ys = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+	x->v = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(xs), _MM_SHUFFLE(3, 1, 2, 0)));
+	y->v = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(ys), _MM_SHUFFLE(3, 1, 2, 0)));
+}
+
+inline void b2StoreXYW(float32* p, b2FloatW x, b2FloatW y)
+{
+	__m256 lo = _mm256_unpacklo_ps(x.v, y.v);
+	__m256 hi = _mm256_unpackhi_ps(x.v, y.v);
+	_mm256_storeu_ps(p, _mm256_permute2f128_ps(lo, hi, 0x20));
+	_mm256_storeu_ps(p + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+}
+
+inline float32 b2ReduceMinW(b2FloatW a)
+{
+	__m128 m = _mm_min_ps(_mm256_castps256_ps128(a.v), _mm256_extractf128_ps(a.v, 1));
+	m = _mm_min_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 0, 3, 2)));
+	m = _mm_min_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtss_f32(m);
+}
+
+inline float32 b2ReduceMaxW(b2FloatW a)
+{
+	__m128 m = _mm_max_ps(_mm256_castps256_ps128(a.v), _mm256_extractf128_ps(a.v, 1));
+	m = _mm_max_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 0, 3, 2)));
+	m = _mm_max_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtss_f32(m);
+}
+
+#elif defined(B2_SIMD_SSE2)
+
+inline b2FloatW b2MakeW(__m128 v) { b2FloatW r; r.v = v; return r; }
+inline b2FloatW b2LoadW(const float32* p) { return b2MakeW(_mm_loadu_ps(p)); }
+inline void b2StoreW(float32* p, b2FloatW a) { _mm_storeu_ps(p, a.v); }
+inline b2FloatW b2SplatW(float32 s) { return b2MakeW(_mm_set1_ps(s)); }
+inline b2FloatW b2ZeroW() { return b2MakeW(_mm_setzero_ps()); }
+inline b2FloatW operator + (b2FloatW a, b2FloatW b) { return b2MakeW(_mm_add_ps(a.v, b.v)); }
+inline b2FloatW operator - (b2FloatW a, b2FloatW b) { return b2MakeW(_mm_sub_ps(a.v, b.v)); }
+inline b2FloatW operator * (b2FloatW a, b2FloatW b) { return b2MakeW(_mm_mul_ps(a.v, b.v)); }
+inline b2FloatW operator / (b2FloatW a, b2FloatW b) { return b2MakeW(_mm_div_ps(a.v, b.v)); }
+inline b2FloatW b2SqrtW(b2FloatW a) { return b2MakeW(_mm_sqrt_ps(a.v)); }
+inline b2FloatW operator - (b2FloatW a) { return b2MakeW(_mm_xor_ps(a.v, _mm_set1_ps(-0.0f))); }
+inline b2FloatW b2MinW(b2FloatW a, b2FloatW b) { return b2MakeW(_mm_min_ps(a.v, b.v)); }
+inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b) { return b2MakeW(_mm_max_ps(a.v, b.v)); }
+inline b2FloatW b2GreaterEqualW(b2FloatW a, b2FloatW b) { return b2MakeW(_mm_cmpge_ps(a.v, b.v)); }
+inline b2FloatW b2GreaterW(b2FloatW a, b2FloatW b) { return b2MakeW(_mm_cmpgt_ps(a.v, b.v)); }
+inline b2FloatW b2AndW(b2FloatW a, b2FloatW b) { return b2MakeW(_mm_and_ps(a.v, b.v)); }
+inline b2FloatW b2OrW(b2FloatW a, b2FloatW b) { return b2MakeW(_mm_or_ps(a.v, b.v)); }
+inline b2FloatW b2SelectW(b2FloatW mask, b2FloatW a, b2FloatW b)
+{
+	return b2MakeW(_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)));
+}
+inline int32 b2MaskBitsW(b2FloatW mask) { return _mm_movemask_ps(mask.v); }
+inline b2FloatW b2LaneIndexW() { return b2MakeW(_mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f)); }
+
+inline void b2LoadXYW(const float32* p, b2FloatW* x, b2FloatW* y)
+{
+	__m128 a = _mm_loadu_ps(p);
+	__m128 b = _mm_loadu_ps(p + 4);
+	x->v = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+	y->v = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+inline void b2StoreXYW(float32* p, b2FloatW x, b2FloatW y)
+{
+	_mm_storeu_ps(p, _mm_unpacklo_ps(x.v, y.v));
+	_mm_storeu_ps(p + 4, _mm_unpackhi_ps(x.v, y.v));
+}
+
+inline float32 b2ReduceMinW(b2FloatW a)
+{
+	__m128 m = _mm_min_ps(a.v, _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(1, 0, 3, 2)));
+	m = _mm_min_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtss_f32(m);
+}
+
+inline float32 b2ReduceMaxW(b2FloatW a)
+{
+	__m128 m = _mm_max_ps(a.v, _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(1, 0, 3, 2)));
+	m = _mm_max_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtss_f32(m);
+}
+
+#else
+
+// Masks are stored as 1.0f (true) and 0.0f (false).
+#define B2_SIMD_LANES(expr) b2FloatW r; for (int32 i = 0; i < b2_simdWidth; ++i) { r.v[i] = expr; } return r
+
+inline b2FloatW b2LoadW(const float32* p) { B2_SIMD_LANES(p[i]); }
+inline void b2StoreW(float32* p, b2FloatW a) { for (int32 i = 0; i < b2_simdWidth; ++i) { p[i] = a.v[i]; } }
+inline b2FloatW b2SplatW(float32 s) { B2_SIMD_LANES(s); }
+inline b2FloatW b2ZeroW() { B2_SIMD_LANES(0.0f); }
+inline b2FloatW operator + (b2FloatW a, b2FloatW b) { B2_SIMD_LANES(a.v[i] + b.v[i]); }
+inline b2FloatW operator - (b2FloatW a, b2FloatW b) { B2_SIMD_LANES(a.v[i] - b.v[i]); }
+inline b2FloatW operator * (b2FloatW a, b2FloatW b) { B2_SIMD_LANES(a.v[i] * b.v[i]); }
+inline b2FloatW operator / (b2FloatW a, b2FloatW b) { B2_SIMD_LANES(a.v[i] / b.v[i]); }
+inline b2FloatW b2SqrtW(b2FloatW a) { B2_SIMD_LANES(std::sqrt(a.v[i])); }
+inline b2FloatW operator - (b2FloatW a) { B2_SIMD_LANES(-a.v[i]); }
+inline b2FloatW b2MinW(b2FloatW a, b2FloatW b) { B2_SIMD_LANES(a.v[i] < b.v[i] ? a.v[i] : b.v[i]); }
+inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b) { B2_SIMD_LANES(a.v[i] > b.v[i] ? a.v[i] : b.v[i]); }
+inline b2FloatW b2GreaterEqualW(b2FloatW a, b2FloatW b) { B2_SIMD_LANES(a.v[i] >= b.v[i] ? 1.0f : 0.0f); }
+inline b2FloatW b2GreaterW(b2FloatW a, b2FloatW b) { B2_SIMD_LANES(a.v[i] > b.v[i] ? 1.0f : 0.0f); }
+inline b2FloatW b2AndW(b2FloatW a, b2FloatW b) { B2_SIMD_LANES(a.v[i] * b.v[i]); }
+inline b2FloatW b2OrW(b2FloatW a, b2FloatW b) { B2_SIMD_LANES(a.v[i] + b.v[i] > 0.0f ? 1.0f : 0.0f); }
+inline b2FloatW b2SelectW(b2FloatW mask, b2FloatW a, b2FloatW b) { B2_SIMD_LANES(mask.v[i] != 0.0f ? a.v[i] : b.v[i]); }
+inline int32 b2MaskBitsW(b2FloatW mask)
+{
+	int32 bits = 0;
+	for (int32 i = 0; i < b2_simdWidth; ++i)
+	{
+		bits |= (mask.v[i] != 0.0f ? 1 : 0) << i;
+	}
+	return bits;
+}
+
+inline b2FloatW b2LaneIndexW() { B2_SIMD_LANES(float32(i)); }
+
+inline void b2LoadXYW(const float32* p, b2FloatW* x, b2FloatW* y)
+{
+	for (int32 i = 0; i < b2_simdWidth; ++i)
+	{
+		x->v[i] = p[2 * i];
+		y->v[i] = p[2 * i + 1];
+	}
+}
+
+inline void b2StoreXYW(float32* p, b2FloatW x, b2FloatW y)
+{
+	for (int32 i = 0; i < b2_simdWidth; ++i)
+	{
+		p[2 * i] = x.v[i];
+		p[2 * i + 1] = y.v[i];
+	}
+}
+
+inline float32 b2ReduceMinW(b2FloatW a)
+{
+	float32 m = a.v[0];
+	for (int32 i = 1; i < b2_simdWidth; ++i)
+	{
+		m = a.v[i] < m ? a.v[i] : m;
+	}
+	return m;
+}
+
+inline float32 b2ReduceMaxW(b2FloatW a)
+{
+	float32 m = a.v[0];
+	for (int32 i = 1; i < b2_simdWidth; ++i)
+	{
+		m = a.v[i] > m ? a.v[i] : m;
+	}
+	return m;
+}
+
+#undef B2_SIMD_LANES
+
+#endif
+
+/// The index of the lowest set bit of a b2MaskBitsW result, which must not be
+/// zero.
+inline int32 b2FirstLane(int32 bits)
+{
+	int32 lane = 0;
+	while ((bits & 1) == 0)
+	{
+		bits >>= 1;
+		++lane;
+	}
+	return lane;
+}
+
+/// Four floats, whatever b2_simdWidth is. This is for data that is laid out in
+/// groups of four, such as the children of a b2WideTree node.
+struct b2Float4
+{
+#if defined(B2_SIMD_AVX2) || defined(B2_SIMD_SSE2)
+	__m128 v;
+#else
+	float32 v[4];
+#endif
+};
+
+#if defined(B2_SIMD_AVX2) || defined(B2_SIMD_SSE2)
+
+inline b2Float4 b2Make4(__m128 v) { b2Float4 r; r.v = v; return r; }
+inline b2Float4 b2Load4(const float32* p) { return b2Make4(_mm_loadu_ps(p)); }
+inline b2Float4 b2Splat4(float32 s) { return b2Make4(_mm_set1_ps(s)); }
+inline b2Float4 b2GreaterEqual4(b2Float4 a, b2Float4 b) { return b2Make4(_mm_cmpge_ps(a.v, b.v)); }
+inline b2Float4 b2And4(b2Float4 a, b2Float4 b) { return b2Make4(_mm_and_ps(a.v, b.v)); }
+inline int32 b2MaskBits4(b2Float4 mask) { return _mm_movemask_ps(mask.v); }
+
+#else
+
+#define B2_SIMD_LANES4(expr) b2Float4 r; for (int32 i = 0; i < 4; ++i) { r.v[i] = expr; } return r
+
+inline b2Float4 b2Load4(const float32* p) { B2_SIMD_LANES4(p[i]); }
+inline b2Float4 b2Splat4(float32 s) { B2_SIMD_LANES4(s); }
+inline b2Float4 b2GreaterEqual4(b2Float4 a, b2Float4 b) { B2_SIMD_LANES4(a.v[i] >= b.v[i] ? 1.0f : 0.0f); }
+inline b2Float4 b2And4(b2Float4 a, b2Float4 b) { B2_SIMD_LANES4(a.v[i] * b.v[i]); }
+inline int32 b2MaskBits4(b2Float4 mask)
+{
+	int32 bits = 0;
+	for (int32 i = 0; i < 4; ++i)
+	{
+		bits |= (mask.v[i] != 0.0f ? 1 : 0) << i;
+	}
+	return bits;
+}
+
+#undef B2_SIMD_LANES4
+
+#endif
+
+#endif
@@ -0,0 +1,73 @@
+/*
+* Copyright (c) 2013 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Common/b2Snapshot.h>
+#include <Box2D/Common/b2Math.h>
+
+b2Snapshot::b2Snapshot()
+{
+	m_data = NULL;
+	m_size = 0;
+	m_capacity = 0;
+	m_readIndex = 0;
+}
+
+b2Snapshot::~b2Snapshot()
+{
+	b2Free(m_data);
+}
+
+void b2Snapshot::Clear()
+{
+	m_size = 0;
+	m_readIndex = 0;
+}
+
+void b2Snapshot::Write(const void* data, int32 size)
+{
+	b2Assert(size >= 0);
+
+	if (m_size + size > m_capacity)
+	{
+		int32 capacity = b2Max(m_size + size, 2 * m_capacity);
+		char* newData = (char*)b2Alloc(capacity);
+		if (m_size > 0)
+		{
+			memcpy(newData, m_data, m_size);
+		}
+		b2Free(m_data);
+		m_data = newData;
+		m_capacity = capacity;
+	}
+
+	memcpy(m_data + m_size, data, size);
+	m_size += size;
+}
+
+void b2Snapshot::BeginRead() const
+{
+	m_readIndex = 0;
+}
+
+const void* b2Snapshot::Read(int32 size) const
+{
+	b2Assert(size >= 0 && m_readIndex + size <= m_size);
+	const void* data = m_data + m_readIndex;
+	m_readIndex += size;
+	return data;
+}
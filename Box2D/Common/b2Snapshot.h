@@ -0,0 +1,87 @@
+/*
+* Copyright (c) 2013 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_SNAPSHOT_H
+#define B2_SNAPSHOT_H
+
+#include <Box2D/Common/b2Settings.h>
+#include <cstring>
+
+/// A binary blob holding the state of a world, see b2World::Snapshot. The blob
+/// holds pointers, so it can only be restored into the world it was taken from.
+/// The buffer is kept between snapshots, so taking a snapshot every step does
+/// not allocate once the buffer has grown.
+class b2Snapshot
+{
+public:
+	b2Snapshot();
+	~b2Snapshot();
+
+	/// Get the size of the snapshot in bytes.
+	int32 GetSize() const;
+
+	/// Is there a snapshot?
+	bool IsEmpty() const;
+
+	/// Drop the snapshot, keeping the buffer.
+	void Clear();
+
+	/// Append data. This is used by the classes that write a snapshot.
+	void Write(const void* data, int32 size);
+
+	template <typename T>
+	void Write(const T& value)
+	{
+		Write(&value, sizeof(T));
+	}
+
+	/// Move the read position to the start. The read position is not part of
+	/// the snapshot, so reading does not change it.
+	void BeginRead() const;
+
+	/// Read data written by Write. This asserts if the snapshot is too short.
+	const void* Read(int32 size) const;
+
+	template <typename T>
+	void Read(T* value) const
+	{
+		memcpy(value, Read(sizeof(T)), sizeof(T));
+	}
+
+private:
+
+	b2Snapshot(const b2Snapshot&);
+	b2Snapshot& operator=(const b2Snapshot&);
+
+	char* m_data;
+	int32 m_size;
+	int32 m_capacity;
+	mutable int32 m_readIndex;
+};
+
+inline int32 b2Snapshot::GetSize() const
+{
+	return m_size;
+}
+
+inline bool b2Snapshot::IsEmpty() const
+{
+	return m_size == 0;
+}
+
+#endif
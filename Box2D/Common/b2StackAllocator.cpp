@@ -21,9 +21,12 @@
 
 b2StackAllocator::b2StackAllocator()
 {
+	m_capacity = b2_stackSize;
+	m_data = (char*)b2Alloc(m_capacity);
 	m_index = 0;
 	m_allocation = 0;
 	m_maxAllocation = 0;
+	m_fallbackCount = 0;
 	m_entryCount = 0;
 }
 
@@ -31,18 +34,38 @@ b2StackAllocator::~b2StackAllocator()
 {
 	b2Assert(m_index == 0);
 	b2Assert(m_entryCount == 0);
+	b2Free(m_data);
+}
+
+void b2StackAllocator::Grow(int32 capacity)
+{
+	b2Assert(m_entryCount == 0);
+	b2Free(m_data);
+
+	// Leave room for the peak to creep up, as it does while islands merge.
+	m_capacity = capacity + capacity / 2;
+	m_data = (char*)b2Alloc(m_capacity);
 }
 
 void* b2StackAllocator::Allocate(int32 size)
 {
 	b2Assert(m_entryCount < b2_maxStackEntries);
 
+	// Round up so the next allocation stays aligned.
+	size = (size + b2_stackAlignment - 1) & ~(b2_stackAlignment - 1);
+
+	if (m_entryCount == 0 && size > m_capacity)
+	{
+		Grow(size);
+	}
+
 	b2StackEntry* entry = m_entries + m_entryCount;
 	entry->size = size;
-	if (m_index + size > b2_stackSize)
+	if (m_index + size > m_capacity)
 	{
 		entry->data = (char*)b2Alloc(size);
 		entry->usedMalloc = true;
+		++m_fallbackCount;
 	}
 	else
 	{
@@ -74,6 +97,12 @@ void b2StackAllocator::Free(void* p)
 	m_allocation -= entry->size;
 	--m_entryCount;
 
+	// Keep the peak size so the next step fits on the stack.
+	if (m_entryCount == 0 && m_maxAllocation > m_capacity)
+	{
+		Grow(m_maxAllocation);
+	}
+
 	p = NULL;
 }
 
@@ -81,3 +110,13 @@ int32 b2StackAllocator::GetMaxAllocation() const
 {
 	return m_maxAllocation;
 }
+
+int32 b2StackAllocator::GetCapacity() const
+{
+	return m_capacity;
+}
+
+int32 b2StackAllocator::GetFallbackCount() const
+{
+	return m_fallbackCount;
+}
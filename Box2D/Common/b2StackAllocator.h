@@ -21,8 +21,9 @@
 
 #include <Box2D/Common/b2Settings.h>
 
-const int32 b2_stackSize = 100 * 1024;	// 100k
+const int32 b2_stackSize = 100 * 1024;	// 100k, the initial capacity
 const int32 b2_maxStackEntries = 32;
+const int32 b2_stackAlignment = 16;	// every allocation is aligned like b2Alloc
 
 struct b2StackEntry
 {
@@ -34,6 +35,8 @@ struct b2StackEntry
 // This is a stack allocator used for fast per step allocations.
 // You must nest allocate/free pairs. The code will assert
 // if you try to interleave multiple allocate/free pairs.
+// Allocations that do not fit fall back to b2Alloc. The stack grows to the
+// peak allocation once it is empty, so the next step does not fall back.
 class b2StackAllocator
 {
 public:
@@ -43,15 +46,28 @@ public:
 	void* Allocate(int32 size);
 	void Free(void* p);
 
+	/// Get the peak number of bytes allocated at once.
 	int32 GetMaxAllocation() const;
 
+	/// Get the number of bytes reserved for the stack.
+	int32 GetCapacity() const;
+
+	/// Get the number of allocations that fell back to b2Alloc.
+	int32 GetFallbackCount() const;
+
 private:
 
-	char m_data[b2_stackSize];
+	// Replace the stack while nothing is allocated from it. This adds headroom
+	// to the requested capacity.
+	void Grow(int32 capacity);
+
+	char* m_data;
+	int32 m_capacity;
 	int32 m_index;
 
 	int32 m_allocation;
 	int32 m_maxAllocation;
+	int32 m_fallbackCount;
 
 	b2StackEntry m_entries[b2_maxStackEntries];
 	int32 m_entryCount;
@@ -0,0 +1,35 @@
+/*
+* Copyright (c) 2013 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_THREAD_ALLOCATOR_H
+#define B2_THREAD_ALLOCATOR_H
+
+#include <Box2D/Common/b2BlockAllocator.h>
+#include <Box2D/Common/b2StackAllocator.h>
+
+/// The allocators of one thread pool thread. Neither allocator is thread safe,
+/// so a parallel task uses the allocators of its thread index to allocate
+/// without locks or b2Alloc. Stack allocations must be freed by the end of the
+/// task. Block allocations may persist, but must be freed by the same thread.
+struct b2ThreadAllocator
+{
+	b2StackAllocator stackAllocator;
+	b2BlockAllocator blockAllocator;
+};
+
+#endif
@@ -0,0 +1,169 @@
+/*
+* Copyright (c) 2013 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Common/b2ThreadPool.h>
+#include <Box2D/Common/b2Math.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <new>
+
+struct b2ThreadPoolImpl
+{
+	void Work(int32 threadIndex)
+	{
+		for (;;)
+		{
+			int32 index = next.fetch_add(1);
+			if (index >= count)
+			{
+				break;
+			}
+
+			task->Execute(index, threadIndex);
+		}
+	}
+
+	void WorkerMain(int32 threadIndex)
+	{
+		uint32 seen = 0;
+		for (;;)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				while (generation == seen && quit == false)
+				{
+					wake.wait(lock);
+				}
+
+				if (quit)
+				{
+					return;
+				}
+
+				seen = generation;
+			}
+
+			Work(threadIndex);
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				--busy;
+				if (busy == 0)
+				{
+					done.notify_one();
+				}
+			}
+		}
+	}
+
+	std::thread* threads;
+	int32 threadCount;
+
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+	uint32 generation;
+	int32 busy;
+	bool quit;
+
+	b2ParallelTask* task;
+	int32 count;
+	std::atomic<int32> next;
+};
+
+b2ThreadPool::b2ThreadPool(int32 threadCount)
+{
+	m_threadCount = b2Clamp(threadCount, 1, b2_maxThreads);
+
+	void* mem = b2Alloc(sizeof(b2ThreadPoolImpl));
+	m_impl = new (mem) b2ThreadPoolImpl;
+	m_impl->generation = 0;
+	m_impl->busy = 0;
+	m_impl->quit = false;
+	m_impl->task = NULL;
+	m_impl->count = 0;
+	m_impl->next = 0;
+
+	// The caller of Run is thread 0, so only the remaining threads are spawned.
+	m_impl->threadCount = m_threadCount - 1;
+	m_impl->threads = (std::thread*)b2Alloc(b2Max(m_impl->threadCount, 1) * sizeof(std::thread));
+	for (int32 i = 0; i < m_impl->threadCount; ++i)
+	{
+		new (m_impl->threads + i) std::thread(&b2ThreadPoolImpl::WorkerMain, m_impl, i + 1);
+	}
+}
+
+b2ThreadPool::~b2ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_impl->mutex);
+		m_impl->quit = true;
+	}
+	m_impl->wake.notify_all();
+
+	for (int32 i = 0; i < m_impl->threadCount; ++i)
+	{
+		m_impl->threads[i].join();
+		m_impl->threads[i].~thread();
+	}
+
+	b2Free(m_impl->threads);
+	m_impl->~b2ThreadPoolImpl();
+	b2Free(m_impl);
+}
+
+void b2ThreadPool::Run(b2ParallelTask* task, int32 count)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+
+	// Not worth waking the workers for a single item.
+	if (m_impl->threadCount == 0 || count == 1)
+	{
+		for (int32 i = 0; i < count; ++i)
+		{
+			task->Execute(i, 0);
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_impl->mutex);
+		m_impl->task = task;
+		m_impl->count = count;
+		m_impl->next = 0;
+		m_impl->busy = m_impl->threadCount;
+		++m_impl->generation;
+	}
+	m_impl->wake.notify_all();
+
+	m_impl->Work(0);
+
+	std::unique_lock<std::mutex> lock(m_impl->mutex);
+	while (m_impl->busy > 0)
+	{
+		m_impl->done.wait(lock);
+	}
+
+	m_impl->task = NULL;
+	m_impl->count = 0;
+}
@@ -0,0 +1,81 @@
+/*
+* Copyright (c) 2013 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_THREAD_POOL_H
+#define B2_THREAD_POOL_H
+
+#include <Box2D/Common/b2Settings.h>
+
+/// The maximum number of threads a b2ThreadPool will run, including the
+/// thread that calls b2ThreadPool::Run.
+#define b2_maxThreads		32
+
+/// Implement this class to run work on a b2ThreadPool. Execute is called
+/// exactly once for every index of the range passed to b2ThreadPool::Run,
+/// in no particular order and possibly from several threads at once.
+class b2ParallelTask
+{
+public:
+	virtual ~b2ParallelTask() {}
+
+	/// Run one work item.
+	/// @param index the work item, in [0, count).
+	/// @param threadIndex the pool thread running the item, in [0, threadCount).
+	/// The thread that called Run is always thread 0. Use this to pick
+	/// per-thread scratch memory.
+	virtual void Execute(int32 index, int32 threadIndex) = 0;
+};
+
+struct b2ThreadPoolImpl;
+
+/// A fixed set of worker threads used to spread independent work items,
+/// such as islands, over the available cores. The pool is owned by you
+/// and may be shared by several worlds as long as they are not stepped at
+/// the same time.
+class b2ThreadPool
+{
+public:
+	/// Construct a pool.
+	/// @param threadCount the total number of threads, including the caller
+	/// of Run. This is clamped to [1, b2_maxThreads]. A pool with one thread
+	/// runs everything on the calling thread.
+	b2ThreadPool(int32 threadCount);
+
+	/// Stops and joins the worker threads.
+	~b2ThreadPool();
+
+	/// Get the total number of threads, including the caller of Run.
+	int32 GetThreadCount() const;
+
+	/// Call task->Execute for every index in [0, count) and wait for all of
+	/// them to finish. The calling thread takes part as thread 0.
+	/// @warning this is not reentrant. Do not call Run from inside a task.
+	void Run(b2ParallelTask* task, int32 count);
+
+private:
+
+	b2ThreadPoolImpl* m_impl;
+	int32 m_threadCount;
+};
+
+inline int32 b2ThreadPool::GetThreadCount() const
+{
+	return m_threadCount;
+}
+
+#endif
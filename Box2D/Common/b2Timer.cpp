@@ -18,83 +18,78 @@
 
 #include <Box2D/Common/b2Timer.h>
 
-#if defined(_WIN32)
-
-float64 b2Timer::s_invFrequency = 0.0f;
-
-#include <windows.h>
-
 b2Timer::b2Timer()
 {
-	LARGE_INTEGER largeInteger;
-
-	if (s_invFrequency == 0.0f)
-	{
-		QueryPerformanceFrequency(&largeInteger);
-		s_invFrequency = float64(largeInteger.QuadPart);
-		if (s_invFrequency > 0.0f)
-		{
-			s_invFrequency = 1000.0f / s_invFrequency;
-		}
-	}
-
-	QueryPerformanceCounter(&largeInteger);
-	m_start = float64(largeInteger.QuadPart);
+	Reset();
 }
 
 void b2Timer::Reset()
 {
-	LARGE_INTEGER largeInteger;
-	QueryPerformanceCounter(&largeInteger);
-	m_start = float64(largeInteger.QuadPart);
+	m_start = GetTicks();
 }
 
 float32 b2Timer::GetMilliseconds() const
 {
-	LARGE_INTEGER largeInteger;
-	QueryPerformanceCounter(&largeInteger);
-	float64 count = float64(largeInteger.QuadPart);
-	float32 ms = float32(s_invFrequency * (count - m_start));
-	return ms;
+	return float32(float64(GetTicks() - m_start) * 1.0e-6);
 }
 
-#elif defined(__linux__) || defined (__APPLE__)
-
-#include <sys/time.h>
-
-b2Timer::b2Timer()
+uint64 b2Timer::GetNanoseconds() const
 {
-    Reset();
+	return GetTicks() - m_start;
 }
 
-void b2Timer::Reset()
-{
-    timeval t;
-    gettimeofday(&t, 0);
-    m_start_sec = t.tv_sec;
-    m_start_msec = t.tv_usec * 0.001f;
-}
+#if defined(_WIN32)
 
-float32 b2Timer::GetMilliseconds() const
+#include <windows.h>
+
+uint64 b2Timer::GetTicks()
 {
-    timeval t;
-    gettimeofday(&t, 0);
-    return (t.tv_sec - m_start_sec) * 1000 + t.tv_usec * 0.001f - m_start_msec;
+	static LARGE_INTEGER s_frequency;
+	if (s_frequency.QuadPart == 0)
+	{
+		QueryPerformanceFrequency(&s_frequency);
+	}
+
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+
+	// Split the conversion so it cannot overflow.
+	uint64 ticks = uint64(counter.QuadPart);
+	uint64 frequency = uint64(s_frequency.QuadPart);
+	return (ticks / frequency) * 1000000000ull + ((ticks % frequency) * 1000000000ull) / frequency;
 }
 
-#else
+#elif defined(__APPLE__)
 
-b2Timer::b2Timer()
+#include <mach/mach_time.h>
+
+uint64 b2Timer::GetTicks()
 {
+	static mach_timebase_info_data_t s_timebase;
+	if (s_timebase.denom == 0)
+	{
+		mach_timebase_info(&s_timebase);
+	}
+
+	return mach_absolute_time() * s_timebase.numer / s_timebase.denom;
 }
 
-void b2Timer::Reset()
+#elif defined(__linux__)
+
+#include <time.h>
+
+uint64 b2Timer::GetTicks()
 {
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return uint64(t.tv_sec) * 1000000000ull + uint64(t.tv_nsec);
 }
 
-float32 b2Timer::GetMilliseconds() const
+#else
+
+uint64 b2Timer::GetTicks()
 {
-	return 0.0f;
+	return 0;
 }
 
 #endif
@@ -16,6 +16,9 @@
 * 3. This notice may not be removed or altered from any source distribution.
 */
 
+#ifndef B2_TIMER_H
+#define B2_TIMER_H
+
 #include <Box2D/Common/b2Settings.h>
 
 /// Timer for profiling. This has platform specific code and may
@@ -33,13 +36,16 @@ public:
 	/// Get the time since construction or the last reset.
 	float32 GetMilliseconds() const;
 
+	/// Get the time since construction or the last reset in nanoseconds.
+	uint64 GetNanoseconds() const;
+
+	/// Read the monotonic clock used by the timer, in nanoseconds from an
+	/// unspecified start.
+	static uint64 GetTicks();
+
 private:
 
-#if defined(_WIN32)
-	float64 m_start;
-	static float64 s_invFrequency;
-#elif defined(__linux__) || defined (__APPLE__)
-	unsigned long m_start_sec;
-	unsigned long m_start_msec;
-#endif
+	uint64 m_start;
 };
+
+#endif
@@ -31,6 +31,7 @@
 #include <Box2D/Collision/Shapes/b2Shape.h>
 #include <Box2D/Common/b2BlockAllocator.h>
 #include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2ContactEvents.h>
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2World.h>
 
@@ -143,7 +144,12 @@ b2Contact::b2Contact(b2Fixture* fA, int32 indexA, b2Fixture* fB, int32 indexB)
 	m_nodeB.next = NULL;
 	m_nodeB.other = NULL;
 
+	m_island = NULL;
+	m_islandPrev = NULL;
+	m_islandNext = NULL;
+
 	m_toiCount = 0;
+	m_speculativeDistance = 0.0f;
 
 	m_friction = b2MixFriction(m_fixtureA->m_friction, m_fixtureB->m_friction);
 	m_restitution = b2MixRestitution(m_fixtureA->m_restitution, m_fixtureB->m_restitution);
@@ -151,40 +157,103 @@ b2Contact::b2Contact(b2Fixture* fA, int32 indexA, b2Fixture* fB, int32 indexB)
 
 // Update the contact manifold and touching status.
 // Note: do not assume the fixture AABBs are overlapping or are valid.
-void b2Contact::Update(b2ContactListener* listener)
+void b2Contact::Update(b2ContactListener* listener, b2ContactEvents* events, float32 speculativeTime)
+{
+	b2Manifold manifold;
+	bool touching = ComputeManifold(&manifold, speculativeTime);
+	Update(listener, events, manifold, touching);
+}
+
+float32 b2Contact::ComputeSpeculativeDistance(float32 speculativeTime) const
+{
+	const b2Body* bodyA = m_fixtureA->GetBody();
+	const b2Body* bodyB = m_fixtureB->GetBody();
+
+	// Bound the distance from each center of mass to its shape with the AABB.
+	b2AABB aabbA, aabbB;
+	m_fixtureA->GetShape()->ComputeAABB(&aabbA, bodyA->Transform(), m_indexA);
+	m_fixtureB->GetShape()->ComputeAABB(&aabbB, bodyB->Transform(), m_indexB);
+	float32 rA = b2Distance(aabbA.GetCenter(), bodyA->Sweep().c) + aabbA.GetExtents().Length();
+	float32 rB = b2Distance(aabbB.GetCenter(), bodyB->Sweep().c) + aabbB.GetExtents().Length();
+
+	b2Vec2 dv = bodyB->LinearVelocity() - bodyA->LinearVelocity();
+	float32 speed = dv.Length() + b2Abs(bodyA->AngularVelocity()) * rA + b2Abs(bodyB->AngularVelocity()) * rB;
+	return b2_speculativeDistance + speculativeTime * speed;
+}
+
+bool b2Contact::ComputeManifold(b2Manifold* manifold, float32 speculativeTime)
+{
+	// Start from the current manifold so the parts a collider leaves alone are kept.
+	*manifold = m_manifold;
+	m_flags &= ~(e_cacheHitFlag | e_cacheMissFlag);
+
+	const b2Transform& xfA = m_fixtureA->GetBody()->GetTransform();
+	const b2Transform& xfB = m_fixtureB->GetBody()->GetTransform();
+
+	// Is this contact a sensor?
+	if (m_fixtureA->IsSensor() || m_fixtureB->IsSensor())
+	{
+		// Sensors don't generate manifolds.
+		manifold->pointCount = 0;
+
+		const b2Shape* shapeA = m_fixtureA->GetShape();
+		const b2Shape* shapeB = m_fixtureB->GetShape();
+		return b2TestOverlap(shapeA, m_indexA, shapeB, m_indexB, xfA, xfB);
+	}
+
+	m_speculativeDistance = 0.0f;
+	if (speculativeTime > 0.0f)
+	{
+		m_speculativeDistance = ComputeSpeculativeDistance(speculativeTime);
+	}
+
+	Evaluate(manifold, xfA, xfB);
+	if (manifold->pointCount == 0)
+	{
+		return false;
+	}
+
+	if (m_speculativeDistance == 0.0f)
+	{
+		return true;
+	}
+
+	// Speculative points can be well apart. The shapes touch once the closest
+	// point is within the slop.
+	b2WorldManifold worldManifold;
+	worldManifold.Initialize(manifold, xfA, m_fixtureA->GetShape()->m_radius, xfB, m_fixtureB->GetShape()->m_radius);
+	float32 minSeparation = worldManifold.separations[0];
+	for (int32 i = 1; i < manifold->pointCount; ++i)
+	{
+		minSeparation = b2Min(minSeparation, worldManifold.separations[i]);
+	}
+	return minSeparation <= b2_linearSlop;
+}
+
+void b2Contact::Update(b2ContactListener* listener, b2ContactEvents* events, const b2Manifold& manifold, bool touching)
 {
 	b2Manifold oldManifold = m_manifold;
 
 	// Re-enable this contact.
 	m_flags |= e_enabledFlag;
 
-	bool touching = false;
 	bool wasTouching = (m_flags & e_touchingFlag) == e_touchingFlag;
+	bool wasSolved = HasSolverPoints();
 
 	bool sensorA = m_fixtureA->IsSensor();
 	bool sensorB = m_fixtureB->IsSensor();
 	bool sensor = sensorA || sensorB;
 
+	// Sensors have no points, so this is only set for solid contacts.
+	bool speculative = touching == false && manifold.pointCount > 0;
+
 	b2Body* bodyA = m_fixtureA->GetBody();
 	b2Body* bodyB = m_fixtureB->GetBody();
-	const b2Transform& xfA = bodyA->GetTransform();
-	const b2Transform& xfB = bodyB->GetTransform();
 
-	// Is this contact a sensor?
-	if (sensor)
-	{
-		const b2Shape* shapeA = m_fixtureA->GetShape();
-		const b2Shape* shapeB = m_fixtureB->GetShape();
-		touching = b2TestOverlap(shapeA, m_indexA, shapeB, m_indexB, xfA, xfB);
+	m_manifold = manifold;
 
-		// Sensors don't generate manifolds.
-		m_manifold.pointCount = 0;
-	}
-	else
+	if (sensor == false)
 	{
-		Evaluate(&m_manifold, xfA, xfB);
-		touching = m_manifold.pointCount > 0;
-
 		// Match old contact ids to new contact ids and copy the
 		// stored impulses to warm start the solver.
 		for (int32 i = 0; i < m_manifold.pointCount; ++i)
@@ -207,7 +276,7 @@ void b2Contact::Update(b2ContactListener* listener)
 			}
 		}
 
-		if (touching != wasTouching)
+		if ((touching || speculative) != wasSolved)
 		{
 			bodyA->SetAwake(true);
 			bodyB->SetAwake(true);
@@ -223,17 +292,43 @@ void b2Contact::Update(b2ContactListener* listener)
 		m_flags &= ~e_touchingFlag;
 	}
 
-	if (wasTouching == false && touching == true && listener)
+	if (speculative)
+	{
+		m_flags |= e_speculativeFlag;
+	}
+	else
+	{
+		m_flags &= ~e_speculativeFlag;
+	}
+
+	if (wasTouching == false && touching == true)
 	{
-		listener->BeginContact(this);
+		if (listener)
+		{
+			listener->BeginContact(this);
+		}
+
+		if (events)
+		{
+			events->AddBegin(this);
+		}
 	}
 
-	if (wasTouching == true && touching == false && listener)
+	if (wasTouching == true && touching == false)
 	{
-		listener->EndContact(this);
+		if (listener)
+		{
+			listener->EndContact(this);
+		}
+
+		if (events)
+		{
+			events->AddEnd(this);
+		}
 	}
 
-	if (sensor == false && touching && listener)
+	// Speculative contacts are solved too, so the listener can still disable them.
+	if (sensor == false && (touching || speculative) && listener)
 	{
 		listener->PreSolve(this, &oldManifold);
 	}
@@ -31,12 +31,14 @@ class b2World;
 class b2BlockAllocator;
 class b2StackAllocator;
 class b2ContactListener;
+class b2ContactEvents;
+struct b2PersistentIsland;
 
 /// Friction mixing law. The idea is to allow either fixture to drive the restitution to zero.
 /// For example, anything slides on ice.
 inline float32 b2MixFriction(float32 friction1, float32 friction2)
 {
-	return std::sqrt(friction1 * friction2);
+	return b2Sqrt(friction1 * friction2);
 }
 
 /// Restitution mixing law. The idea is allow for anything to bounce off an inelastic surface.
@@ -86,7 +88,8 @@ public:
 	/// Get the world manifold.
 	void GetWorldManifold(b2WorldManifold* worldManifold) const;
 
-	/// Is this contact touching?
+	/// Is this contact touching? Speculative contacts, see b2World::SetSpeculativeContacts,
+	/// may have manifold points before the shapes touch.
 	bool IsTouching() const;
 
 	/// Enable/disable this contact. This can be used inside the pre-solve
@@ -140,10 +143,12 @@ public:
 
 protected:
 	friend class b2ContactManager;
+	friend class b2IslandManager;
 	friend class b2World;
 	friend class b2ContactSolver;
 	friend class b2Body;
 	friend class b2Fixture;
+	friend struct b2NarrowPhaseTask;
 
 	// Flags stored in m_flags
 	enum
@@ -164,7 +169,14 @@ protected:
 		e_bulletHitFlag		= 0x0010,
 
 		// This contact has a valid TOI in m_toi
-		e_toiFlag			= 0x0020
+		e_toiFlag			= 0x0020,
+
+		// The last manifold reused or searched for the cached separating edges
+		e_cacheHitFlag		= 0x0040,
+		e_cacheMissFlag		= 0x0080,
+
+		// The manifold has speculative points but the shapes are not touching yet
+		e_speculativeFlag	= 0x0100
 	};
 
 	/// Flag this contact for filtering. Filtering will occur the next time step.
@@ -181,7 +193,27 @@ protected:
 	b2Contact(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB);
 	virtual ~b2Contact() {}
 
-	void Update(b2ContactListener* listener);
+	void Update(b2ContactListener* listener, b2ContactEvents* events, float32 speculativeTime = 0.0f);
+
+	// Touching, or the manifold has speculative points. The solver handles both.
+	bool HasSolverPoints() const;
+
+	// Compute the manifold for the current body transforms. Sensors only test for
+	// overlap and get no points. If speculativeTime is positive, points are kept
+	// for shapes that the relative motion over that time could bring into contact.
+	// This only writes m_speculativeDistance and reads the bodies, so several
+	// contacts can be computed in parallel. Returns true if the shapes are touching,
+	// which for speculative points means they are within b2_linearSlop.
+	bool ComputeManifold(b2Manifold* manifold, float32 speculativeTime = 0.0f);
+
+	// The distance the relative motion over the given time can close, bounded
+	// using the body velocities and the fixture AABBs.
+	float32 ComputeSpeculativeDistance(float32 speculativeTime) const;
+
+	// Update with a manifold from ComputeManifold. This matches the warm starting
+	// impulses, wakes the bodies and reports the contact events like Update.
+	// The begin and end events are also recorded in the event buffers, if any.
+	void Update(b2ContactListener* listener, b2ContactEvents* events, const b2Manifold& manifold, bool touching);
 
 	static b2ContactRegister s_registers[b2Shape::e_typeCount][b2Shape::e_typeCount];
 	static bool s_initialized;
@@ -196,6 +228,11 @@ protected:
 	b2ContactEdge m_nodeA;
 	b2ContactEdge m_nodeB;
 
+	// The persistent island, set while the contact is touching.
+	b2PersistentIsland* m_island;
+	b2Contact* m_islandPrev;
+	b2Contact* m_islandNext;
+
 	b2Fixture* m_fixtureA;
 	b2Fixture* m_fixtureB;
 
@@ -209,6 +246,9 @@ protected:
 
 	float32 m_friction;
 	float32 m_restitution;
+
+	// The points that Evaluate keeps may be this far apart.
+	float32 m_speculativeDistance;
 };
 
 inline b2Manifold* b2Contact::GetManifold()
@@ -253,6 +293,11 @@ inline bool b2Contact::IsTouching() const
 	return (m_flags & e_touchingFlag) == e_touchingFlag;
 }
 
+inline bool b2Contact::HasSolverPoints() const
+{
+	return (m_flags & (e_touchingFlag | e_speculativeFlag)) != 0;
+}
+
 inline b2Contact* b2Contact::GetNext()
 {
 	return m_next;
@@ -23,6 +23,8 @@
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2World.h>
 #include <Box2D/Common/b2StackAllocator.h>
+#include <Box2D/Common/b2Simd.h>
+#include <cstring>
 
 #define B2_DEBUG_SOLVER 0
 
@@ -41,6 +43,36 @@ struct b2ContactPositionConstraint
 	int32 pointCount;
 };
 
+// Velocity constraints of up to b2_simdWidth contacts with the same point count,
+// stored as structure of arrays. No two contacts in a batch share a body that
+// the solver moves, so the lanes can be solved at the same time.
+struct b2ContactVelocityBatch
+{
+	int32 indexA[b2_simdWidth];
+	int32 indexB[b2_simdWidth];
+	int32 constraintIndex[b2_simdWidth];
+	int32 count;
+	int32 pointCount;
+
+	float32 invMassA[b2_simdWidth], invMassB[b2_simdWidth];
+	float32 invIA[b2_simdWidth], invIB[b2_simdWidth];
+	float32 normalX[b2_simdWidth], normalY[b2_simdWidth];
+	float32 friction[b2_simdWidth];
+
+	float32 rAx[b2_maxManifoldPoints][b2_simdWidth], rAy[b2_maxManifoldPoints][b2_simdWidth];
+	float32 rBx[b2_maxManifoldPoints][b2_simdWidth], rBy[b2_maxManifoldPoints][b2_simdWidth];
+	float32 normalImpulse[b2_maxManifoldPoints][b2_simdWidth];
+	float32 tangentImpulse[b2_maxManifoldPoints][b2_simdWidth];
+	float32 normalMass[b2_maxManifoldPoints][b2_simdWidth];
+	float32 tangentMass[b2_maxManifoldPoints][b2_simdWidth];
+	float32 velocityBias[b2_maxManifoldPoints][b2_simdWidth];
+
+	// Block solver, only used when pointCount == 2.
+	float32 k11[b2_simdWidth], k12[b2_simdWidth], k22[b2_simdWidth];
+	float32 normalMass11[b2_simdWidth], normalMass12[b2_simdWidth];
+	float32 normalMass21[b2_simdWidth], normalMass22[b2_simdWidth];
+};
+
 b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 {
 	m_step = def->step;
@@ -51,6 +83,11 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 	m_positions = def->positions;
 	m_velocities = def->velocities;
 	m_contacts = def->contacts;
+	m_batches = NULL;
+	m_batchOrder = NULL;
+	m_batchCount = 0;
+
+	const b2SolverData* solverData = def->solverData;
 
 	// Initialize position independent portions of the constraints.
 	for (int32 i = 0; i < m_count; ++i)
@@ -73,26 +110,26 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
 		vc->friction = contact->m_friction;
 		vc->restitution = contact->m_restitution;
-		vc->indexA = bodyA->m_islandIndex;
-		vc->indexB = bodyB->m_islandIndex;
-		vc->invMassA = bodyA->m_invMass;
-		vc->invMassB = bodyB->m_invMass;
-		vc->invIA = bodyA->m_invI;
-		vc->invIB = bodyB->m_invI;
+		vc->indexA = solverData->GetIndex(bodyA);
+		vc->indexB = solverData->GetIndex(bodyB);
+		vc->invMassA = bodyA->InvMass();
+		vc->invMassB = bodyB->InvMass();
+		vc->invIA = bodyA->InvI();
+		vc->invIB = bodyB->InvI();
 		vc->contactIndex = i;
 		vc->pointCount = pointCount;
 		vc->K.SetZero();
 		vc->normalMass.SetZero();
 
 		b2ContactPositionConstraint* pc = m_positionConstraints + i;
-		pc->indexA = bodyA->m_islandIndex;
-		pc->indexB = bodyB->m_islandIndex;
-		pc->invMassA = bodyA->m_invMass;
-		pc->invMassB = bodyB->m_invMass;
-		pc->localCenterA = bodyA->m_sweep.localCenter;
-		pc->localCenterB = bodyB->m_sweep.localCenter;
-		pc->invIA = bodyA->m_invI;
-		pc->invIB = bodyB->m_invI;
+		pc->indexA = solverData->GetIndex(bodyA);
+		pc->indexB = solverData->GetIndex(bodyB);
+		pc->invMassA = bodyA->InvMass();
+		pc->invMassB = bodyB->InvMass();
+		pc->localCenterA = bodyA->Sweep().localCenter;
+		pc->localCenterB = bodyB->Sweep().localCenter;
+		pc->invIA = bodyA->InvI();
+		pc->invIB = bodyB->InvI();
 		pc->localNormal = manifold->localNormal;
 		pc->localPoint = manifold->localPoint;
 		pc->pointCount = pointCount;
@@ -129,6 +166,12 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 
 b2ContactSolver::~b2ContactSolver()
 {
+	if (m_batches)
+	{
+		m_allocator->Free(m_batches);
+		m_allocator->Free(m_batchOrder);
+	}
+
 	m_allocator->Free(m_velocityConstraints);
 	m_allocator->Free(m_positionConstraints);
 }
@@ -205,7 +248,13 @@ void b2ContactSolver::InitializeVelocityConstraints()
 			// Setup a velocity bias for restitution.
 			vcp->velocityBias = 0.0f;
 			float32 vRel = b2Dot(vc->normal, vB + b2Cross(wB, vcp->rB) - vA - b2Cross(wA, vcp->rA));
-			if (vRel < -b2_velocityThreshold)
+			float32 separation = worldManifold.separations[j];
+			if (m_step.speculativeContacts && separation > 0.0f)
+			{
+				// A speculative point only stops the approach that would close the gap.
+				vcp->velocityBias = -separation * m_step.inv_dt;
+			}
+			else if (vRel < -b2_velocityThreshold)
 			{
 				vcp->velocityBias = -vc->restitution * vRel;
 			}
@@ -287,6 +336,12 @@ void b2ContactSolver::WarmStart()
 
 void b2ContactSolver::SolveVelocityConstraints()
 {
+	if (m_batches)
+	{
+		SolveVelocityBatches();
+		return;
+	}
+
 	for (int32 i = 0; i < m_count; ++i)
 	{
 		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
@@ -597,6 +652,22 @@ void b2ContactSolver::SolveVelocityConstraints()
 
 void b2ContactSolver::StoreImpulses()
 {
+	// Bring the batched impulses back to the constraints, they are also
+	// used to report the contact impulses.
+	for (int32 i = 0; i < m_batchCount; ++i)
+	{
+		const b2ContactVelocityBatch* batch = m_batches + i;
+		for (int32 lane = 0; lane < batch->count; ++lane)
+		{
+			b2ContactVelocityConstraint* vc = m_velocityConstraints + batch->constraintIndex[lane];
+			for (int32 j = 0; j < vc->pointCount; ++j)
+			{
+				vc->points[j].normalImpulse = batch->normalImpulse[j][lane];
+				vc->points[j].tangentImpulse = batch->tangentImpulse[j][lane];
+			}
+		}
+	}
+
 	for (int32 i = 0; i < m_count; ++i)
 	{
 		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
@@ -610,6 +681,366 @@ void b2ContactSolver::StoreImpulses()
 	}
 }
 
+// Greedy graph coloring of the velocity constraints. Each color holds contacts
+// with the same point count that share no moving body, and is then cut into
+// batches of b2_simdWidth. Bodies without mass and inertia (static and
+// kinematic) are never written by a contact, so they may be shared.
+void b2ContactSolver::InitializeVelocityBatches()
+{
+	b2Assert(m_batches == NULL);
+
+	// m_batchOrder holds the colored constraint order followed by the color of
+	// each entry.
+	m_batchOrder = (int32*)m_allocator->Allocate(2 * m_count * sizeof(int32));
+	int32* order = m_batchOrder;
+	int32* colors = m_batchOrder + m_count;
+
+	int32 bodyCount = 0;
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
+		bodyCount = b2Max(bodyCount, b2Max(vc->indexA, vc->indexB) + 1);
+	}
+
+	int32* stamps = (int32*)m_allocator->Allocate(bodyCount * sizeof(int32));
+	int32* pending = (int32*)m_allocator->Allocate(m_count * sizeof(int32));
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		stamps[i] = -1;
+	}
+
+	int32 pendingCount = m_count;
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		pending[i] = i;
+	}
+
+	int32 orderCount = 0;
+	int32 colorCount = 0;
+	m_batchCount = 0;
+	while (pendingCount > 0)
+	{
+		for (int32 pointCount = b2_maxManifoldPoints; pointCount > 0; --pointCount)
+		{
+			int32 color = colorCount;
+			int32 colorStart = orderCount;
+			int32 keepCount = 0;
+			for (int32 k = 0; k < pendingCount; ++k)
+			{
+				int32 i = pending[k];
+				b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
+
+				bool movesA = vc->invMassA > 0.0f || vc->invIA > 0.0f;
+				bool movesB = vc->invMassB > 0.0f || vc->invIB > 0.0f;
+				if (vc->pointCount != pointCount ||
+					(movesA && stamps[vc->indexA] == color) ||
+					(movesB && stamps[vc->indexB] == color))
+				{
+					pending[keepCount++] = i;
+					continue;
+				}
+
+				if (movesA)
+				{
+					stamps[vc->indexA] = color;
+				}
+
+				if (movesB)
+				{
+					stamps[vc->indexB] = color;
+				}
+
+				order[orderCount] = i;
+				colors[orderCount] = color;
+				++orderCount;
+			}
+
+			pendingCount = keepCount;
+
+			int32 colorSize = orderCount - colorStart;
+			if (colorSize > 0)
+			{
+				m_batchCount += (colorSize + b2_simdWidth - 1) / b2_simdWidth;
+				++colorCount;
+			}
+		}
+	}
+
+	m_allocator->Free(pending);
+	m_allocator->Free(stamps);
+
+	m_batches = (b2ContactVelocityBatch*)m_allocator->Allocate(m_batchCount * sizeof(b2ContactVelocityBatch));
+
+	int32 batchIndex = -1;
+	b2ContactVelocityBatch* batch = NULL;
+	for (int32 k = 0; k < m_count; ++k)
+	{
+		if (batch == NULL || batch->count == b2_simdWidth || colors[k] != colors[k - 1])
+		{
+			++batchIndex;
+			batch = m_batches + batchIndex;
+			memset(batch, 0, sizeof(b2ContactVelocityBatch));
+		}
+
+		int32 i = order[k];
+		const b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
+
+		int32 lane = batch->count++;
+		batch->pointCount = vc->pointCount;
+		batch->indexA[lane] = vc->indexA;
+		batch->indexB[lane] = vc->indexB;
+		batch->constraintIndex[lane] = i;
+		batch->invMassA[lane] = vc->invMassA;
+		batch->invMassB[lane] = vc->invMassB;
+		batch->invIA[lane] = vc->invIA;
+		batch->invIB[lane] = vc->invIB;
+		batch->normalX[lane] = vc->normal.x;
+		batch->normalY[lane] = vc->normal.y;
+		batch->friction[lane] = vc->friction;
+
+		for (int32 j = 0; j < vc->pointCount; ++j)
+		{
+			const b2VelocityConstraintPoint* vcp = vc->points + j;
+			batch->rAx[j][lane] = vcp->rA.x;
+			batch->rAy[j][lane] = vcp->rA.y;
+			batch->rBx[j][lane] = vcp->rB.x;
+			batch->rBy[j][lane] = vcp->rB.y;
+			batch->normalImpulse[j][lane] = vcp->normalImpulse;
+			batch->tangentImpulse[j][lane] = vcp->tangentImpulse;
+			batch->normalMass[j][lane] = vcp->normalMass;
+			batch->tangentMass[j][lane] = vcp->tangentMass;
+			batch->velocityBias[j][lane] = vcp->velocityBias;
+		}
+
+		batch->k11[lane] = vc->K.ex.x;
+		batch->k12[lane] = vc->K.ex.y;
+		batch->k22[lane] = vc->K.ey.y;
+		batch->normalMass11[lane] = vc->normalMass.ex.x;
+		batch->normalMass12[lane] = vc->normalMass.ey.x;
+		batch->normalMass21[lane] = vc->normalMass.ex.y;
+		batch->normalMass22[lane] = vc->normalMass.ey.y;
+	}
+
+	b2Assert(batchIndex + 1 == m_batchCount);
+}
+
+// This mirrors the scalar solver, lane by lane, including the order of the
+// floating point operations.
+void b2ContactSolver::SolveVelocityBatches()
+{
+	float32 vAx[b2_simdWidth], vAy[b2_simdWidth], wAs[b2_simdWidth];
+	float32 vBx[b2_simdWidth], vBy[b2_simdWidth], wBs[b2_simdWidth];
+
+	const b2FloatW zero = b2ZeroW();
+
+	for (int32 i = 0; i < m_batchCount; ++i)
+	{
+		b2ContactVelocityBatch* batch = m_batches + i;
+		int32 count = batch->count;
+
+		// Gather
+		for (int32 lane = 0; lane < b2_simdWidth; ++lane)
+		{
+			if (lane < count)
+			{
+				const b2Velocity& velocityA = m_velocities[batch->indexA[lane]];
+				const b2Velocity& velocityB = m_velocities[batch->indexB[lane]];
+				vAx[lane] = velocityA.v.x;
+				vAy[lane] = velocityA.v.y;
+				wAs[lane] = velocityA.w;
+				vBx[lane] = velocityB.v.x;
+				vBy[lane] = velocityB.v.y;
+				wBs[lane] = velocityB.w;
+			}
+			else
+			{
+				vAx[lane] = vAy[lane] = wAs[lane] = 0.0f;
+				vBx[lane] = vBy[lane] = wBs[lane] = 0.0f;
+			}
+		}
+
+		b2FloatW vAX = b2LoadW(vAx), vAY = b2LoadW(vAy), wA = b2LoadW(wAs);
+		b2FloatW vBX = b2LoadW(vBx), vBY = b2LoadW(vBy), wB = b2LoadW(wBs);
+
+		b2FloatW mA = b2LoadW(batch->invMassA);
+		b2FloatW iA = b2LoadW(batch->invIA);
+		b2FloatW mB = b2LoadW(batch->invMassB);
+		b2FloatW iB = b2LoadW(batch->invIB);
+
+		b2FloatW normalX = b2LoadW(batch->normalX);
+		b2FloatW normalY = b2LoadW(batch->normalY);
+		b2FloatW tangentX = normalY;
+		b2FloatW tangentY = -normalX;
+		b2FloatW friction = b2LoadW(batch->friction);
+
+		int32 pointCount = batch->pointCount;
+
+		// Solve tangent constraints first because non-penetration is more important
+		// than friction.
+		for (int32 j = 0; j < pointCount; ++j)
+		{
+			b2FloatW rAX = b2LoadW(batch->rAx[j]), rAY = b2LoadW(batch->rAy[j]);
+			b2FloatW rBX = b2LoadW(batch->rBx[j]), rBY = b2LoadW(batch->rBy[j]);
+
+			// Relative velocity at contact
+			b2FloatW dvX = vBX + (-wB) * rBY - vAX - (-wA) * rAY;
+			b2FloatW dvY = vBY + wB * rBX - vAY - wA * rAX;
+
+			// Compute tangent force
+			b2FloatW vt = dvX * tangentX + dvY * tangentY;
+			b2FloatW lambda = b2LoadW(batch->tangentMass[j]) * (-vt);
+
+			// Clamp the accumulated force
+			b2FloatW oldImpulse = b2LoadW(batch->tangentImpulse[j]);
+			b2FloatW maxFriction = friction * b2LoadW(batch->normalImpulse[j]);
+			b2FloatW newImpulse = b2MaxW(-maxFriction, b2MinW(oldImpulse + lambda, maxFriction));
+			lambda = newImpulse - oldImpulse;
+			b2StoreW(batch->tangentImpulse[j], newImpulse);
+
+			// Apply contact impulse
+			b2FloatW PX = lambda * tangentX;
+			b2FloatW PY = lambda * tangentY;
+
+			vAX = vAX - mA * PX;
+			vAY = vAY - mA * PY;
+			wA = wA - iA * (rAX * PY - rAY * PX);
+
+			vBX = vBX + mB * PX;
+			vBY = vBY + mB * PY;
+			wB = wB + iB * (rBX * PY - rBY * PX);
+		}
+
+		// Solve normal constraints
+		if (pointCount == 1)
+		{
+			b2FloatW rAX = b2LoadW(batch->rAx[0]), rAY = b2LoadW(batch->rAy[0]);
+			b2FloatW rBX = b2LoadW(batch->rBx[0]), rBY = b2LoadW(batch->rBy[0]);
+
+			// Relative velocity at contact
+			b2FloatW dvX = vBX + (-wB) * rBY - vAX - (-wA) * rAY;
+			b2FloatW dvY = vBY + wB * rBX - vAY - wA * rAX;
+
+			// Compute normal impulse
+			b2FloatW vn = dvX * normalX + dvY * normalY;
+			b2FloatW lambda = (-b2LoadW(batch->normalMass[0])) * (vn - b2LoadW(batch->velocityBias[0]));
+
+			// Clamp the accumulated impulse
+			b2FloatW oldImpulse = b2LoadW(batch->normalImpulse[0]);
+			b2FloatW newImpulse = b2MaxW(oldImpulse + lambda, zero);
+			lambda = newImpulse - oldImpulse;
+			b2StoreW(batch->normalImpulse[0], newImpulse);
+
+			// Apply contact impulse
+			b2FloatW PX = lambda * normalX;
+			b2FloatW PY = lambda * normalY;
+
+			vAX = vAX - mA * PX;
+			vAY = vAY - mA * PY;
+			wA = wA - iA * (rAX * PY - rAY * PX);
+
+			vBX = vBX + mB * PX;
+			vBY = vBY + mB * PY;
+			wB = wB + iB * (rBX * PY - rBY * PX);
+		}
+		else
+		{
+			// Block solver, see SolveVelocityConstraints. All four cases are
+			// evaluated and the first valid one is selected per lane.
+			b2FloatW r1AX = b2LoadW(batch->rAx[0]), r1AY = b2LoadW(batch->rAy[0]);
+			b2FloatW r1BX = b2LoadW(batch->rBx[0]), r1BY = b2LoadW(batch->rBy[0]);
+			b2FloatW r2AX = b2LoadW(batch->rAx[1]), r2AY = b2LoadW(batch->rAy[1]);
+			b2FloatW r2BX = b2LoadW(batch->rBx[1]), r2BY = b2LoadW(batch->rBy[1]);
+
+			b2FloatW aX = b2LoadW(batch->normalImpulse[0]);
+			b2FloatW aY = b2LoadW(batch->normalImpulse[1]);
+
+			// Relative velocity at contact
+			b2FloatW dv1X = vBX + (-wB) * r1BY - vAX - (-wA) * r1AY;
+			b2FloatW dv1Y = vBY + wB * r1BX - vAY - wA * r1AX;
+			b2FloatW dv2X = vBX + (-wB) * r2BY - vAX - (-wA) * r2AY;
+			b2FloatW dv2Y = vBY + wB * r2BX - vAY - wA * r2AX;
+
+			// Compute normal velocity
+			b2FloatW vn1 = dv1X * normalX + dv1Y * normalY;
+			b2FloatW vn2 = dv2X * normalX + dv2Y * normalY;
+
+			b2FloatW bX = vn1 - b2LoadW(batch->velocityBias[0]);
+			b2FloatW bY = vn2 - b2LoadW(batch->velocityBias[1]);
+
+			// Compute b'
+			b2FloatW k11 = b2LoadW(batch->k11);
+			b2FloatW k12 = b2LoadW(batch->k12);
+			b2FloatW k22 = b2LoadW(batch->k22);
+			bX = bX - (k11 * aX + k12 * aY);
+			bY = bY - (k12 * aX + k22 * aY);
+
+			// Case 4: x1 = 0 and x2 = 0
+			b2FloatW valid = b2AndW(b2GreaterEqualW(bX, zero), b2GreaterEqualW(bY, zero));
+			b2FloatW xX = b2SelectW(valid, zero, aX);
+			b2FloatW xY = b2SelectW(valid, zero, aY);
+
+			// Case 3: vn2 = 0 and x1 = 0
+			b2FloatW x3Y = (-b2LoadW(batch->normalMass[1])) * bY;
+			b2FloatW vn13 = k12 * x3Y + bX;
+			valid = b2AndW(b2GreaterEqualW(x3Y, zero), b2GreaterEqualW(vn13, zero));
+			xX = b2SelectW(valid, zero, xX);
+			xY = b2SelectW(valid, x3Y, xY);
+
+			// Case 2: vn1 = 0 and x2 = 0
+			b2FloatW x2X = (-b2LoadW(batch->normalMass[0])) * bX;
+			b2FloatW vn22 = k12 * x2X + bY;
+			valid = b2AndW(b2GreaterEqualW(x2X, zero), b2GreaterEqualW(vn22, zero));
+			xX = b2SelectW(valid, x2X, xX);
+			xY = b2SelectW(valid, zero, xY);
+
+			// Case 1: vn = 0
+			b2FloatW x1X = -(b2LoadW(batch->normalMass11) * bX + b2LoadW(batch->normalMass12) * bY);
+			b2FloatW x1Y = -(b2LoadW(batch->normalMass21) * bX + b2LoadW(batch->normalMass22) * bY);
+			valid = b2AndW(b2GreaterEqualW(x1X, zero), b2GreaterEqualW(x1Y, zero));
+			xX = b2SelectW(valid, x1X, xX);
+			xY = b2SelectW(valid, x1Y, xY);
+
+			// Get the incremental impulse
+			b2FloatW dX = xX - aX;
+			b2FloatW dY = xY - aY;
+
+			// Apply incremental impulse
+			b2FloatW P1X = dX * normalX, P1Y = dX * normalY;
+			b2FloatW P2X = dY * normalX, P2Y = dY * normalY;
+
+			vAX = vAX - mA * (P1X + P2X);
+			vAY = vAY - mA * (P1Y + P2Y);
+			wA = wA - iA * ((r1AX * P1Y - r1AY * P1X) + (r2AX * P2Y - r2AY * P2X));
+
+			vBX = vBX + mB * (P1X + P2X);
+			vBY = vBY + mB * (P1Y + P2Y);
+			wB = wB + iB * ((r1BX * P1Y - r1BY * P1X) + (r2BX * P2Y - r2BY * P2X));
+
+			// Accumulate
+			b2StoreW(batch->normalImpulse[0], xX);
+			b2StoreW(batch->normalImpulse[1], xY);
+		}
+
+		// Scatter
+		b2StoreW(vAx, vAX);
+		b2StoreW(vAy, vAY);
+		b2StoreW(wAs, wA);
+		b2StoreW(vBx, vBX);
+		b2StoreW(vBy, vBY);
+		b2StoreW(wBs, wB);
+
+		for (int32 lane = 0; lane < count; ++lane)
+		{
+			b2Velocity& velocityA = m_velocities[batch->indexA[lane]];
+			b2Velocity& velocityB = m_velocities[batch->indexB[lane]];
+			velocityA.v.Set(vAx[lane], vAy[lane]);
+			velocityA.w = wAs[lane];
+			velocityB.v.Set(vBx[lane], vBy[lane]);
+			velocityB.w = wBs[lane];
+		}
+	}
+}
+
 struct b2PositionSolverManifold
 {
 	void Initialize(b2ContactPositionConstraint* pc, const b2Transform& xfA, const b2Transform& xfB, int32 index)
@@ -27,6 +27,7 @@ class b2Contact;
 class b2Body;
 class b2StackAllocator;
 struct b2ContactPositionConstraint;
+struct b2ContactVelocityBatch;
 
 struct b2VelocityConstraintPoint
 {
@@ -62,6 +63,7 @@ struct b2ContactSolverDef
 	int32 count;
 	b2Position* positions;
 	b2Velocity* velocities;
+	const b2SolverData* solverData;	///< finds the island index of each body
 	b2StackAllocator* allocator;
 };
 
@@ -77,6 +79,11 @@ public:
 	void SolveVelocityConstraints();
 	void StoreImpulses();
 
+	/// Copy the velocity constraints into structure of arrays batches that
+	/// SolveVelocityConstraints then solves b2_simdWidth contacts at a time.
+	/// Call this after WarmStart. StoreImpulses copies the impulses back.
+	void InitializeVelocityBatches();
+
 	bool SolvePositionConstraints();
 	bool SolveTOIPositionConstraints(int32 toiIndexA, int32 toiIndexB);
 
@@ -88,6 +95,14 @@ public:
 	b2ContactVelocityConstraint* m_velocityConstraints;
 	b2Contact** m_contacts;
 	int m_count;
+
+	b2ContactVelocityBatch* m_batches;
+	int32* m_batchOrder;
+	int32 m_batchCount;
+
+private:
+
+	void SolveVelocityBatches();
 };
 
 #endif
@@ -34,6 +34,9 @@ public:
 	~b2PolygonContact() {}
 
 	void Evaluate(b2Manifold* manifold, const b2Transform& xfA, const b2Transform& xfB);
+
+	// The separating edges found by the last evaluation.
+	b2PolygonCache m_cache;
 };
 
 #endif
@@ -19,6 +19,8 @@
 #include <Box2D/Dynamics/Joints/b2DistanceJoint.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
+#include <Box2D/Common/b2Snapshot.h>
+#include <Box2D/Dynamics/b2WorldFile.h>
 
 // 1-D constrained system
 // m (v2 - v1) = lambda
@@ -61,14 +63,14 @@ b2DistanceJoint::b2DistanceJoint(const b2DistanceJointDef* def)
 
 void b2DistanceJoint::InitVelocityConstraints(const b2SolverData& data)
 {
-	m_indexA = m_bodyA->m_islandIndex;
-	m_indexB = m_bodyB->m_islandIndex;
-	m_localCenterA = m_bodyA->m_sweep.localCenter;
-	m_localCenterB = m_bodyB->m_sweep.localCenter;
-	m_invMassA = m_bodyA->m_invMass;
-	m_invMassB = m_bodyB->m_invMass;
-	m_invIA = m_bodyA->m_invI;
-	m_invIB = m_bodyB->m_invI;
+	m_indexA = data.GetIndex(m_bodyA);
+	m_indexB = data.GetIndex(m_bodyB);
+	m_localCenterA = m_bodyA->Sweep().localCenter;
+	m_localCenterB = m_bodyB->Sweep().localCenter;
+	m_invMassA = m_bodyA->InvMass();
+	m_invMassB = m_bodyB->InvMass();
+	m_invIA = m_bodyA->InvI();
+	m_invIB = m_bodyB->InvI();
 
 	b2Vec2 cA = data.positions[m_indexA].c;
 	float32 aA = data.positions[m_indexA].a;
@@ -258,3 +260,32 @@ void b2DistanceJoint::Dump()
 	b2Log("  jd.dampingRatio = %.15lef;\n", m_dampingRatio);
 	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
 }
+
+void b2DistanceJoint::Save(b2WorldFileJoint* record) const
+{
+	record->localAnchorA = m_localAnchorA;
+	record->localAnchorB = m_localAnchorB;
+	record->values[0] = m_length;
+	record->values[1] = m_frequencyHz;
+	record->values[2] = m_dampingRatio;
+}
+
+void b2DistanceJoint::WriteSnapshot(b2Snapshot* snapshot) const
+{
+	b2Joint::WriteSnapshot(snapshot);
+	snapshot->Write(m_frequencyHz);
+	snapshot->Write(m_dampingRatio);
+	snapshot->Write(m_length);
+	snapshot->Write(m_impulse);
+	snapshot->Write(m_u);
+}
+
+void b2DistanceJoint::ReadSnapshot(const b2Snapshot* snapshot)
+{
+	b2Joint::ReadSnapshot(snapshot);
+	snapshot->Read(&m_frequencyHz);
+	snapshot->Read(&m_dampingRatio);
+	snapshot->Read(&m_length);
+	snapshot->Read(&m_impulse);
+	snapshot->Read(&m_u);
+}
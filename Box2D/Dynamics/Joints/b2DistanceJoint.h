@@ -101,6 +101,9 @@ public:
 	/// Dump joint to dmLog
 	void Dump();
 
+	/// Save to a world file joint record.
+	void Save(b2WorldFileJoint* record) const;
+
 protected:
 
 	friend class b2Joint;
@@ -110,6 +113,9 @@ protected:
 	void SolveVelocityConstraints(const b2SolverData& data);
 	bool SolvePositionConstraints(const b2SolverData& data);
 
+	void WriteSnapshot(b2Snapshot* snapshot) const;
+	void ReadSnapshot(const b2Snapshot* snapshot);
+
 	float32 m_frequencyHz;
 	float32 m_dampingRatio;
 	float32 m_bias;
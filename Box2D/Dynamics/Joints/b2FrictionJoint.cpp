@@ -19,6 +19,8 @@
 #include <Box2D/Dynamics/Joints/b2FrictionJoint.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
+#include <Box2D/Common/b2Snapshot.h>
+#include <Box2D/Dynamics/b2WorldFile.h>
 
 // Point-to-point constraint
 // Cdot = v2 - v1
@@ -55,14 +57,14 @@ b2FrictionJoint::b2FrictionJoint(const b2FrictionJointDef* def)
 
 void b2FrictionJoint::InitVelocityConstraints(const b2SolverData& data)
 {
-	m_indexA = m_bodyA->m_islandIndex;
-	m_indexB = m_bodyB->m_islandIndex;
-	m_localCenterA = m_bodyA->m_sweep.localCenter;
-	m_localCenterB = m_bodyB->m_sweep.localCenter;
-	m_invMassA = m_bodyA->m_invMass;
-	m_invMassB = m_bodyB->m_invMass;
-	m_invIA = m_bodyA->m_invI;
-	m_invIB = m_bodyB->m_invI;
+	m_indexA = data.GetIndex(m_bodyA);
+	m_indexB = data.GetIndex(m_bodyB);
+	m_localCenterA = m_bodyA->Sweep().localCenter;
+	m_localCenterB = m_bodyB->Sweep().localCenter;
+	m_invMassA = m_bodyA->InvMass();
+	m_invMassB = m_bodyB->InvMass();
+	m_invIA = m_bodyA->InvI();
+	m_invIB = m_bodyB->InvI();
 
 	float32 aA = data.positions[m_indexA].a;
 	b2Vec2 vA = data.velocities[m_indexA].v;
@@ -249,3 +251,29 @@ void b2FrictionJoint::Dump()
 	b2Log("  jd.maxTorque = %.15lef;\n", m_maxTorque);
 	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
 }
+
+void b2FrictionJoint::Save(b2WorldFileJoint* record) const
+{
+	record->localAnchorA = m_localAnchorA;
+	record->localAnchorB = m_localAnchorB;
+	record->values[0] = m_maxForce;
+	record->values[1] = m_maxTorque;
+}
+
+void b2FrictionJoint::WriteSnapshot(b2Snapshot* snapshot) const
+{
+	b2Joint::WriteSnapshot(snapshot);
+	snapshot->Write(m_linearImpulse);
+	snapshot->Write(m_angularImpulse);
+	snapshot->Write(m_maxForce);
+	snapshot->Write(m_maxTorque);
+}
+
+void b2FrictionJoint::ReadSnapshot(const b2Snapshot* snapshot)
+{
+	b2Joint::ReadSnapshot(snapshot);
+	snapshot->Read(&m_linearImpulse);
+	snapshot->Read(&m_angularImpulse);
+	snapshot->Read(&m_maxForce);
+	snapshot->Read(&m_maxTorque);
+}
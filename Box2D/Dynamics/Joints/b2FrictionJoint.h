@@ -82,6 +82,9 @@ public:
 	/// Dump joint to dmLog
 	void Dump();
 
+	/// Save to a world file joint record.
+	void Save(b2WorldFileJoint* record) const;
+
 protected:
 
 	friend class b2Joint;
@@ -92,6 +95,9 @@ protected:
 	void SolveVelocityConstraints(const b2SolverData& data);
 	bool SolvePositionConstraints(const b2SolverData& data);
 
+	void WriteSnapshot(b2Snapshot* snapshot) const;
+	void ReadSnapshot(const b2Snapshot* snapshot);
+
 	b2Vec2 m_localAnchorA;
 	b2Vec2 m_localAnchorB;
 
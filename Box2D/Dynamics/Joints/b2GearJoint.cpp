@@ -21,6 +21,8 @@
 #include <Box2D/Dynamics/Joints/b2PrismaticJoint.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
+#include <Box2D/Common/b2Snapshot.h>
+#include <Box2D/Dynamics/b2WorldFile.h>
 
 // Gear Joint:
 // C0 = (coordinate1 + ratio * coordinate2)_initial
@@ -61,10 +63,10 @@ b2GearJoint::b2GearJoint(const b2GearJointDef* def)
 	m_bodyA = m_joint1->GetBodyB();
 
 	// Get geometry of joint1
-	b2Transform xfA = m_bodyA->m_xf;
-	float32 aA = m_bodyA->m_sweep.a;
-	b2Transform xfC = m_bodyC->m_xf;
-	float32 aC = m_bodyC->m_sweep.a;
+	b2Transform xfA = m_bodyA->Transform();
+	float32 aA = m_bodyA->Sweep().a;
+	b2Transform xfC = m_bodyC->Transform();
+	float32 aC = m_bodyC->Sweep().a;
 
 	if (m_typeA == e_revoluteJoint)
 	{
@@ -93,10 +95,10 @@ b2GearJoint::b2GearJoint(const b2GearJointDef* def)
 	m_bodyB = m_joint2->GetBodyB();
 
 	// Get geometry of joint2
-	b2Transform xfB = m_bodyB->m_xf;
-	float32 aB = m_bodyB->m_sweep.a;
-	b2Transform xfD = m_bodyD->m_xf;
-	float32 aD = m_bodyD->m_sweep.a;
+	b2Transform xfB = m_bodyB->Transform();
+	float32 aB = m_bodyB->Sweep().a;
+	b2Transform xfD = m_bodyD->Transform();
+	float32 aD = m_bodyD->Sweep().a;
 
 	if (m_typeB == e_revoluteJoint)
 	{
@@ -130,22 +132,22 @@ b2GearJoint::b2GearJoint(const b2GearJointDef* def)
 
 void b2GearJoint::InitVelocityConstraints(const b2SolverData& data)
 {
-	m_indexA = m_bodyA->m_islandIndex;
-	m_indexB = m_bodyB->m_islandIndex;
-	m_indexC = m_bodyC->m_islandIndex;
-	m_indexD = m_bodyD->m_islandIndex;
-	m_lcA = m_bodyA->m_sweep.localCenter;
-	m_lcB = m_bodyB->m_sweep.localCenter;
-	m_lcC = m_bodyC->m_sweep.localCenter;
-	m_lcD = m_bodyD->m_sweep.localCenter;
-	m_mA = m_bodyA->m_invMass;
-	m_mB = m_bodyB->m_invMass;
-	m_mC = m_bodyC->m_invMass;
-	m_mD = m_bodyD->m_invMass;
-	m_iA = m_bodyA->m_invI;
-	m_iB = m_bodyB->m_invI;
-	m_iC = m_bodyC->m_invI;
-	m_iD = m_bodyD->m_invI;
+	m_indexA = data.GetIndex(m_bodyA);
+	m_indexB = data.GetIndex(m_bodyB);
+	m_indexC = data.GetIndex(m_bodyC);
+	m_indexD = data.GetIndex(m_bodyD);
+	m_lcA = m_bodyA->Sweep().localCenter;
+	m_lcB = m_bodyB->Sweep().localCenter;
+	m_lcC = m_bodyC->Sweep().localCenter;
+	m_lcD = m_bodyD->Sweep().localCenter;
+	m_mA = m_bodyA->InvMass();
+	m_mB = m_bodyB->InvMass();
+	m_mC = m_bodyC->InvMass();
+	m_mD = m_bodyD->InvMass();
+	m_iA = m_bodyA->InvI();
+	m_iB = m_bodyB->InvI();
+	m_iC = m_bodyC->InvI();
+	m_iD = m_bodyD->InvI();
 
 	b2Vec2 cA = data.positions[m_indexA].c;
 	float32 aA = data.positions[m_indexA].a;
@@ -421,3 +423,28 @@ void b2GearJoint::Dump()
 	b2Log("  jd.ratio = %.15lef;\n", m_ratio);
 	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
 }
+
+void b2GearJoint::Save(b2WorldFileJoint* record) const
+{
+	record->joint1 = m_joint1->m_index;
+	record->joint2 = m_joint2->m_index;
+	record->values[0] = m_ratio;
+}
+
+void b2GearJoint::WriteSnapshot(b2Snapshot* snapshot) const
+{
+	b2Joint::WriteSnapshot(snapshot);
+	snapshot->Write(m_ratio);
+	snapshot->Write(m_impulse);
+	snapshot->Write(m_JvAC);
+	snapshot->Write(m_JwA);
+}
+
+void b2GearJoint::ReadSnapshot(const b2Snapshot* snapshot)
+{
+	b2Joint::ReadSnapshot(snapshot);
+	snapshot->Read(&m_ratio);
+	snapshot->Read(&m_impulse);
+	snapshot->Read(&m_JvAC);
+	snapshot->Read(&m_JwA);
+}
@@ -75,6 +75,9 @@ public:
 	/// Dump joint to dmLog
 	void Dump();
 
+	/// Save to a world file joint record.
+	void Save(b2WorldFileJoint* record) const;
+
 protected:
 
 	friend class b2Joint;
@@ -84,6 +87,9 @@ protected:
 	void SolveVelocityConstraints(const b2SolverData& data);
 	bool SolvePositionConstraints(const b2SolverData& data);
 
+	void WriteSnapshot(b2Snapshot* snapshot) const;
+	void ReadSnapshot(const b2Snapshot* snapshot);
+
 	b2Joint* m_joint1;
 	b2Joint* m_joint2;
 
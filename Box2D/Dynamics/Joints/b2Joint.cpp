@@ -30,6 +30,7 @@
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2World.h>
 #include <Box2D/Common/b2BlockAllocator.h>
+#include <Box2D/Common/b2Snapshot.h>
 
 #include <new>
 
@@ -120,46 +121,181 @@ b2Joint* b2Joint::Create(const b2JointDef* def, b2BlockAllocator* allocator)
 void b2Joint::Destroy(b2Joint* joint, b2BlockAllocator* allocator)
 {
 	joint->~b2Joint();
-	switch (joint->m_type)
+	allocator->Free(joint, GetSize(joint->m_type));
+}
+
+int32 b2Joint::GetSize(b2JointType type)
+{
+	switch (type)
 	{
 	case e_distanceJoint:
-		allocator->Free(joint, sizeof(b2DistanceJoint));
-		break;
+		return sizeof(b2DistanceJoint);
 
 	case e_mouseJoint:
-		allocator->Free(joint, sizeof(b2MouseJoint));
+		return sizeof(b2MouseJoint);
+
+	case e_prismaticJoint:
+		return sizeof(b2PrismaticJoint);
+
+	case e_revoluteJoint:
+		return sizeof(b2RevoluteJoint);
+
+	case e_pulleyJoint:
+		return sizeof(b2PulleyJoint);
+
+	case e_gearJoint:
+		return sizeof(b2GearJoint);
+
+	case e_wheelJoint:
+		return sizeof(b2WheelJoint);
+    
+	case e_weldJoint:
+		return sizeof(b2WeldJoint);
+
+	case e_frictionJoint:
+		return sizeof(b2FrictionJoint);
+
+	case e_ropeJoint:
+		return sizeof(b2RopeJoint);
+
+	default:
+		b2Assert(false);
+		return 0;
+	}
+}
+
+// The qualified calls bypass the virtual table.
+template <typename T>
+void b2Joint::InitVelocityBatch(b2Joint** joints, int32 count, const b2SolverData& data)
+{
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Assert(joints[i]->m_type == joints[0]->m_type);
+		T* joint = static_cast<T*>(joints[i]);
+		joint->T::InitVelocityConstraints(data);
+	}
+}
+
+template <typename T>
+void b2Joint::SolveVelocityBatch(b2Joint** joints, int32 count, const b2SolverData& data)
+{
+	for (int32 i = 0; i < count; ++i)
+	{
+		T* joint = static_cast<T*>(joints[i]);
+		joint->T::SolveVelocityConstraints(data);
+	}
+}
+
+template <typename T>
+bool b2Joint::SolvePositionBatch(b2Joint** joints, int32 count, const b2SolverData& data)
+{
+	bool jointsOkay = true;
+	for (int32 i = 0; i < count; ++i)
+	{
+		T* joint = static_cast<T*>(joints[i]);
+		bool jointOkay = joint->T::SolvePositionConstraints(data);
+		jointsOkay = jointsOkay && jointOkay;
+	}
+
+	return jointsOkay;
+}
+
+void b2Joint::InitVelocityBatch(b2Joint** joints, int32 count, const b2SolverData& data)
+{
+	b2Assert(count > 0);
+
+	switch (joints[0]->m_type)
+	{
+	case e_revoluteJoint:
+		InitVelocityBatch<b2RevoluteJoint>(joints, count, data);
 		break;
 
 	case e_prismaticJoint:
-		allocator->Free(joint, sizeof(b2PrismaticJoint));
+		InitVelocityBatch<b2PrismaticJoint>(joints, count, data);
+		break;
+
+	case e_distanceJoint:
+		InitVelocityBatch<b2DistanceJoint>(joints, count, data);
+		break;
+
+	case e_pulleyJoint:
+		InitVelocityBatch<b2PulleyJoint>(joints, count, data);
+		break;
+
+	case e_mouseJoint:
+		InitVelocityBatch<b2MouseJoint>(joints, count, data);
+		break;
+
+	case e_gearJoint:
+		InitVelocityBatch<b2GearJoint>(joints, count, data);
+		break;
+
+	case e_wheelJoint:
+		InitVelocityBatch<b2WheelJoint>(joints, count, data);
+		break;
+
+	case e_weldJoint:
+		InitVelocityBatch<b2WeldJoint>(joints, count, data);
+		break;
+
+	case e_frictionJoint:
+		InitVelocityBatch<b2FrictionJoint>(joints, count, data);
+		break;
+
+	case e_ropeJoint:
+		InitVelocityBatch<b2RopeJoint>(joints, count, data);
 		break;
 
+	default:
+		b2Assert(false);
+		break;
+	}
+}
+
+void b2Joint::SolveVelocityBatch(b2Joint** joints, int32 count, const b2SolverData& data)
+{
+	b2Assert(count > 0);
+
+	switch (joints[0]->m_type)
+	{
 	case e_revoluteJoint:
-		allocator->Free(joint, sizeof(b2RevoluteJoint));
+		SolveVelocityBatch<b2RevoluteJoint>(joints, count, data);
+		break;
+
+	case e_prismaticJoint:
+		SolveVelocityBatch<b2PrismaticJoint>(joints, count, data);
+		break;
+
+	case e_distanceJoint:
+		SolveVelocityBatch<b2DistanceJoint>(joints, count, data);
 		break;
 
 	case e_pulleyJoint:
-		allocator->Free(joint, sizeof(b2PulleyJoint));
+		SolveVelocityBatch<b2PulleyJoint>(joints, count, data);
+		break;
+
+	case e_mouseJoint:
+		SolveVelocityBatch<b2MouseJoint>(joints, count, data);
 		break;
 
 	case e_gearJoint:
-		allocator->Free(joint, sizeof(b2GearJoint));
+		SolveVelocityBatch<b2GearJoint>(joints, count, data);
 		break;
 
 	case e_wheelJoint:
-		allocator->Free(joint, sizeof(b2WheelJoint));
+		SolveVelocityBatch<b2WheelJoint>(joints, count, data);
 		break;
-    
+
 	case e_weldJoint:
-		allocator->Free(joint, sizeof(b2WeldJoint));
+		SolveVelocityBatch<b2WeldJoint>(joints, count, data);
 		break;
 
 	case e_frictionJoint:
-		allocator->Free(joint, sizeof(b2FrictionJoint));
+		SolveVelocityBatch<b2FrictionJoint>(joints, count, data);
 		break;
 
 	case e_ropeJoint:
-		allocator->Free(joint, sizeof(b2RopeJoint));
+		SolveVelocityBatch<b2RopeJoint>(joints, count, data);
 		break;
 
 	default:
@@ -168,6 +304,48 @@ void b2Joint::Destroy(b2Joint* joint, b2BlockAllocator* allocator)
 	}
 }
 
+bool b2Joint::SolvePositionBatch(b2Joint** joints, int32 count, const b2SolverData& data)
+{
+	b2Assert(count > 0);
+
+	switch (joints[0]->m_type)
+	{
+	case e_revoluteJoint:
+		return SolvePositionBatch<b2RevoluteJoint>(joints, count, data);
+
+	case e_prismaticJoint:
+		return SolvePositionBatch<b2PrismaticJoint>(joints, count, data);
+
+	case e_distanceJoint:
+		return SolvePositionBatch<b2DistanceJoint>(joints, count, data);
+
+	case e_pulleyJoint:
+		return SolvePositionBatch<b2PulleyJoint>(joints, count, data);
+
+	case e_mouseJoint:
+		return SolvePositionBatch<b2MouseJoint>(joints, count, data);
+
+	case e_gearJoint:
+		return SolvePositionBatch<b2GearJoint>(joints, count, data);
+
+	case e_wheelJoint:
+		return SolvePositionBatch<b2WheelJoint>(joints, count, data);
+
+	case e_weldJoint:
+		return SolvePositionBatch<b2WeldJoint>(joints, count, data);
+
+	case e_frictionJoint:
+		return SolvePositionBatch<b2FrictionJoint>(joints, count, data);
+
+	case e_ropeJoint:
+		return SolvePositionBatch<b2RopeJoint>(joints, count, data);
+
+	default:
+		b2Assert(false);
+		return true;
+	}
+}
+
 b2Joint::b2Joint(const b2JointDef* def)
 {
 	b2Assert(def->bodyA != def->bodyB);
@@ -180,6 +358,9 @@ b2Joint::b2Joint(const b2JointDef* def)
 	m_index = 0;
 	m_collideConnected = def->collideConnected;
 	m_islandFlag = false;
+	m_island = NULL;
+	m_islandPrev = NULL;
+	m_islandNext = NULL;
 	m_userData = def->userData;
 
 	m_edgeA.joint = NULL;
@@ -197,3 +378,25 @@ bool b2Joint::IsActive() const
 {
 	return m_bodyA->IsActive() && m_bodyB->IsActive();
 }
+
+void b2Joint::WriteSnapshot(b2Snapshot* snapshot) const
+{
+	snapshot->Write(m_prev);
+	snapshot->Write(m_next);
+	snapshot->Write(m_edgeA);
+	snapshot->Write(m_edgeB);
+	snapshot->Write(m_index);
+	snapshot->Write(m_islandFlag);
+	snapshot->Write(m_userData);
+}
+
+void b2Joint::ReadSnapshot(const b2Snapshot* snapshot)
+{
+	snapshot->Read(&m_prev);
+	snapshot->Read(&m_next);
+	snapshot->Read(&m_edgeA);
+	snapshot->Read(&m_edgeB);
+	snapshot->Read(&m_index);
+	snapshot->Read(&m_islandFlag);
+	snapshot->Read(&m_userData);
+}
@@ -25,6 +25,9 @@ class b2Body;
 class b2Joint;
 struct b2SolverData;
 class b2BlockAllocator;
+struct b2PersistentIsland;
+struct b2WorldFileJoint;
+class b2Snapshot;
 
 enum b2JointType
 {
@@ -41,6 +44,8 @@ enum b2JointType
 	e_ropeJoint
 };
 
+#define b2_jointTypeCount	(e_ropeJoint + 1)
+
 enum b2LimitState
 {
 	e_inactiveLimit,
@@ -145,15 +150,26 @@ public:
 	/// Dump this joint to the log file.
 	virtual void Dump() { b2Log("// Dump is not supported for this joint type.\n"); }
 
+	/// Save the joint specific fields to a world file joint record. Joints that
+	/// are not saved leave the record alone.
+	virtual void Save(b2WorldFileJoint* record) const { B2_NOT_USED(record); }
+
+	/// Shift the origin for any points stored in world coordinates.
+	virtual void ShiftOrigin(const b2Vec2& newOrigin) { B2_NOT_USED(newOrigin); }
+
 protected:
 	friend class b2World;
 	friend class b2Body;
 	friend class b2Island;
+	friend class b2IslandManager;
 	friend class b2GearJoint;
 
 	static b2Joint* Create(const b2JointDef* def, b2BlockAllocator* allocator);
 	static void Destroy(b2Joint* joint, b2BlockAllocator* allocator);
 
+	// The size of a joint of the given type.
+	static int32 GetSize(b2JointType type);
+
 	b2Joint(const b2JointDef* def);
 	virtual ~b2Joint() {}
 
@@ -163,6 +179,25 @@ protected:
 	// This returns true if the position errors are within tolerance.
 	virtual bool SolvePositionConstraints(const b2SolverData& data) = 0;
 
+	// Write and read the state that can change after creation, see b2World::Snapshot.
+	// Joint types with more state extend these.
+	virtual void WriteSnapshot(b2Snapshot* snapshot) const;
+	virtual void ReadSnapshot(const b2Snapshot* snapshot);
+
+	// Solve a batch of joints that all have the same type. The type is looked
+	// up once for the batch and the solver functions of the joint class are
+	// then called directly instead of through the virtual table.
+	static void InitVelocityBatch(b2Joint** joints, int32 count, const b2SolverData& data);
+	static void SolveVelocityBatch(b2Joint** joints, int32 count, const b2SolverData& data);
+	static bool SolvePositionBatch(b2Joint** joints, int32 count, const b2SolverData& data);
+
+	template <typename T>
+	static void InitVelocityBatch(b2Joint** joints, int32 count, const b2SolverData& data);
+	template <typename T>
+	static void SolveVelocityBatch(b2Joint** joints, int32 count, const b2SolverData& data);
+	template <typename T>
+	static bool SolvePositionBatch(b2Joint** joints, int32 count, const b2SolverData& data);
+
 	b2JointType m_type;
 	b2Joint* m_prev;
 	b2Joint* m_next;
@@ -171,6 +206,11 @@ protected:
 	b2Body* m_bodyA;
 	b2Body* m_bodyB;
 
+	// The persistent island, NULL if either body is inactive.
+	b2PersistentIsland* m_island;
+	b2Joint* m_islandPrev;
+	b2Joint* m_islandNext;
+
 	int32 m_index;
 
 	bool m_islandFlag;
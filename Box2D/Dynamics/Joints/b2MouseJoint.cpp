@@ -19,6 +19,7 @@
 #include <Box2D/Dynamics/Joints/b2MouseJoint.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
+#include <Box2D/Common/b2Snapshot.h>
 
 // p = attached point, m = mouse point
 // C = p - m
@@ -95,10 +96,10 @@ float32 b2MouseJoint::GetDampingRatio() const
 
 void b2MouseJoint::InitVelocityConstraints(const b2SolverData& data)
 {
-	m_indexB = m_bodyB->m_islandIndex;
-	m_localCenterB = m_bodyB->m_sweep.localCenter;
-	m_invMassB = m_bodyB->m_invMass;
-	m_invIB = m_bodyB->m_invI;
+	m_indexB = data.GetIndex(m_bodyB);
+	m_localCenterB = m_bodyB->Sweep().localCenter;
+	m_invMassB = m_bodyB->InvMass();
+	m_invIB = m_bodyB->InvI();
 
 	b2Vec2 cB = data.positions[m_indexB].c;
 	float32 aB = data.positions[m_indexB].a;
@@ -215,3 +216,28 @@ float32 b2MouseJoint::GetReactionTorque(float32 inv_dt) const
 {
 	return inv_dt * 0.0f;
 }
+
+void b2MouseJoint::ShiftOrigin(const b2Vec2& newOrigin)
+{
+	m_targetA -= newOrigin;
+}
+
+void b2MouseJoint::WriteSnapshot(b2Snapshot* snapshot) const
+{
+	b2Joint::WriteSnapshot(snapshot);
+	snapshot->Write(m_targetA);
+	snapshot->Write(m_frequencyHz);
+	snapshot->Write(m_dampingRatio);
+	snapshot->Write(m_impulse);
+	snapshot->Write(m_maxForce);
+}
+
+void b2MouseJoint::ReadSnapshot(const b2Snapshot* snapshot)
+{
+	b2Joint::ReadSnapshot(snapshot);
+	snapshot->Read(&m_targetA);
+	snapshot->Read(&m_frequencyHz);
+	snapshot->Read(&m_dampingRatio);
+	snapshot->Read(&m_impulse);
+	snapshot->Read(&m_maxForce);
+}
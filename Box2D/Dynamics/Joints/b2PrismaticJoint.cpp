@@ -19,6 +19,8 @@
 #include <Box2D/Dynamics/Joints/b2PrismaticJoint.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
+#include <Box2D/Common/b2Snapshot.h>
+#include <Box2D/Dynamics/b2WorldFile.h>
 
 // Linear constraint (point-to-line)
 // d = p2 - p1 = x2 + r2 - x1 - r1
@@ -125,14 +127,14 @@ b2PrismaticJoint::b2PrismaticJoint(const b2PrismaticJointDef* def)
 
 void b2PrismaticJoint::InitVelocityConstraints(const b2SolverData& data)
 {
-	m_indexA = m_bodyA->m_islandIndex;
-	m_indexB = m_bodyB->m_islandIndex;
-	m_localCenterA = m_bodyA->m_sweep.localCenter;
-	m_localCenterB = m_bodyB->m_sweep.localCenter;
-	m_invMassA = m_bodyA->m_invMass;
-	m_invMassB = m_bodyB->m_invMass;
-	m_invIA = m_bodyA->m_invI;
-	m_invIB = m_bodyB->m_invI;
+	m_indexA = data.GetIndex(m_bodyA);
+	m_indexB = data.GetIndex(m_bodyB);
+	m_localCenterA = m_bodyA->Sweep().localCenter;
+	m_localCenterB = m_bodyB->Sweep().localCenter;
+	m_invMassA = m_bodyA->InvMass();
+	m_invMassB = m_bodyB->InvMass();
+	m_invIA = m_bodyA->InvI();
+	m_invIB = m_bodyB->InvI();
 
 	b2Vec2 cA = data.positions[m_indexA].c;
 	float32 aA = data.positions[m_indexA].a;
@@ -528,17 +530,17 @@ float32 b2PrismaticJoint::GetJointSpeed() const
 	b2Body* bA = m_bodyA;
 	b2Body* bB = m_bodyB;
 
-	b2Vec2 rA = b2Mul(bA->m_xf.q, m_localAnchorA - bA->m_sweep.localCenter);
-	b2Vec2 rB = b2Mul(bB->m_xf.q, m_localAnchorB - bB->m_sweep.localCenter);
-	b2Vec2 p1 = bA->m_sweep.c + rA;
-	b2Vec2 p2 = bB->m_sweep.c + rB;
+	b2Vec2 rA = b2Mul(bA->Transform().q, m_localAnchorA - bA->Sweep().localCenter);
+	b2Vec2 rB = b2Mul(bB->Transform().q, m_localAnchorB - bB->Sweep().localCenter);
+	b2Vec2 p1 = bA->Sweep().c + rA;
+	b2Vec2 p2 = bB->Sweep().c + rB;
 	b2Vec2 d = p2 - p1;
-	b2Vec2 axis = b2Mul(bA->m_xf.q, m_localXAxisA);
+	b2Vec2 axis = b2Mul(bA->Transform().q, m_localXAxisA);
 
-	b2Vec2 vA = bA->m_linearVelocity;
-	b2Vec2 vB = bB->m_linearVelocity;
-	float32 wA = bA->m_angularVelocity;
-	float32 wB = bB->m_angularVelocity;
+	b2Vec2 vA = bA->LinearVelocity();
+	b2Vec2 vB = bB->LinearVelocity();
+	float32 wA = bA->AngularVelocity();
+	float32 wB = bB->AngularVelocity();
 
 	float32 speed = b2Dot(d, b2Cross(wA, axis)) + b2Dot(axis, vB + b2Cross(wB, rB) - vA - b2Cross(wA, rA));
 	return speed;
@@ -635,3 +637,55 @@ void b2PrismaticJoint::Dump()
 	b2Log("  jd.maxMotorForce = %.15lef;\n", m_maxMotorForce);
 	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
 }
+
+void b2PrismaticJoint::Save(b2WorldFileJoint* record) const
+{
+	record->localAnchorA = m_localAnchorA;
+	record->localAnchorB = m_localAnchorB;
+	record->vectorA = m_localXAxisA;
+	record->values[0] = m_referenceAngle;
+	record->values[1] = m_lowerTranslation;
+	record->values[2] = m_upperTranslation;
+	record->values[3] = m_motorSpeed;
+	record->values[4] = m_maxMotorForce;
+	if (m_enableLimit)
+	{
+		record->flags |= b2WorldFileJoint::e_enableLimitFlag;
+	}
+	if (m_enableMotor)
+	{
+		record->flags |= b2WorldFileJoint::e_enableMotorFlag;
+	}
+}
+
+void b2PrismaticJoint::WriteSnapshot(b2Snapshot* snapshot) const
+{
+	b2Joint::WriteSnapshot(snapshot);
+	snapshot->Write(m_impulse);
+	snapshot->Write(m_motorImpulse);
+	snapshot->Write(m_lowerTranslation);
+	snapshot->Write(m_upperTranslation);
+	snapshot->Write(m_maxMotorForce);
+	snapshot->Write(m_motorSpeed);
+	snapshot->Write(m_enableLimit);
+	snapshot->Write(m_enableMotor);
+	snapshot->Write(m_limitState);
+	snapshot->Write(m_axis);
+	snapshot->Write(m_perp);
+}
+
+void b2PrismaticJoint::ReadSnapshot(const b2Snapshot* snapshot)
+{
+	b2Joint::ReadSnapshot(snapshot);
+	snapshot->Read(&m_impulse);
+	snapshot->Read(&m_motorImpulse);
+	snapshot->Read(&m_lowerTranslation);
+	snapshot->Read(&m_upperTranslation);
+	snapshot->Read(&m_maxMotorForce);
+	snapshot->Read(&m_motorSpeed);
+	snapshot->Read(&m_enableLimit);
+	snapshot->Read(&m_enableMotor);
+	snapshot->Read(&m_limitState);
+	snapshot->Read(&m_axis);
+	snapshot->Read(&m_perp);
+}
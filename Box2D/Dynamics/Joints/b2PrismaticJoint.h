@@ -147,6 +147,9 @@ public:
 	/// Dump to b2Log
 	void Dump();
 
+	/// Save to a world file joint record.
+	void Save(b2WorldFileJoint* record) const;
+
 protected:
 	friend class b2Joint;
 	friend class b2GearJoint;
@@ -156,6 +159,9 @@ protected:
 	void SolveVelocityConstraints(const b2SolverData& data);
 	bool SolvePositionConstraints(const b2SolverData& data);
 
+	void WriteSnapshot(b2Snapshot* snapshot) const;
+	void ReadSnapshot(const b2Snapshot* snapshot);
+
 	// Solver shared
 	b2Vec2 m_localAnchorA;
 	b2Vec2 m_localAnchorB;
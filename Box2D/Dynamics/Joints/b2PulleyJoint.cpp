@@ -19,6 +19,8 @@
 #include <Box2D/Dynamics/Joints/b2PulleyJoint.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
+#include <Box2D/Common/b2Snapshot.h>
+#include <Box2D/Dynamics/b2WorldFile.h>
 
 // Pulley:
 // length1 = norm(p1 - s1)
@@ -72,14 +74,14 @@ b2PulleyJoint::b2PulleyJoint(const b2PulleyJointDef* def)
 
 void b2PulleyJoint::InitVelocityConstraints(const b2SolverData& data)
 {
-	m_indexA = m_bodyA->m_islandIndex;
-	m_indexB = m_bodyB->m_islandIndex;
-	m_localCenterA = m_bodyA->m_sweep.localCenter;
-	m_localCenterB = m_bodyB->m_sweep.localCenter;
-	m_invMassA = m_bodyA->m_invMass;
-	m_invMassB = m_bodyB->m_invMass;
-	m_invIA = m_bodyA->m_invI;
-	m_invIB = m_bodyB->m_invI;
+	m_indexA = data.GetIndex(m_bodyA);
+	m_indexB = data.GetIndex(m_bodyB);
+	m_localCenterA = m_bodyA->Sweep().localCenter;
+	m_localCenterB = m_bodyB->Sweep().localCenter;
+	m_invMassA = m_bodyA->InvMass();
+	m_invMassB = m_bodyB->InvMass();
+	m_invIA = m_bodyA->InvI();
+	m_invIB = m_bodyB->InvI();
 
 	b2Vec2 cA = data.positions[m_indexA].c;
 	float32 aA = data.positions[m_indexA].a;
@@ -330,3 +332,40 @@ void b2PulleyJoint::Dump()
 	b2Log("  jd.ratio = %.15lef;\n", m_ratio);
 	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
 }
+
+void b2PulleyJoint::ShiftOrigin(const b2Vec2& newOrigin)
+{
+	m_groundAnchorA -= newOrigin;
+	m_groundAnchorB -= newOrigin;
+}
+
+void b2PulleyJoint::Save(b2WorldFileJoint* record) const
+{
+	record->localAnchorA = m_localAnchorA;
+	record->localAnchorB = m_localAnchorB;
+	record->vectorA = m_groundAnchorA;
+	record->vectorB = m_groundAnchorB;
+	record->values[0] = m_lengthA;
+	record->values[1] = m_lengthB;
+	record->values[2] = m_ratio;
+}
+
+void b2PulleyJoint::WriteSnapshot(b2Snapshot* snapshot) const
+{
+	b2Joint::WriteSnapshot(snapshot);
+	snapshot->Write(m_groundAnchorA);
+	snapshot->Write(m_groundAnchorB);
+	snapshot->Write(m_impulse);
+	snapshot->Write(m_uA);
+	snapshot->Write(m_uB);
+}
+
+void b2PulleyJoint::ReadSnapshot(const b2Snapshot* snapshot)
+{
+	b2Joint::ReadSnapshot(snapshot);
+	snapshot->Read(&m_groundAnchorA);
+	snapshot->Read(&m_groundAnchorB);
+	snapshot->Read(&m_impulse);
+	snapshot->Read(&m_uA);
+	snapshot->Read(&m_uB);
+}
@@ -103,6 +103,12 @@ public:
 	/// Dump joint to dmLog
 	void Dump();
 
+	/// Save to a world file joint record.
+	void Save(b2WorldFileJoint* record) const;
+
+	/// Implement b2Joint::ShiftOrigin
+	void ShiftOrigin(const b2Vec2& newOrigin);
+
 protected:
 
 	friend class b2Joint;
@@ -112,6 +118,9 @@ protected:
 	void SolveVelocityConstraints(const b2SolverData& data);
 	bool SolvePositionConstraints(const b2SolverData& data);
 
+	void WriteSnapshot(b2Snapshot* snapshot) const;
+	void ReadSnapshot(const b2Snapshot* snapshot);
+
 	b2Vec2 m_groundAnchorA;
 	b2Vec2 m_groundAnchorB;
 	float32 m_lengthA;
@@ -19,6 +19,8 @@
 #include <Box2D/Dynamics/Joints/b2RevoluteJoint.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
+#include <Box2D/Common/b2Snapshot.h>
+#include <Box2D/Dynamics/b2WorldFile.h>
 
 // Point-to-point constraint
 // C = p2 - p1
@@ -63,14 +65,14 @@ b2RevoluteJoint::b2RevoluteJoint(const b2RevoluteJointDef* def)
 
 void b2RevoluteJoint::InitVelocityConstraints(const b2SolverData& data)
 {
-	m_indexA = m_bodyA->m_islandIndex;
-	m_indexB = m_bodyB->m_islandIndex;
-	m_localCenterA = m_bodyA->m_sweep.localCenter;
-	m_localCenterB = m_bodyB->m_sweep.localCenter;
-	m_invMassA = m_bodyA->m_invMass;
-	m_invMassB = m_bodyB->m_invMass;
-	m_invIA = m_bodyA->m_invI;
-	m_invIB = m_bodyB->m_invI;
+	m_indexA = data.GetIndex(m_bodyA);
+	m_indexB = data.GetIndex(m_bodyB);
+	m_localCenterA = m_bodyA->Sweep().localCenter;
+	m_localCenterB = m_bodyB->Sweep().localCenter;
+	m_invMassA = m_bodyA->InvMass();
+	m_invMassB = m_bodyB->InvMass();
+	m_invIA = m_bodyA->InvI();
+	m_invIB = m_bodyB->InvI();
 
 	b2Vec2 cA = data.positions[m_indexA].c;
 	float32 aA = data.positions[m_indexA].a;
@@ -401,14 +403,14 @@ float32 b2RevoluteJoint::GetJointAngle() const
 {
 	b2Body* bA = m_bodyA;
 	b2Body* bB = m_bodyB;
-	return bB->m_sweep.a - bA->m_sweep.a - m_referenceAngle;
+	return bB->Sweep().a - bA->Sweep().a - m_referenceAngle;
 }
 
 float32 b2RevoluteJoint::GetJointSpeed() const
 {
 	b2Body* bA = m_bodyA;
 	b2Body* bB = m_bodyB;
-	return bB->m_angularVelocity - bA->m_angularVelocity;
+	return bB->AngularVelocity() - bA->AngularVelocity();
 }
 
 bool b2RevoluteJoint::IsMotorEnabled() const
@@ -502,3 +504,50 @@ void b2RevoluteJoint::Dump()
 	b2Log("  jd.maxMotorTorque = %.15lef;\n", m_maxMotorTorque);
 	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
 }
+
+void b2RevoluteJoint::Save(b2WorldFileJoint* record) const
+{
+	record->localAnchorA = m_localAnchorA;
+	record->localAnchorB = m_localAnchorB;
+	record->values[0] = m_referenceAngle;
+	record->values[1] = m_lowerAngle;
+	record->values[2] = m_upperAngle;
+	record->values[3] = m_motorSpeed;
+	record->values[4] = m_maxMotorTorque;
+	if (m_enableLimit)
+	{
+		record->flags |= b2WorldFileJoint::e_enableLimitFlag;
+	}
+	if (m_enableMotor)
+	{
+		record->flags |= b2WorldFileJoint::e_enableMotorFlag;
+	}
+}
+
+void b2RevoluteJoint::WriteSnapshot(b2Snapshot* snapshot) const
+{
+	b2Joint::WriteSnapshot(snapshot);
+	snapshot->Write(m_impulse);
+	snapshot->Write(m_motorImpulse);
+	snapshot->Write(m_enableMotor);
+	snapshot->Write(m_maxMotorTorque);
+	snapshot->Write(m_motorSpeed);
+	snapshot->Write(m_enableLimit);
+	snapshot->Write(m_lowerAngle);
+	snapshot->Write(m_upperAngle);
+	snapshot->Write(m_limitState);
+}
+
+void b2RevoluteJoint::ReadSnapshot(const b2Snapshot* snapshot)
+{
+	b2Joint::ReadSnapshot(snapshot);
+	snapshot->Read(&m_impulse);
+	snapshot->Read(&m_motorImpulse);
+	snapshot->Read(&m_enableMotor);
+	snapshot->Read(&m_maxMotorTorque);
+	snapshot->Read(&m_motorSpeed);
+	snapshot->Read(&m_enableLimit);
+	snapshot->Read(&m_lowerAngle);
+	snapshot->Read(&m_upperAngle);
+	snapshot->Read(&m_limitState);
+}
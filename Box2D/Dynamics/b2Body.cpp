@@ -55,31 +55,42 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 	}
 
 	m_world = world;
+	m_states = &world->m_bodyStates;
+	m_stateIndex = m_states->Allocate();
 
-	m_xf.p = bd->position;
-	m_xf.q.Set(bd->angle);
+	b2Transform& xf = Transform();
+	xf.p = bd->position;
+	xf.q.Set(bd->angle);
 
-	m_sweep.localCenter.SetZero();
-	m_sweep.c0 = m_xf.p;
-	m_sweep.c = m_xf.p;
-	m_sweep.a0 = bd->angle;
-	m_sweep.a = bd->angle;
-	m_sweep.alpha0 = 0.0f;
+	b2Sweep& sweep = Sweep();
+	sweep.localCenter.SetZero();
+	sweep.c0 = xf.p;
+	sweep.c = xf.p;
+	sweep.a0 = bd->angle;
+	sweep.a = bd->angle;
+	sweep.alpha0 = 0.0f;
 
 	m_jointList = NULL;
 	m_contactList = NULL;
 	m_prev = NULL;
+	m_sector = b2_nullSector;
+	m_sectorPrev = NULL;
+	m_sectorNext = NULL;
 	m_next = NULL;
 
-	m_linearVelocity = bd->linearVelocity;
-	m_angularVelocity = bd->angularVelocity;
+	m_island = NULL;
+	m_islandPrev = NULL;
+	m_islandNext = NULL;
+
+	LinearVelocity() = bd->linearVelocity;
+	AngularVelocity() = bd->angularVelocity;
 
 	m_linearDamping = bd->linearDamping;
 	m_angularDamping = bd->angularDamping;
 	m_gravityScale = bd->gravityScale;
 
-	m_force.SetZero();
-	m_torque = 0.0f;
+	Force().SetZero();
+	Torque() = 0.0f;
 
 	m_sleepTime = 0.0f;
 
@@ -88,16 +99,16 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 	if (m_type == b2_dynamicBody)
 	{
 		m_mass = 1.0f;
-		m_invMass = 1.0f;
+		InvMass() = 1.0f;
 	}
 	else
 	{
 		m_mass = 0.0f;
-		m_invMass = 0.0f;
+		InvMass() = 0.0f;
 	}
 
 	m_I = 0.0f;
-	m_invI = 0.0f;
+	InvI() = 0.0f;
 
 	m_userData = bd->userData;
 
@@ -108,6 +119,7 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 b2Body::~b2Body()
 {
 	// shapes and joints are destroyed in b2World::Destroy
+	m_states->Free(m_stateIndex);
 }
 
 void b2Body::SetType(b2BodyType type)
@@ -123,29 +135,41 @@ void b2Body::SetType(b2BodyType type)
 		return;
 	}
 
+	// Static bodies don't have an island.
+	m_world->m_islandManager.RemoveBody(this);
+
 	m_type = type;
 
 	ResetMassData();
 
 	if (m_type == b2_staticBody)
 	{
-		m_linearVelocity.SetZero();
-		m_angularVelocity = 0.0f;
-		m_sweep.a0 = m_sweep.a;
-		m_sweep.c0 = m_sweep.c;
+		LinearVelocity().SetZero();
+		AngularVelocity() = 0.0f;
+		Sweep().a0 = Sweep().a;
+		Sweep().c0 = Sweep().c;
 		SynchronizeFixtures();
 	}
 
 	SetAwake(true);
 
-	m_force.SetZero();
-	m_torque = 0.0f;
+	Force().SetZero();
+	Torque() = 0.0f;
+
+	// Move the proxies to the tree of the new type.
+	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
+	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
+	{
+		f->UpdateProxyType(broadPhase);
+	}
 
 	// Since the body type changed, we need to flag contacts for filtering.
 	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
 	{
 		f->Refilter();
 	}
+
+	m_world->m_islandManager.AddBody(this);
 }
 
 b2Fixture* b2Body::CreateFixture(const b2FixtureDef* def)
@@ -156,24 +180,14 @@ b2Fixture* b2Body::CreateFixture(const b2FixtureDef* def)
 		return NULL;
 	}
 
-	b2BlockAllocator* allocator = &m_world->m_blockAllocator;
-
-	void* memory = allocator->Allocate(sizeof(b2Fixture));
-	b2Fixture* fixture = new (memory) b2Fixture;
-	fixture->Create(allocator, this, def);
+	b2Fixture* fixture = AddFixture(def);
 
 	if (m_flags & e_activeFlag)
 	{
 		b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
-		fixture->CreateProxies(broadPhase, m_xf);
+		fixture->CreateProxies(broadPhase, Transform());
 	}
 
-	fixture->m_next = m_fixtureList;
-	m_fixtureList = fixture;
-	++m_fixtureCount;
-
-	fixture->m_body = this;
-
 	// Adjust mass properties if needed.
 	if (fixture->m_density > 0.0f)
 	{
@@ -182,7 +196,7 @@ b2Fixture* b2Body::CreateFixture(const b2FixtureDef* def)
 
 	// Let the world know we have a new fixture. This will cause new contacts
 	// to be created at the beginning of the next time step.
-	m_world->m_flags |= b2World::e_newFixture;
+	m_world->m_flags |= b2World::e_newFixture | b2World::e_newSector;
 
 	return fixture;
 }
@@ -196,6 +210,61 @@ b2Fixture* b2Body::CreateFixture(const b2Shape* shape, float32 density)
 	return CreateFixture(&def);
 }
 
+void b2Body::CreateFixtures(const b2FixtureDef* defs, int32 count, b2Fixture** fixtures)
+{
+	b2Assert(m_world->IsLocked() == false);
+	if (m_world->IsLocked() == true)
+	{
+		return;
+	}
+
+	b2StackAllocator* stackAllocator = &m_world->m_stackAllocator;
+	b2Fixture** created = (b2Fixture**)stackAllocator->Allocate(count * sizeof(b2Fixture*));
+
+	bool hasMass = false;
+	for (int32 i = 0; i < count; ++i)
+	{
+		created[i] = AddFixture(defs + i);
+		hasMass = hasMass || defs[i].density > 0.0f;
+
+		if (fixtures)
+		{
+			fixtures[i] = created[i];
+		}
+	}
+
+	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
+	b2Fixture::CreateProxies(broadPhase, stackAllocator, created, count);
+	stackAllocator->Free(created);
+
+	// Adjust mass properties if needed.
+	if (hasMass)
+	{
+		ResetMassData();
+	}
+
+	// Let the world know we have new fixtures. This will cause new contacts
+	// to be created at the beginning of the next time step.
+	m_world->m_flags |= b2World::e_newFixture | b2World::e_newSector;
+}
+
+b2Fixture* b2Body::AddFixture(const b2FixtureDef* def)
+{
+	b2BlockAllocator* allocator = &m_world->m_blockAllocator;
+
+	void* memory = allocator->Allocate(sizeof(b2Fixture));
+	b2Fixture* fixture = new (memory) b2Fixture;
+	fixture->Create(allocator, this, def);
+
+	fixture->m_next = m_fixtureList;
+	m_fixtureList = fixture;
+	++m_fixtureCount;
+
+	fixture->m_body = this;
+
+	return fixture;
+}
+
 void b2Body::DestroyFixture(b2Fixture* fixture)
 {
 	b2Assert(m_world->IsLocked() == false);
@@ -267,17 +336,17 @@ void b2Body::ResetMassData()
 {
 	// Compute mass data from shapes. Each shape has its own density.
 	m_mass = 0.0f;
-	m_invMass = 0.0f;
+	InvMass() = 0.0f;
 	m_I = 0.0f;
-	m_invI = 0.0f;
-	m_sweep.localCenter.SetZero();
+	InvI() = 0.0f;
+	Sweep().localCenter.SetZero();
 
 	// Static and kinematic bodies have zero mass.
 	if (m_type == b2_staticBody || m_type == b2_kinematicBody)
 	{
-		m_sweep.c0 = m_xf.p;
-		m_sweep.c = m_xf.p;
-		m_sweep.a0 = m_sweep.a;
+		Sweep().c0 = Transform().p;
+		Sweep().c = Transform().p;
+		Sweep().a0 = Sweep().a;
 		return;
 	}
 
@@ -302,14 +371,14 @@ void b2Body::ResetMassData()
 	// Compute center of mass.
 	if (m_mass > 0.0f)
 	{
-		m_invMass = 1.0f / m_mass;
-		localCenter *= m_invMass;
+		InvMass() = 1.0f / m_mass;
+		localCenter *= InvMass();
 	}
 	else
 	{
 		// Force all dynamic bodies to have a positive mass.
 		m_mass = 1.0f;
-		m_invMass = 1.0f;
+		InvMass() = 1.0f;
 	}
 
 	if (m_I > 0.0f && (m_flags & e_fixedRotationFlag) == 0)
@@ -317,22 +386,22 @@ void b2Body::ResetMassData()
 		// Center the inertia about the center of mass.
 		m_I -= m_mass * b2Dot(localCenter, localCenter);
 		b2Assert(m_I > 0.0f);
-		m_invI = 1.0f / m_I;
+		InvI() = 1.0f / m_I;
 
 	}
 	else
 	{
 		m_I = 0.0f;
-		m_invI = 0.0f;
+		InvI() = 0.0f;
 	}
 
 	// Move center of mass.
-	b2Vec2 oldCenter = m_sweep.c;
-	m_sweep.localCenter = localCenter;
-	m_sweep.c0 = m_sweep.c = b2Mul(m_xf, m_sweep.localCenter);
+	b2Vec2 oldCenter = Sweep().c;
+	Sweep().localCenter = localCenter;
+	Sweep().c0 = Sweep().c = b2Mul(Transform(), Sweep().localCenter);
 
 	// Update center of mass velocity.
-	m_linearVelocity += b2Cross(m_angularVelocity, m_sweep.c - oldCenter);
+	LinearVelocity() += b2Cross(AngularVelocity(), Sweep().c - oldCenter);
 }
 
 void b2Body::SetMassData(const b2MassData* massData)
@@ -348,9 +417,9 @@ void b2Body::SetMassData(const b2MassData* massData)
 		return;
 	}
 
-	m_invMass = 0.0f;
+	InvMass() = 0.0f;
 	m_I = 0.0f;
-	m_invI = 0.0f;
+	InvI() = 0.0f;
 
 	m_mass = massData->mass;
 	if (m_mass <= 0.0f)
@@ -358,22 +427,22 @@ void b2Body::SetMassData(const b2MassData* massData)
 		m_mass = 1.0f;
 	}
 
-	m_invMass = 1.0f / m_mass;
+	InvMass() = 1.0f / m_mass;
 
 	if (massData->I > 0.0f && (m_flags & b2Body::e_fixedRotationFlag) == 0)
 	{
 		m_I = massData->I - m_mass * b2Dot(massData->center, massData->center);
 		b2Assert(m_I > 0.0f);
-		m_invI = 1.0f / m_I;
+		InvI() = 1.0f / m_I;
 	}
 
 	// Move center of mass.
-	b2Vec2 oldCenter = m_sweep.c;
-	m_sweep.localCenter =  massData->center;
-	m_sweep.c0 = m_sweep.c = b2Mul(m_xf, m_sweep.localCenter);
+	b2Vec2 oldCenter = Sweep().c;
+	Sweep().localCenter =  massData->center;
+	Sweep().c0 = Sweep().c = b2Mul(Transform(), Sweep().localCenter);
 
 	// Update center of mass velocity.
-	m_linearVelocity += b2Cross(m_angularVelocity, m_sweep.c - oldCenter);
+	LinearVelocity() += b2Cross(AngularVelocity(), Sweep().c - oldCenter);
 }
 
 bool b2Body::ShouldCollide(const b2Body* other) const
@@ -407,34 +476,38 @@ void b2Body::SetTransform(const b2Vec2& position, float32 angle)
 		return;
 	}
 
-	m_xf.q.Set(angle);
-	m_xf.p = position;
+	Transform().q.Set(angle);
+	Transform().p = position;
 
-	m_sweep.c = b2Mul(m_xf, m_sweep.localCenter);
-	m_sweep.a = angle;
+	Sweep().c = b2Mul(Transform(), Sweep().localCenter);
+	Sweep().a = angle;
 
-	m_sweep.c0 = m_sweep.c;
-	m_sweep.a0 = angle;
+	Sweep().c0 = Sweep().c;
+	Sweep().a0 = angle;
 
 	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
 	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
 	{
-		f->Synchronize(broadPhase, m_xf, m_xf);
+		f->Synchronize(broadPhase, Transform(), Transform());
 	}
 
 	m_world->m_contactManager.FindNewContacts();
+
+	// The body may have moved to another sector.
+	m_world->m_flags |= b2World::e_newSector;
 }
 
 void b2Body::SynchronizeFixtures()
 {
 	b2Transform xf1;
-	xf1.q.Set(m_sweep.a0);
-	xf1.p = m_sweep.c0 - b2Mul(xf1.q, m_sweep.localCenter);
+	xf1.q.Set(Sweep().a0);
+	xf1.p = Sweep().c0 - b2Mul(xf1.q, Sweep().localCenter);
 
 	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
+	bool predict = m_world->m_speculativeContacts;
 	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
 	{
-		f->Synchronize(broadPhase, xf1, m_xf);
+		f->Synchronize(broadPhase, xf1, Transform(), predict);
 	}
 }
 
@@ -442,6 +515,9 @@ void b2Body::SetActive(bool flag)
 {
 	b2Assert(m_world->IsLocked() == false);
 
+	// The user takes over from sector streaming.
+	m_flags &= ~e_streamedFlag;
+
 	if (flag == IsActive())
 	{
 		return;
@@ -455,13 +531,17 @@ void b2Body::SetActive(bool flag)
 		b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
 		for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
 		{
-			f->CreateProxies(broadPhase, m_xf);
+			f->CreateProxies(broadPhase, Transform());
 		}
 
+		m_world->m_islandManager.AddBody(this);
+
 		// Contacts are created the next time step.
 	}
 	else
 	{
+		m_world->m_islandManager.RemoveBody(this);
+
 		m_flags &= ~e_activeFlag;
 
 		// Destroy all proxies.
@@ -483,6 +563,33 @@ void b2Body::SetActive(bool flag)
 	}
 }
 
+void b2Body::SetAwake(bool flag)
+{
+	if (flag)
+	{
+		if ((m_flags & e_awakeFlag) == 0)
+		{
+			m_flags |= e_awakeFlag;
+			m_sleepTime = 0.0f;
+
+			// The island is solved again.
+			if (m_island)
+			{
+				m_world->m_islandManager.WakeIsland(m_island);
+			}
+		}
+	}
+	else
+	{
+		m_flags &= ~e_awakeFlag;
+		m_sleepTime = 0.0f;
+		LinearVelocity().SetZero();
+		AngularVelocity() = 0.0f;
+		Force().SetZero();
+		Torque() = 0.0f;
+	}
+}
+
 void b2Body::Dump()
 {
 	int32 bodyIndex = m_islandIndex;
@@ -490,10 +597,10 @@ void b2Body::Dump()
 	b2Log("{\n");
 	b2Log("  b2BodyDef bd;\n");
 	b2Log("  bd.type = b2BodyType(%d);\n", m_type);
-	b2Log("  bd.position.Set(%.15lef, %.15lef);\n", m_xf.p.x, m_xf.p.y);
-	b2Log("  bd.angle = %.15lef;\n", m_sweep.a);
-	b2Log("  bd.linearVelocity.Set(%.15lef, %.15lef);\n", m_linearVelocity.x, m_linearVelocity.y);
-	b2Log("  bd.angularVelocity = %.15lef;\n", m_angularVelocity);
+	b2Log("  bd.position.Set(%.15lef, %.15lef);\n", Transform().p.x, Transform().p.y);
+	b2Log("  bd.angle = %.15lef;\n", Sweep().a);
+	b2Log("  bd.linearVelocity.Set(%.15lef, %.15lef);\n", LinearVelocity().x, LinearVelocity().y);
+	b2Log("  bd.angularVelocity = %.15lef;\n", AngularVelocity());
 	b2Log("  bd.linearDamping = %.15lef;\n", m_linearDamping);
 	b2Log("  bd.angularDamping = %.15lef;\n", m_angularDamping);
 	b2Log("  bd.allowSleep = bool(%d);\n", m_flags & e_autoSleepFlag);
@@ -21,6 +21,7 @@
 
 #include <Box2D/Common/b2Math.h>
 #include <Box2D/Collision/Shapes/b2Shape.h>
+#include <Box2D/Dynamics/b2BodyStates.h>
 #include <memory>
 
 class b2Fixture;
@@ -31,6 +32,7 @@ class b2World;
 struct b2FixtureDef;
 struct b2JointEdge;
 struct b2ContactEdge;
+struct b2PersistentIsland;
 
 /// The body type.
 /// static: zero mass, zero velocity, may be manually moved
@@ -144,6 +146,15 @@ public:
 	/// @warning This function is locked during callbacks.
 	b2Fixture* CreateFixture(const b2Shape* shape, float32 density);
 
+	/// Creates many fixtures and attach them to this body. The mass is updated
+	/// once and the proxies are inserted into the broad-phase in bulk, which is
+	/// faster than calling CreateFixture for each definition.
+	/// @param defs the fixture definitions.
+	/// @param count the number of fixture definitions.
+	/// @param fixtures receives the new fixtures, may be NULL.
+	/// @warning This function is locked during callbacks.
+	void CreateFixtures(const b2FixtureDef* defs, int32 count, b2Fixture** fixtures = NULL);
+
 	/// Destroy a fixture. This removes the fixture from the broad-phase and
 	/// destroys all contacts associated with this fixture. This will
 	/// automatically adjust the mass of the body if the body is dynamic and the
@@ -162,21 +173,21 @@ public:
 
 	/// Get the body transform for the body's origin.
 	/// @return the world transform of the body's origin.
-	const b2Transform& GetTransform() const;
+	b2Transform GetTransform() const;
 
 	/// Get the world body origin position.
 	/// @return the world position of the body's origin.
-	const b2Vec2& GetPosition() const;
+	b2Vec2 GetPosition() const;
 
 	/// Get the angle in radians.
 	/// @return the current world rotation angle in radians.
 	float32 GetAngle() const;
 
 	/// Get the world position of the center of mass.
-	const b2Vec2& GetWorldCenter() const;
+	b2Vec2 GetWorldCenter() const;
 
 	/// Get the local position of the center of mass.
-	const b2Vec2& GetLocalCenter() const;
+	b2Vec2 GetLocalCenter() const;
 
 	/// Set the linear velocity of the center of mass.
 	/// @param v the new linear velocity of the center of mass.
@@ -382,6 +393,7 @@ private:
 
 	friend class b2World;
 	friend class b2Island;
+	friend class b2IslandManager;
 	friend class b2ContactManager;
 	friend class b2ContactSolver;
 	friend class b2Contact;
@@ -396,6 +408,8 @@ private:
 	friend class b2WeldJoint;
 	friend class b2FrictionJoint;
 	friend class b2RopeJoint;
+	friend class b2Sectors;
+	friend struct b2SolverData;
 
 	// m_flags
 	enum
@@ -406,7 +420,8 @@ private:
 		e_bulletFlag		= 0x0008,
 		e_fixedRotationFlag	= 0x0010,
 		e_activeFlag		= 0x0020,
-		e_toiFlag			= 0x0040
+		e_toiFlag			= 0x0040,
+		e_streamedFlag		= 0x0080	// deactivated by sector streaming
 	};
 
 	b2Body(const b2BodyDef* bd, b2World* world);
@@ -415,41 +430,64 @@ private:
 	void SynchronizeFixtures();
 	void SynchronizeTransform();
 
+	// Create a fixture and add it to the list without proxies or mass.
+	b2Fixture* AddFixture(const b2FixtureDef* def);
+
 	// This is used to prevent connected bodies from colliding.
 	// It may lie, depending on the collideConnected flag.
 	bool ShouldCollide(const b2Body* other) const;
 
 	void Advance(float32 t);
 
+	// The hot state lives in the world arrays at m_stateIndex.
+	b2Transform& Transform() { return m_states->m_transforms[m_stateIndex]; }
+	const b2Transform& Transform() const { return m_states->m_transforms[m_stateIndex]; }
+	b2Sweep& Sweep() { return m_states->m_sweeps[m_stateIndex]; }
+	const b2Sweep& Sweep() const { return m_states->m_sweeps[m_stateIndex]; }
+	b2Vec2& LinearVelocity() { return m_states->m_linearVelocities[m_stateIndex]; }
+	const b2Vec2& LinearVelocity() const { return m_states->m_linearVelocities[m_stateIndex]; }
+	float32& AngularVelocity() { return m_states->m_angularVelocities[m_stateIndex]; }
+	float32 AngularVelocity() const { return m_states->m_angularVelocities[m_stateIndex]; }
+	b2Vec2& Force() { return m_states->m_forces[m_stateIndex]; }
+	float32& Torque() { return m_states->m_torques[m_stateIndex]; }
+	float32& InvMass() { return m_states->m_invMasses[m_stateIndex]; }
+	float32 InvMass() const { return m_states->m_invMasses[m_stateIndex]; }
+	float32& InvI() { return m_states->m_invIs[m_stateIndex]; }
+	float32 InvI() const { return m_states->m_invIs[m_stateIndex]; }
+
 	b2BodyType m_type;
 
 	uint16 m_flags;
 
 	int32 m_islandIndex;
 
-	b2Transform m_xf;		// the body origin transform
-	b2Sweep m_sweep;		// the swept motion for CCD
-
-	b2Vec2 m_linearVelocity;
-	float32 m_angularVelocity;
-
-	b2Vec2 m_force;
-	float32 m_torque;
+	b2BodyStates* m_states;
+	int32 m_stateIndex;
 
 	b2World* m_world;
 	b2Body* m_prev;
 	b2Body* m_next;
 
+	// The streaming sector, see b2World::SetStreaming.
+	int32 m_sector;
+	b2Body* m_sectorPrev;
+	b2Body* m_sectorNext;
+
 	b2Fixture* m_fixtureList;
 	int32 m_fixtureCount;
 
 	b2JointEdge* m_jointList;
 	b2ContactEdge* m_contactList;
 
-	float32 m_mass, m_invMass;
+	// The persistent island, NULL for static and inactive bodies.
+	b2PersistentIsland* m_island;
+	b2Body* m_islandPrev;
+	b2Body* m_islandNext;
+
+	float32 m_mass;
 
 	// Rotational inertia about the center of mass.
-	float32 m_I, m_invI;
+	float32 m_I;
 
 	float32 m_linearDamping;
 	float32 m_angularDamping;
@@ -465,29 +503,29 @@ inline b2BodyType b2Body::GetType() const
 	return m_type;
 }
 
-inline const b2Transform& b2Body::GetTransform() const
+inline b2Transform b2Body::GetTransform() const
 {
-	return m_xf;
+	return Transform();
 }
 
-inline const b2Vec2& b2Body::GetPosition() const
+inline b2Vec2 b2Body::GetPosition() const
 {
-	return m_xf.p;
+	return Transform().p;
 }
 
 inline float32 b2Body::GetAngle() const
 {
-	return m_sweep.a;
+	return Sweep().a;
 }
 
-inline const b2Vec2& b2Body::GetWorldCenter() const
+inline b2Vec2 b2Body::GetWorldCenter() const
 {
-	return m_sweep.c;
+	return Sweep().c;
 }
 
-inline const b2Vec2& b2Body::GetLocalCenter() const
+inline b2Vec2 b2Body::GetLocalCenter() const
 {
-	return m_sweep.localCenter;
+	return Sweep().localCenter;
 }
 
 inline void b2Body::SetLinearVelocity(const b2Vec2& v)
@@ -502,12 +540,12 @@ inline void b2Body::SetLinearVelocity(const b2Vec2& v)
 		SetAwake(true);
 	}
 
-	m_linearVelocity = v;
+	LinearVelocity() = v;
 }
 
 inline b2Vec2 b2Body::GetLinearVelocity() const
 {
-	return m_linearVelocity;
+	return LinearVelocity();
 }
 
 inline void b2Body::SetAngularVelocity(float32 w)
@@ -522,12 +560,12 @@ inline void b2Body::SetAngularVelocity(float32 w)
 		SetAwake(true);
 	}
 
-	m_angularVelocity = w;
+	AngularVelocity() = w;
 }
 
 inline float32 b2Body::GetAngularVelocity() const
 {
-	return m_angularVelocity;
+	return AngularVelocity();
 }
 
 inline float32 b2Body::GetMass() const
@@ -537,39 +575,39 @@ inline float32 b2Body::GetMass() const
 
 inline float32 b2Body::GetInertia() const
 {
-	return m_I + m_mass * b2Dot(m_sweep.localCenter, m_sweep.localCenter);
+	return m_I + m_mass * b2Dot(Sweep().localCenter, Sweep().localCenter);
 }
 
 inline void b2Body::GetMassData(b2MassData* data) const
 {
 	data->mass = m_mass;
-	data->I = m_I + m_mass * b2Dot(m_sweep.localCenter, m_sweep.localCenter);
-	data->center = m_sweep.localCenter;
+	data->I = m_I + m_mass * b2Dot(Sweep().localCenter, Sweep().localCenter);
+	data->center = Sweep().localCenter;
 }
 
 inline b2Vec2 b2Body::GetWorldPoint(const b2Vec2& localPoint) const
 {
-	return b2Mul(m_xf, localPoint);
+	return b2Mul(Transform(), localPoint);
 }
 
 inline b2Vec2 b2Body::GetWorldVector(const b2Vec2& localVector) const
 {
-	return b2Mul(m_xf.q, localVector);
+	return b2Mul(Transform().q, localVector);
 }
 
 inline b2Vec2 b2Body::GetLocalPoint(const b2Vec2& worldPoint) const
 {
-	return b2MulT(m_xf, worldPoint);
+	return b2MulT(Transform(), worldPoint);
 }
 
 inline b2Vec2 b2Body::GetLocalVector(const b2Vec2& worldVector) const
 {
-	return b2MulT(m_xf.q, worldVector);
+	return b2MulT(Transform().q, worldVector);
 }
 
 inline b2Vec2 b2Body::GetLinearVelocityFromWorldPoint(const b2Vec2& worldPoint) const
 {
-	return m_linearVelocity + b2Cross(m_angularVelocity, worldPoint - m_sweep.c);
+	return LinearVelocity() + b2Cross(AngularVelocity(), worldPoint - Sweep().c);
 }
 
 inline b2Vec2 b2Body::GetLinearVelocityFromLocalPoint(const b2Vec2& localPoint) const
@@ -624,27 +662,6 @@ inline bool b2Body::IsBullet() const
 	return (m_flags & e_bulletFlag) == e_bulletFlag;
 }
 
-inline void b2Body::SetAwake(bool flag)
-{
-	if (flag)
-	{
-		if ((m_flags & e_awakeFlag) == 0)
-		{
-			m_flags |= e_awakeFlag;
-			m_sleepTime = 0.0f;
-		}
-	}
-	else
-	{
-		m_flags &= ~e_awakeFlag;
-		m_sleepTime = 0.0f;
-		m_linearVelocity.SetZero();
-		m_angularVelocity = 0.0f;
-		m_force.SetZero();
-		m_torque = 0.0f;
-	}
-}
-
 inline bool b2Body::IsAwake() const
 {
 	return (m_flags & e_awakeFlag) == e_awakeFlag;
@@ -754,8 +771,8 @@ inline void b2Body::ApplyForce(const b2Vec2& force, const b2Vec2& point)
 		SetAwake(true);
 	}
 
-	m_force += force;
-	m_torque += b2Cross(point - m_sweep.c, force);
+	Force() += force;
+	Torque() += b2Cross(point - Sweep().c, force);
 }
 
 inline void b2Body::ApplyForceToCenter(const b2Vec2& force)
@@ -770,7 +787,7 @@ inline void b2Body::ApplyForceToCenter(const b2Vec2& force)
 		SetAwake(true);
 	}
 
-	m_force += force;
+	Force() += force;
 }
 
 inline void b2Body::ApplyTorque(float32 torque)
@@ -785,7 +802,7 @@ inline void b2Body::ApplyTorque(float32 torque)
 		SetAwake(true);
 	}
 
-	m_torque += torque;
+	Torque() += torque;
 }
 
 inline void b2Body::ApplyLinearImpulse(const b2Vec2& impulse, const b2Vec2& point)
@@ -799,8 +816,8 @@ inline void b2Body::ApplyLinearImpulse(const b2Vec2& impulse, const b2Vec2& poin
 	{
 		SetAwake(true);
 	}
-	m_linearVelocity += m_invMass * impulse;
-	m_angularVelocity += m_invI * b2Cross(point - m_sweep.c, impulse);
+	LinearVelocity() += InvMass() * impulse;
+	AngularVelocity() += InvI() * b2Cross(point - Sweep().c, impulse);
 }
 
 inline void b2Body::ApplyAngularImpulse(float32 impulse)
@@ -814,23 +831,27 @@ inline void b2Body::ApplyAngularImpulse(float32 impulse)
 	{
 		SetAwake(true);
 	}
-	m_angularVelocity += m_invI * impulse;
+	AngularVelocity() += InvI() * impulse;
 }
 
 inline void b2Body::SynchronizeTransform()
 {
-	m_xf.q.Set(m_sweep.a);
-	m_xf.p = m_sweep.c - b2Mul(m_xf.q, m_sweep.localCenter);
+	const b2Sweep& sweep = Sweep();
+	b2Transform& xf = Transform();
+	xf.q.Set(sweep.a);
+	xf.p = sweep.c - b2Mul(xf.q, sweep.localCenter);
 }
 
 inline void b2Body::Advance(float32 alpha)
 {
 	// Advance to the new safe time. This doesn't sync the broad-phase.
-	m_sweep.Advance(alpha);
-	m_sweep.c = m_sweep.c0;
-	m_sweep.a = m_sweep.a0;
-	m_xf.q.Set(m_sweep.a);
-	m_xf.p = m_sweep.c - b2Mul(m_xf.q, m_sweep.localCenter);
+	b2Sweep& sweep = Sweep();
+	b2Transform& xf = Transform();
+	sweep.Advance(alpha);
+	sweep.c = sweep.c0;
+	sweep.a = sweep.a0;
+	xf.q.Set(sweep.a);
+	xf.p = sweep.c - b2Mul(xf.q, sweep.localCenter);
 }
 
 inline b2World* b2Body::GetWorld()
@@ -0,0 +1,93 @@
+/*
+* Copyright (c) 2013 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/b2BodyStates.h>
+
+b2BodyStates::b2BodyStates()
+{
+	m_transforms = NULL;
+	m_sweeps = NULL;
+	m_linearVelocities = NULL;
+	m_angularVelocities = NULL;
+	m_forces = NULL;
+	m_torques = NULL;
+	m_invMasses = NULL;
+	m_invIs = NULL;
+
+	m_count = 0;
+	m_capacity = 0;
+
+	m_freeIndices = NULL;
+	m_freeCount = 0;
+}
+
+b2BodyStates::~b2BodyStates()
+{
+	b2Free(m_transforms);
+	b2Free(m_sweeps);
+	b2Free(m_linearVelocities);
+	b2Free(m_angularVelocities);
+	b2Free(m_forces);
+	b2Free(m_torques);
+	b2Free(m_invMasses);
+	b2Free(m_invIs);
+	b2Free(m_freeIndices);
+}
+
+void b2BodyStates::Grow()
+{
+	int32 capacity = b2Max(2 * m_capacity, 64);
+	b2GrowArray(&m_transforms, m_count, capacity);
+	b2GrowArray(&m_sweeps, m_count, capacity);
+	b2GrowArray(&m_linearVelocities, m_count, capacity);
+	b2GrowArray(&m_angularVelocities, m_count, capacity);
+	b2GrowArray(&m_forces, m_count, capacity);
+	b2GrowArray(&m_torques, m_count, capacity);
+	b2GrowArray(&m_invMasses, m_count, capacity);
+	b2GrowArray(&m_invIs, m_count, capacity);
+	b2GrowArray(&m_freeIndices, m_freeCount, capacity);
+	m_capacity = capacity;
+}
+
+int32 b2BodyStates::Allocate()
+{
+	if (m_freeCount > 0)
+	{
+		return m_freeIndices[--m_freeCount];
+	}
+
+	if (m_count == m_capacity)
+	{
+		Grow();
+	}
+
+	return m_count++;
+}
+
+void b2BodyStates::Free(int32 index)
+{
+	b2Assert(0 <= index && index < m_count);
+	b2Assert(m_freeCount < m_capacity);
+
+	// Freed entries stay in the arrays, so keep them harmless for loops over
+	// every index.
+	m_forces[index].SetZero();
+	m_torques[index] = 0.0f;
+
+	m_freeIndices[m_freeCount++] = index;
+}
@@ -0,0 +1,64 @@
+/*
+* Copyright (c) 2013 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_BODY_STATES_H
+#define B2_BODY_STATES_H
+
+#include <Box2D/Common/b2Math.h>
+
+/// The hot state of the bodies of a world in structure of arrays form. Each
+/// body owns the entries at its state index, which stays the same for the
+/// life of the body, so loops over many bodies read contiguous memory instead
+/// of following the body list. Indices of destroyed bodies are reused.
+/// This is an internal class.
+class b2BodyStates
+{
+public:
+	b2BodyStates();
+	~b2BodyStates();
+
+	/// Get a free index. The arrays may move.
+	int32 Allocate();
+
+	/// Return an index to the free list.
+	void Free(int32 index);
+
+	/// One past the largest index in use. Loops over all bodies run up to here.
+	int32 GetCount() const { return m_count; }
+
+	b2Transform* m_transforms;		// the body origin transforms
+	b2Sweep* m_sweeps;				// the swept motion for CCD
+	b2Vec2* m_linearVelocities;
+	float32* m_angularVelocities;
+	b2Vec2* m_forces;
+	float32* m_torques;
+	float32* m_invMasses;
+	float32* m_invIs;				// inverse rotational inertia about the center of mass
+
+private:
+
+	void Grow();
+
+	int32 m_count;
+	int32 m_capacity;
+
+	int32* m_freeIndices;
+	int32 m_freeCount;
+};
+
+#endif
@@ -0,0 +1,129 @@
+/*
+* Copyright (c) 2013 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/b2ContactEvents.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Dynamics/b2WorldCallbacks.h>
+#include <Box2D/Dynamics/Contacts/b2Contact.h>
+
+// Make room for one more event, doubling the buffer when it is full.
+template <typename T>
+static T* b2GrowEvents(T* events, int32 count, int32* capacity)
+{
+	if (count < *capacity)
+	{
+		return events;
+	}
+
+	*capacity = b2Max(2 * *capacity, 16);
+	b2GrowArray(&events, count, *capacity);
+	return events;
+}
+
+b2ContactEvents::b2ContactEvents()
+{
+	m_categoryMask = 0xFFFF;
+	m_solveEnabled = true;
+
+	m_beginEvents = NULL;
+	m_beginCount = 0;
+	m_beginCapacity = 0;
+
+	m_endEvents = NULL;
+	m_endCount = 0;
+	m_endCapacity = 0;
+
+	m_solveEvents = NULL;
+	m_solveCount = 0;
+	m_solveCapacity = 0;
+}
+
+b2ContactEvents::~b2ContactEvents()
+{
+	b2Free(m_beginEvents);
+	b2Free(m_endEvents);
+	b2Free(m_solveEvents);
+}
+
+void b2ContactEvents::Clear()
+{
+	m_beginCount = 0;
+	m_endCount = 0;
+	m_solveCount = 0;
+}
+
+bool b2ContactEvents::ShouldReport(const b2Contact* contact) const
+{
+	uint16 categoryBits = contact->GetFixtureA()->GetFilterData().categoryBits;
+	categoryBits |= contact->GetFixtureB()->GetFilterData().categoryBits;
+	return (categoryBits & m_categoryMask) != 0;
+}
+
+void b2ContactEvents::AddBegin(b2Contact* contact)
+{
+	if (ShouldReport(contact) == false)
+	{
+		return;
+	}
+
+	m_beginEvents = b2GrowEvents(m_beginEvents, m_beginCount, &m_beginCapacity);
+	b2ContactTouchEvent* event = m_beginEvents + m_beginCount++;
+	event->fixtureA = contact->GetFixtureA();
+	event->fixtureB = contact->GetFixtureB();
+	event->childIndexA = contact->GetChildIndexA();
+	event->childIndexB = contact->GetChildIndexB();
+}
+
+void b2ContactEvents::AddEnd(b2Contact* contact)
+{
+	if (ShouldReport(contact) == false)
+	{
+		return;
+	}
+
+	m_endEvents = b2GrowEvents(m_endEvents, m_endCount, &m_endCapacity);
+	b2ContactTouchEvent* event = m_endEvents + m_endCount++;
+	event->fixtureA = contact->GetFixtureA();
+	event->fixtureB = contact->GetFixtureB();
+	event->childIndexA = contact->GetChildIndexA();
+	event->childIndexB = contact->GetChildIndexB();
+}
+
+void b2ContactEvents::AddSolve(b2Contact* contact, const b2ContactImpulse* impulse)
+{
+	if (m_solveEnabled == false || ShouldReport(contact) == false)
+	{
+		return;
+	}
+
+	b2WorldManifold worldManifold;
+	contact->GetWorldManifold(&worldManifold);
+
+	m_solveEvents = b2GrowEvents(m_solveEvents, m_solveCount, &m_solveCapacity);
+	b2ContactSolveEvent* event = m_solveEvents + m_solveCount++;
+	event->fixtureA = contact->GetFixtureA();
+	event->fixtureB = contact->GetFixtureB();
+	event->normal = worldManifold.normal;
+	event->pointCount = impulse->count;
+	for (int32 i = 0; i < impulse->count; ++i)
+	{
+		event->points[i] = worldManifold.points[i];
+		event->normalImpulses[i] = impulse->normalImpulses[i];
+		event->tangentImpulses[i] = impulse->tangentImpulses[i];
+	}
+}
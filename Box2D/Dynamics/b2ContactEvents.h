@@ -0,0 +1,120 @@
+/*
+* Copyright (c) 2013 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_CONTACT_EVENTS_H
+#define B2_CONTACT_EVENTS_H
+
+#include <Box2D/Common/b2Math.h>
+
+class b2Contact;
+class b2Fixture;
+struct b2ContactImpulse;
+
+/// Two fixtures that began or stopped touching.
+struct b2ContactTouchEvent
+{
+	b2Fixture* fixtureA;
+	b2Fixture* fixtureB;
+	int32 childIndexA;
+	int32 childIndexB;
+};
+
+/// A contact after the solver ran. This holds the same data as
+/// b2ContactListener::PostSolve, with the manifold in world coordinates.
+struct b2ContactSolveEvent
+{
+	b2Fixture* fixtureA;
+	b2Fixture* fixtureB;
+	b2Vec2 normal;									///< world vector pointing from A to B
+	b2Vec2 points[b2_maxManifoldPoints];			///< world contact points
+	float32 normalImpulses[b2_maxManifoldPoints];
+	float32 tangentImpulses[b2_maxManifoldPoints];
+	int32 pointCount;
+};
+
+/// Flat buffers of the contact events of a time step. Register one with
+/// b2World::SetContactEvents and read the events after b2World::Step instead of
+/// handling them in b2ContactListener callbacks. Events are only recorded for
+/// pairs where a fixture has a category bit in the category mask, so a game can
+/// skip the pairs it does not care about without a virtual call for each of them.
+/// Events raised outside of b2World::Step, such as by destroying a body, are
+/// not recorded.
+class b2ContactEvents
+{
+public:
+	b2ContactEvents();
+	~b2ContactEvents();
+
+	/// Only record pairs where fixture A or fixture B has one of these
+	/// category bits. The default records every pair.
+	void SetCategoryMask(uint16 mask) { m_categoryMask = mask; }
+	uint16 GetCategoryMask() const { return m_categoryMask; }
+
+	/// Enable or disable the solve events. These need the world manifold, so
+	/// leave them off if only the begin and end events are used. On by default.
+	void SetSolveEventsEnabled(bool flag) { m_solveEnabled = flag; }
+	bool IsSolveEventsEnabled() const { return m_solveEnabled; }
+
+	/// Remove all events. b2World::Step calls this when it begins.
+	void Clear();
+
+	/// Fixtures that began touching during the last step.
+	const b2ContactTouchEvent* GetBeginEvents() const { return m_beginEvents; }
+	int32 GetBeginEventCount() const { return m_beginCount; }
+
+	/// Fixtures that stopped touching during the last step. The contact may
+	/// have been destroyed.
+	const b2ContactTouchEvent* GetEndEvents() const { return m_endEvents; }
+	int32 GetEndEventCount() const { return m_endCount; }
+
+	/// Touching, non-sensor contacts after the solver ran, in the order of the
+	/// PostSolve callbacks. A contact solved again in a TOI sub-step appears again.
+	const b2ContactSolveEvent* GetSolveEvents() const { return m_solveEvents; }
+	int32 GetSolveEventCount() const { return m_solveCount; }
+
+	/// Does this contact pass the category mask?
+	bool ShouldReport(const b2Contact* contact) const;
+
+private:
+
+	friend class b2Contact;
+	friend class b2ContactManager;
+	friend class b2Island;
+	friend class b2World;
+
+	void AddBegin(b2Contact* contact);
+	void AddEnd(b2Contact* contact);
+	void AddSolve(b2Contact* contact, const b2ContactImpulse* impulse);
+
+	uint16 m_categoryMask;
+	bool m_solveEnabled;
+
+	b2ContactTouchEvent* m_beginEvents;
+	int32 m_beginCount;
+	int32 m_beginCapacity;
+
+	b2ContactTouchEvent* m_endEvents;
+	int32 m_endCount;
+	int32 m_endCapacity;
+
+	b2ContactSolveEvent* m_solveEvents;
+	int32 m_solveCount;
+	int32 m_solveCapacity;
+};
+
+#endif
@@ -18,20 +18,40 @@
 
 #include <Box2D/Dynamics/b2ContactManager.h>
 #include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2ContactEvents.h>
 #include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Dynamics/b2IslandManager.h>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
+#include <Box2D/Collision/b2Distance.h>
+#include <Box2D/Common/b2ThreadPool.h>
+#include <Box2D/Common/b2Profiler.h>
 
 b2ContactFilter b2_defaultFilter;
 b2ContactListener b2_defaultListener;
 
-b2ContactManager::b2ContactManager()
+b2ContactManager::b2ContactManager(b2BroadPhaseTree treeType)
+	: m_broadPhase(treeType)
 {
 	m_contactList = NULL;
 	m_contactCount = 0;
 	m_contactFilter = &b2_defaultFilter;
 	m_contactListener = &b2_defaultListener;
+	m_contactEvents = NULL;
 	m_allocator = NULL;
+	m_islandManager = NULL;
+	m_speculativeTime = 0.0f;
+	m_polygonCacheHits = 0;
+	m_polygonCacheMisses = 0;
+	m_threadPool = NULL;
+	m_profiler = NULL;
+	m_narrowPhaseResults = NULL;
+	m_narrowPhaseCapacity = 0;
+}
+
+b2ContactManager::~b2ContactManager()
+{
+	b2Free(m_narrowPhaseResults);
 }
 
 void b2ContactManager::Destroy(b2Contact* c)
@@ -41,9 +61,22 @@ void b2ContactManager::Destroy(b2Contact* c)
 	b2Body* bodyA = fixtureA->GetBody();
 	b2Body* bodyB = fixtureB->GetBody();
 
-	if (m_contactListener && c->IsTouching())
+	if (c->IsTouching())
+	{
+		if (m_contactListener)
+		{
+			m_contactListener->EndContact(c);
+		}
+
+		if (m_contactEvents)
+		{
+			m_contactEvents->AddEnd(c);
+		}
+	}
+
+	if (c->m_island)
 	{
-		m_contactListener->EndContact(c);
+		m_islandManager->UnlinkContact(c);
 	}
 
 	// Remove from the world.
@@ -102,12 +135,137 @@ void b2ContactManager::Destroy(b2Contact* c)
 // This is the top level collision call for the time step. Here
 // all the narrow phase collision is processed for the world
 // contact list.
+// The manifold of one contact, computed ahead of b2Contact::Update.
+struct b2NarrowPhaseResult
+{
+	b2Contact* contact;
+	b2Manifold manifold;
+	bool touching;
+	bool sensor;
+};
+
+// Contacts are handed to the pool threads in groups of this size.
+#define b2_narrowPhaseGroupSize	16
+
+struct b2NarrowPhaseTask : public b2ParallelTask
+{
+	void Execute(int32 index, int32 threadIndex)
+	{
+		b2ProfileScope scope(profiler, "narrowPhaseGroup", threadIndex);
+
+		// Sensors run GJK, which counts into the global statistics.
+		if (threadIndex > 0)
+		{
+			b2SetThreadCounters(counters + threadIndex);
+		}
+
+		int32 first = index * b2_narrowPhaseGroupSize;
+		int32 last = b2Min(first + b2_narrowPhaseGroupSize, count);
+		for (int32 i = first; i < last; ++i)
+		{
+			b2NarrowPhaseResult* result = results + i;
+			b2Contact* c = result->contact;
+			result->sensor = c->GetFixtureA()->IsSensor() || c->GetFixtureB()->IsSensor();
+			result->touching = c->ComputeManifold(&result->manifold, speculativeTime);
+		}
+
+		if (threadIndex > 0)
+		{
+			b2SetThreadCounters(NULL);
+		}
+	}
+
+	b2NarrowPhaseResult* results;
+	int32 count;
+	float32 speculativeTime;
+	b2Profiler* profiler;
+	b2CollisionCounters counters[b2_maxThreads];
+};
+
+int32 b2ContactManager::ComputeManifolds()
+{
+	if (m_contactCount > m_narrowPhaseCapacity)
+	{
+		b2Free(m_narrowPhaseResults);
+		m_narrowPhaseCapacity = b2Max(m_contactCount, 2 * m_narrowPhaseCapacity);
+		m_narrowPhaseResults = (b2NarrowPhaseResult*)b2Alloc(m_narrowPhaseCapacity * sizeof(b2NarrowPhaseResult));
+	}
+
+	// Flatten the contacts that pass the checks in Collide that don't involve the
+	// user. Filtering may still destroy some of them.
+	int32 count = 0;
+	for (b2Contact* c = m_contactList; c; c = c->GetNext())
+	{
+		b2Fixture* fixtureA = c->GetFixtureA();
+		b2Fixture* fixtureB = c->GetFixtureB();
+		b2Body* bodyA = fixtureA->GetBody();
+		b2Body* bodyB = fixtureB->GetBody();
+
+		bool activeA = bodyA->IsAwake() && bodyA->m_type != b2_staticBody;
+		bool activeB = bodyB->IsAwake() && bodyB->m_type != b2_staticBody;
+		if (activeA == false && activeB == false)
+		{
+			continue;
+		}
+
+		int32 proxyIdA = fixtureA->m_proxies[c->GetChildIndexA()].proxyId;
+		int32 proxyIdB = fixtureB->m_proxies[c->GetChildIndexB()].proxyId;
+		if (m_broadPhase.TestOverlap(proxyIdA, proxyIdB) == false)
+		{
+			continue;
+		}
+
+		m_narrowPhaseResults[count++].contact = c;
+	}
+
+	b2NarrowPhaseTask task;
+	task.results = m_narrowPhaseResults;
+	task.count = count;
+	task.speculativeTime = m_speculativeTime;
+	task.profiler = m_profiler;
+
+	int32 threadCount = m_threadPool->GetThreadCount();
+	for (int32 i = 1; i < threadCount; ++i)
+	{
+		task.counters[i].SetZero();
+	}
+
+	m_threadPool->Run(&task, (count + b2_narrowPhaseGroupSize - 1) / b2_narrowPhaseGroupSize);
+
+	for (int32 i = 1; i < threadCount; ++i)
+	{
+		b2AddGlobalCounters(task.counters[i]);
+	}
+
+	return count;
+}
+
 void b2ContactManager::Collide()
 {
+	// With a thread pool the manifolds are computed up front. The loop below then
+	// only applies them, so the filtering, the contact events and the destruction
+	// of contacts still happen here in list order.
+	int32 resultCount = 0;
+	if (m_threadPool)
+	{
+		resultCount = ComputeManifolds();
+	}
+	int32 resultIndex = 0;
+
+	m_polygonCacheHits = 0;
+	m_polygonCacheMisses = 0;
+
 	// Update awake contacts.
 	b2Contact* c = m_contactList;
 	while (c)
 	{
+		b2NarrowPhaseResult* result = NULL;
+		if (resultIndex < resultCount && m_narrowPhaseResults[resultIndex].contact == c)
+		{
+			result = m_narrowPhaseResults + resultIndex;
+			++resultIndex;
+		}
+
 		b2Fixture* fixtureA = c->GetFixtureA();
 		b2Fixture* fixtureB = c->GetFixtureB();
 		int32 indexA = c->GetChildIndexA();
@@ -163,8 +321,28 @@ void b2ContactManager::Collide()
 			continue;
 		}
 
-		// The contact persists.
-		c->Update(m_contactListener);
+		// The contact persists. Contacts that were woken up by an earlier one or
+		// had a sensor flag changed by a callback are computed here.
+		bool sensor = fixtureA->IsSensor() || fixtureB->IsSensor();
+		if (result && result->sensor == sensor)
+		{
+			c->Update(m_contactListener, m_contactEvents, result->manifold, result->touching);
+		}
+		else
+		{
+			c->Update(m_contactListener, m_contactEvents, m_speculativeTime);
+		}
+
+		if (c->m_flags & b2Contact::e_cacheHitFlag)
+		{
+			++m_polygonCacheHits;
+		}
+		else if (c->m_flags & b2Contact::e_cacheMissFlag)
+		{
+			++m_polygonCacheMisses;
+		}
+
+		m_islandManager->UpdateContact(c);
 		c = c->GetNext();
 	}
 }
@@ -196,11 +374,20 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 
 	// TODO_ERIN use a hash table to remove a potential bottleneck when both
 	// bodies have a lot of contacts.
-	// Does a contact already exist?
-	b2ContactEdge* edge = bodyB->GetContactList();
+	// Does a contact already exist? Static bodies, such as level geometry, can
+	// touch many bodies so search the other one.
+	b2Body* body = bodyB;
+	b2Body* other = bodyA;
+	if (bodyB->GetType() == b2_staticBody)
+	{
+		body = bodyA;
+		other = bodyB;
+	}
+
+	b2ContactEdge* edge = body->GetContactList();
 	while (edge)
 	{
-		if (edge->other == bodyA)
+		if (edge->other == other)
 		{
 			b2Fixture* fA = edge->contact->GetFixtureA();
 			b2Fixture* fB = edge->contact->GetFixtureB();
@@ -24,13 +24,19 @@
 class b2Contact;
 class b2ContactFilter;
 class b2ContactListener;
+class b2ContactEvents;
 class b2BlockAllocator;
+class b2IslandManager;
+class b2ThreadPool;
+class b2Profiler;
+struct b2NarrowPhaseResult;
 
 // Delegate of b2World.
 class b2ContactManager
 {
 public:
-	b2ContactManager();
+	b2ContactManager(b2BroadPhaseTree treeType = b2_binaryTree);
+	~b2ContactManager();
 
 	// Broad-phase callback.
 	void AddPair(void* proxyUserDataA, void* proxyUserDataB);
@@ -40,13 +46,36 @@ public:
 	void Destroy(b2Contact* c);
 
 	void Collide();
+
+	// Compute the manifolds of the contacts that Collide is going to update
+	// on the thread pool. Returns the number of results.
+	int32 ComputeManifolds();
             
 	b2BroadPhase m_broadPhase;
 	b2Contact* m_contactList;
 	int32 m_contactCount;
 	b2ContactFilter* m_contactFilter;
 	b2ContactListener* m_contactListener;
+
+	// The event buffers of the world. Only set while the world is stepping.
+	b2ContactEvents* m_contactEvents;
 	b2BlockAllocator* m_allocator;
+	b2IslandManager* m_islandManager;
+
+	// Collide keeps contact points that the relative motion over this time could
+	// close. Zero unless the world uses speculative contacts.
+	float32 m_speculativeTime;
+
+	// The polygon contacts updated by the last Collide that did or did not
+	// reuse the separating edges of the step before.
+	int32 m_polygonCacheHits;
+	int32 m_polygonCacheMisses;
+
+	// With a thread pool Collide computes the manifolds in parallel first.
+	b2ThreadPool* m_threadPool;
+	b2Profiler* m_profiler;
+	b2NarrowPhaseResult* m_narrowPhaseResults;
+	int32 m_narrowPhaseCapacity;
 };
 
 #endif
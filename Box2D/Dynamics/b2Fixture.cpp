@@ -26,6 +26,7 @@
 #include <Box2D/Collision/b2BroadPhase.h>
 #include <Box2D/Collision/b2Collision.h>
 #include <Box2D/Common/b2BlockAllocator.h>
+#include <Box2D/Common/b2StackAllocator.h>
 
 b2Fixture::b2Fixture()
 {
@@ -119,10 +120,22 @@ void b2Fixture::Destroy(b2BlockAllocator* allocator)
 	m_shape = NULL;
 }
 
+static b2ProxyType b2GetProxyType(const b2Body* body)
+{
+	if (body->GetType() == b2_staticBody)
+	{
+		return b2_staticProxy;
+	}
+
+	return body->IsAwake() ? b2_dynamicProxy : b2_sleepingProxy;
+}
+
 void b2Fixture::CreateProxies(b2BroadPhase* broadPhase, const b2Transform& xf)
 {
 	b2Assert(m_proxyCount == 0);
 
+	b2ProxyType type = b2GetProxyType(m_body);
+
 	// Create proxies in the broad-phase.
 	m_proxyCount = m_shape->GetChildCount();
 
@@ -130,12 +143,69 @@ void b2Fixture::CreateProxies(b2BroadPhase* broadPhase, const b2Transform& xf)
 	{
 		b2FixtureProxy* proxy = m_proxies + i;
 		m_shape->ComputeAABB(&proxy->aabb, xf, i);
-		proxy->proxyId = broadPhase->CreateProxy(proxy->aabb, proxy);
+		proxy->proxyId = broadPhase->CreateProxy(proxy->aabb, proxy, type);
 		proxy->fixture = this;
 		proxy->childIndex = i;
 	}
 }
 
+void b2Fixture::CreateProxies(b2BroadPhase* broadPhase, b2StackAllocator* allocator, b2Fixture* const* fixtures, int32 count)
+{
+	int32 proxyCount = 0;
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Assert(fixtures[i]->m_proxyCount == 0);
+		if (fixtures[i]->m_body->IsActive())
+		{
+			proxyCount += fixtures[i]->m_shape->GetChildCount();
+		}
+	}
+
+	b2AABB* aabbs = (b2AABB*)allocator->Allocate(proxyCount * sizeof(b2AABB));
+	void** userData = (void**)allocator->Allocate(proxyCount * sizeof(void*));
+	b2ProxyType* types = (b2ProxyType*)allocator->Allocate(proxyCount * sizeof(b2ProxyType));
+	int32* proxyIds = (int32*)allocator->Allocate(proxyCount * sizeof(int32));
+
+	int32 index = 0;
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Fixture* fixture = fixtures[i];
+		b2Body* body = fixture->m_body;
+		if (body->IsActive() == false)
+		{
+			continue;
+		}
+
+		b2ProxyType type = b2GetProxyType(body);
+		fixture->m_proxyCount = fixture->m_shape->GetChildCount();
+		for (int32 j = 0; j < fixture->m_proxyCount; ++j)
+		{
+			b2FixtureProxy* proxy = fixture->m_proxies + j;
+			fixture->m_shape->ComputeAABB(&proxy->aabb, body->GetTransform(), j);
+			proxy->fixture = fixture;
+			proxy->childIndex = j;
+
+			aabbs[index] = proxy->aabb;
+			userData[index] = proxy;
+			types[index] = type;
+			++index;
+		}
+	}
+
+	broadPhase->CreateProxies(aabbs, userData, types, proxyCount, proxyIds);
+
+	for (int32 i = 0; i < proxyCount; ++i)
+	{
+		b2FixtureProxy* proxy = (b2FixtureProxy*)userData[i];
+		proxy->proxyId = proxyIds[i];
+	}
+
+	allocator->Free(proxyIds);
+	allocator->Free(types);
+	allocator->Free(userData);
+	allocator->Free(aabbs);
+}
+
 void b2Fixture::DestroyProxies(b2BroadPhase* broadPhase)
 {
 	// Destroy proxies in the broad-phase.
@@ -149,13 +219,15 @@ void b2Fixture::DestroyProxies(b2BroadPhase* broadPhase)
 	m_proxyCount = 0;
 }
 
-void b2Fixture::Synchronize(b2BroadPhase* broadPhase, const b2Transform& transform1, const b2Transform& transform2)
+void b2Fixture::Synchronize(b2BroadPhase* broadPhase, const b2Transform& transform1, const b2Transform& transform2, bool predict)
 {
 	if (m_proxyCount == 0)
 	{	
 		return;
 	}
 
+	UpdateProxyType(broadPhase);
+
 	for (int32 i = 0; i < m_proxyCount; ++i)
 	{
 		b2FixtureProxy* proxy = m_proxies + i;
@@ -169,7 +241,29 @@ void b2Fixture::Synchronize(b2BroadPhase* broadPhase, const b2Transform& transfo
 
 		b2Vec2 displacement = transform2.p - transform1.p;
 
-		broadPhase->MoveProxy(proxy->proxyId, proxy->aabb, displacement);
+		b2AABB aabb = proxy->aabb;
+		if (predict)
+		{
+			b2AABB aabb3;
+			aabb3.lowerBound = aabb2.lowerBound + displacement;
+			aabb3.upperBound = aabb2.upperBound + displacement;
+			aabb.Combine(aabb3);
+		}
+
+		broadPhase->MoveProxy(proxy->proxyId, aabb, displacement);
+	}
+}
+
+void b2Fixture::UpdateProxyType(b2BroadPhase* broadPhase)
+{
+	b2ProxyType type = b2GetProxyType(m_body);
+	for (int32 i = 0; i < m_proxyCount; ++i)
+	{
+		b2FixtureProxy* proxy = m_proxies + i;
+		if (broadPhase->GetProxyType(proxy->proxyId) != type)
+		{
+			proxy->proxyId = broadPhase->SetProxyType(proxy->proxyId, type);
+		}
 	}
 }
 
@@ -24,6 +24,7 @@
 #include <Box2D/Collision/Shapes/b2Shape.h>
 
 class b2BlockAllocator;
+class b2StackAllocator;
 class b2Body;
 class b2BroadPhase;
 class b2Fixture;
@@ -211,9 +212,17 @@ protected:
 
 	// These support body activation/deactivation.
 	void CreateProxies(b2BroadPhase* broadPhase, const b2Transform& xf);
+
+	// Create the proxies of many fixtures of active bodies with one bulk insert.
+	static void CreateProxies(b2BroadPhase* broadPhase, b2StackAllocator* allocator, b2Fixture* const* fixtures, int32 count);
 	void DestroyProxies(b2BroadPhase* broadPhase);
 
-	void Synchronize(b2BroadPhase* broadPhase, const b2Transform& xf1, const b2Transform& xf2);
+	// With predict set, the proxy also covers the next step if the displacement
+	// repeats. Speculative contacts need the pair before the shapes get close.
+	void Synchronize(b2BroadPhase* broadPhase, const b2Transform& xf1, const b2Transform& xf2, bool predict = false);
+
+	// Move the proxies to the broad-phase tree matching the body type and sleep state.
+	void UpdateProxyType(b2BroadPhase* broadPhase);
 
 	float32 m_density;
 
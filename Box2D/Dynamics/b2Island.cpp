@@ -19,6 +19,7 @@
 #include <Box2D/Collision/b2Distance.h>
 #include <Box2D/Dynamics/b2Island.h>
 #include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2ContactEvents.h>
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2World.h>
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
@@ -26,6 +27,8 @@
 #include <Box2D/Dynamics/Joints/b2Joint.h>
 #include <Box2D/Common/b2StackAllocator.h>
 #include <Box2D/Common/b2Timer.h>
+#include <string.h>
+#include <algorithm>
 
 /*
 Position Correction Notes
@@ -161,6 +164,11 @@ b2Island::b2Island(
 
 	m_allocator = allocator;
 	m_listener = listener;
+	m_impulses = NULL;
+	m_events = NULL;
+	m_jointBatchCount = 0;
+	m_statics = NULL;
+	m_staticCount = 0;
 
 	m_bodies = (b2Body**)m_allocator->Allocate(bodyCapacity * sizeof(b2Body*));
 	m_contacts = (b2Contact**)m_allocator->Allocate(contactCapacity	 * sizeof(b2Contact*));
@@ -170,6 +178,58 @@ b2Island::b2Island(
 	m_positions = (b2Position*)m_allocator->Allocate(m_bodyCapacity * sizeof(b2Position));
 }
 
+bool b2Island::StaticLessThan(const b2Body* bodyA, const b2Body* bodyB)
+{
+	return bodyA->m_islandIndex < bodyB->m_islandIndex;
+}
+
+void b2Island::SetStatics(b2Body** statics, int32 count)
+{
+	b2Assert(m_bodyCount + count <= m_bodyCapacity);
+	std::sort(statics, statics + count, StaticLessThan);
+	m_statics = statics;
+	m_staticCount = count;
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Body* body = statics[i];
+		b2Assert(body->m_type == b2_staticBody);
+		int32 index = m_bodyCount + i;
+		const b2Sweep& sweep = body->Sweep();
+		m_positions[index].c = sweep.c;
+		m_positions[index].a = sweep.a;
+		m_velocities[index].v = body->LinearVelocity();
+		m_velocities[index].w = body->AngularVelocity();
+	}
+}
+
+int32 b2SolverData::GetIndex(const b2Body* body) const
+{
+	if (statics == NULL || body->m_type != b2_staticBody)
+	{
+		return body->m_islandIndex;
+	}
+
+	// Binary search for the shared static body.
+	int32 low = 0;
+	int32 high = staticCount - 1;
+	while (low < high)
+	{
+		int32 mid = (low + high) >> 1;
+		if (statics[mid]->m_islandIndex < body->m_islandIndex)
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+
+	b2Assert(statics[low] == body);
+	return bodyCount + low;
+}
+
 b2Island::~b2Island()
 {
 	// Warning: the order should reverse the constructor order.
@@ -180,31 +240,140 @@ b2Island::~b2Island()
 	m_allocator->Free(m_bodies);
 }
 
+void b2Island::BatchJoints()
+{
+	m_jointBatchCount = 0;
+	if (m_jointCount == 0)
+	{
+		m_jointBatches[0] = 0;
+		return;
+	}
+
+	// Counting sort, stable within each type.
+	int32 starts[b2_jointTypeCount];
+	for (int32 i = 0; i < b2_jointTypeCount; ++i)
+	{
+		starts[i] = 0;
+	}
+
+	for (int32 i = 0; i < m_jointCount; ++i)
+	{
+		++starts[m_joints[i]->GetType()];
+	}
+
+	int32 offset = 0;
+	for (int32 i = 0; i < b2_jointTypeCount; ++i)
+	{
+		int32 count = starts[i];
+		starts[i] = offset;
+		if (count > 0)
+		{
+			m_jointBatches[m_jointBatchCount++] = offset;
+		}
+		offset += count;
+	}
+	m_jointBatches[m_jointBatchCount] = offset;
+
+	b2Joint** joints = (b2Joint**)m_allocator->Allocate(m_jointCount * sizeof(b2Joint*));
+	for (int32 i = 0; i < m_jointCount; ++i)
+	{
+		joints[starts[m_joints[i]->GetType()]++] = m_joints[i];
+	}
+
+	memcpy(m_joints, joints, m_jointCount * sizeof(b2Joint*));
+	m_allocator->Free(joints);
+}
+
+void b2Island::InitJointVelocities(const b2SolverData& data, bool batched)
+{
+	if (batched)
+	{
+		for (int32 i = 0; i < m_jointBatchCount; ++i)
+		{
+			int32 start = m_jointBatches[i];
+			b2Joint::InitVelocityBatch(m_joints + start, m_jointBatches[i + 1] - start, data);
+		}
+		return;
+	}
+
+	for (int32 i = 0; i < m_jointCount; ++i)
+	{
+		m_joints[i]->InitVelocityConstraints(data);
+	}
+}
+
+void b2Island::SolveJointVelocities(const b2SolverData& data, bool batched)
+{
+	if (batched)
+	{
+		for (int32 i = 0; i < m_jointBatchCount; ++i)
+		{
+			int32 start = m_jointBatches[i];
+			b2Joint::SolveVelocityBatch(m_joints + start, m_jointBatches[i + 1] - start, data);
+		}
+		return;
+	}
+
+	for (int32 i = 0; i < m_jointCount; ++i)
+	{
+		m_joints[i]->SolveVelocityConstraints(data);
+	}
+}
+
+bool b2Island::SolveJointPositions(const b2SolverData& data, bool batched)
+{
+	bool jointsOkay = true;
+	if (batched)
+	{
+		for (int32 i = 0; i < m_jointBatchCount; ++i)
+		{
+			int32 start = m_jointBatches[i];
+			bool batchOkay = b2Joint::SolvePositionBatch(m_joints + start, m_jointBatches[i + 1] - start, data);
+			jointsOkay = jointsOkay && batchOkay;
+		}
+		return jointsOkay;
+	}
+
+	for (int32 i = 0; i < m_jointCount; ++i)
+	{
+		bool jointOkay = m_joints[i]->SolvePositionConstraints(data);
+		jointsOkay = jointsOkay && jointOkay;
+	}
+
+	return jointsOkay;
+}
+
 void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep)
 {
 	b2Timer timer;
 
+	if (step.batchedJoints)
+	{
+		BatchJoints();
+	}
+
 	float32 h = step.dt;
 
 	// Integrate velocities and apply damping. Initialize the body state.
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
 		b2Body* b = m_bodies[i];
+		b2Sweep& sweep = b->Sweep();
 
-		b2Vec2 c = b->m_sweep.c;
-		float32 a = b->m_sweep.a;
-		b2Vec2 v = b->m_linearVelocity;
-		float32 w = b->m_angularVelocity;
+		b2Vec2 c = sweep.c;
+		float32 a = sweep.a;
+		b2Vec2 v = b->LinearVelocity();
+		float32 w = b->AngularVelocity();
 
 		// Store positions for continuous collision.
-		b->m_sweep.c0 = b->m_sweep.c;
-		b->m_sweep.a0 = b->m_sweep.a;
+		sweep.c0 = sweep.c;
+		sweep.a0 = sweep.a;
 
 		if (b->m_type == b2_dynamicBody)
 		{
 			// Integrate velocities.
-			v += h * (b->m_gravityScale * gravity + b->m_invMass * b->m_force);
-			w += h * b->m_invI * b->m_torque;
+			v += h * (b->m_gravityScale * gravity + b->InvMass() * b->Force());
+			w += h * b->InvI() * b->Torque();
 
 			// Apply damping.
 			// ODE: dv/dt + c * v = 0
@@ -230,6 +399,9 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	solverData.step = step;
 	solverData.positions = m_positions;
 	solverData.velocities = m_velocities;
+	solverData.statics = m_statics;
+	solverData.staticCount = m_staticCount;
+	solverData.bodyCount = m_bodyCount;
 
 	// Initialize velocity constraints.
 	b2ContactSolverDef contactSolverDef;
@@ -238,6 +410,7 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	contactSolverDef.count = m_contactCount;
 	contactSolverDef.positions = m_positions;
 	contactSolverDef.velocities = m_velocities;
+	contactSolverDef.solverData = &solverData;
 	contactSolverDef.allocator = m_allocator;
 
 	b2ContactSolver contactSolver(&contactSolverDef);
@@ -247,11 +420,13 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	{
 		contactSolver.WarmStart();
 	}
-	
-	for (int32 i = 0; i < m_jointCount; ++i)
+
+	if (step.simdContactSolver)
 	{
-		m_joints[i]->InitVelocityConstraints(solverData);
+		contactSolver.InitializeVelocityBatches();
 	}
+	
+	InitJointVelocities(solverData, step.batchedJoints);
 
 	profile->solveInit = timer.GetMilliseconds();
 
@@ -259,10 +434,7 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	timer.Reset();
 	for (int32 i = 0; i < step.velocityIterations; ++i)
 	{
-		for (int32 j = 0; j < m_jointCount; ++j)
-		{
-			m_joints[j]->SolveVelocityConstraints(solverData);
-		}
+		SolveJointVelocities(solverData, step.batchedJoints);
 
 		contactSolver.SolveVelocityConstraints();
 	}
@@ -311,12 +483,7 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	{
 		bool contactsOkay = contactSolver.SolvePositionConstraints();
 
-		bool jointsOkay = true;
-		for (int32 i = 0; i < m_jointCount; ++i)
-		{
-			bool jointOkay = m_joints[i]->SolvePositionConstraints(solverData);
-			jointsOkay = jointsOkay && jointOkay;
-		}
+		bool jointsOkay = SolveJointPositions(solverData, step.batchedJoints);
 
 		if (contactsOkay && jointsOkay)
 		{
@@ -330,10 +497,11 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
 		b2Body* body = m_bodies[i];
-		body->m_sweep.c = m_positions[i].c;
-		body->m_sweep.a = m_positions[i].a;
-		body->m_linearVelocity = m_velocities[i].v;
-		body->m_angularVelocity = m_velocities[i].w;
+		b2Sweep& sweep = body->Sweep();
+		sweep.c = m_positions[i].c;
+		sweep.a = m_positions[i].a;
+		body->LinearVelocity() = m_velocities[i].v;
+		body->AngularVelocity() = m_velocities[i].w;
 		body->SynchronizeTransform();
 	}
 
@@ -356,9 +524,11 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 				continue;
 			}
 
+			float32 w = b->AngularVelocity();
+			const b2Vec2& v = b->LinearVelocity();
 			if ((b->m_flags & b2Body::e_autoSleepFlag) == 0 ||
-				b->m_angularVelocity * b->m_angularVelocity > angTolSqr ||
-				b2Dot(b->m_linearVelocity, b->m_linearVelocity) > linTolSqr)
+				w * w > angTolSqr ||
+				b2Dot(v, v) > linTolSqr)
 			{
 				b->m_sleepTime = 0.0f;
 				minSleepTime = 0.0f;
@@ -390,12 +560,21 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiInd
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
 		b2Body* b = m_bodies[i];
-		m_positions[i].c = b->m_sweep.c;
-		m_positions[i].a = b->m_sweep.a;
-		m_velocities[i].v = b->m_linearVelocity;
-		m_velocities[i].w = b->m_angularVelocity;
+		const b2Sweep& sweep = b->Sweep();
+		m_positions[i].c = sweep.c;
+		m_positions[i].a = sweep.a;
+		m_velocities[i].v = b->LinearVelocity();
+		m_velocities[i].w = b->AngularVelocity();
 	}
 
+	b2SolverData solverData;
+	solverData.step = subStep;
+	solverData.positions = m_positions;
+	solverData.velocities = m_velocities;
+	solverData.statics = NULL;
+	solverData.staticCount = 0;
+	solverData.bodyCount = m_bodyCount;
+
 	b2ContactSolverDef contactSolverDef;
 	contactSolverDef.contacts = m_contacts;
 	contactSolverDef.count = m_contactCount;
@@ -403,6 +582,7 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiInd
 	contactSolverDef.step = subStep;
 	contactSolverDef.positions = m_positions;
 	contactSolverDef.velocities = m_velocities;
+	contactSolverDef.solverData = &solverData;
 	b2ContactSolver contactSolver(&contactSolverDef);
 
 	// Solve position constraints.
@@ -449,10 +629,10 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiInd
 #endif
 
 	// Leap of faith to new safe state.
-	m_bodies[toiIndexA]->m_sweep.c0 = m_positions[toiIndexA].c;
-	m_bodies[toiIndexA]->m_sweep.a0 = m_positions[toiIndexA].a;
-	m_bodies[toiIndexB]->m_sweep.c0 = m_positions[toiIndexB].c;
-	m_bodies[toiIndexB]->m_sweep.a0 = m_positions[toiIndexB].a;
+	m_bodies[toiIndexA]->Sweep().c0 = m_positions[toiIndexA].c;
+	m_bodies[toiIndexA]->Sweep().a0 = m_positions[toiIndexA].a;
+	m_bodies[toiIndexB]->Sweep().c0 = m_positions[toiIndexB].c;
+	m_bodies[toiIndexB]->Sweep().a0 = m_positions[toiIndexB].a;
 
 	// No warm starting is needed for TOI events because warm
 	// starting impulses were applied in the discrete solver.
@@ -503,10 +683,11 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiInd
 
 		// Sync bodies
 		b2Body* body = m_bodies[i];
-		body->m_sweep.c = c;
-		body->m_sweep.a = a;
-		body->m_linearVelocity = v;
-		body->m_angularVelocity = w;
+		b2Sweep& sweep = body->Sweep();
+		sweep.c = c;
+		sweep.a = a;
+		body->LinearVelocity() = v;
+		body->AngularVelocity() = w;
 		body->SynchronizeTransform();
 	}
 
@@ -515,7 +696,7 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiInd
 
 void b2Island::Report(const b2ContactVelocityConstraint* constraints)
 {
-	if (m_listener == NULL)
+	if (m_listener == NULL && m_impulses == NULL && m_events == NULL)
 	{
 		return;
 	}
@@ -534,6 +715,20 @@ void b2Island::Report(const b2ContactVelocityConstraint* constraints)
 			impulse.tangentImpulses[j] = vc->points[j].tangentImpulse;
 		}
 
-		m_listener->PostSolve(c, &impulse);
+		if (m_impulses)
+		{
+			m_impulses[i] = impulse;
+			continue;
+		}
+
+		if (m_listener)
+		{
+			m_listener->PostSolve(c, &impulse);
+		}
+
+		if (m_events)
+		{
+			m_events->AddSolve(c, &impulse);
+		}
 	}
 }
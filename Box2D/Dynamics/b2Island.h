@@ -22,11 +22,14 @@
 #include <Box2D/Common/b2Math.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
+#include <Box2D/Dynamics/Joints/b2Joint.h>
 
 class b2Contact;
 class b2Joint;
 class b2StackAllocator;
 class b2ContactListener;
+class b2ContactEvents;
+struct b2ContactImpulse;
 struct b2ContactVelocityConstraint;
 struct b2Profile;
 
@@ -57,6 +60,12 @@ public:
 		++m_bodyCount;
 	}
 
+	/// Set the static bodies that may be shared with other islands. Each one has
+	/// an island index assigned by the caller that is unique for the step. Call
+	/// this after adding the other bodies. This sorts the statics by that index
+	/// and stores them after the other bodies. Solve never writes to them.
+	void SetStatics(b2Body** statics, int32 count);
+
 	void Add(b2Contact* contact)
 	{
 		b2Assert(m_contactCount < m_contactCapacity);
@@ -71,10 +80,27 @@ public:
 
 	void Report(const b2ContactVelocityConstraint* constraints);
 
+	// Sort the joints by type and find the batches of each type.
+	void BatchJoints();
+
+	// Joint solver phases. With batched joints each batch is solved through
+	// direct calls, otherwise every joint is called in island order.
+	void InitJointVelocities(const b2SolverData& data, bool batched);
+	void SolveJointVelocities(const b2SolverData& data, bool batched);
+	bool SolveJointPositions(const b2SolverData& data, bool batched);
+
 	b2StackAllocator* m_allocator;
 	b2ContactListener* m_listener;
 
+	// If set, Report stores one impulse per contact here instead of calling
+	// the listener, so the callbacks can be replayed later.
+	b2ContactImpulse* m_impulses;
+
+	// If set, Report also records a solve event for each contact.
+	b2ContactEvents* m_events;
+
 	b2Body** m_bodies;
+	b2Body** m_statics;
 	b2Contact** m_contacts;
 	b2Joint** m_joints;
 
@@ -82,12 +108,21 @@ public:
 	b2Velocity* m_velocities;
 
 	int32 m_bodyCount;
+	int32 m_staticCount;
 	int32 m_jointCount;
 	int32 m_contactCount;
 
 	int32 m_bodyCapacity;
 	int32 m_contactCapacity;
 	int32 m_jointCapacity;
+
+	// Batch i holds the joints from m_jointBatches[i] up to m_jointBatches[i + 1].
+	int32 m_jointBatches[b2_jointTypeCount + 1];
+	int32 m_jointBatchCount;
+
+private:
+
+	static bool StaticLessThan(const b2Body* bodyA, const b2Body* bodyB);
 };
 
 #endif
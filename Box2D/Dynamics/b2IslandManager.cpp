@@ -0,0 +1,687 @@
+/*
+* Copyright (c) 2013 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/b2IslandManager.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Dynamics/Contacts/b2Contact.h>
+#include <Box2D/Dynamics/Joints/b2Joint.h>
+#include <Box2D/Common/b2BlockAllocator.h>
+#include <Box2D/Common/b2StackAllocator.h>
+
+b2IslandManager::b2IslandManager()
+{
+	m_awakeList = NULL;
+	m_sleepingList = NULL;
+	m_islandCount = 0;
+	m_splitCount = 0;
+	m_allocator = NULL;
+	m_stackAllocator = NULL;
+}
+
+b2PersistentIsland* b2IslandManager::CreateIsland(bool awake)
+{
+	void* mem = m_allocator->Allocate(sizeof(b2PersistentIsland));
+	b2PersistentIsland* island = (b2PersistentIsland*)mem;
+	island->parent = NULL;
+	island->bodyList = NULL;
+	island->contactList = NULL;
+	island->jointList = NULL;
+	island->bodyCount = 0;
+	island->contactCount = 0;
+	island->jointCount = 0;
+	island->constraintRemoveCount = 0;
+	island->awake = awake;
+
+	b2PersistentIsland** list = awake ? &m_awakeList : &m_sleepingList;
+	island->prev = NULL;
+	island->next = *list;
+	if (*list)
+	{
+		(*list)->prev = island;
+	}
+	*list = island;
+
+	++m_islandCount;
+	return island;
+}
+
+void b2IslandManager::DestroyIsland(b2PersistentIsland* island)
+{
+	if (island->prev)
+	{
+		island->prev->next = island->next;
+	}
+
+	if (island->next)
+	{
+		island->next->prev = island->prev;
+	}
+
+	if (island == m_awakeList)
+	{
+		m_awakeList = island->next;
+	}
+
+	if (island == m_sleepingList)
+	{
+		m_sleepingList = island->next;
+	}
+
+	--m_islandCount;
+	m_allocator->Free(island, sizeof(b2PersistentIsland));
+}
+
+void b2IslandManager::WakeIsland(b2PersistentIsland* island)
+{
+	if (island->awake)
+	{
+		return;
+	}
+
+	// Remove from the sleeping list.
+	if (island->prev)
+	{
+		island->prev->next = island->next;
+	}
+
+	if (island->next)
+	{
+		island->next->prev = island->prev;
+	}
+
+	if (island == m_sleepingList)
+	{
+		m_sleepingList = island->next;
+	}
+
+	// Add to the awake list.
+	island->prev = NULL;
+	island->next = m_awakeList;
+	if (m_awakeList)
+	{
+		m_awakeList->prev = island;
+	}
+	m_awakeList = island;
+
+	island->awake = true;
+}
+
+void b2IslandManager::SleepIsland(b2PersistentIsland* island)
+{
+	b2Assert(island->parent == NULL);
+
+	if (island->awake == false)
+	{
+		return;
+	}
+
+	// Remove from the awake list.
+	if (island->prev)
+	{
+		island->prev->next = island->next;
+	}
+
+	if (island->next)
+	{
+		island->next->prev = island->prev;
+	}
+
+	if (island == m_awakeList)
+	{
+		m_awakeList = island->next;
+	}
+
+	// Add to the sleeping list.
+	island->prev = NULL;
+	island->next = m_sleepingList;
+	if (m_sleepingList)
+	{
+		m_sleepingList->prev = island;
+	}
+	m_sleepingList = island;
+
+	island->awake = false;
+}
+
+void b2IslandManager::AddToIsland(b2PersistentIsland* island, b2Body* body)
+{
+	body->m_island = island;
+	body->m_islandPrev = NULL;
+	body->m_islandNext = island->bodyList;
+	if (island->bodyList)
+	{
+		island->bodyList->m_islandPrev = body;
+	}
+	island->bodyList = body;
+	++island->bodyCount;
+}
+
+void b2IslandManager::AddToIsland(b2PersistentIsland* island, b2Contact* contact)
+{
+	contact->m_island = island;
+	contact->m_islandPrev = NULL;
+	contact->m_islandNext = island->contactList;
+	if (island->contactList)
+	{
+		island->contactList->m_islandPrev = contact;
+	}
+	island->contactList = contact;
+	++island->contactCount;
+}
+
+void b2IslandManager::AddToIsland(b2PersistentIsland* island, b2Joint* joint)
+{
+	joint->m_island = island;
+	joint->m_islandPrev = NULL;
+	joint->m_islandNext = island->jointList;
+	if (island->jointList)
+	{
+		island->jointList->m_islandPrev = joint;
+	}
+	island->jointList = joint;
+	++island->jointCount;
+}
+
+void b2IslandManager::AddBody(b2Body* body)
+{
+	b2Assert(body->m_island == NULL);
+
+	if (body->IsActive() == false)
+	{
+		return;
+	}
+
+	if (body->m_type != b2_staticBody)
+	{
+		b2PersistentIsland* island = CreateIsland(body->IsAwake());
+		AddToIsland(island, body);
+	}
+
+	for (b2JointEdge* je = body->m_jointList; je; je = je->next)
+	{
+		if (je->joint->m_island == NULL)
+		{
+			LinkJoint(je->joint);
+		}
+	}
+
+	for (b2ContactEdge* ce = body->m_contactList; ce; ce = ce->next)
+	{
+		UpdateContact(ce->contact);
+	}
+}
+
+void b2IslandManager::RemoveBody(b2Body* body)
+{
+	for (b2ContactEdge* ce = body->m_contactList; ce; ce = ce->next)
+	{
+		if (ce->contact->m_island)
+		{
+			UnlinkContact(ce->contact);
+		}
+	}
+
+	for (b2JointEdge* je = body->m_jointList; je; je = je->next)
+	{
+		if (je->joint->m_island)
+		{
+			UnlinkJoint(je->joint);
+		}
+	}
+
+	b2PersistentIsland* island = body->m_island;
+	if (island == NULL)
+	{
+		return;
+	}
+
+	if (body->m_islandPrev)
+	{
+		body->m_islandPrev->m_islandNext = body->m_islandNext;
+	}
+
+	if (body->m_islandNext)
+	{
+		body->m_islandNext->m_islandPrev = body->m_islandPrev;
+	}
+
+	if (body == island->bodyList)
+	{
+		island->bodyList = body->m_islandNext;
+	}
+
+	--island->bodyCount;
+	body->m_island = NULL;
+	body->m_islandPrev = NULL;
+	body->m_islandNext = NULL;
+
+	// An awake island may be the target of a pending union, so empty awake
+	// islands are destroyed by SplitIslands.
+	if (island->bodyCount == 0 && island->awake == false)
+	{
+		DestroyIsland(island);
+	}
+}
+
+void b2IslandManager::UpdateContact(b2Contact* contact)
+{
+	bool link = contact->HasSolverPoints() &&
+		contact->m_fixtureA->IsSensor() == false &&
+		contact->m_fixtureB->IsSensor() == false;
+
+	if (link && contact->m_island == NULL)
+	{
+		LinkContact(contact);
+	}
+	else if (link == false && contact->m_island != NULL)
+	{
+		UnlinkContact(contact);
+	}
+}
+
+void b2IslandManager::LinkContact(b2Contact* contact)
+{
+	b2Body* bodyA = contact->m_fixtureA->GetBody();
+	b2Body* bodyB = contact->m_fixtureB->GetBody();
+
+	if (bodyA->m_island && bodyB->m_island)
+	{
+		LinkIslands(bodyA->m_island, bodyB->m_island);
+	}
+
+	// Linking sleeping islands merges them right away.
+	b2PersistentIsland* island = bodyA->m_island ? bodyA->m_island : bodyB->m_island;
+	if (island)
+	{
+		AddToIsland(island, contact);
+	}
+}
+
+void b2IslandManager::UnlinkContact(b2Contact* contact)
+{
+	b2PersistentIsland* island = contact->m_island;
+	b2Assert(island != NULL);
+
+	if (contact->m_islandPrev)
+	{
+		contact->m_islandPrev->m_islandNext = contact->m_islandNext;
+	}
+
+	if (contact->m_islandNext)
+	{
+		contact->m_islandNext->m_islandPrev = contact->m_islandPrev;
+	}
+
+	if (contact == island->contactList)
+	{
+		island->contactList = contact->m_islandNext;
+	}
+
+	--island->contactCount;
+
+	// Contacts with a static body don't hold an island together.
+	if (contact->m_fixtureA->GetBody()->m_island && contact->m_fixtureB->GetBody()->m_island)
+	{
+		++island->constraintRemoveCount;
+	}
+
+	contact->m_island = NULL;
+	contact->m_islandPrev = NULL;
+	contact->m_islandNext = NULL;
+}
+
+void b2IslandManager::LinkJoint(b2Joint* joint)
+{
+	b2Assert(joint->m_island == NULL);
+
+	b2Body* bodyA = joint->m_bodyA;
+	b2Body* bodyB = joint->m_bodyB;
+
+	// Joints connected to inactive bodies are not simulated.
+	if (bodyA->IsActive() == false || bodyB->IsActive() == false)
+	{
+		return;
+	}
+
+	if (bodyA->m_island && bodyB->m_island)
+	{
+		LinkIslands(bodyA->m_island, bodyB->m_island);
+	}
+
+	b2PersistentIsland* island = bodyA->m_island ? bodyA->m_island : bodyB->m_island;
+	if (island)
+	{
+		AddToIsland(island, joint);
+	}
+}
+
+void b2IslandManager::UnlinkJoint(b2Joint* joint)
+{
+	b2PersistentIsland* island = joint->m_island;
+	b2Assert(island != NULL);
+
+	if (joint->m_islandPrev)
+	{
+		joint->m_islandPrev->m_islandNext = joint->m_islandNext;
+	}
+
+	if (joint->m_islandNext)
+	{
+		joint->m_islandNext->m_islandPrev = joint->m_islandPrev;
+	}
+
+	if (joint == island->jointList)
+	{
+		island->jointList = joint->m_islandNext;
+	}
+
+	--island->jointCount;
+
+	if (joint->m_bodyA->m_island && joint->m_bodyB->m_island)
+	{
+		++island->constraintRemoveCount;
+	}
+
+	joint->m_island = NULL;
+	joint->m_islandPrev = NULL;
+	joint->m_islandNext = NULL;
+}
+
+static b2PersistentIsland* b2FindRoot(b2PersistentIsland* island)
+{
+	b2PersistentIsland* root = island;
+	while (root->parent)
+	{
+		root = root->parent;
+	}
+
+	// Path compression.
+	while (island != root)
+	{
+		b2PersistentIsland* parent = island->parent;
+		island->parent = root;
+		island = parent;
+	}
+
+	return root;
+}
+
+void b2IslandManager::LinkIslands(b2PersistentIsland* islandA, b2PersistentIsland* islandB)
+{
+	b2PersistentIsland* rootA = b2FindRoot(islandA);
+	b2PersistentIsland* rootB = b2FindRoot(islandB);
+	if (rootA == rootB)
+	{
+		return;
+	}
+
+	// Union by size: the smaller island is merged into the larger one.
+	if (rootA->bodyCount < rootB->bodyCount)
+	{
+		b2Swap(rootA, rootB);
+	}
+
+	// Sleeping roots never have pending unions, so they can be merged right away.
+	// This keeps a joint between two sleeping islands from waking them.
+	if (rootA->awake == false && rootB->awake == false)
+	{
+		MergeIsland(rootB, rootA);
+		return;
+	}
+
+	// The merge is deferred to MergeIslands, which only visits awake islands.
+	rootB->parent = rootA;
+	WakeIsland(rootA);
+	WakeIsland(rootB);
+}
+
+void b2IslandManager::MergeIsland(b2PersistentIsland* island, b2PersistentIsland* root)
+{
+	b2Assert(island != root);
+
+	if (island->bodyList)
+	{
+		b2Body* last = NULL;
+		for (b2Body* b = island->bodyList; b; b = b->m_islandNext)
+		{
+			b->m_island = root;
+			last = b;
+		}
+
+		last->m_islandNext = root->bodyList;
+		if (root->bodyList)
+		{
+			root->bodyList->m_islandPrev = last;
+		}
+		root->bodyList = island->bodyList;
+	}
+
+	if (island->contactList)
+	{
+		b2Contact* last = NULL;
+		for (b2Contact* c = island->contactList; c; c = c->m_islandNext)
+		{
+			c->m_island = root;
+			last = c;
+		}
+
+		last->m_islandNext = root->contactList;
+		if (root->contactList)
+		{
+			root->contactList->m_islandPrev = last;
+		}
+		root->contactList = island->contactList;
+	}
+
+	if (island->jointList)
+	{
+		b2Joint* last = NULL;
+		for (b2Joint* j = island->jointList; j; j = j->m_islandNext)
+		{
+			j->m_island = root;
+			last = j;
+		}
+
+		last->m_islandNext = root->jointList;
+		if (root->jointList)
+		{
+			root->jointList->m_islandPrev = last;
+		}
+		root->jointList = island->jointList;
+	}
+
+	root->bodyCount += island->bodyCount;
+	root->contactCount += island->contactCount;
+	root->jointCount += island->jointCount;
+	root->constraintRemoveCount += island->constraintRemoveCount;
+
+	DestroyIsland(island);
+}
+
+void b2IslandManager::MergeIslands()
+{
+	// Point every child at its root first, merging frees the children.
+	for (b2PersistentIsland* island = m_awakeList; island; island = island->next)
+	{
+		if (island->parent)
+		{
+			island->parent = b2FindRoot(island);
+		}
+	}
+
+	b2PersistentIsland* island = m_awakeList;
+	while (island)
+	{
+		b2PersistentIsland* next = island->next;
+
+		b2PersistentIsland* root = island->parent;
+		if (root)
+		{
+			b2Assert(root->parent == NULL && root->awake);
+			MergeIsland(island, root);
+		}
+
+		island = next;
+	}
+}
+
+void b2IslandManager::SplitIslands()
+{
+	m_splitCount = 0;
+
+	b2PersistentIsland* island = m_awakeList;
+	while (island)
+	{
+		b2PersistentIsland* next = island->next;
+		b2Assert(island->parent == NULL);
+
+		if (island->bodyCount == 0)
+		{
+			b2Assert(island->contactCount == 0 && island->jointCount == 0);
+			DestroyIsland(island);
+			island = next;
+			continue;
+		}
+
+		bool awake = false;
+		for (b2Body* b = island->bodyList; b; b = b->m_islandNext)
+		{
+			if (b->IsAwake())
+			{
+				awake = true;
+				break;
+			}
+		}
+
+		if (awake == false)
+		{
+			// The island is split when it wakes up.
+			SleepIsland(island);
+		}
+		else if (island->constraintRemoveCount > 0)
+		{
+			// The new islands are added to the head of the awake list.
+			SplitIsland(island);
+			++m_splitCount;
+		}
+
+		island = next;
+	}
+}
+
+// Depth first search over the linked constraints of the island. Every connected
+// component becomes a new island.
+void b2IslandManager::SplitIsland(b2PersistentIsland* island)
+{
+	int32 bodyCount = island->bodyCount;
+	b2Body** bodies = (b2Body**)m_stackAllocator->Allocate(bodyCount * sizeof(b2Body*));
+	b2Body** stack = (b2Body**)m_stackAllocator->Allocate(bodyCount * sizeof(b2Body*));
+
+	int32 index = 0;
+	for (b2Body* b = island->bodyList; b; b = b->m_islandNext)
+	{
+		b->m_flags &= ~b2Body::e_islandFlag;
+		bodies[index++] = b;
+	}
+	b2Assert(index == bodyCount);
+
+	for (b2Contact* c = island->contactList; c; c = c->m_islandNext)
+	{
+		c->m_flags &= ~b2Contact::e_islandFlag;
+	}
+
+	for (b2Joint* j = island->jointList; j; j = j->m_islandNext)
+	{
+		j->m_islandFlag = false;
+	}
+
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		b2Body* seed = bodies[i];
+		if (seed->m_flags & b2Body::e_islandFlag)
+		{
+			continue;
+		}
+
+		b2PersistentIsland* newIsland = CreateIsland(true);
+
+		int32 stackCount = 0;
+		stack[stackCount++] = seed;
+		seed->m_flags |= b2Body::e_islandFlag;
+
+		while (stackCount > 0)
+		{
+			b2Body* b = stack[--stackCount];
+			AddToIsland(newIsland, b);
+
+			for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
+			{
+				b2Contact* contact = ce->contact;
+
+				// Only linked contacts connect bodies.
+				if (contact->m_island == NULL || (contact->m_flags & b2Contact::e_islandFlag))
+				{
+					continue;
+				}
+
+				AddToIsland(newIsland, contact);
+				contact->m_flags |= b2Contact::e_islandFlag;
+
+				// Static bodies don't propagate islands.
+				b2Body* other = ce->other;
+				if (other->m_island == NULL || (other->m_flags & b2Body::e_islandFlag))
+				{
+					continue;
+				}
+
+				b2Assert(stackCount < bodyCount);
+				stack[stackCount++] = other;
+				other->m_flags |= b2Body::e_islandFlag;
+			}
+
+			for (b2JointEdge* je = b->m_jointList; je; je = je->next)
+			{
+				b2Joint* joint = je->joint;
+				if (joint->m_island == NULL || joint->m_islandFlag)
+				{
+					continue;
+				}
+
+				AddToIsland(newIsland, joint);
+				joint->m_islandFlag = true;
+
+				b2Body* other = je->other;
+				if (other->m_island == NULL || (other->m_flags & b2Body::e_islandFlag))
+				{
+					continue;
+				}
+
+				b2Assert(stackCount < bodyCount);
+				stack[stackCount++] = other;
+				other->m_flags |= b2Body::e_islandFlag;
+			}
+		}
+	}
+
+	m_stackAllocator->Free(stack);
+	m_stackAllocator->Free(bodies);
+
+	// The lists of the old island were taken over by the new islands.
+	DestroyIsland(island);
+}
@@ -0,0 +1,114 @@
+/*
+* Copyright (c) 2013 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_ISLAND_MANAGER_H
+#define B2_ISLAND_MANAGER_H
+
+#include <Box2D/Common/b2Settings.h>
+
+class b2Body;
+class b2Contact;
+class b2Joint;
+class b2BlockAllocator;
+class b2StackAllocator;
+
+/// A connected group of bodies that is kept between time steps. Static bodies
+/// never belong to an island. Contacts and joints to a static body belong to
+/// the island of the other body.
+struct b2PersistentIsland
+{
+	// Awake or sleeping list of the island manager.
+	b2PersistentIsland* prev;
+	b2PersistentIsland* next;
+
+	// Pending union, this island is merged into the parent before the next solve.
+	b2PersistentIsland* parent;
+
+	b2Body* bodyList;
+	b2Contact* contactList;
+	b2Joint* jointList;
+	int32 bodyCount;
+	int32 contactCount;
+	int32 jointCount;
+
+	// Constraints removed since the island was built. The island may have come
+	// apart and is split before it is solved again.
+	int32 constraintRemoveCount;
+
+	bool awake;
+};
+
+// Delegate of b2World. Islands are joined with union-find when a contact begins
+// touching or a joint is created, and only an island that lost a constraint is
+// rebuilt. Sleeping islands are not visited.
+class b2IslandManager
+{
+public:
+	b2IslandManager();
+
+	// Create the island of an active dynamic or kinematic body and link its
+	// constraints.
+	void AddBody(b2Body* body);
+
+	// Unlink the constraints of a body and remove it from its island.
+	void RemoveBody(b2Body* body);
+
+	// Link or unlink a contact after its touching state was updated.
+	void UpdateContact(b2Contact* contact);
+	void UnlinkContact(b2Contact* contact);
+
+	void LinkJoint(b2Joint* joint);
+	void UnlinkJoint(b2Joint* joint);
+
+	// Move an island to the awake list. This does not wake the bodies.
+	void WakeIsland(b2PersistentIsland* island);
+	void SleepIsland(b2PersistentIsland* island);
+
+	// Apply the pending unions.
+	void MergeIslands();
+
+	// Split the awake islands that lost a constraint. Islands without an awake
+	// body are moved to the sleeping list instead.
+	void SplitIslands();
+
+	b2PersistentIsland* m_awakeList;
+	b2PersistentIsland* m_sleepingList;
+	int32 m_islandCount;
+
+	// The number of islands split by the last call to SplitIslands.
+	int32 m_splitCount;
+
+	b2BlockAllocator* m_allocator;
+	b2StackAllocator* m_stackAllocator;
+
+private:
+
+	b2PersistentIsland* CreateIsland(bool awake);
+	void DestroyIsland(b2PersistentIsland* island);
+
+	void LinkContact(b2Contact* contact);
+	void LinkIslands(b2PersistentIsland* islandA, b2PersistentIsland* islandB);
+	void MergeIsland(b2PersistentIsland* island, b2PersistentIsland* root);
+	void SplitIsland(b2PersistentIsland* island);
+
+	void AddToIsland(b2PersistentIsland* island, b2Body* body);
+	void AddToIsland(b2PersistentIsland* island, b2Contact* contact);
+	void AddToIsland(b2PersistentIsland* island, b2Joint* joint);
+};
+
+#endif
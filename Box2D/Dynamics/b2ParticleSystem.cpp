@@ -0,0 +1,648 @@
+/*
+* Copyright (c) 2013 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/b2ParticleSystem.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Dynamics/b2World.h>
+#include <Box2D/Common/b2Draw.h>
+#include <Box2D/Common/b2Simd.h>
+#include <Box2D/Common/b2ThreadPool.h>
+#include <string.h>
+
+// The weight of a pair of particles is 1 - distance / diameter and the density
+// of a particle is the sum of the weights of its neighbors. Particles are pushed
+// apart while their density is above the rest density, so neighbors settle a
+// little closer than a diameter.
+#define b2_particleRestDensity	0.25f
+
+static inline uint32 b2HashCell(int32 x, int32 y)
+{
+	return (uint32(x) * 73856093u) ^ (uint32(y) * 19349663u);
+}
+
+// Each work item is one chunk of particles.
+struct b2ParticleTask : public b2ParallelTask
+{
+	void Execute(int32 index, int32 threadIndex)
+	{
+		B2_NOT_USED(threadIndex);
+
+		int32 first = index * b2_particleChunkSize;
+		int32 last = b2Min(first + b2_particleChunkSize, system->m_count);
+
+		switch (pass)
+		{
+		case b2ParticleSystem::e_integratePass:
+			system->Integrate(first, last, *step);
+			break;
+
+		case b2ParticleSystem::e_densityPass:
+			system->ComputePressures(first, last);
+			break;
+
+		case b2ParticleSystem::e_relaxPass:
+			system->Relax(first, last, *step);
+			break;
+
+		case b2ParticleSystem::e_collidePass:
+			system->Collide(first, last, *step);
+			break;
+		}
+	}
+
+	b2ParticleSystem* system;
+	b2ParticleSystem::b2ParticlePass pass;
+	const b2TimeStep* step;
+};
+
+// Collects the fixtures under up to b2_simdWidth particles.
+struct b2ParticleQueryWrapper
+{
+	bool QueryCallback(int32 index, int32 proxyId)
+	{
+		const b2FixtureProxy* proxy = (const b2FixtureProxy*)broadPhase->GetUserData(proxyId);
+		const b2Fixture* fixture = proxy->fixture;
+		if (fixture->IsSensor() || (fixture->GetFilterData().categoryBits & maskBits) == 0)
+		{
+			return true;
+		}
+
+		if (counts[index] < b2_maxParticleFixtures)
+		{
+			proxies[index][counts[index]++] = proxy;
+		}
+		return true;
+	}
+
+	const b2BroadPhase* broadPhase;
+	uint16 maskBits;
+	const b2FixtureProxy* proxies[b2_simdWidth][b2_maxParticleFixtures];
+	int32 counts[b2_simdWidth];
+};
+
+b2ParticleSystem::b2ParticleSystem(const b2ParticleSystemDef* def, b2World* world)
+{
+	b2Assert(def->radius > 0.0f);
+	b2Assert(def->maxCount >= 0);
+
+	m_def = *def;
+	m_world = world;
+	m_prev = NULL;
+	m_next = NULL;
+
+	m_count = 0;
+	m_capacity = 0;
+
+	m_positions = NULL;
+	m_velocities = NULL;
+	m_deltas = NULL;
+	m_pressures = NULL;
+	m_ages = NULL;
+
+	m_cellX = NULL;
+	m_cellY = NULL;
+	m_bucketParticles = NULL;
+	m_bucketStarts = NULL;
+	m_bucketCount = 0;
+}
+
+b2ParticleSystem::~b2ParticleSystem()
+{
+	b2Free(m_positions);
+	b2Free(m_velocities);
+	b2Free(m_deltas);
+	b2Free(m_pressures);
+	b2Free(m_ages);
+	b2Free(m_cellX);
+	b2Free(m_cellY);
+	b2Free(m_bucketParticles);
+	b2Free(m_bucketStarts);
+}
+
+void b2ParticleSystem::Grow()
+{
+	int32 capacity = b2Max(2 * m_capacity, 256);
+	b2GrowArray(&m_positions, m_count, capacity);
+	b2GrowArray(&m_velocities, m_count, capacity);
+	b2GrowArray(&m_deltas, 0, capacity);
+	b2GrowArray(&m_pressures, 0, capacity);
+	b2GrowArray(&m_ages, m_count, capacity);
+	b2GrowArray(&m_cellX, 0, capacity);
+	b2GrowArray(&m_cellY, 0, capacity);
+	b2GrowArray(&m_bucketParticles, 0, capacity);
+	m_capacity = capacity;
+
+	// The capacity is a power of two, so the hash table stays at most half full.
+	m_bucketCount = 2 * capacity;
+	b2GrowArray(&m_bucketStarts, 0, m_bucketCount + 1);
+}
+
+int32 b2ParticleSystem::CreateParticle(const b2ParticleDef& def)
+{
+	b2Assert(m_world->IsLocked() == false);
+	if (m_world->IsLocked())
+	{
+		return -1;
+	}
+
+	if (m_def.maxCount > 0 && m_count >= m_def.maxCount)
+	{
+		return -1;
+	}
+
+	if (m_count == m_capacity)
+	{
+		Grow();
+	}
+
+	int32 index = m_count++;
+	m_positions[index] = def.position;
+	m_velocities[index] = def.velocity;
+	m_ages[index] = 0.0f;
+	return index;
+}
+
+void b2ParticleSystem::DestroyParticle(int32 index)
+{
+	b2Assert(m_world->IsLocked() == false);
+	b2Assert(0 <= index && index < m_count);
+	if (m_world->IsLocked())
+	{
+		return;
+	}
+
+	int32 last = --m_count;
+	m_positions[index] = m_positions[last];
+	m_velocities[index] = m_velocities[last];
+	m_ages[index] = m_ages[last];
+}
+
+void b2ParticleSystem::DestroyParticles()
+{
+	b2Assert(m_world->IsLocked() == false);
+	if (m_world->IsLocked())
+	{
+		return;
+	}
+
+	m_count = 0;
+}
+
+void b2ParticleSystem::BuildHash()
+{
+	float32 inv_diameter = 0.5f / m_def.radius;
+	uint32 mask = uint32(m_bucketCount - 1);
+
+	memset(m_bucketStarts, 0, (m_bucketCount + 1) * sizeof(int32));
+
+	// Count the particles of each bucket one slot ahead.
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		int32 x = int32(floorf(m_positions[i].x * inv_diameter));
+		int32 y = int32(floorf(m_positions[i].y * inv_diameter));
+		m_cellX[i] = x;
+		m_cellY[i] = y;
+		++m_bucketStarts[(b2HashCell(x, y) & mask) + 1];
+	}
+
+	for (int32 b = 0; b < m_bucketCount; ++b)
+	{
+		m_bucketStarts[b + 1] += m_bucketStarts[b];
+	}
+
+	// Filling a bucket moves its start to the start of the next bucket, so
+	// shift the starts back afterwards.
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		uint32 b = b2HashCell(m_cellX[i], m_cellY[i]) & mask;
+		m_bucketParticles[m_bucketStarts[b]++] = i;
+	}
+
+	memmove(m_bucketStarts + 1, m_bucketStarts, m_bucketCount * sizeof(int32));
+	m_bucketStarts[0] = 0;
+}
+
+// Call callback->Visit(j, d, distance) for every particle j within a diameter
+// of particle i, where d = p_j - p_i. Particles are checked against their cell,
+// so cells that share a bucket are not visited twice.
+template <typename T>
+static inline void b2VisitNeighbors(int32 i, const b2Vec2* positions, const int32* cellX, const int32* cellY,
+									const int32* bucketParticles, const int32* bucketStarts, uint32 mask,
+									float32 diameter, T* callback)
+{
+	b2Vec2 p = positions[i];
+	float32 diameterSquared = diameter * diameter;
+
+	for (int32 y = cellY[i] - 1; y <= cellY[i] + 1; ++y)
+	{
+		for (int32 x = cellX[i] - 1; x <= cellX[i] + 1; ++x)
+		{
+			uint32 b = b2HashCell(x, y) & mask;
+			for (int32 k = bucketStarts[b]; k < bucketStarts[b + 1]; ++k)
+			{
+				int32 j = bucketParticles[k];
+				if (j == i || cellX[j] != x || cellY[j] != y)
+				{
+					continue;
+				}
+
+				b2Vec2 d = positions[j] - p;
+				float32 distanceSquared = b2Dot(d, d);
+				if (distanceSquared < diameterSquared)
+				{
+					callback->Visit(j, d, b2Sqrt(distanceSquared));
+				}
+			}
+		}
+	}
+}
+
+void b2ParticleSystem::Integrate(int32 first, int32 last, const b2TimeStep& step)
+{
+	float32 h = step.dt;
+	b2Vec2 gravity = h * m_def.gravityScale * m_world->GetGravity();
+	float32 damping = 1.0f / (1.0f + h * m_def.damping);
+
+	// A particle moves at most a diameter in a step, so it cannot pass its
+	// neighbors.
+	float32 maxSpeed = 2.0f * m_def.radius * step.inv_dt;
+	float32 maxSpeedSquared = maxSpeed * maxSpeed;
+
+	for (int32 i = first; i < last; ++i)
+	{
+		b2Vec2 v = damping * (m_velocities[i] + gravity);
+		float32 speedSquared = b2Dot(v, v);
+		if (speedSquared > maxSpeedSquared)
+		{
+			v *= b2Sqrt(maxSpeedSquared / speedSquared);
+		}
+
+		m_velocities[i] = v;
+		m_positions[i] += h * v;
+	}
+}
+
+// The direction from particle i to particle j. Particles at the same position
+// are split along the x-axis.
+static inline b2Vec2 b2ParticleDirection(int32 i, int32 j, const b2Vec2& d, float32 distance)
+{
+	if (distance > b2_epsilon)
+	{
+		return (1.0f / distance) * d;
+	}
+
+	return b2Vec2(i < j ? 1.0f : -1.0f, 0.0f);
+}
+
+struct b2ParticleDensityCallback
+{
+	void Visit(int32 j, const b2Vec2& d, float32 distance)
+	{
+		density += 1.0f - distance * inv_diameter;
+		gradient += b2ParticleDirection(i, j, d, distance);
+		++count;
+	}
+
+	int32 i;
+	float32 inv_diameter;
+	float32 density;
+	b2Vec2 gradient;
+	int32 count;
+};
+
+void b2ParticleSystem::ComputePressures(int32 first, int32 last)
+{
+	float32 diameter = 2.0f * m_def.radius;
+	uint32 mask = uint32(m_bucketCount - 1);
+
+	b2ParticleDensityCallback callback;
+	callback.inv_diameter = 1.0f / diameter;
+
+	// The pressure of a particle is the distance its neighbors move away to
+	// bring its density down to the rest density. Moving a neighbor changes
+	// the density by its distance over the diameter, and moving the particle
+	// itself changes it along the sum of the directions.
+	for (int32 i = first; i < last; ++i)
+	{
+		callback.i = i;
+		callback.density = 0.0f;
+		callback.gradient.SetZero();
+		callback.count = 0;
+		b2VisitNeighbors(i, m_positions, m_cellX, m_cellY, m_bucketParticles, m_bucketStarts, mask, diameter, &callback);
+
+		float32 error = callback.density - b2_particleRestDensity;
+		if (error > 0.0f)
+		{
+			float32 k = float32(callback.count) + b2Dot(callback.gradient, callback.gradient);
+			m_pressures[i] = m_def.pressureStrength * diameter * error / k;
+		}
+		else
+		{
+			m_pressures[i] = 0.0f;
+		}
+	}
+}
+
+struct b2ParticleRelaxCallback
+{
+	void Visit(int32 j, const b2Vec2& d, float32 distance)
+	{
+		b2Vec2 n = b2ParticleDirection(i, j, d, distance);
+
+		// Push apart along the line between the particles.
+		if (pressure > 0.0f)
+		{
+			push -= pressure * n;
+			++pushCount;
+		}
+
+		if (pressures[j] > 0.0f)
+		{
+			push -= pressures[j] * n;
+			++pushCount;
+		}
+
+		// Stop the particles that run into each other.
+		b2Vec2 dv = velocities[j] - velocity;
+		float32 vn = b2Dot(dv, n);
+		if (vn < 0.0f)
+		{
+			impact += vn * n;
+			++impactCount;
+		}
+
+		// Pull toward the velocity of the neighbor.
+		float32 w = 1.0f - distance * inv_diameter;
+		viscous += w * dv;
+		weight += w;
+	}
+
+	int32 i;
+	const float32* pressures;
+	const b2Vec2* velocities;
+	float32 inv_diameter;
+
+	float32 pressure;
+	b2Vec2 velocity;
+
+	b2Vec2 push;
+	int32 pushCount;
+	b2Vec2 impact;
+	int32 impactCount;
+	b2Vec2 viscous;
+	float32 weight;
+};
+
+void b2ParticleSystem::Relax(int32 first, int32 last, const b2TimeStep& step)
+{
+	float32 h = step.dt;
+	float32 diameter = 2.0f * m_def.radius;
+	uint32 mask = uint32(m_bucketCount - 1);
+
+	b2ParticleRelaxCallback callback;
+	callback.pressures = m_pressures;
+	callback.velocities = m_velocities;
+	callback.inv_diameter = 1.0f / diameter;
+
+	for (int32 i = first; i < last; ++i)
+	{
+		callback.i = i;
+		callback.pressure = m_pressures[i];
+		callback.velocity = m_velocities[i];
+		callback.push.SetZero();
+		callback.pushCount = 0;
+		callback.impact.SetZero();
+		callback.impactCount = 0;
+		callback.viscous.SetZero();
+		callback.weight = 0.0f;
+		b2VisitNeighbors(i, m_positions, m_cellX, m_cellY, m_bucketParticles, m_bucketStarts, mask, diameter, &callback);
+
+		// Each particle takes the mean of the corrections of its neighbors, so
+		// crowded particles do not overshoot. A particle takes half of each
+		// impact and its neighbor the other half.
+		b2Vec2 delta = (1.0f / b2Max(callback.pushCount, 1)) * callback.push;
+		delta += (0.5f * h / b2Max(callback.impactCount, 1)) * callback.impact;
+		delta += (h * m_def.viscousStrength / b2Max(callback.weight, 1.0f)) * callback.viscous;
+		m_deltas[i] = delta;
+	}
+}
+
+void b2ParticleSystem::Collide(int32 first, int32 last, const b2TimeStep& step)
+{
+	float32 h = step.dt;
+	float32 inv_h = step.inv_dt;
+	float32 radius = m_def.radius;
+	float32 friction = m_def.friction;
+	float32 restitution = m_def.restitution;
+	bool interacting = m_def.pressureStrength > 0.0f || m_def.viscousStrength > 0.0f;
+
+	b2ParticleQueryWrapper wrapper;
+	wrapper.broadPhase = &m_world->m_contactManager.m_broadPhase;
+	wrapper.maskBits = m_def.maskBits;
+
+	// The particles of a group share one walk of the broad-phase trees.
+	for (int32 group = first; group < last; group += b2_simdWidth)
+	{
+		int32 count = b2Min(last - group, int32(b2_simdWidth));
+
+		// The particles move from p1 to p2 in this step.
+		b2Vec2 p1s[b2_simdWidth];
+		b2Vec2 p2s[b2_simdWidth];
+		b2AABB aabbs[b2_simdWidth];
+		for (int32 k = 0; k < count; ++k)
+		{
+			int32 i = group + k;
+			b2Vec2 p1 = m_positions[i] - h * m_velocities[i];
+			b2Vec2 p2 = m_positions[i];
+			if (interacting)
+			{
+				p2 += m_deltas[i];
+			}
+
+			p1s[k] = p1;
+			p2s[k] = p2;
+
+			b2Vec2 r(radius, radius);
+			aabbs[k].lowerBound = b2Min(p1, p2) - r;
+			aabbs[k].upperBound = b2Max(p1, p2) + r;
+			wrapper.counts[k] = 0;
+		}
+
+		wrapper.broadPhase->QueryBatch(&wrapper, aabbs, count);
+
+		for (int32 k = 0; k < count; ++k)
+		{
+			int32 i = group + k;
+			b2Vec2 p1 = p1s[k];
+			b2Vec2 p2 = p2s[k];
+			b2Vec2 v = inv_h * (p2 - p1);
+			int32 fixtureCount = wrapper.counts[k];
+			const b2FixtureProxy* const* proxies = wrapper.proxies[k];
+
+			// Stop at the first surface on the way, so fast particles do not
+			// pass through thin shapes.
+			b2RayCastInput input;
+			input.p1 = p1;
+			input.p2 = p2;
+			input.maxFraction = 1.0f;
+			bool hit = false;
+			b2Vec2 normal;
+			for (int32 j = 0; j < fixtureCount; ++j)
+			{
+				b2RayCastOutput output;
+				if (proxies[j]->fixture->RayCast(&output, input, proxies[j]->childIndex))
+				{
+					input.maxFraction = output.fraction;
+					normal = output.normal;
+					hit = true;
+				}
+			}
+
+			if (hit)
+			{
+				p2 = p1 + input.maxFraction * (p2 - p1) + b2_linearSlop * normal;
+			}
+
+			// Push the particle out of the fixtures and remove the velocity into
+			// them, relative to the moving bodies. Static fixtures go last, so a
+			// particle squeezed by a moving body is not pushed through the ground.
+			for (int32 n = 0; n < 2 * fixtureCount; ++n)
+			{
+				const b2Fixture* fixture = proxies[n % fixtureCount]->fixture;
+				const b2Body* body = fixture->GetBody();
+				if ((body->GetType() == b2_staticBody) != (n >= fixtureCount))
+				{
+					continue;
+				}
+
+				const b2Shape* shape = fixture->GetShape();
+				float32 distance;
+				shape->ComputeDistance(body->GetTransform(), p2, &distance, &normal, proxies[n % fixtureCount]->childIndex);
+
+				// Edges have two sides. Keep the particle on the side it started
+				// the step on, even if another fixture pushed it across.
+				b2Shape::Type type = shape->GetType();
+				if ((type == b2Shape::e_edge || type == b2Shape::e_chain) && b2Dot(p1 - p2, normal) < -distance)
+				{
+					distance = -distance;
+					normal = -normal;
+				}
+
+				if (distance >= radius)
+				{
+					continue;
+				}
+
+				p2 += (radius - distance) * normal;
+
+				b2Vec2 vr = v - body->GetLinearVelocityFromWorldPoint(p2);
+				float32 vn = b2Dot(vr, normal);
+				if (vn < 0.0f)
+				{
+					b2Vec2 vt = vr - vn * normal;
+					float32 vtLength = vt.Length();
+					v -= (1.0f + restitution) * vn * normal;
+					if (vtLength > b2_epsilon)
+					{
+						float32 drop = b2Min(vtLength, -friction * vn);
+						v -= (drop / vtLength) * vt;
+					}
+				}
+			}
+
+			m_positions[i] = p2;
+			m_velocities[i] = v;
+		}
+	}
+}
+
+void b2ParticleSystem::RunPass(b2ParticlePass pass, const b2TimeStep& step)
+{
+	b2ParticleTask task;
+	task.system = this;
+	task.pass = pass;
+	task.step = &step;
+
+	int32 chunkCount = (m_count + b2_particleChunkSize - 1) / b2_particleChunkSize;
+	b2ThreadPool* threadPool = m_world->GetThreadPool();
+	if (threadPool != NULL && threadPool->GetThreadCount() > 1 && chunkCount > 1)
+	{
+		threadPool->Run(&task, chunkCount);
+		return;
+	}
+
+	for (int32 i = 0; i < chunkCount; ++i)
+	{
+		task.Execute(i, 0);
+	}
+}
+
+void b2ParticleSystem::Solve(const b2TimeStep& step)
+{
+	if (m_def.lifetime > 0.0f)
+	{
+		for (int32 i = m_count - 1; i >= 0; --i)
+		{
+			m_ages[i] += step.dt;
+			if (m_ages[i] > m_def.lifetime)
+			{
+				int32 last = --m_count;
+				m_positions[i] = m_positions[last];
+				m_velocities[i] = m_velocities[last];
+				m_ages[i] = m_ages[last];
+			}
+		}
+	}
+
+	if (m_count == 0)
+	{
+		return;
+	}
+
+	// Move the particles ahead, relax the predicted positions against each
+	// other and then collide the result with the fixtures. The velocities
+	// follow the positions, so the relaxation is stable at any pressure.
+	RunPass(e_integratePass, step);
+
+	if (m_def.pressureStrength > 0.0f || m_def.viscousStrength > 0.0f)
+	{
+		BuildHash();
+		RunPass(e_densityPass, step);
+		RunPass(e_relaxPass, step);
+	}
+
+	RunPass(e_collidePass, step);
+}
+
+void b2ParticleSystem::ShiftOrigin(const b2Vec2& newOrigin)
+{
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		m_positions[i] -= newOrigin;
+	}
+}
+
+void b2ParticleSystem::Draw(b2Draw* draw) const
+{
+	b2Color color(0.4f, 0.6f, 0.9f);
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		draw->DrawCircle(m_positions[i], m_def.radius, color);
+	}
+}
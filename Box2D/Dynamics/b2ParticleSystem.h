@@ -0,0 +1,213 @@
+/*
+* Copyright (c) 2013 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_PARTICLE_SYSTEM_H
+#define B2_PARTICLE_SYSTEM_H
+
+#include <Box2D/Common/b2Math.h>
+
+class b2Draw;
+class b2World;
+struct b2TimeStep;
+
+/// The particles of a system solved in one work item of the thread pool.
+#define b2_particleChunkSize		256
+
+/// The number of fixtures a particle collides with in one step. Further
+/// fixtures under the particle are ignored.
+#define b2_maxParticleFixtures		8
+
+/// A particle system definition holds the settings shared by all particles of
+/// a system.
+struct b2ParticleSystemDef
+{
+	/// The constructor sets the default values.
+	b2ParticleSystemDef()
+	{
+		radius = 0.1f;
+		gravityScale = 1.0f;
+		damping = 0.0f;
+		pressureStrength = 1.0f;
+		viscousStrength = 0.0f;
+		friction = 0.2f;
+		restitution = 0.0f;
+		maskBits = 0xFFFF;
+		lifetime = 0.0f;
+		maxCount = 0;
+	}
+
+	/// The particle radius. Particles closer than a diameter interact.
+	float32 radius;
+
+	/// Scale the world gravity applied to the particles.
+	float32 gravityScale;
+
+	/// Linear damping of the particle velocities.
+	float32 damping;
+
+	/// Push crowded particles apart, usually in [0,1]. Particles that push
+	/// behave like a fluid or a pile of sand. Zero leaves the particles
+	/// independent of each other, which is cheapest and suits sparks.
+	float32 pressureStrength;
+
+	/// Even out the velocities of neighboring particles, usually in [0,1].
+	/// Higher values make a thicker fluid.
+	float32 viscousStrength;
+
+	/// The friction against fixtures, usually in [0,1].
+	float32 friction;
+
+	/// The restitution against fixtures, usually in [0,1].
+	float32 restitution;
+
+	/// The fixtures collide with the particles if their category bits overlap
+	/// these. Sensors never collide with particles.
+	uint16 maskBits;
+
+	/// The lifetime of a particle in seconds, zero for particles that live
+	/// until they are destroyed.
+	float32 lifetime;
+
+	/// The maximum number of particles, zero for no limit.
+	int32 maxCount;
+};
+
+/// A particle definition.
+struct b2ParticleDef
+{
+	b2ParticleDef()
+	{
+		position.SetZero();
+		velocity.SetZero();
+	}
+
+	/// The world position of the particle.
+	b2Vec2 position;
+
+	/// The linear velocity of the particle in world co-ordinates.
+	b2Vec2 velocity;
+};
+
+/// A system of many small round particles for effects such as sand, debris
+/// and liquid. Particles cost much less than bodies: they have no fixtures,
+/// broad-phase proxies or contacts. The particles are kept in arrays, one per
+/// field, and the neighbors of a particle are found with a spatial hash that
+/// is rebuilt every step. Crowded particles are moved apart and their
+/// velocities follow the moves, which stays stable without small time steps.
+/// Particles collide with the fixtures of the world through the broad-phase,
+/// but they do not push bodies. The system is solved
+/// after the bodies in b2World::Step, in chunks of particles that run on the
+/// thread pool of the world.
+/// Particle systems are created and destroyed with b2World.
+class b2ParticleSystem
+{
+public:
+
+	/// Create a particle.
+	/// @return the index of the particle or -1 if the system is full.
+	/// @warning This function is locked during callbacks.
+	int32 CreateParticle(const b2ParticleDef& def);
+
+	/// Destroy a particle. The last particle is moved to its index.
+	/// @warning This function is locked during callbacks.
+	void DestroyParticle(int32 index);
+
+	/// Destroy all particles.
+	void DestroyParticles();
+
+	/// Get the number of particles.
+	int32 GetParticleCount() const { return m_count; }
+
+	/// Get the particle positions. The buffer holds GetParticleCount() entries
+	/// and moves when particles are created.
+	b2Vec2* GetPositionBuffer() { return m_positions; }
+	const b2Vec2* GetPositionBuffer() const { return m_positions; }
+
+	/// Get the particle velocities, see GetPositionBuffer.
+	b2Vec2* GetVelocityBuffer() { return m_velocities; }
+	const b2Vec2* GetVelocityBuffer() const { return m_velocities; }
+
+	/// Get the particle radius.
+	float32 GetRadius() const { return m_def.radius; }
+
+	/// Get the next particle system in the world's particle system list.
+	b2ParticleSystem* GetNext() { return m_next; }
+	const b2ParticleSystem* GetNext() const { return m_next; }
+
+	/// Get the parent world of this particle system.
+	b2World* GetWorld() { return m_world; }
+	const b2World* GetWorld() const { return m_world; }
+
+private:
+
+	friend class b2World;
+	friend struct b2ParticleTask;
+
+	enum b2ParticlePass
+	{
+		e_integratePass,
+		e_densityPass,
+		e_relaxPass,
+		e_collidePass
+	};
+
+	b2ParticleSystem(const b2ParticleSystemDef* def, b2World* world);
+	~b2ParticleSystem();
+
+	void Grow();
+
+	// Sort the particles into the buckets of the spatial hash.
+	void BuildHash();
+
+	// Run a pass over all particles, on the thread pool if there is one.
+	void RunPass(b2ParticlePass pass, const b2TimeStep& step);
+
+	void Integrate(int32 first, int32 last, const b2TimeStep& step);
+	void ComputePressures(int32 first, int32 last);
+	void Relax(int32 first, int32 last, const b2TimeStep& step);
+	void Collide(int32 first, int32 last, const b2TimeStep& step);
+
+	void Solve(const b2TimeStep& step);
+	void ShiftOrigin(const b2Vec2& newOrigin);
+	void Draw(b2Draw* draw) const;
+
+	b2ParticleSystemDef m_def;
+	b2World* m_world;
+	b2ParticleSystem* m_prev;
+	b2ParticleSystem* m_next;
+
+	int32 m_count;
+	int32 m_capacity;
+
+	b2Vec2* m_positions;
+	b2Vec2* m_velocities;
+	b2Vec2* m_deltas;			// displacements from the neighbors
+	float32* m_pressures;		// how far each particle pushes its neighbors
+	float32* m_ages;
+
+	// The spatial hash. The cell of a particle is its position divided by the
+	// diameter, and the particles of bucket b are m_bucketParticles[k] for k in
+	// [m_bucketStarts[b], m_bucketStarts[b + 1]).
+	int32* m_cellX;
+	int32* m_cellY;
+	int32* m_bucketParticles;
+	int32* m_bucketStarts;
+	int32 m_bucketCount;
+};
+
+#endif
@@ -0,0 +1,237 @@
+/*
+* Copyright (c) 2013 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/b2Sectors.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <string.h>
+
+static inline uint32 b2HashSector(int32 x, int32 y)
+{
+	return (uint32(x) * 73856093u) ^ (uint32(y) * 19349663u);
+}
+
+b2Sectors::b2Sectors()
+{
+	m_sectors = NULL;
+	m_sectorCount = 0;
+	m_sectorCapacity = 0;
+
+	m_activeSectors = NULL;
+	m_activeCount = 0;
+
+	m_table = NULL;
+	m_tableCapacity = 0;
+
+	m_sectorSize = 0.0f;
+	m_origin.SetZero();
+}
+
+b2Sectors::~b2Sectors()
+{
+	b2Free(m_sectors);
+	b2Free(m_activeSectors);
+	b2Free(m_table);
+}
+
+void b2Sectors::Reset(float32 sectorSize)
+{
+	m_sectorCount = 0;
+	m_activeCount = 0;
+	for (int32 i = 0; i < m_tableCapacity; ++i)
+	{
+		m_table[i] = b2_nullSector;
+	}
+
+	m_sectorSize = sectorSize;
+}
+
+void b2Sectors::GetKey(const b2Vec2& point, int32* x, int32* y) const
+{
+	b2Assert(m_sectorSize > 0.0f);
+	float32 inv_size = 1.0f / m_sectorSize;
+	*x = int32(floorf((point.x + m_origin.x) * inv_size));
+	*y = int32(floorf((point.y + m_origin.y) * inv_size));
+}
+
+float32 b2Sectors::GetDistanceSquared(int32 index, const b2Vec2& point) const
+{
+	b2Assert(0 <= index && index < m_sectorCount);
+	const b2Sector* sector = m_sectors + index;
+
+	b2Vec2 lower(sector->x * m_sectorSize - m_origin.x, sector->y * m_sectorSize - m_origin.y);
+	b2Vec2 upper(lower.x + m_sectorSize, lower.y + m_sectorSize);
+	b2Vec2 d = b2Max(lower - point, point - upper);
+	d = b2Max(d, b2Vec2_zero);
+	return b2Dot(d, d);
+}
+
+int32 b2Sectors::Find(int32 x, int32 y) const
+{
+	if (m_tableCapacity == 0)
+	{
+		return b2_nullSector;
+	}
+
+	uint32 mask = uint32(m_tableCapacity - 1);
+	uint32 slot = b2HashSector(x, y) & mask;
+	while (m_table[slot] != b2_nullSector)
+	{
+		const b2Sector* sector = m_sectors + m_table[slot];
+		if (sector->x == x && sector->y == y)
+		{
+			return m_table[slot];
+		}
+
+		slot = (slot + 1) & mask;
+	}
+
+	return b2_nullSector;
+}
+
+void b2Sectors::Grow()
+{
+	int32 capacity = b2Max(2 * m_sectorCapacity, 64);
+
+	b2Sector* oldSectors = m_sectors;
+	m_sectors = (b2Sector*)b2Alloc(capacity * sizeof(b2Sector));
+	int32* oldActive = m_activeSectors;
+	m_activeSectors = (int32*)b2Alloc(capacity * sizeof(int32));
+	if (oldSectors)
+	{
+		memcpy(m_sectors, oldSectors, m_sectorCount * sizeof(b2Sector));
+		memcpy(m_activeSectors, oldActive, m_activeCount * sizeof(int32));
+		b2Free(oldSectors);
+		b2Free(oldActive);
+	}
+	m_sectorCapacity = capacity;
+
+	// Keep the table at most half full.
+	b2Free(m_table);
+	m_tableCapacity = 2 * capacity;
+	m_table = (int32*)b2Alloc(m_tableCapacity * sizeof(int32));
+	for (int32 i = 0; i < m_tableCapacity; ++i)
+	{
+		m_table[i] = b2_nullSector;
+	}
+
+	uint32 mask = uint32(m_tableCapacity - 1);
+	for (int32 i = 0; i < m_sectorCount; ++i)
+	{
+		uint32 slot = b2HashSector(m_sectors[i].x, m_sectors[i].y) & mask;
+		while (m_table[slot] != b2_nullSector)
+		{
+			slot = (slot + 1) & mask;
+		}
+		m_table[slot] = i;
+	}
+}
+
+int32 b2Sectors::Create(int32 x, int32 y)
+{
+	b2Assert(Find(x, y) == b2_nullSector);
+
+	if (m_sectorCount == m_sectorCapacity)
+	{
+		Grow();
+	}
+
+	int32 index = m_sectorCount++;
+	b2Sector* sector = m_sectors + index;
+	sector->x = x;
+	sector->y = y;
+	sector->bodyList = NULL;
+	sector->bodyCount = 0;
+	sector->activeIndex = -1;
+
+	uint32 mask = uint32(m_tableCapacity - 1);
+	uint32 slot = b2HashSector(x, y) & mask;
+	while (m_table[slot] != b2_nullSector)
+	{
+		slot = (slot + 1) & mask;
+	}
+	m_table[slot] = index;
+
+	return index;
+}
+
+void b2Sectors::SetActive(int32 index, bool flag)
+{
+	b2Assert(0 <= index && index < m_sectorCount);
+	b2Sector* sector = m_sectors + index;
+
+	if (flag)
+	{
+		b2Assert(sector->activeIndex == -1);
+		sector->activeIndex = m_activeCount;
+		m_activeSectors[m_activeCount++] = index;
+	}
+	else
+	{
+		b2Assert(sector->activeIndex != -1);
+
+		// Swap the last active sector into the hole.
+		int32 last = m_activeSectors[--m_activeCount];
+		m_activeSectors[sector->activeIndex] = last;
+		m_sectors[last].activeIndex = sector->activeIndex;
+		sector->activeIndex = -1;
+	}
+}
+
+void b2Sectors::AddBody(int32 index, b2Body* body)
+{
+	b2Assert(0 <= index && index < m_sectorCount);
+	b2Assert(body->m_sector == b2_nullSector);
+	b2Sector* sector = m_sectors + index;
+
+	body->m_sector = index;
+	body->m_sectorPrev = NULL;
+	body->m_sectorNext = sector->bodyList;
+	if (sector->bodyList)
+	{
+		sector->bodyList->m_sectorPrev = body;
+	}
+	sector->bodyList = body;
+	++sector->bodyCount;
+}
+
+void b2Sectors::RemoveBody(b2Body* body)
+{
+	if (body->m_sector == b2_nullSector)
+	{
+		return;
+	}
+
+	b2Sector* sector = m_sectors + body->m_sector;
+	if (body->m_sectorPrev)
+	{
+		body->m_sectorPrev->m_sectorNext = body->m_sectorNext;
+	}
+	if (body->m_sectorNext)
+	{
+		body->m_sectorNext->m_sectorPrev = body->m_sectorPrev;
+	}
+	if (body == sector->bodyList)
+	{
+		sector->bodyList = body->m_sectorNext;
+	}
+	--sector->bodyCount;
+
+	body->m_sector = b2_nullSector;
+	body->m_sectorPrev = NULL;
+	body->m_sectorNext = NULL;
+}
@@ -0,0 +1,99 @@
+/*
+* Copyright (c) 2013 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_SECTORS_H
+#define B2_SECTORS_H
+
+#include <Box2D/Common/b2Math.h>
+
+class b2Body;
+
+#define b2_nullSector	(-1)
+
+/// A square cell of the streaming grid and the bodies whose origin lies in it.
+struct b2Sector
+{
+	int32 x, y;
+	b2Body* bodyList;
+	int32 bodyCount;
+
+	// Index in the active sector list, inactive = -1
+	int32 activeIndex;
+};
+
+/// A sparse grid of square sectors used by b2World to stream bodies in and out
+/// of the simulation around a focus point. Sectors are kept in a hash table
+/// keyed by their grid coordinates, so only sectors that hold or held bodies
+/// cost memory. The grid is fixed to the original world origin and follows
+/// b2World::ShiftOrigin.
+/// This is an internal class.
+class b2Sectors
+{
+public:
+	b2Sectors();
+	~b2Sectors();
+
+	/// Drop all sectors and set the sector size. The origin is kept. The bodies
+	/// must be unlinked by the caller.
+	void Reset(float32 sectorSize);
+
+	/// Get the grid coordinates of the sector that contains a point.
+	void GetKey(const b2Vec2& point, int32* x, int32* y) const;
+
+	/// Get the squared distance from a point to the box of a sector.
+	float32 GetDistanceSquared(int32 index, const b2Vec2& point) const;
+
+	/// Find a sector, or b2_nullSector if it does not exist.
+	int32 Find(int32 x, int32 y) const;
+
+	/// Create a sector that does not exist yet. The arrays may move.
+	int32 Create(int32 x, int32 y);
+
+	/// Add/remove a sector to/from the active list.
+	void SetActive(int32 index, bool flag);
+
+	/// Link a body into a sector.
+	void AddBody(int32 index, b2Body* body);
+
+	/// Unlink a body from its sector, if any.
+	void RemoveBody(b2Body* body);
+
+	b2Sector* m_sectors;
+	int32 m_sectorCount;
+
+	int32* m_activeSectors;
+	int32 m_activeCount;
+
+	float32 m_sectorSize;
+
+	// The sum of the origin shifts. World points are moved back by this to
+	// find their sector.
+	b2Vec2 m_origin;
+
+private:
+
+	void Grow();
+
+	int32 m_sectorCapacity;
+
+	// Open addressing table of sector indices, empty = b2_nullSector.
+	int32* m_table;
+	int32 m_tableCapacity;
+};
+
+#endif
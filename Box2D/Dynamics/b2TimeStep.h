@@ -21,6 +21,8 @@
 
 #include <Box2D/Common/b2Math.h>
 
+class b2Body;
+
 /// Profiling data. Times are in milliseconds.
 struct b2Profile
 {
@@ -32,6 +34,21 @@ struct b2Profile
 	float32 solvePosition;
 	float32 broadphase;
 	float32 solveTOI;
+	float32 solveTOISearch;	///< finding the TOI events, part of solveTOI
+	int32 toiCount;			///< the number of TOI events solved
+	int32 polygonCacheHits;	///< polygon contacts that reused their separating edges
+	int32 polygonCacheMisses;	///< polygon contacts that searched for them
+};
+
+/// Allocator statistics, summed over the world allocators and the allocators
+/// of each thread pool thread. Sizes are in bytes.
+struct b2AllocatorStats
+{
+	int32 stackCapacity;
+	int32 stackPeak;
+	int32 stackFallbacks;	///< stack allocations that used b2Alloc
+	int32 blockPeak;
+	int32 blockFallbacks;	///< large block allocations that used b2Alloc
 };
 
 /// This is an internal structure.
@@ -43,6 +60,9 @@ struct b2TimeStep
 	int32 velocityIterations;
 	int32 positionIterations;
 	bool warmStarting;
+	bool simdContactSolver;
+	bool batchedJoints;
+	bool speculativeContacts;
 };
 
 /// This is an internal structure.
@@ -62,9 +82,19 @@ struct b2Velocity
 /// Solver Data
 struct b2SolverData
 {
+	/// The index of a body in positions and velocities.
+	int32 GetIndex(const b2Body* body) const;
+
 	b2TimeStep step;
 	b2Position* positions;
 	b2Velocity* velocities;
+
+	// Static bodies shared with islands that are solved at the same time, sorted
+	// by their island index. They are stored after the bodyCount island bodies.
+	// NULL if the island index of every body is its index in the island.
+	b2Body* const* statics;
+	int32 staticCount;
+	int32 bodyCount;
 };
 
 #endif
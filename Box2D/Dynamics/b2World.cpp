@@ -18,8 +18,10 @@
 
 #include <Box2D/Dynamics/b2World.h>
 #include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2ContactEvents.h>
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2Island.h>
+#include <Box2D/Dynamics/b2ParticleSystem.h>
 #include <Box2D/Dynamics/Joints/b2PulleyJoint.h>
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
 #include <Box2D/Dynamics/Contacts/b2ContactSolver.h>
@@ -32,15 +34,75 @@
 #include <Box2D/Collision/b2TimeOfImpact.h>
 #include <Box2D/Common/b2Draw.h>
 #include <Box2D/Common/b2Timer.h>
+#include <Box2D/Common/b2Profiler.h>
+#include <Box2D/Common/b2ThreadPool.h>
+#include <Box2D/Common/b2Snapshot.h>
 #include <new>
+#include <algorithm>
 
-b2World::b2World(const b2Vec2& gravity)
+// A queued TOI event. An event goes stale when the TOI of its contact is
+// invalidated and is dropped when it comes up.
+struct b2TOIEvent
+{
+	float32 alpha;
+	int32 order;
+	b2Contact* contact;
+};
+
+// Heap order: the earliest TOI first, ties go to the event queued first.
+inline bool b2TOIEventLater(const b2TOIEvent& a, const b2TOIEvent& b)
+{
+	if (a.alpha != b.alpha)
+	{
+		return a.alpha > b.alpha;
+	}
+
+	return a.order > b.order;
+}
+
+// A contact visited by the first TOI search of a step.
+struct b2TOICandidate
+{
+	b2Contact* contact;
+	b2TOIInput input;
+	float32 alpha0;
+	float32 alpha;
+	bool compute;
+};
+
+struct b2TOIScheduler
+{
+	// Min-heap of the events.
+	b2TOIEvent* events;
+	int32 eventCount;
+	int32 eventCapacity;
+	int32 order;
+
+	b2TOICandidate* candidates;
+	int32 candidateCapacity;
+
+	// Contacts whose TOI was invalidated by the last event.
+	b2Contact** dirty;
+	int32 dirtyCount;
+	int32 dirtyCapacity;
+};
+
+b2World::b2World(const b2Vec2& gravity, b2BroadPhaseTree treeType)
+	: m_contactManager(treeType)
 {
 	m_destructionListener = NULL;
 	m_debugDraw = NULL;
 
+	m_threadPool = NULL;
+	m_profiler = NULL;
+	m_checksumListener = NULL;
+	m_contactEvents = NULL;
+	m_threadAllocators = NULL;
+	m_threadAllocatorCount = 0;
+
 	m_bodyList = NULL;
 	m_jointList = NULL;
+	m_particleSystemList = NULL;
 
 	m_bodyCount = 0;
 	m_jointCount = 0;
@@ -48,8 +110,15 @@ b2World::b2World(const b2Vec2& gravity)
 	m_warmStarting = true;
 	m_continuousPhysics = true;
 	m_subStepping = false;
+	m_simdContactSolver = false;
+	m_batchedJoints = false;
+	m_speculativeContacts = false;
+
+	m_streamingFocus.SetZero();
+	m_streamingRadius = 0.0f;
 
 	m_stepComplete = true;
+	m_toiScheduler = NULL;
 
 	m_allowSleep = true;
 	m_gravity = gravity;
@@ -59,6 +128,10 @@ b2World::b2World(const b2Vec2& gravity)
 	m_inv_dt0 = 0.0f;
 
 	m_contactManager.m_allocator = &m_blockAllocator;
+	m_contactManager.m_islandManager = &m_islandManager;
+
+	m_islandManager.m_allocator = &m_blockAllocator;
+	m_islandManager.m_stackAllocator = &m_stackAllocator;
 
 	memset(&m_profile, 0, sizeof(b2Profile));
 }
@@ -82,6 +155,25 @@ b2World::~b2World()
 
 		b = bNext;
 	}
+
+	// Particle systems allocate using b2Alloc.
+	b2ParticleSystem* ps = m_particleSystemList;
+	while (ps)
+	{
+		b2ParticleSystem* psNext = ps->m_next;
+		ps->~b2ParticleSystem();
+		ps = psNext;
+	}
+
+	SetThreadPool(NULL);
+
+	if (m_toiScheduler)
+	{
+		b2Free(m_toiScheduler->events);
+		b2Free(m_toiScheduler->candidates);
+		b2Free(m_toiScheduler->dirty);
+		b2Free(m_toiScheduler);
+	}
 }
 
 void b2World::SetDestructionListener(b2DestructionListener* listener)
@@ -104,6 +196,110 @@ void b2World::SetDebugDraw(b2Draw* debugDraw)
 	m_debugDraw = debugDraw;
 }
 
+void b2World::SetSplitBroadPhase(bool flag)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked() || flag == GetSplitBroadPhase())
+	{
+		return;
+	}
+
+	// The contacts are kept and new pairs are found on the next step.
+	b2BroadPhase* broadPhase = &m_contactManager.m_broadPhase;
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			f->DestroyProxies(broadPhase);
+		}
+	}
+
+	broadPhase->SetSplitTrees(flag);
+
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		if (b->IsActive() == false)
+		{
+			continue;
+		}
+
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			f->CreateProxies(broadPhase, b->Transform());
+		}
+	}
+}
+
+void b2World::SetProfiler(b2Profiler* profiler)
+{
+	m_profiler = profiler;
+	m_contactManager.m_profiler = profiler;
+}
+
+void b2World::SetContactEvents(b2ContactEvents* events)
+{
+	m_contactEvents = events;
+}
+
+void b2World::SetChecksumListener(b2ChecksumListener* listener)
+{
+	m_checksumListener = listener;
+}
+
+void b2World::SetThreadPool(b2ThreadPool* threadPool)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	for (int32 i = 0; i < m_threadAllocatorCount; ++i)
+	{
+		m_threadAllocators[i].~b2ThreadAllocator();
+	}
+	b2Free(m_threadAllocators);
+	m_threadAllocators = NULL;
+	m_threadAllocatorCount = 0;
+
+	m_threadPool = threadPool;
+	m_contactManager.m_broadPhase.SetThreadPool(threadPool);
+	m_contactManager.m_threadPool = threadPool;
+	if (m_threadPool == NULL)
+	{
+		return;
+	}
+
+	m_threadAllocatorCount = m_threadPool->GetThreadCount();
+	m_threadAllocators = (b2ThreadAllocator*)b2Alloc(m_threadAllocatorCount * sizeof(b2ThreadAllocator));
+	for (int32 i = 0; i < m_threadAllocatorCount; ++i)
+	{
+		new (m_threadAllocators + i) b2ThreadAllocator;
+	}
+}
+
+b2AllocatorStats b2World::GetAllocatorStats() const
+{
+	b2AllocatorStats stats;
+	stats.stackCapacity = m_stackAllocator.GetCapacity();
+	stats.stackPeak = m_stackAllocator.GetMaxAllocation();
+	stats.stackFallbacks = m_stackAllocator.GetFallbackCount();
+	stats.blockPeak = m_blockAllocator.GetMaxAllocation();
+	stats.blockFallbacks = m_blockAllocator.GetFallbackCount();
+
+	for (int32 i = 0; i < m_threadAllocatorCount; ++i)
+	{
+		const b2ThreadAllocator* allocator = m_threadAllocators + i;
+		stats.stackCapacity += allocator->stackAllocator.GetCapacity();
+		stats.stackPeak += allocator->stackAllocator.GetMaxAllocation();
+		stats.stackFallbacks += allocator->stackAllocator.GetFallbackCount();
+		stats.blockPeak += allocator->blockAllocator.GetMaxAllocation();
+		stats.blockFallbacks += allocator->blockAllocator.GetFallbackCount();
+	}
+
+	return stats;
+}
+
 b2Body* b2World::CreateBody(const b2BodyDef* def)
 {
 	b2Assert(IsLocked() == false);
@@ -125,9 +321,61 @@ b2Body* b2World::CreateBody(const b2BodyDef* def)
 	m_bodyList = b;
 	++m_bodyCount;
 
+	m_islandManager.AddBody(b);
+
+	// The body is put into a sector by the next step.
+	m_flags |= e_newSector;
+
 	return b;
 }
 
+void b2World::CreateBodies(const b2BodyDef* bodyDefs, int32 count, const b2FixtureDef* fixtureDefs, const int32* fixtureCounts, b2Body** bodies)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	int32 fixtureCount = 0;
+	for (int32 i = 0; i < count; ++i)
+	{
+		fixtureCount += fixtureCounts[i];
+	}
+
+	b2Fixture** fixtures = (b2Fixture**)m_stackAllocator.Allocate(fixtureCount * sizeof(b2Fixture*));
+
+	const b2FixtureDef* fixtureDef = fixtureDefs;
+	int32 fixtureIndex = 0;
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Body* b = CreateBody(bodyDefs + i);
+
+		bool hasMass = false;
+		for (int32 j = 0; j < fixtureCounts[i]; ++j)
+		{
+			fixtures[fixtureIndex++] = b->AddFixture(fixtureDef);
+			hasMass = hasMass || fixtureDef->density > 0.0f;
+			++fixtureDef;
+		}
+
+		if (hasMass)
+		{
+			b->ResetMassData();
+		}
+
+		if (bodies)
+		{
+			bodies[i] = b;
+		}
+	}
+
+	b2Fixture::CreateProxies(&m_contactManager.m_broadPhase, &m_stackAllocator, fixtures, fixtureCount);
+	m_stackAllocator.Free(fixtures);
+
+	m_flags |= e_newFixture;
+}
+
 void b2World::DestroyBody(b2Body* b)
 {
 	b2Assert(m_bodyCount > 0);
@@ -188,6 +436,9 @@ void b2World::DestroyBody(b2Body* b)
 	b->m_fixtureList = NULL;
 	b->m_fixtureCount = 0;
 
+	// Remove from the island.
+	m_islandManager.RemoveBody(b);
+
 	// Remove world body list.
 	if (b->m_prev)
 	{
@@ -204,6 +455,8 @@ void b2World::DestroyBody(b2Body* b)
 		m_bodyList = b->m_next;
 	}
 
+	m_sectors.RemoveBody(b);
+
 	--m_bodyCount;
 	b->~b2Body();
 	m_blockAllocator.Free(b, sizeof(b2Body));
@@ -244,6 +497,9 @@ b2Joint* b2World::CreateJoint(const b2JointDef* def)
 	if (j->m_bodyB->m_jointList) j->m_bodyB->m_jointList->prev = &j->m_edgeB;
 	j->m_bodyB->m_jointList = &j->m_edgeB;
 
+	// Join the islands of the bodies.
+	m_islandManager.LinkJoint(j);
+
 	b2Body* bodyA = def->bodyA;
 	b2Body* bodyB = def->bodyB;
 
@@ -299,6 +555,11 @@ void b2World::DestroyJoint(b2Joint* j)
 	b2Body* bodyA = j->m_bodyA;
 	b2Body* bodyB = j->m_bodyB;
 
+	if (j->m_island)
+	{
+		m_islandManager.UnlinkJoint(j);
+	}
+
 	// Wake up connected bodies.
 	bodyA->SetAwake(true);
 	bodyB->SetAwake(true);
@@ -364,6 +625,57 @@ void b2World::DestroyJoint(b2Joint* j)
 	}
 }
 
+b2ParticleSystem* b2World::CreateParticleSystem(const b2ParticleSystemDef* def)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return NULL;
+	}
+
+	void* mem = m_blockAllocator.Allocate(sizeof(b2ParticleSystem));
+	b2ParticleSystem* ps = new (mem) b2ParticleSystem(def, this);
+
+	// Add to world doubly linked list.
+	ps->m_prev = NULL;
+	ps->m_next = m_particleSystemList;
+	if (m_particleSystemList)
+	{
+		m_particleSystemList->m_prev = ps;
+	}
+	m_particleSystemList = ps;
+
+	return ps;
+}
+
+void b2World::DestroyParticleSystem(b2ParticleSystem* ps)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	// Remove from the world particle system list.
+	if (ps->m_prev)
+	{
+		ps->m_prev->m_next = ps->m_next;
+	}
+
+	if (ps->m_next)
+	{
+		ps->m_next->m_prev = ps->m_prev;
+	}
+
+	if (ps == m_particleSystemList)
+	{
+		m_particleSystemList = ps->m_next;
+	}
+
+	ps->~b2ParticleSystem();
+	m_blockAllocator.Free(ps, sizeof(b2ParticleSystem));
+}
+
 //
 void b2World::SetAllowSleeping(bool flag)
 {
@@ -389,144 +701,131 @@ void b2World::Solve(const b2TimeStep& step)
 	m_profile.solveVelocity = 0.0f;
 	m_profile.solvePosition = 0.0f;
 
-	// Size the island for the worst case.
-	b2Island island(m_bodyCount,
-					m_contactManager.m_contactCount,
-					m_jointCount,
-					&m_stackAllocator,
-					m_contactManager.m_contactListener);
-
-	// Clear all the island flags.
-	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	// Bring the persistent islands up to date. Only islands that gained or lost
+	// a constraint are touched.
 	{
-		b->m_flags &= ~b2Body::e_islandFlag;
+		b2ProfileScope scope(m_profiler, "updateIslands");
+		m_islandManager.MergeIslands();
+		m_islandManager.SplitIslands();
 	}
-	for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+
+	if (m_threadPool != NULL && m_threadPool->GetThreadCount() > 1)
 	{
-		c->m_flags &= ~b2Contact::e_islandFlag;
+		SolveIslandsParallel(step);
 	}
-	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	else
 	{
-		j->m_islandFlag = false;
+		SolveIslands(step);
 	}
 
-	// Build and simulate all awake islands.
-	int32 stackSize = m_bodyCount;
-	b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
-	for (b2Body* seed = m_bodyList; seed; seed = seed->m_next)
 	{
-		if (seed->m_flags & b2Body::e_islandFlag)
+		b2ProfileScope scope(m_profiler, "broadphase");
+		b2Timer timer;
+		// Synchronize fixtures, check for out of range bodies. Bodies that
+		// were not in an awake island did not move.
+		b2PersistentIsland* island = m_islandManager.m_awakeList;
+		while (island)
 		{
-			continue;
-		}
+			b2PersistentIsland* next = island->next;
 
-		if (seed->IsAwake() == false || seed->IsActive() == false)
-		{
-			continue;
-		}
+			for (b2Body* b = island->bodyList; b; b = b->m_islandNext)
+			{
+				// Update fixtures (for broad-phase).
+				b->SynchronizeFixtures();
+			}
 
-		// The seed can be dynamic or kinematic.
-		if (seed->GetType() == b2_staticBody)
-		{
-			continue;
+			// The island went to sleep during the solve.
+			if (island->bodyList->IsAwake() == false)
+			{
+				m_islandManager.SleepIsland(island);
+			}
+
+			island = next;
 		}
 
-		// Reset island and stack.
+		// Look for new contacts.
+		b2ProfileScope findScope(m_profiler, "findNewContacts");
+		m_contactManager.FindNewContacts();
+		m_profile.broadphase = timer.GetMilliseconds();
+	}
+}
+
+// Simulate all awake islands one at a time.
+void b2World::SolveIslands(const b2TimeStep& step)
+{
+	// Size the island for the worst case.
+	b2Island island(m_bodyCount,
+					m_contactManager.m_contactCount,
+					m_jointCount,
+					&m_stackAllocator,
+					m_contactManager.m_contactListener);
+	island.m_events = m_contactManager.m_contactEvents;
+
+	for (b2PersistentIsland* pi = m_islandManager.m_awakeList; pi; pi = pi->next)
+	{
 		island.Clear();
-		int32 stackCount = 0;
-		stack[stackCount++] = seed;
-		seed->m_flags |= b2Body::e_islandFlag;
 
-		// Perform a depth first search (DFS) on the constraint graph.
-		while (stackCount > 0)
+		for (b2Body* b = pi->bodyList; b; b = b->m_islandNext)
 		{
-			// Grab the next body off the stack and add it to the island.
-			b2Body* b = stack[--stackCount];
 			b2Assert(b->IsActive() == true);
 			island.Add(b);
 
 			// Make sure the body is awake.
 			b->SetAwake(true);
+		}
 
-			// To keep islands as small as possible, we don't
-			// propagate islands across static bodies.
-			if (b->GetType() == b2_staticBody)
+		// Static bodies are not part of persistent islands. They are added to
+		// every island that touches them.
+		for (b2Contact* contact = pi->contactList; contact; contact = contact->m_islandNext)
+		{
+			// Is this contact solid and touching?
+			if (contact->IsEnabled() == false ||
+				contact->HasSolverPoints() == false)
 			{
 				continue;
 			}
 
-			// Search all contacts connected to this body.
-			for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
+			// Skip sensors.
+			bool sensorA = contact->m_fixtureA->m_isSensor;
+			bool sensorB = contact->m_fixtureB->m_isSensor;
+			if (sensorA || sensorB)
 			{
-				b2Contact* contact = ce->contact;
-
-				// Has this contact already been added to an island?
-				if (contact->m_flags & b2Contact::e_islandFlag)
-				{
-					continue;
-				}
-
-				// Is this contact solid and touching?
-				if (contact->IsEnabled() == false ||
-					contact->IsTouching() == false)
-				{
-					continue;
-				}
-
-				// Skip sensors.
-				bool sensorA = contact->m_fixtureA->m_isSensor;
-				bool sensorB = contact->m_fixtureB->m_isSensor;
-				if (sensorA || sensorB)
-				{
-					continue;
-				}
-
-				island.Add(contact);
-				contact->m_flags |= b2Contact::e_islandFlag;
-
-				b2Body* other = ce->other;
-
-				// Was the other body already added to this island?
-				if (other->m_flags & b2Body::e_islandFlag)
-				{
-					continue;
-				}
-
-				b2Assert(stackCount < stackSize);
-				stack[stackCount++] = other;
-				other->m_flags |= b2Body::e_islandFlag;
+				continue;
 			}
 
-			// Search all joints connect to this body.
-			for (b2JointEdge* je = b->m_jointList; je; je = je->next)
-			{
-				if (je->joint->m_islandFlag == true)
-				{
-					continue;
-				}
-
-				b2Body* other = je->other;
+			island.Add(contact);
 
-				// Don't simulate joints connected to inactive bodies.
-				if (other->IsActive() == false)
+			b2Body* bodies[2] = {contact->m_fixtureA->m_body, contact->m_fixtureB->m_body};
+			for (int32 i = 0; i < 2; ++i)
+			{
+				b2Body* other = bodies[i];
+				if (other->GetType() == b2_staticBody && (other->m_flags & b2Body::e_islandFlag) == 0)
 				{
-					continue;
+					island.Add(other);
+					other->SetAwake(true);
+					other->m_flags |= b2Body::e_islandFlag;
 				}
+			}
+		}
 
-				island.Add(je->joint);
-				je->joint->m_islandFlag = true;
+		for (b2Joint* joint = pi->jointList; joint; joint = joint->m_islandNext)
+		{
+			island.Add(joint);
 
-				if (other->m_flags & b2Body::e_islandFlag)
+			b2Body* bodies[2] = {joint->m_bodyA, joint->m_bodyB};
+			for (int32 i = 0; i < 2; ++i)
+			{
+				b2Body* other = bodies[i];
+				if (other->GetType() == b2_staticBody && (other->m_flags & b2Body::e_islandFlag) == 0)
 				{
-					continue;
+					island.Add(other);
+					other->SetAwake(true);
+					other->m_flags |= b2Body::e_islandFlag;
 				}
-
-				b2Assert(stackCount < stackSize);
-				stack[stackCount++] = other;
-				other->m_flags |= b2Body::e_islandFlag;
 			}
 		}
 
+		b2ProfileScope islandScope(m_profiler, "island", 0, island.m_bodyCount);
 		b2Profile profile;
 		island.Solve(&profile, step, m_gravity, m_allowSleep);
 		m_profile.solveInit += profile.solveInit;
@@ -544,174 +843,592 @@ void b2World::Solve(const b2TimeStep& step)
 			}
 		}
 	}
+}
 
-	m_stackAllocator.Free(stack);
+// The bodies, contacts and joints of one island, as ranges into the flat
+// arrays filled by b2World::SolveIslandsParallel.
+struct b2IslandRange
+{
+	int32 bodyIndex, bodyCount;
+	int32 staticIndex, staticCount;
+	int32 contactIndex, contactCount;
+	int32 jointIndex, jointCount;
+	float32 solveInit, solveVelocity, solvePosition;
+};
 
+struct b2SolveIslandTask : public b2ParallelTask
+{
+	void Execute(int32 index, int32 threadIndex)
 	{
-		b2Timer timer;
-		// Synchronize fixtures, check for out of range bodies.
-		for (b2Body* b = m_bodyList; b; b = b->GetNext())
-		{
-			// If a body was not in an island then it did not move.
-			if ((b->m_flags & b2Body::e_islandFlag) == 0)
-			{
-				continue;
-			}
+		b2IslandRange* range = ranges + index;
+		b2ProfileScope scope(profiler, "island", threadIndex, range->bodyCount);
 
-			if (b->GetType() == b2_staticBody)
-			{
-				continue;
-			}
+		// Listener callbacks are buffered and replayed in island order later.
+		int32 bodyCapacity = range->bodyCount + range->staticCount;
+		b2Island island(bodyCapacity, range->contactCount, range->jointCount, &allocators[threadIndex].stackAllocator, NULL);
+		island.m_impulses = impulses + range->contactIndex;
 
-			// Update fixtures (for broad-phase).
-			b->SynchronizeFixtures();
+		for (int32 i = 0; i < range->bodyCount; ++i)
+		{
+			island.Add(bodies[range->bodyIndex + i]);
+		}
+		island.SetStatics(statics + range->staticIndex, range->staticCount);
+		for (int32 i = 0; i < range->contactCount; ++i)
+		{
+			island.Add(contacts[range->contactIndex + i]);
+		}
+		for (int32 i = 0; i < range->jointCount; ++i)
+		{
+			island.Add(joints[range->jointIndex + i]);
 		}
 
-		// Look for new contacts.
-		m_contactManager.FindNewContacts();
-		m_profile.broadphase = timer.GetMilliseconds();
+		b2Profile profile;
+		island.Solve(&profile, *step, gravity, allowSleep);
+		range->solveInit = profile.solveInit;
+		range->solveVelocity = profile.solveVelocity;
+		range->solvePosition = profile.solvePosition;
 	}
-}
 
-// Find TOI contacts and solve them.
-void b2World::SolveTOI(const b2TimeStep& step)
-{
-	b2Island island(2 * b2_maxTOIContacts, b2_maxTOIContacts, 0, &m_stackAllocator, m_contactManager.m_contactListener);
+	const b2TimeStep* step;
+	b2Vec2 gravity;
+	bool allowSleep;
+
+	b2IslandRange* ranges;
+	b2Body** bodies;
+	b2Body** statics;
+	b2Contact** contacts;
+	b2Joint** joints;
+	b2ContactImpulse* impulses;
+	b2ThreadAllocator* allocators;
+	b2Profiler* profiler;
+};
 
-	if (m_stepComplete)
+// Collect all awake islands first, then solve them on the thread pool. Static
+// bodies are shared between islands, so each one gets a single island index
+// for the whole step and is never written by the island solvers. Each island
+// stores its statics after its own bodies and finds them by that index.
+void b2World::SolveIslandsParallel(const b2TimeStep& step)
+{
+	int32 contactCapacity = m_contactManager.m_contactCount;
+	int32 staticCapacity = contactCapacity + m_jointCount;
+
+	b2IslandRange* ranges = (b2IslandRange*)m_stackAllocator.Allocate(m_bodyCount * sizeof(b2IslandRange));
+	b2Body** bodies = (b2Body**)m_stackAllocator.Allocate(m_bodyCount * sizeof(b2Body*));
+	b2Body** statics = (b2Body**)m_stackAllocator.Allocate(staticCapacity * sizeof(b2Body*));
+	b2Contact** contacts = (b2Contact**)m_stackAllocator.Allocate(contactCapacity * sizeof(b2Contact*));
+	b2Joint** joints = (b2Joint**)m_stackAllocator.Allocate(m_jointCount * sizeof(b2Joint*));
+	b2ContactImpulse* impulses = (b2ContactImpulse*)m_stackAllocator.Allocate(contactCapacity * sizeof(b2ContactImpulse));
+
+	uint64 gatherStart = b2Timer::GetTicks();
+	int32 islandCount = 0;
+	int32 bodyCount = 0;
+	int32 staticCount = 0;
+	int32 contactCount = 0;
+	int32 jointCount = 0;
+
+	// This gathers the same islands as SolveIslands.
+	for (b2PersistentIsland* pi = m_islandManager.m_awakeList; pi; pi = pi->next)
 	{
-		for (b2Body* b = m_bodyList; b; b = b->m_next)
-		{
-			b->m_flags &= ~b2Body::e_islandFlag;
-			b->m_sweep.alpha0 = 0.0f;
-		}
+		b2IslandRange* range = ranges + islandCount;
+		range->bodyIndex = bodyCount;
+		range->staticIndex = staticCount;
+		range->contactIndex = contactCount;
+		range->jointIndex = jointCount;
 
-		for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+		for (b2Body* b = pi->bodyList; b; b = b->m_islandNext)
 		{
-			// Invalidate TOI
-			c->m_flags &= ~(b2Contact::e_toiFlag | b2Contact::e_islandFlag);
-			c->m_toiCount = 0;
-			c->m_toi = 1.0f;
-		}
-	}
+			b2Assert(b->IsActive() == true);
+			bodies[bodyCount++] = b;
 
-	// Find TOI events and solve them.
-	for (;;)
-	{
-		// Find the first TOI.
-		b2Contact* minContact = NULL;
-		float32 minAlpha = 1.0f;
+			// Make sure the body is awake.
+			b->SetAwake(true);
+		}
 
-		for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+		for (b2Contact* contact = pi->contactList; contact; contact = contact->m_islandNext)
 		{
-			// Is this contact disabled?
-			if (c->IsEnabled() == false)
+			if (contact->IsEnabled() == false ||
+				contact->HasSolverPoints() == false)
 			{
 				continue;
 			}
 
-			// Prevent excessive sub-stepping.
-			if (c->m_toiCount > b2_maxSubSteps)
+			bool sensorA = contact->m_fixtureA->m_isSensor;
+			bool sensorB = contact->m_fixtureB->m_isSensor;
+			if (sensorA || sensorB)
 			{
 				continue;
 			}
 
-			float32 alpha = 1.0f;
-			if (c->m_flags & b2Contact::e_toiFlag)
+			contacts[contactCount++] = contact;
+
+			b2Body* others[2] = {contact->m_fixtureA->m_body, contact->m_fixtureB->m_body};
+			for (int32 i = 0; i < 2; ++i)
 			{
-				// This contact has a valid cached TOI.
-				alpha = c->m_toi;
+				b2Body* other = others[i];
+				if (other->GetType() == b2_staticBody && (other->m_flags & b2Body::e_islandFlag) == 0)
+				{
+					b2Assert(staticCount < staticCapacity);
+					statics[staticCount++] = other;
+					other->SetAwake(true);
+					other->m_flags |= b2Body::e_islandFlag;
+				}
 			}
-			else
-			{
-				b2Fixture* fA = c->GetFixtureA();
-				b2Fixture* fB = c->GetFixtureB();
+		}
 
-				// Is there a sensor?
-				if (fA->IsSensor() || fB->IsSensor())
+		for (b2Joint* joint = pi->jointList; joint; joint = joint->m_islandNext)
+		{
+			joints[jointCount++] = joint;
+
+			b2Body* others[2] = {joint->m_bodyA, joint->m_bodyB};
+			for (int32 i = 0; i < 2; ++i)
+			{
+				b2Body* other = others[i];
+				if (other->GetType() == b2_staticBody && (other->m_flags & b2Body::e_islandFlag) == 0)
 				{
-					continue;
+					b2Assert(staticCount < staticCapacity);
+					statics[staticCount++] = other;
+					other->SetAwake(true);
+					other->m_flags |= b2Body::e_islandFlag;
 				}
+			}
+		}
 
-				b2Body* bA = fA->GetBody();
-				b2Body* bB = fB->GetBody();
+		range->bodyCount = bodyCount - range->bodyIndex;
+		range->staticCount = staticCount - range->staticIndex;
+		range->contactCount = contactCount - range->contactIndex;
+		range->jointCount = jointCount - range->jointIndex;
+		++islandCount;
 
-				b2BodyType typeA = bA->m_type;
-				b2BodyType typeB = bB->m_type;
-				b2Assert(typeA == b2_dynamicBody || typeB == b2_dynamicBody);
+		// Allow static bodies to participate in other islands.
+		for (int32 i = range->staticIndex; i < staticCount; ++i)
+		{
+			statics[i]->m_flags &= ~b2Body::e_islandFlag;
+		}
+	}
 
-				bool activeA = bA->IsAwake() && typeA != b2_staticBody;
-				bool activeB = bB->IsAwake() && typeB != b2_staticBody;
+	// Assign the shared static indices.
+	for (int32 i = 0; i < staticCount; ++i)
+	{
+		statics[i]->m_islandIndex = -1;
+	}
 
-				// Is at least one body active (awake and dynamic or kinematic)?
-				if (activeA == false && activeB == false)
-				{
-					continue;
-				}
+	int32 staticIndexCount = 0;
+	for (int32 i = 0; i < staticCount; ++i)
+	{
+		if (statics[i]->m_islandIndex == -1)
+		{
+			statics[i]->m_islandIndex = staticIndexCount;
+			++staticIndexCount;
+		}
+	}
 
-				bool collideA = bA->IsBullet() || typeA != b2_dynamicBody;
-				bool collideB = bB->IsBullet() || typeB != b2_dynamicBody;
+	if (m_profiler)
+	{
+		m_profiler->Record(0, "gatherIslands", gatherStart, b2Timer::GetTicks(), islandCount);
+	}
 
-				// Are these two non-bullet dynamic bodies?
-				if (collideA == false && collideB == false)
-				{
-					continue;
-				}
+	b2SolveIslandTask task;
+	task.step = &step;
+	task.gravity = m_gravity;
+	task.allowSleep = m_allowSleep;
+	task.ranges = ranges;
+	task.bodies = bodies;
+	task.statics = statics;
+	task.contacts = contacts;
+	task.joints = joints;
+	task.impulses = impulses;
+	task.allocators = m_threadAllocators;
+	task.profiler = m_profiler;
+	m_threadPool->Run(&task, islandCount);
+
+	// Report in the same order as the serial solver and apply the sleep
+	// state of each island to its shared static bodies.
+	b2ContactListener* listener = m_contactManager.m_contactListener;
+	b2ContactEvents* events = m_contactManager.m_contactEvents;
+	for (int32 i = 0; i < islandCount; ++i)
+	{
+		b2IslandRange* range = ranges + i;
+		m_profile.solveInit += range->solveInit;
+		m_profile.solveVelocity += range->solveVelocity;
+		m_profile.solvePosition += range->solvePosition;
 
-				// Compute the TOI for this contact.
-				// Put the sweeps onto the same time interval.
-				float32 alpha0 = bA->m_sweep.alpha0;
+		for (int32 j = 0; j < range->contactCount; ++j)
+		{
+			int32 index = range->contactIndex + j;
+			if (listener)
+			{
+				listener->PostSolve(contacts[index], impulses + index);
+			}
 
-				if (bA->m_sweep.alpha0 < bB->m_sweep.alpha0)
-				{
-					alpha0 = bB->m_sweep.alpha0;
-					bA->m_sweep.Advance(alpha0);
-				}
-				else if (bB->m_sweep.alpha0 < bA->m_sweep.alpha0)
-				{
-					alpha0 = bA->m_sweep.alpha0;
-					bB->m_sweep.Advance(alpha0);
-				}
+			if (events)
+			{
+				events->AddSolve(contacts[index], impulses + index);
+			}
+		}
 
-				b2Assert(alpha0 < 1.0f);
+		bool awake = bodies[range->bodyIndex]->IsAwake();
+		for (int32 j = 0; j < range->staticCount; ++j)
+		{
+			statics[range->staticIndex + j]->SetAwake(awake);
+		}
+	}
 
-				int32 indexA = c->GetChildIndexA();
-				int32 indexB = c->GetChildIndexB();
+	m_stackAllocator.Free(impulses);
+	m_stackAllocator.Free(joints);
+	m_stackAllocator.Free(contacts);
+	m_stackAllocator.Free(statics);
+	m_stackAllocator.Free(bodies);
+	m_stackAllocator.Free(ranges);
+}
 
-				// Compute the time of impact in interval [0, minTOI]
-				b2TOIInput input;
-				input.proxyA.Set(fA->GetShape(), indexA);
-				input.proxyB.Set(fB->GetShape(), indexB);
-				input.sweepA = bA->m_sweep;
-				input.sweepB = bB->m_sweep;
-				input.tMax = 1.0f;
+static void b2QueueTOI(b2TOIScheduler* scheduler, b2Contact* c, float32 alpha)
+{
+	if (scheduler->eventCount == scheduler->eventCapacity)
+	{
+		scheduler->eventCapacity = b2Max(scheduler->eventCount + 1, 2 * scheduler->eventCapacity);
+		b2GrowArray(&scheduler->events, scheduler->eventCount, scheduler->eventCapacity);
+	}
 
-				b2TOIOutput output;
-				b2TimeOfImpact(&output, &input);
+	b2TOIEvent* event = scheduler->events + scheduler->eventCount;
+	event->alpha = alpha;
+	event->order = scheduler->order;
+	event->contact = c;
+	++scheduler->eventCount;
+	++scheduler->order;
 
-				// Beta is the fraction of the remaining portion of the .
-				float32 beta = output.t;
-				if (output.state == b2TOIOutput::e_touching)
-				{
-					alpha = b2Min(alpha0 + (1.0f - alpha0) * beta, 1.0f);
-				}
-				else
-				{
-					alpha = 1.0f;
-				}
+	std::push_heap(scheduler->events, scheduler->events + scheduler->eventCount, b2TOIEventLater);
+}
+
+// Compute the TOI as a fraction of the full step.
+static float32 b2ComputeTOI(const b2TOIInput* input, float32 alpha0)
+{
+	b2TOIOutput output;
+	b2TimeOfImpact(&output, input);
+
+	// Beta is the fraction of the remaining portion of the .
+	float32 beta = output.t;
+	if (output.state == b2TOIOutput::e_touching)
+	{
+		return b2Min(alpha0 + (1.0f - alpha0) * beta, 1.0f);
+	}
+
+	return 1.0f;
+}
+
+// The first TOI search hands its candidates to the pool threads in groups of this size.
+#define b2_toiGroupSize	8
+
+// b2TimeOfImpact only reads its input. The pool threads count the TOI and GJK
+// statistics per thread and the calling thread adds them to the globals.
+struct b2TOITask : public b2ParallelTask
+{
+	void Execute(int32 index, int32 threadIndex)
+	{
+		b2ProfileScope scope(profiler, "toiGroup", threadIndex);
+
+		if (threadIndex > 0)
+		{
+			b2SetThreadCounters(counters + threadIndex);
+		}
+
+		int32 first = index * b2_toiGroupSize;
+		int32 last = b2Min(first + b2_toiGroupSize, count);
+		for (int32 i = first; i < last; ++i)
+		{
+			b2TOICandidate* candidate = candidates + i;
+			if (candidate->compute)
+			{
+				candidate->alpha = b2ComputeTOI(&candidate->input, candidate->alpha0);
+			}
+		}
+
+		if (threadIndex > 0)
+		{
+			b2SetThreadCounters(NULL);
+		}
+	}
+
+	b2TOICandidate* candidates;
+	int32 count;
+	b2Profiler* profiler;
+	b2CollisionCounters counters[b2_maxThreads];
+};
+
+bool b2World::PrepareTOI(b2Contact* c, b2TOIInput* input, float32* alpha0)
+{
+	b2Fixture* fA = c->GetFixtureA();
+	b2Fixture* fB = c->GetFixtureB();
+
+	// Is there a sensor?
+	if (fA->IsSensor() || fB->IsSensor())
+	{
+		return false;
+	}
+
+	b2Body* bA = fA->GetBody();
+	b2Body* bB = fB->GetBody();
+
+	b2BodyType typeA = bA->m_type;
+	b2BodyType typeB = bB->m_type;
+	b2Assert(typeA == b2_dynamicBody || typeB == b2_dynamicBody);
+
+	bool activeA = bA->IsAwake() && typeA != b2_staticBody;
+	bool activeB = bB->IsAwake() && typeB != b2_staticBody;
+
+	// Is at least one body active (awake and dynamic or kinematic)?
+	if (activeA == false && activeB == false)
+	{
+		return false;
+	}
+
+	bool collideA = bA->IsBullet() || typeA != b2_dynamicBody;
+	bool collideB = bB->IsBullet() || typeB != b2_dynamicBody;
+
+	// Speculative contacts handle everything but bullets.
+	if (m_speculativeContacts)
+	{
+		collideA = bA->IsBullet();
+		collideB = bB->IsBullet();
+	}
+
+	// Are these two non-bullet dynamic bodies?
+	if (collideA == false && collideB == false)
+	{
+		return false;
+	}
+
+	// Put the sweeps onto the same time interval.
+	*alpha0 = bA->Sweep().alpha0;
+
+	if (bA->Sweep().alpha0 < bB->Sweep().alpha0)
+	{
+		*alpha0 = bB->Sweep().alpha0;
+		bA->Sweep().Advance(*alpha0);
+	}
+	else if (bB->Sweep().alpha0 < bA->Sweep().alpha0)
+	{
+		*alpha0 = bA->Sweep().alpha0;
+		bB->Sweep().Advance(*alpha0);
+	}
+
+	b2Assert(*alpha0 < 1.0f);
+
+	int32 indexA = c->GetChildIndexA();
+	int32 indexB = c->GetChildIndexB();
+
+	// Compute the time of impact in interval [0, minTOI]
+	input->proxyA.Set(fA->GetShape(), indexA);
+	input->proxyB.Set(fB->GetShape(), indexB);
+	input->sweepA = bA->Sweep();
+	input->sweepB = bB->Sweep();
+	input->tMax = 1.0f;
+
+	return true;
+}
+
+void b2World::FindTOIs()
+{
+	b2ProfileScope scope(m_profiler, "findTOIs");
+
+	b2TOIScheduler* scheduler = m_toiScheduler;
+	scheduler->eventCount = 0;
+	scheduler->order = 0;
+
+	if (m_contactManager.m_contactCount > scheduler->candidateCapacity)
+	{
+		scheduler->candidateCapacity = b2Max(m_contactManager.m_contactCount, 2 * scheduler->candidateCapacity);
+		b2GrowArray(&scheduler->candidates, 0, scheduler->candidateCapacity);
+	}
+
+	// Walk the contacts in list order, so the sweeps are advanced like they are
+	// when the contacts are searched one by one.
+	int32 count = 0;
+	for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+	{
+		// Is this contact disabled?
+		if (c->IsEnabled() == false)
+		{
+			continue;
+		}
+
+		// Prevent excessive sub-stepping.
+		if (c->m_toiCount > b2_maxSubSteps)
+		{
+			continue;
+		}
+
+		b2TOICandidate* candidate = scheduler->candidates + count;
+		if (c->m_flags & b2Contact::e_toiFlag)
+		{
+			// This contact has a valid cached TOI.
+			candidate->contact = c;
+			candidate->alpha = c->m_toi;
+			candidate->compute = false;
+			++count;
+			continue;
+		}
+
+		if (PrepareTOI(c, &candidate->input, &candidate->alpha0) == false)
+		{
+			continue;
+		}
+
+		candidate->contact = c;
+		candidate->compute = true;
+		++count;
+	}
+
+	b2TOITask task;
+	task.candidates = scheduler->candidates;
+	task.count = count;
+	task.profiler = m_profiler;
+
+	int32 groupCount = (count + b2_toiGroupSize - 1) / b2_toiGroupSize;
+	if (m_threadPool)
+	{
+		int32 threadCount = m_threadPool->GetThreadCount();
+		for (int32 i = 1; i < threadCount; ++i)
+		{
+			task.counters[i].SetZero();
+		}
+
+		m_threadPool->Run(&task, groupCount);
+
+		for (int32 i = 1; i < threadCount; ++i)
+		{
+			b2AddGlobalCounters(task.counters[i]);
+		}
+	}
+	else
+	{
+		for (int32 i = 0; i < groupCount; ++i)
+		{
+			task.Execute(i, 0);
+		}
+	}
+
+	// Queue in list order so ties go to the first contact in the list.
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2TOICandidate* candidate = scheduler->candidates + i;
+		b2Contact* c = candidate->contact;
+		if (candidate->compute)
+		{
+			c->m_toi = candidate->alpha;
+			c->m_flags |= b2Contact::e_toiFlag;
+		}
+
+		if (candidate->alpha < 1.0f)
+		{
+			b2QueueTOI(scheduler, c, candidate->alpha);
+		}
+	}
+}
+
+void b2World::FindTOI(b2Contact* c)
+{
+	if (c->IsEnabled() == false || c->m_toiCount > b2_maxSubSteps)
+	{
+		return;
+	}
+
+	// A contact shared by two displaced bodies is only searched once.
+	if (c->m_flags & b2Contact::e_toiFlag)
+	{
+		return;
+	}
+
+	b2TOIInput input;
+	float32 alpha0;
+	if (PrepareTOI(c, &input, &alpha0) == false)
+	{
+		return;
+	}
+
+	float32 alpha = b2ComputeTOI(&input, alpha0);
+	c->m_toi = alpha;
+	c->m_flags |= b2Contact::e_toiFlag;
+
+	if (alpha < 1.0f)
+	{
+		b2QueueTOI(m_toiScheduler, c, alpha);
+	}
+}
+
+// Find TOI contacts and solve them.
+void b2World::SolveTOI(const b2TimeStep& step)
+{
+	b2Island island(2 * b2_maxTOIContacts, b2_maxTOIContacts, 0, &m_stackAllocator, m_contactManager.m_contactListener);
+	island.m_events = m_contactManager.m_contactEvents;
+
+	if (m_toiScheduler == NULL)
+	{
+		m_toiScheduler = (b2TOIScheduler*)b2Alloc(sizeof(b2TOIScheduler));
+		memset(m_toiScheduler, 0, sizeof(b2TOIScheduler));
+	}
+
+	if (m_stepComplete)
+	{
+		for (b2Body* b = m_bodyList; b; b = b->m_next)
+		{
+			b->m_flags &= ~b2Body::e_islandFlag;
+			b->Sweep().alpha0 = 0.0f;
+		}
+
+		for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+		{
+			// Invalidate TOI
+			c->m_flags &= ~(b2Contact::e_toiFlag | b2Contact::e_islandFlag);
+			c->m_toiCount = 0;
+			c->m_toi = 1.0f;
+		}
+	}
+
+	// Search all contacts once, then only the contacts of the bodies that each
+	// TOI event displaces.
+	b2Timer searchTimer;
+	FindTOIs();
+	float32 searchTime = searchTimer.GetMilliseconds();
+	int32 toiCount = 0;
+
+	b2TOIScheduler* scheduler = m_toiScheduler;
+
+	// Find TOI events and solve them.
+	for (;;)
+	{
+		searchTimer.Reset();
+
+		// Find the first TOI.
+		b2Contact* minContact = NULL;
+		float32 minAlpha = 1.0f;
+
+		while (scheduler->eventCount > 0)
+		{
+			b2TOIEvent event = scheduler->events[0];
+			std::pop_heap(scheduler->events, scheduler->events + scheduler->eventCount, b2TOIEventLater);
+			--scheduler->eventCount;
+
+			b2Contact* c = event.contact;
 
-				c->m_toi = alpha;
-				c->m_flags |= b2Contact::e_toiFlag;
+			// Is this contact disabled or sub-stepped too much?
+			if (c->IsEnabled() == false || c->m_toiCount > b2_maxSubSteps)
+			{
+				continue;
 			}
 
-			if (alpha < minAlpha)
+			// Is this event stale?
+			if ((c->m_flags & b2Contact::e_toiFlag) == 0 || c->m_toi != event.alpha)
 			{
-				// This is the minimum TOI found so far.
-				minContact = c;
-				minAlpha = alpha;
+				continue;
 			}
+
+			minContact = c;
+			minAlpha = event.alpha;
+			break;
 		}
 
+		searchTime += searchTimer.GetMilliseconds();
+
 		if (minContact == NULL || 1.0f - 10.0f * b2_epsilon < minAlpha)
 		{
 			// No more TOI events. Done!
@@ -719,30 +1436,33 @@ void b2World::SolveTOI(const b2TimeStep& step)
 			break;
 		}
 
+		++toiCount;
+
 		// Advance the bodies to the TOI.
 		b2Fixture* fA = minContact->GetFixtureA();
 		b2Fixture* fB = minContact->GetFixtureB();
 		b2Body* bA = fA->GetBody();
 		b2Body* bB = fB->GetBody();
 
-		b2Sweep backup1 = bA->m_sweep;
-		b2Sweep backup2 = bB->m_sweep;
+		b2Sweep backup1 = bA->Sweep();
+		b2Sweep backup2 = bB->Sweep();
 
 		bA->Advance(minAlpha);
 		bB->Advance(minAlpha);
 
 		// The TOI contact likely has some new contact points.
-		minContact->Update(m_contactManager.m_contactListener);
+		minContact->Update(m_contactManager.m_contactListener, m_contactManager.m_contactEvents);
+		m_islandManager.UpdateContact(minContact);
 		minContact->m_flags &= ~b2Contact::e_toiFlag;
 		++minContact->m_toiCount;
 
 		// Is the contact solid?
-		if (minContact->IsEnabled() == false || minContact->IsTouching() == false)
+		if (minContact->IsEnabled() == false || minContact->HasSolverPoints() == false)
 		{
 			// Restore the sweeps.
 			minContact->SetEnabled(false);
-			bA->m_sweep = backup1;
-			bB->m_sweep = backup2;
+			bA->Sweep() = backup1;
+			bB->Sweep() = backup2;
 			bA->SynchronizeTransform();
 			bB->SynchronizeTransform();
 			continue;
@@ -805,27 +1525,28 @@ void b2World::SolveTOI(const b2TimeStep& step)
 					}
 
 					// Tentatively advance the body to the TOI.
-					b2Sweep backup = other->m_sweep;
+					b2Sweep backup = other->Sweep();
 					if ((other->m_flags & b2Body::e_islandFlag) == 0)
 					{
 						other->Advance(minAlpha);
 					}
 
 					// Update the contact points
-					contact->Update(m_contactManager.m_contactListener);
+					contact->Update(m_contactManager.m_contactListener, m_contactManager.m_contactEvents);
+					m_islandManager.UpdateContact(contact);
 
 					// Was the contact disabled by the user?
 					if (contact->IsEnabled() == false)
 					{
-						other->m_sweep = backup;
+						other->Sweep() = backup;
 						other->SynchronizeTransform();
 						continue;
 					}
 
 					// Are there contact points?
-					if (contact->IsTouching() == false)
+					if (contact->HasSolverPoints() == false)
 					{
-						other->m_sweep = backup;
+						other->Sweep() = backup;
 						other->SynchronizeTransform();
 						continue;
 					}
@@ -860,9 +1581,13 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		subStep.positionIterations = 20;
 		subStep.velocityIterations = step.velocityIterations;
 		subStep.warmStarting = false;
+		subStep.simdContactSolver = false;
+		subStep.batchedJoints = false;
+		subStep.speculativeContacts = false;
 		island.SolveTOI(subStep, bA->m_islandIndex, bB->m_islandIndex);
 
 		// Reset island flags and synchronize broad-phase proxies.
+		scheduler->dirtyCount = 0;
 		for (int32 i = 0; i < island.m_bodyCount; ++i)
 		{
 			b2Body* body = island.m_bodies[i];
@@ -879,11 +1604,19 @@ void b2World::SolveTOI(const b2TimeStep& step)
 			for (b2ContactEdge* ce = body->m_contactList; ce; ce = ce->next)
 			{
 				ce->contact->m_flags &= ~(b2Contact::e_toiFlag | b2Contact::e_islandFlag);
+
+				if (scheduler->dirtyCount == scheduler->dirtyCapacity)
+				{
+					scheduler->dirtyCapacity = b2Max(scheduler->dirtyCount + 1, 2 * scheduler->dirtyCapacity);
+					b2GrowArray(&scheduler->dirty, scheduler->dirtyCount, scheduler->dirtyCapacity);
+				}
+				scheduler->dirty[scheduler->dirtyCount++] = ce->contact;
 			}
 		}
 
 		// Commit fixture proxy movements to the broad-phase so that new contacts are created.
 		// Also, some contacts can be destroyed.
+		b2Contact* oldContactList = m_contactManager.m_contactList;
 		m_contactManager.FindNewContacts();
 
 		if (m_subStepping)
@@ -891,15 +1624,293 @@ void b2World::SolveTOI(const b2TimeStep& step)
 			m_stepComplete = false;
 			break;
 		}
+
+		searchTimer.Reset();
+
+		for (int32 i = 0; i < scheduler->dirtyCount; ++i)
+		{
+			FindTOI(scheduler->dirty[i]);
+		}
+
+		// New contacts are added to the front of the list.
+		for (b2Contact* c = m_contactManager.m_contactList; c != oldContactList; c = c->m_next)
+		{
+			FindTOI(c);
+		}
+
+		searchTime += searchTimer.GetMilliseconds();
 	}
+
+	m_profile.solveTOISearch = searchTime;
+	m_profile.toiCount = toiCount;
 }
 
-void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIterations)
+void b2World::ShiftOrigin(const b2Vec2& newOrigin)
 {
-	b2Timer stepTimer;
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
 
-	// If new fixtures were added, we need to find the new contacts.
-	if (m_flags & e_newFixture)
+	// The body states are contiguous. Free entries are shifted too, which is
+	// harmless.
+	b2Transform* transforms = m_bodyStates.m_transforms;
+	b2Sweep* sweeps = m_bodyStates.m_sweeps;
+	int32 count = m_bodyStates.GetCount();
+	for (int32 i = 0; i < count; ++i)
+	{
+		transforms[i].p -= newOrigin;
+		sweeps[i].c0 -= newOrigin;
+		sweeps[i].c -= newOrigin;
+	}
+
+	// The fixture proxies keep their last AABB for b2Fixture::GetAABB.
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			for (int32 i = 0; i < f->m_proxyCount; ++i)
+			{
+				f->m_proxies[i].aabb.lowerBound -= newOrigin;
+				f->m_proxies[i].aabb.upperBound -= newOrigin;
+			}
+		}
+	}
+
+	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		j->ShiftOrigin(newOrigin);
+	}
+
+	m_contactManager.m_broadPhase.ShiftOrigin(newOrigin);
+
+	for (b2ParticleSystem* ps = m_particleSystemList; ps; ps = ps->m_next)
+	{
+		ps->ShiftOrigin(newOrigin);
+	}
+
+	// The sector grid stays fixed to the original origin.
+	m_sectors.m_origin += newOrigin;
+	m_streamingFocus -= newOrigin;
+}
+
+void b2World::SetStreaming(float32 sectorSize, float32 radius)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	b2Assert(radius >= 0.0f);
+	b2Assert(radius == 0.0f || sectorSize > 0.0f);
+
+	// Bring the streamed bodies back and start over with an empty grid.
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		if (b->m_flags & b2Body::e_streamedFlag)
+		{
+			b->SetActive(true);
+			m_flags |= e_newFixture;
+		}
+
+		b->m_sector = b2_nullSector;
+		b->m_sectorPrev = NULL;
+		b->m_sectorNext = NULL;
+	}
+
+	m_sectors.Reset(sectorSize);
+	m_streamingRadius = radius;
+	m_flags |= e_newSector;
+}
+
+void b2World::SetSectorActive(int32 index, bool flag)
+{
+	m_sectors.SetActive(index, flag);
+
+	for (b2Body* b = m_sectors.m_sectors[index].bodyList; b; b = b->m_sectorNext)
+	{
+		if (flag)
+		{
+			if (b->m_flags & b2Body::e_streamedFlag)
+			{
+				b->SetActive(true);
+				m_flags |= e_newFixture;
+			}
+		}
+		else if (b->IsActive())
+		{
+			b->SetActive(false);
+			b->m_flags |= b2Body::e_streamedFlag;
+		}
+	}
+}
+
+void b2World::StreamBody(b2Body* b, bool checkSize)
+{
+	if (checkSize && b->m_fixtureList)
+	{
+		b2AABB aabb;
+		aabb.lowerBound.Set(b2_maxFloat, b2_maxFloat);
+		aabb.upperBound.Set(-b2_maxFloat, -b2_maxFloat);
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			int32 childCount = f->m_shape->GetChildCount();
+			for (int32 i = 0; i < childCount; ++i)
+			{
+				b2AABB childAABB;
+				f->m_shape->ComputeAABB(&childAABB, b->Transform(), i);
+				aabb.Combine(childAABB);
+			}
+		}
+
+		// A body larger than a sector would vanish while still in range, so it
+		// is never streamed.
+		b2Vec2 extents = aabb.upperBound - aabb.lowerBound;
+		float32 size = m_sectors.m_sectorSize;
+		if (extents.x > size || extents.y > size)
+		{
+			m_sectors.RemoveBody(b);
+			if (b->m_flags & b2Body::e_streamedFlag)
+			{
+				b->SetActive(true);
+				m_flags |= e_newFixture;
+			}
+			return;
+		}
+	}
+
+	int32 x, y;
+	m_sectors.GetKey(b->Transform().p, &x, &y);
+
+	int32 index = b->m_sector;
+	if (index == b2_nullSector || m_sectors.m_sectors[index].x != x || m_sectors.m_sectors[index].y != y)
+	{
+		index = m_sectors.Find(x, y);
+		if (index == b2_nullSector)
+		{
+			index = m_sectors.Create(x, y);
+			if (m_sectors.GetDistanceSquared(index, m_streamingFocus) <= m_streamingRadius * m_streamingRadius)
+			{
+				m_sectors.SetActive(index, true);
+			}
+		}
+
+		m_sectors.RemoveBody(b);
+		m_sectors.AddBody(index, b);
+	}
+
+	// Match the body to its sector.
+	bool active = m_sectors.m_sectors[index].activeIndex != -1;
+	if (active && (b->m_flags & b2Body::e_streamedFlag))
+	{
+		b->SetActive(true);
+		m_flags |= e_newFixture;
+	}
+	else if (active == false && b->IsActive())
+	{
+		b->SetActive(false);
+		b->m_flags |= b2Body::e_streamedFlag;
+	}
+}
+
+void b2World::UpdateSectors()
+{
+	if (m_streamingRadius == 0.0f)
+	{
+		m_flags &= ~e_newSector;
+		return;
+	}
+
+	b2ProfileScope scope(m_profiler, "sectors");
+
+	if (m_flags & e_newSector)
+	{
+		for (b2Body* b = m_bodyList; b; b = b->m_next)
+		{
+			StreamBody(b, true);
+		}
+		m_flags &= ~e_newSector;
+	}
+	else
+	{
+		// Only the awake bodies of active sectors can have moved.
+		for (int32 i = 0; i < m_sectors.m_activeCount; ++i)
+		{
+			b2Body* b = m_sectors.m_sectors[m_sectors.m_activeSectors[i]].bodyList;
+			while (b)
+			{
+				b2Body* next = b->m_sectorNext;
+				if (b->m_type != b2_staticBody && b->IsAwake())
+				{
+					StreamBody(b, false);
+				}
+				b = next;
+			}
+		}
+	}
+
+	float32 radius = m_streamingRadius;
+	float32 radiusSquared = radius * radius;
+
+	// Activate the sectors in range. Look them up by grid coordinates unless
+	// there are fewer sectors than grid cells in range.
+	int32 x0, y0, x1, y1;
+	m_sectors.GetKey(m_streamingFocus - b2Vec2(radius, radius), &x0, &y0);
+	m_sectors.GetKey(m_streamingFocus + b2Vec2(radius, radius), &x1, &y1);
+	float32 cellCount = float32(x1 - x0 + 1) * float32(y1 - y0 + 1);
+	if (cellCount <= float32(m_sectors.m_sectorCount))
+	{
+		for (int32 y = y0; y <= y1; ++y)
+		{
+			for (int32 x = x0; x <= x1; ++x)
+			{
+				int32 index = m_sectors.Find(x, y);
+				if (index != b2_nullSector && m_sectors.m_sectors[index].activeIndex == -1 &&
+					m_sectors.GetDistanceSquared(index, m_streamingFocus) <= radiusSquared)
+				{
+					SetSectorActive(index, true);
+				}
+			}
+		}
+	}
+	else
+	{
+		for (int32 index = 0; index < m_sectors.m_sectorCount; ++index)
+		{
+			if (m_sectors.m_sectors[index].activeIndex == -1 &&
+				m_sectors.GetDistanceSquared(index, m_streamingFocus) <= radiusSquared)
+			{
+				SetSectorActive(index, true);
+			}
+		}
+	}
+
+	// Deactivate the sectors out of range. Half a sector of slack keeps a focus
+	// near the radius from toggling a sector every step. Removal swaps the last
+	// active sector in, which was already visited.
+	float32 outer = radius + 0.5f * m_sectors.m_sectorSize;
+	for (int32 i = m_sectors.m_activeCount - 1; i >= 0; --i)
+	{
+		int32 index = m_sectors.m_activeSectors[i];
+		if (m_sectors.GetDistanceSquared(index, m_streamingFocus) > outer * outer)
+		{
+			SetSectorActive(index, false);
+		}
+	}
+}
+
+void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIterations)
+{
+	b2ProfileScope stepScope(m_profiler, "step");
+	b2Timer stepTimer;
+
+	// This may activate bodies, so do it before looking for new contacts.
+	UpdateSectors();
+
+	// If new fixtures were added, we need to find the new contacts.
+	if (m_flags & e_newFixture)
 	{
 		m_contactManager.FindNewContacts();
 		m_flags &= ~e_newFixture;
@@ -907,6 +1918,13 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 
 	m_flags |= e_locked;
 
+	// Record the events of this step only.
+	if (m_contactEvents)
+	{
+		m_contactEvents->Clear();
+	}
+	m_contactManager.m_contactEvents = m_contactEvents;
+
 	b2TimeStep step;
 	step.dt = dt;
 	step.velocityIterations	= velocityIterations;
@@ -923,17 +1941,25 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 	step.dtRatio = m_inv_dt0 * dt;
 
 	step.warmStarting = m_warmStarting;
+	step.simdContactSolver = m_simdContactSolver;
+	step.batchedJoints = m_batchedJoints;
+	step.speculativeContacts = m_speculativeContacts;
 	
 	// Update contacts. This is where some contacts are destroyed.
 	{
+		m_contactManager.m_speculativeTime = m_speculativeContacts ? dt : 0.0f;
+		b2ProfileScope scope(m_profiler, "collide");
 		b2Timer timer;
 		m_contactManager.Collide();
 		m_profile.collide = timer.GetMilliseconds();
+		m_profile.polygonCacheHits = m_contactManager.m_polygonCacheHits;
+		m_profile.polygonCacheMisses = m_contactManager.m_polygonCacheMisses;
 	}
 
 	// Integrate velocities, solve velocity constraints, and integrate positions.
 	if (m_stepComplete && step.dt > 0.0f)
 	{
+		b2ProfileScope scope(m_profiler, "solve");
 		b2Timer timer;
 		Solve(step);
 		m_profile.solve = timer.GetMilliseconds();
@@ -942,11 +1968,22 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 	// Handle TOI events.
 	if (m_continuousPhysics && step.dt > 0.0f)
 	{
+		b2ProfileScope scope(m_profiler, "solveTOI");
 		b2Timer timer;
 		SolveTOI(step);
 		m_profile.solveTOI = timer.GetMilliseconds();
 	}
 
+	// Move the particles against the new body positions.
+	if (m_particleSystemList && step.dt > 0.0f)
+	{
+		b2ProfileScope scope(m_profiler, "particles");
+		for (b2ParticleSystem* ps = m_particleSystemList; ps; ps = ps->m_next)
+		{
+			ps->Solve(step);
+		}
+	}
+
 	if (step.dt > 0.0f)
 	{
 		m_inv_dt0 = step.inv_dt;
@@ -957,17 +1994,27 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 		ClearForces();
 	}
 
+	m_contactManager.m_contactEvents = NULL;
 	m_flags &= ~e_locked;
 
 	m_profile.step = stepTimer.GetMilliseconds();
+
+	if (m_checksumListener)
+	{
+		m_checksumListener->ReportChecksum(GetChecksum());
+	}
 }
 
 void b2World::ClearForces()
 {
-	for (b2Body* body = m_bodyList; body; body = body->GetNext())
+	// Free entries have no force, so the whole arrays can be cleared.
+	int32 count = m_bodyStates.GetCount();
+	b2Vec2* forces = m_bodyStates.m_forces;
+	float32* torques = m_bodyStates.m_torques;
+	for (int32 i = 0; i < count; ++i)
 	{
-		body->m_force.SetZero();
-		body->m_torque = 0.0f;
+		forces[i].SetZero();
+		torques[i] = 0.0f;
 	}
 }
 
@@ -1028,6 +2075,192 @@ void b2World::RayCast(b2RayCastCallback* callback, const b2Vec2& point1, const b
 	m_contactManager.m_broadPhase.RayCast(&wrapper, input);
 }
 
+static inline bool b2TestQueryFilter(const b2QueryFilter& filter, const b2Fixture* fixture)
+{
+	if (filter.ignoreSensors && fixture->IsSensor())
+	{
+		return false;
+	}
+
+	return (fixture->GetFilterData().categoryBits & filter.maskBits) != 0;
+}
+
+struct b2WorldQueryBatchWrapper
+{
+	bool QueryCallback(int32 index, int32 proxyId)
+	{
+		b2FixtureProxy* proxy = (b2FixtureProxy*)broadPhase->GetUserData(proxyId);
+		b2Fixture* fixture = proxy->fixture;
+		if (b2TestQueryFilter(*filter, fixture))
+		{
+			int32 n = counts[index]++;
+			if (n < maxFixtures)
+			{
+				fixtures[index * maxFixtures + n] = fixture;
+			}
+		}
+		return true;
+	}
+
+	const b2BroadPhase* broadPhase;
+	const b2QueryFilter* filter;
+	b2Fixture** fixtures;
+	int32 maxFixtures;
+	int32* counts;
+};
+
+// Each work item is one group of AABBs that share a walk of the trees.
+struct b2QueryAABBsTask : public b2ParallelTask
+{
+	void Execute(int32 index, int32 threadIndex)
+	{
+		B2_NOT_USED(threadIndex);
+
+		int32 first = index * b2_simdWidth;
+		int32 n = b2Min(count - first, int32(b2_simdWidth));
+
+		b2WorldQueryBatchWrapper wrapper;
+		wrapper.broadPhase = broadPhase;
+		wrapper.filter = filter;
+		wrapper.fixtures = fixtures + first * maxFixtures;
+		wrapper.maxFixtures = maxFixtures;
+		wrapper.counts = counts + first;
+
+		for (int32 i = 0; i < n; ++i)
+		{
+			wrapper.counts[i] = 0;
+		}
+
+		broadPhase->QueryBatch(&wrapper, aabbs + first, n);
+	}
+
+	const b2BroadPhase* broadPhase;
+	const b2QueryFilter* filter;
+	const b2AABB* aabbs;
+	int32 count;
+	b2Fixture** fixtures;
+	int32 maxFixtures;
+	int32* counts;
+};
+
+void b2World::QueryAABBs(const b2AABB* aabbs, int32 count, const b2QueryFilter& filter,
+						 b2Fixture** fixtures, int32 maxFixtures, int32* counts) const
+{
+	b2QueryAABBsTask task;
+	task.broadPhase = &m_contactManager.m_broadPhase;
+	task.filter = &filter;
+	task.aabbs = aabbs;
+	task.count = count;
+	task.fixtures = fixtures;
+	task.maxFixtures = maxFixtures;
+	task.counts = counts;
+
+	int32 groupCount = (count + b2_simdWidth - 1) / b2_simdWidth;
+	if (m_threadPool)
+	{
+		m_threadPool->Run(&task, groupCount);
+	}
+	else
+	{
+		for (int32 i = 0; i < groupCount; ++i)
+		{
+			task.Execute(i, 0);
+		}
+	}
+}
+
+// Keeps the closest hit that passes the filter.
+struct b2WorldRayCastClosestWrapper
+{
+	float32 RayCastCallback(const b2RayCastInput& input, int32 proxyId)
+	{
+		b2FixtureProxy* proxy = (b2FixtureProxy*)broadPhase->GetUserData(proxyId);
+		b2Fixture* fixture = proxy->fixture;
+		if (b2TestQueryFilter(*filter, fixture) == false)
+		{
+			return -1.0f;
+		}
+
+		b2RayCastOutput output;
+		bool hit = fixture->RayCast(&output, input, proxy->childIndex);
+		if (hit == false)
+		{
+			return input.maxFraction;
+		}
+
+		float32 fraction = output.fraction;
+		closest->fixture = fixture;
+		closest->point = (1.0f - fraction) * input.p1 + fraction * input.p2;
+		closest->normal = output.normal;
+		closest->fraction = fraction;
+		return fraction;
+	}
+
+	const b2BroadPhase* broadPhase;
+	const b2QueryFilter* filter;
+	b2RayCastHit* closest;
+};
+
+// Rays are handed to the pool threads in groups of this size.
+#define b2_rayCastGroupSize	16
+
+struct b2RayCastsTask : public b2ParallelTask
+{
+	void Execute(int32 index, int32 threadIndex)
+	{
+		B2_NOT_USED(threadIndex);
+
+		int32 first = index * b2_rayCastGroupSize;
+		int32 last = b2Min(first + b2_rayCastGroupSize, count);
+
+		b2WorldRayCastClosestWrapper wrapper;
+		wrapper.broadPhase = broadPhase;
+		wrapper.filter = filter;
+
+		for (int32 i = first; i < last; ++i)
+		{
+			b2RayCastHit* hit = hits + i;
+			hit->fixture = NULL;
+			hit->point.SetZero();
+			hit->normal.SetZero();
+			hit->fraction = rays[i].maxFraction;
+
+			wrapper.closest = hit;
+			broadPhase->RayCast(&wrapper, rays[i]);
+		}
+	}
+
+	const b2BroadPhase* broadPhase;
+	const b2QueryFilter* filter;
+	const b2RayCastInput* rays;
+	int32 count;
+	b2RayCastHit* hits;
+};
+
+void b2World::RayCasts(const b2RayCastInput* rays, int32 count, const b2QueryFilter& filter,
+					   b2RayCastHit* hits) const
+{
+	b2RayCastsTask task;
+	task.broadPhase = &m_contactManager.m_broadPhase;
+	task.filter = &filter;
+	task.rays = rays;
+	task.count = count;
+	task.hits = hits;
+
+	int32 groupCount = (count + b2_rayCastGroupSize - 1) / b2_rayCastGroupSize;
+	if (m_threadPool)
+	{
+		m_threadPool->Run(&task, groupCount);
+	}
+	else
+	{
+		for (int32 i = 0; i < groupCount; ++i)
+		{
+			task.Execute(i, 0);
+		}
+	}
+}
+
 void b2World::DrawShape(b2Fixture* fixture, const b2Transform& xf, const b2Color& color)
 {
 	switch (fixture->GetType())
@@ -1170,6 +2403,11 @@ void b2World::DrawDebugData()
 				}
 			}
 		}
+
+		for (b2ParticleSystem* ps = m_particleSystemList; ps; ps = ps->m_next)
+		{
+			ps->Draw(m_debugDraw);
+		}
 	}
 
 	if (flags & b2Draw::e_jointBit)
@@ -1256,6 +2494,770 @@ float32 b2World::GetTreeQuality() const
 	return m_contactManager.m_broadPhase.GetTreeQuality();
 }
 
+uint64 b2World::GetChecksum() const
+{
+	// 64-bit FNV-1a over the raw bits, so even a sign of zero counts.
+	uint64 hash = 14695981039346656037ULL;
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		const uint8* bytes = (const uint8*)&b->Transform();
+		for (size_t i = 0; i < sizeof(b2Transform); ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ULL;
+		}
+	}
+
+	return hash;
+}
+
+// Snapshot layout, in order: header, world, bodies each followed by its fixtures,
+// the joint table, the joints, contacts, the contact edges of each body, islands
+// and the broad-phase. Bodies and joints are stored field by field under their
+// address, fixtures as their bytes. Contacts and islands are stored by value and
+// rebuilt on restore.
+#define b2_snapshotMagic	0x62325331	// b2S1
+
+struct b2SnapshotHeader
+{
+	uint32 magic;
+	int32 fixtureSize;
+	int32 bodyCount;
+	int32 fixtureCount;
+	int32 jointCount;
+	int32 contactCount;
+	int32 islandCount;
+};
+
+struct b2SnapshotBody
+{
+	b2Body* prev;
+	b2Body* next;
+	b2Fixture* fixtureList;
+	int32 fixtureCount;
+	b2JointEdge* jointList;
+	b2BodyType type;
+	uint16 flags;
+	float32 mass;
+	float32 I;
+	float32 linearDamping;
+	float32 angularDamping;
+	float32 gravityScale;
+	float32 sleepTime;
+	void* userData;
+
+	// The hot state from the world arrays.
+	b2Transform xf;
+	b2Sweep sweep;
+	b2Vec2 linearVelocity;
+	float32 angularVelocity;
+	b2Vec2 force;
+	float32 torque;
+	float32 invMass;
+	float32 invI;
+};
+
+// The joint table is written before the joints so the joints can be validated
+// without knowing the size of each joint.
+struct b2SnapshotJoint
+{
+	b2Joint* joint;
+	b2JointType type;
+};
+
+struct b2SnapshotContact
+{
+	b2Fixture* fixtureA;
+	b2Fixture* fixtureB;
+	int32 indexA;
+	int32 indexB;
+	uint32 flags;
+	b2Manifold manifold;
+	int32 toiCount;
+	float32 toi;
+	float32 friction;
+	float32 restitution;
+};
+
+struct b2SnapshotIsland
+{
+	int32 parent;
+	int32 bodyCount;
+	int32 contactCount;
+	int32 jointCount;
+	int32 constraintRemoveCount;
+	bool awake;
+};
+
+// Maps addresses to snapshot indices.
+struct b2SnapshotIndex
+{
+	const void* pointer;
+	int32 index;
+};
+
+inline bool b2SnapshotIndexLessThan(const b2SnapshotIndex& a, const b2SnapshotIndex& b)
+{
+	return a.pointer < b.pointer;
+}
+
+static int32 b2FindSnapshotIndex(const b2SnapshotIndex* map, int32 count, const void* pointer)
+{
+	if (pointer == NULL)
+	{
+		return b2_nullNode;
+	}
+
+	b2SnapshotIndex key;
+	key.pointer = pointer;
+	key.index = b2_nullNode;
+	const b2SnapshotIndex* entry = std::lower_bound(map, map + count, key, b2SnapshotIndexLessThan);
+	b2Assert(entry < map + count && entry->pointer == pointer);
+	return entry->index;
+}
+
+static bool b2ContainsPointer(const void** pointers, int32 count, const void* pointer)
+{
+	return std::binary_search(pointers, pointers + count, pointer);
+}
+
+void b2World::Snapshot(b2Snapshot* snapshot)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	snapshot->Clear();
+
+	b2SnapshotHeader header;
+	header.magic = b2_snapshotMagic;
+	header.fixtureSize = sizeof(b2Fixture);
+	header.bodyCount = m_bodyCount;
+	header.fixtureCount = 0;
+	header.jointCount = m_jointCount;
+	header.contactCount = m_contactManager.m_contactCount;
+	header.islandCount = m_islandManager.m_islandCount;
+
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		header.fixtureCount += b->m_fixtureCount;
+	}
+
+	snapshot->Write(header);
+
+	uint16 flags = m_flags & ~e_locked;
+	snapshot->Write(flags);
+	snapshot->Write(m_gravity);
+	snapshot->Write(m_allowSleep);
+	snapshot->Write(m_inv_dt0);
+	snapshot->Write(m_stepComplete);
+
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		b2SnapshotBody body;
+		body.prev = b->m_prev;
+		body.next = b->m_next;
+		body.fixtureList = b->m_fixtureList;
+		body.fixtureCount = b->m_fixtureCount;
+		body.jointList = b->m_jointList;
+		body.type = b->m_type;
+		body.flags = b->m_flags;
+		body.mass = b->m_mass;
+		body.I = b->m_I;
+		body.linearDamping = b->m_linearDamping;
+		body.angularDamping = b->m_angularDamping;
+		body.gravityScale = b->m_gravityScale;
+		body.sleepTime = b->m_sleepTime;
+		body.userData = b->m_userData;
+		body.xf = b->Transform();
+		body.sweep = b->Sweep();
+		body.linearVelocity = b->LinearVelocity();
+		body.angularVelocity = b->AngularVelocity();
+		body.force = b->Force();
+		body.torque = b->Torque();
+		body.invMass = b->InvMass();
+		body.invI = b->InvI();
+
+		snapshot->Write(b);
+		snapshot->Write(body);
+
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			int32 childCount = f->m_shape->GetChildCount();
+			snapshot->Write(f);
+			snapshot->Write(f, sizeof(b2Fixture));
+			snapshot->Write(childCount);
+			snapshot->Write(f->m_proxies, childCount * sizeof(b2FixtureProxy));
+		}
+	}
+
+	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		b2SnapshotJoint joint;
+		joint.joint = j;
+		joint.type = j->m_type;
+		snapshot->Write(joint);
+	}
+
+	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		j->WriteSnapshot(snapshot);
+	}
+
+	int32 contactCount = m_contactManager.m_contactCount;
+	int32 islandCount = m_islandManager.m_islandCount;
+	b2SnapshotIndex* contactMap = (b2SnapshotIndex*)m_stackAllocator.Allocate(contactCount * sizeof(b2SnapshotIndex));
+	b2SnapshotIndex* islandMap = (b2SnapshotIndex*)m_stackAllocator.Allocate(islandCount * sizeof(b2SnapshotIndex));
+
+	int32 index = 0;
+	for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+	{
+		b2SnapshotContact contact;
+		contact.fixtureA = c->m_fixtureA;
+		contact.fixtureB = c->m_fixtureB;
+		contact.indexA = c->m_indexA;
+		contact.indexB = c->m_indexB;
+		contact.flags = c->m_flags;
+		contact.manifold = c->m_manifold;
+		contact.toiCount = c->m_toiCount;
+		contact.toi = c->m_toi;
+		contact.friction = c->m_friction;
+		contact.restitution = c->m_restitution;
+		snapshot->Write(contact);
+
+		contactMap[index].pointer = c;
+		contactMap[index].index = index;
+		++index;
+	}
+	std::sort(contactMap, contactMap + contactCount, b2SnapshotIndexLessThan);
+
+	// The contact edges are stored as 2 * contact index + 1 for the edge of body B.
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		int32 edgeCount = 0;
+		for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
+		{
+			++edgeCount;
+		}
+
+		snapshot->Write(edgeCount);
+		for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
+		{
+			int32 edge = 2 * b2FindSnapshotIndex(contactMap, contactCount, ce->contact);
+			if (ce == &ce->contact->m_nodeB)
+			{
+				edge += 1;
+			}
+
+			snapshot->Write(edge);
+		}
+	}
+
+	// Awake islands first, then the sleeping ones.
+	index = 0;
+	for (int32 list = 0; list < 2; ++list)
+	{
+		for (b2PersistentIsland* pi = list == 0 ? m_islandManager.m_awakeList : m_islandManager.m_sleepingList; pi; pi = pi->next)
+		{
+			islandMap[index].pointer = pi;
+			islandMap[index].index = index;
+			++index;
+		}
+	}
+	b2Assert(index == islandCount);
+	std::sort(islandMap, islandMap + islandCount, b2SnapshotIndexLessThan);
+
+	for (int32 list = 0; list < 2; ++list)
+	{
+		for (b2PersistentIsland* pi = list == 0 ? m_islandManager.m_awakeList : m_islandManager.m_sleepingList; pi; pi = pi->next)
+		{
+			b2SnapshotIsland island;
+			island.parent = b2FindSnapshotIndex(islandMap, islandCount, pi->parent);
+			island.bodyCount = pi->bodyCount;
+			island.contactCount = pi->contactCount;
+			island.jointCount = pi->jointCount;
+			island.constraintRemoveCount = pi->constraintRemoveCount;
+			island.awake = pi->awake;
+			snapshot->Write(island);
+
+			for (b2Body* b = pi->bodyList; b; b = b->m_islandNext)
+			{
+				snapshot->Write(b);
+			}
+
+			for (b2Contact* c = pi->contactList; c; c = c->m_islandNext)
+			{
+				snapshot->Write(b2FindSnapshotIndex(contactMap, contactCount, c));
+			}
+
+			for (b2Joint* j = pi->jointList; j; j = j->m_islandNext)
+			{
+				snapshot->Write(j);
+			}
+		}
+	}
+
+	m_stackAllocator.Free(islandMap);
+	m_stackAllocator.Free(contactMap);
+
+	m_contactManager.m_broadPhase.Save(snapshot);
+}
+
+bool b2World::Restore(const b2Snapshot* snapshot)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return false;
+	}
+
+	snapshot->BeginRead();
+
+	b2SnapshotHeader header;
+	snapshot->Read(&header);
+	b2Assert(header.magic == b2_snapshotMagic);
+	b2Assert(header.fixtureSize == sizeof(b2Fixture));
+
+	// Collect the current objects to check that the snapshot objects still exist.
+	int32 fixtureCount = 0;
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		fixtureCount += b->m_fixtureCount;
+	}
+
+	const void** bodies = (const void**)m_stackAllocator.Allocate(m_bodyCount * sizeof(void*));
+	const void** fixtures = (const void**)m_stackAllocator.Allocate(fixtureCount * sizeof(void*));
+	const void** joints = (const void**)m_stackAllocator.Allocate(m_jointCount * sizeof(void*));
+	const void** snapshotBodies = (const void**)m_stackAllocator.Allocate(header.bodyCount * sizeof(void*));
+	const void** snapshotFixtures = (const void**)m_stackAllocator.Allocate(header.fixtureCount * sizeof(void*));
+	const void** snapshotJoints = (const void**)m_stackAllocator.Allocate(header.jointCount * sizeof(void*));
+
+	int32 bodyCount = 0;
+	fixtureCount = 0;
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		bodies[bodyCount++] = b;
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			fixtures[fixtureCount++] = f;
+		}
+	}
+
+	int32 jointCount = 0;
+	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		joints[jointCount++] = j;
+	}
+
+	std::sort(bodies, bodies + bodyCount);
+	std::sort(fixtures, fixtures + fixtureCount);
+	std::sort(joints, joints + jointCount);
+
+	uint16 flags;
+	bool allowSleep, stepComplete;
+	b2Vec2 gravity;
+	float32 inv_dt0;
+	snapshot->Read(&flags);
+	snapshot->Read(&gravity);
+	snapshot->Read(&allowSleep);
+	snapshot->Read(&inv_dt0);
+	snapshot->Read(&stepComplete);
+
+	bool valid = true;
+	int32 snapshotFixtureCount = 0;
+	for (int32 i = 0; i < header.bodyCount; ++i)
+	{
+		b2Body* b;
+		b2SnapshotBody body;
+		snapshot->Read(&b);
+		snapshot->Read(&body);
+		snapshotBodies[i] = b;
+		valid = valid && b2ContainsPointer(bodies, bodyCount, b);
+
+		for (int32 k = 0; k < body.fixtureCount; ++k)
+		{
+			b2Fixture* f;
+			int32 childCount;
+			snapshot->Read(&f);
+			snapshot->Read(sizeof(b2Fixture));
+			snapshot->Read(&childCount);
+			snapshot->Read(childCount * sizeof(b2FixtureProxy));
+			snapshotFixtures[snapshotFixtureCount++] = f;
+			valid = valid && b2ContainsPointer(fixtures, fixtureCount, f);
+		}
+	}
+	b2Assert(snapshotFixtureCount == header.fixtureCount);
+
+	for (int32 i = 0; i < header.jointCount; ++i)
+	{
+		b2SnapshotJoint joint;
+		snapshot->Read(&joint);
+		snapshotJoints[i] = joint.joint;
+		valid = valid && b2ContainsPointer(joints, jointCount, joint.joint) && joint.joint->m_type == joint.type;
+	}
+
+	if (valid == false)
+	{
+		m_stackAllocator.Free(snapshotJoints);
+		m_stackAllocator.Free(snapshotFixtures);
+		m_stackAllocator.Free(snapshotBodies);
+		m_stackAllocator.Free(joints);
+		m_stackAllocator.Free(fixtures);
+		m_stackAllocator.Free(bodies);
+		return false;
+	}
+
+	std::sort(snapshotBodies, snapshotBodies + header.bodyCount);
+	std::sort(snapshotFixtures, snapshotFixtures + header.fixtureCount);
+	std::sort(snapshotJoints, snapshotJoints + header.jointCount);
+
+	// The contacts and islands are rebuilt from the snapshot. Destroy them
+	// without waking the bodies.
+	b2Contact* c = m_contactManager.m_contactList;
+	while (c)
+	{
+		b2Contact* next = c->m_next;
+		b2Shape::Type typeA = c->m_fixtureA->GetType();
+		b2Shape::Type typeB = c->m_fixtureB->GetType();
+		b2Contact::s_registers[typeA][typeB].destroyFcn(c, &m_blockAllocator);
+		c = next;
+	}
+	m_contactManager.m_contactList = NULL;
+	m_contactManager.m_contactCount = 0;
+
+	for (int32 list = 0; list < 2; ++list)
+	{
+		b2PersistentIsland* pi = list == 0 ? m_islandManager.m_awakeList : m_islandManager.m_sleepingList;
+		while (pi)
+		{
+			b2PersistentIsland* next = pi->next;
+			m_blockAllocator.Free(pi, sizeof(b2PersistentIsland));
+			pi = next;
+		}
+	}
+	m_islandManager.m_awakeList = NULL;
+	m_islandManager.m_sleepingList = NULL;
+	m_islandManager.m_islandCount = 0;
+
+	// Destroy the joints, fixtures and bodies created after the snapshot. Their
+	// broad-phase proxies are dropped by the broad-phase restore.
+	b2Joint* j = m_jointList;
+	while (j)
+	{
+		b2Joint* next = j->m_next;
+		if (b2ContainsPointer(snapshotJoints, header.jointCount, j) == false)
+		{
+			b2Joint::Destroy(j, &m_blockAllocator);
+		}
+		j = next;
+	}
+
+	b2Body* b = m_bodyList;
+	while (b)
+	{
+		b2Body* nextBody = b->m_next;
+		bool keepBody = b2ContainsPointer(snapshotBodies, header.bodyCount, b);
+
+		b2Fixture* f = b->m_fixtureList;
+		while (f)
+		{
+			b2Fixture* nextFixture = f->m_next;
+			if (keepBody == false || b2ContainsPointer(snapshotFixtures, header.fixtureCount, f) == false)
+			{
+				f->m_proxyCount = 0;
+				f->Destroy(&m_blockAllocator);
+				f->~b2Fixture();
+				m_blockAllocator.Free(f, sizeof(b2Fixture));
+			}
+			f = nextFixture;
+		}
+
+		if (keepBody == false)
+		{
+			b->~b2Body();
+			m_blockAllocator.Free(b, sizeof(b2Body));
+		}
+
+		b = nextBody;
+	}
+
+	// Copy the state back. The fields hold the list pointers of the snapshot.
+	snapshot->BeginRead();
+	snapshot->Read(&header);
+	snapshot->Read(&flags);
+	snapshot->Read(&m_gravity);
+	snapshot->Read(&m_allowSleep);
+	snapshot->Read(&m_inv_dt0);
+	snapshot->Read(&m_stepComplete);
+	m_flags = flags;
+
+	m_bodyList = NULL;
+	for (int32 i = 0; i < header.bodyCount; ++i)
+	{
+		b2SnapshotBody body;
+		snapshot->Read(&b);
+		snapshot->Read(&body);
+		b->m_prev = body.prev;
+		b->m_next = body.next;
+		b->m_fixtureList = body.fixtureList;
+		b->m_fixtureCount = body.fixtureCount;
+		b->m_jointList = body.jointList;
+		b->m_type = body.type;
+		b->m_flags = body.flags;
+		b->m_mass = body.mass;
+		b->m_I = body.I;
+		b->m_linearDamping = body.linearDamping;
+		b->m_angularDamping = body.angularDamping;
+		b->m_gravityScale = body.gravityScale;
+		b->m_sleepTime = body.sleepTime;
+		b->m_userData = body.userData;
+		b->Transform() = body.xf;
+		b->Sweep() = body.sweep;
+		b->LinearVelocity() = body.linearVelocity;
+		b->AngularVelocity() = body.angularVelocity;
+		b->Force() = body.force;
+		b->Torque() = body.torque;
+		b->InvMass() = body.invMass;
+		b->InvI() = body.invI;
+
+		for (int32 k = 0; k < body.fixtureCount; ++k)
+		{
+			b2Fixture* f;
+			int32 childCount;
+			snapshot->Read(&f);
+			memcpy(f, snapshot->Read(sizeof(b2Fixture)), sizeof(b2Fixture));
+			snapshot->Read(&childCount);
+			memcpy(f->m_proxies, snapshot->Read(childCount * sizeof(b2FixtureProxy)), childCount * sizeof(b2FixtureProxy));
+		}
+
+		b->m_contactList = NULL;
+		b->m_island = NULL;
+		b->m_islandPrev = NULL;
+		b->m_islandNext = NULL;
+		b->m_sector = b2_nullSector;
+		b->m_sectorPrev = NULL;
+		b->m_sectorNext = NULL;
+
+		if (m_bodyList == NULL)
+		{
+			m_bodyList = b;
+		}
+	}
+	m_bodyCount = header.bodyCount;
+
+	// The sectors are rebuilt by the next step.
+	m_sectors.Reset(m_sectors.m_sectorSize);
+	m_flags |= e_newSector;
+
+	// The joint pointers are no longer needed sorted, keep them in list order.
+	for (int32 i = 0; i < header.jointCount; ++i)
+	{
+		b2SnapshotJoint joint;
+		snapshot->Read(&joint);
+		snapshotJoints[i] = joint.joint;
+	}
+
+	m_jointList = NULL;
+	for (int32 i = 0; i < header.jointCount; ++i)
+	{
+		j = (b2Joint*)snapshotJoints[i];
+		j->ReadSnapshot(snapshot);
+
+		j->m_island = NULL;
+		j->m_islandPrev = NULL;
+		j->m_islandNext = NULL;
+
+		if (m_jointList == NULL)
+		{
+			m_jointList = j;
+		}
+	}
+	m_jointCount = header.jointCount;
+
+	b2Contact** contacts = (b2Contact**)m_stackAllocator.Allocate(header.contactCount * sizeof(b2Contact*));
+	b2Contact* prevContact = NULL;
+	for (int32 i = 0; i < header.contactCount; ++i)
+	{
+		b2SnapshotContact contact;
+		snapshot->Read(&contact);
+
+		c = b2Contact::Create(contact.fixtureA, contact.indexA, contact.fixtureB, contact.indexB, &m_blockAllocator);
+		b2Assert(c->m_fixtureA == contact.fixtureA);
+		c->m_flags = contact.flags;
+		c->m_manifold = contact.manifold;
+		c->m_toiCount = contact.toiCount;
+		c->m_toi = contact.toi;
+		c->m_friction = contact.friction;
+		c->m_restitution = contact.restitution;
+
+		c->m_prev = prevContact;
+		c->m_next = NULL;
+		if (prevContact)
+		{
+			prevContact->m_next = c;
+		}
+		else
+		{
+			m_contactManager.m_contactList = c;
+		}
+		prevContact = c;
+		contacts[i] = c;
+	}
+	m_contactManager.m_contactCount = header.contactCount;
+
+	for (b = m_bodyList; b; b = b->m_next)
+	{
+		int32 edgeCount;
+		snapshot->Read(&edgeCount);
+
+		b2ContactEdge* prevEdge = NULL;
+		for (int32 i = 0; i < edgeCount; ++i)
+		{
+			int32 edge;
+			snapshot->Read(&edge);
+
+			c = contacts[edge >> 1];
+			b2ContactEdge* ce;
+			if (edge & 1)
+			{
+				ce = &c->m_nodeB;
+				ce->other = c->m_fixtureA->m_body;
+			}
+			else
+			{
+				ce = &c->m_nodeA;
+				ce->other = c->m_fixtureB->m_body;
+			}
+
+			ce->contact = c;
+			ce->prev = prevEdge;
+			ce->next = NULL;
+			if (prevEdge)
+			{
+				prevEdge->next = ce;
+			}
+			else
+			{
+				b->m_contactList = ce;
+			}
+			prevEdge = ce;
+		}
+	}
+
+	b2PersistentIsland** islands = (b2PersistentIsland**)m_stackAllocator.Allocate(header.islandCount * sizeof(b2PersistentIsland*));
+	for (int32 i = 0; i < header.islandCount; ++i)
+	{
+		islands[i] = (b2PersistentIsland*)m_blockAllocator.Allocate(sizeof(b2PersistentIsland));
+	}
+
+	b2PersistentIsland* tails[2] = {NULL, NULL};
+	for (int32 i = 0; i < header.islandCount; ++i)
+	{
+		b2SnapshotIsland island;
+		snapshot->Read(&island);
+
+		b2PersistentIsland* pi = islands[i];
+		pi->parent = island.parent == b2_nullNode ? NULL : islands[island.parent];
+		pi->bodyCount = island.bodyCount;
+		pi->contactCount = island.contactCount;
+		pi->jointCount = island.jointCount;
+		pi->constraintRemoveCount = island.constraintRemoveCount;
+		pi->awake = island.awake;
+
+		int32 list = island.awake ? 0 : 1;
+		pi->prev = tails[list];
+		pi->next = NULL;
+		if (tails[list])
+		{
+			tails[list]->next = pi;
+		}
+		else if (island.awake)
+		{
+			m_islandManager.m_awakeList = pi;
+		}
+		else
+		{
+			m_islandManager.m_sleepingList = pi;
+		}
+		tails[list] = pi;
+
+		pi->bodyList = NULL;
+		b2Body* prevBody = NULL;
+		for (int32 k = 0; k < island.bodyCount; ++k)
+		{
+			snapshot->Read(&b);
+			b->m_island = pi;
+			b->m_islandPrev = prevBody;
+			b->m_islandNext = NULL;
+			if (prevBody)
+			{
+				prevBody->m_islandNext = b;
+			}
+			else
+			{
+				pi->bodyList = b;
+			}
+			prevBody = b;
+		}
+
+		pi->contactList = NULL;
+		prevContact = NULL;
+		for (int32 k = 0; k < island.contactCount; ++k)
+		{
+			int32 index;
+			snapshot->Read(&index);
+			c = contacts[index];
+			c->m_island = pi;
+			c->m_islandPrev = prevContact;
+			c->m_islandNext = NULL;
+			if (prevContact)
+			{
+				prevContact->m_islandNext = c;
+			}
+			else
+			{
+				pi->contactList = c;
+			}
+			prevContact = c;
+		}
+
+		pi->jointList = NULL;
+		b2Joint* prevJoint = NULL;
+		for (int32 k = 0; k < island.jointCount; ++k)
+		{
+			snapshot->Read(&j);
+			j->m_island = pi;
+			j->m_islandPrev = prevJoint;
+			j->m_islandNext = NULL;
+			if (prevJoint)
+			{
+				prevJoint->m_islandNext = j;
+			}
+			else
+			{
+				pi->jointList = j;
+			}
+			prevJoint = j;
+		}
+	}
+	m_islandManager.m_islandCount = header.islandCount;
+
+	m_contactManager.m_broadPhase.Restore(snapshot);
+
+	m_stackAllocator.Free(islands);
+	m_stackAllocator.Free(contacts);
+	m_stackAllocator.Free(snapshotJoints);
+	m_stackAllocator.Free(snapshotFixtures);
+	m_stackAllocator.Free(snapshotBodies);
+	m_stackAllocator.Free(joints);
+	m_stackAllocator.Free(fixtures);
+	m_stackAllocator.Free(bodies);
+
+	return true;
+}
+
 void b2World::Dump()
 {
 	if ((m_flags & e_locked) == e_locked)
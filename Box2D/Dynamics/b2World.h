@@ -22,18 +22,57 @@
 #include <Box2D/Common/b2Math.h>
 #include <Box2D/Common/b2BlockAllocator.h>
 #include <Box2D/Common/b2StackAllocator.h>
+#include <Box2D/Common/b2ThreadAllocator.h>
+#include <Box2D/Dynamics/b2BodyStates.h>
 #include <Box2D/Dynamics/b2ContactManager.h>
+#include <Box2D/Dynamics/b2IslandManager.h>
+#include <Box2D/Dynamics/b2Sectors.h>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
 
 struct b2AABB;
 struct b2BodyDef;
 struct b2Color;
+struct b2FixtureDef;
 struct b2JointDef;
+struct b2ParticleSystemDef;
 class b2Body;
+class b2ContactEvents;
 class b2Draw;
 class b2Fixture;
 class b2Joint;
+class b2ParticleSystem;
+class b2ThreadPool;
+class b2Profiler;
+class b2Snapshot;
+struct b2TOIInput;
+struct b2TOIScheduler;
+struct b2RayCastInput;
+
+/// Selects the fixtures reported by the batch queries of b2World.
+struct b2QueryFilter
+{
+	b2QueryFilter()
+	{
+		maskBits = 0xFFFF;
+		ignoreSensors = true;
+	}
+
+	/// A fixture is reported if its category bits overlap these.
+	uint16 maskBits;
+
+	/// Skip sensor fixtures.
+	bool ignoreSensors;
+};
+
+/// The closest hit of a ray, see b2World::RayCasts.
+struct b2RayCastHit
+{
+	b2Fixture* fixture;	///< the fixture hit, NULL if the ray hit nothing
+	b2Vec2 point;		///< the point of initial intersection
+	b2Vec2 normal;		///< the surface normal at the point
+	float32 fraction;	///< the fraction along the ray
+};
 
 /// The world class manages all physics entities, dynamic simulation,
 /// and asynchronous queries. The world also contains efficient memory
@@ -43,7 +82,8 @@ class b2World
 public:
 	/// Construct a world object.
 	/// @param gravity the world gravity vector.
-	b2World(const b2Vec2& gravity);
+	/// @param treeType the tree used by the broad-phase.
+	b2World(const b2Vec2& gravity, b2BroadPhaseTree treeType = b2_binaryTree);
 
 	/// Destruct the world. All physics entities are destroyed and all heap memory is released.
 	~b2World();
@@ -61,16 +101,63 @@ public:
 	/// remain in scope.
 	void SetContactListener(b2ContactListener* listener);
 
+	/// Register buffers that receive the begin, end and solve events of each step.
+	/// Step clears them when it begins, so read them after Step returns. These work
+	/// next to the contact listener; set the listener to NULL to skip its virtual
+	/// calls entirely. The buffers are owned by you and must remain in scope.
+	/// Pass NULL to stop recording.
+	void SetContactEvents(b2ContactEvents* events);
+
+	/// Get the registered contact event buffers, if any.
+	b2ContactEvents* GetContactEvents() const { return m_contactEvents; }
+
 	/// Register a routine for debug drawing. The debug draw functions are called
 	/// inside with b2World::DrawDebugData method. The debug draw object is owned
 	/// by you and must remain in scope.
 	void SetDebugDraw(b2Draw* debugDraw);
 
+	/// Register a thread pool used to solve islands in parallel. Islands are
+	/// collected first and then solved on the pool threads, each thread with its
+	/// own stack allocator. The results do not depend on the number of threads
+	/// and b2ContactListener::PostSolve is still reported in island order, after
+	/// all islands have been solved. The pool also computes the contact manifolds;
+	/// the contact events and filtering are then still reported in contact list
+	/// order on the calling thread. Pass NULL to do everything on the calling thread.
+	/// The pool is owned by you and must remain in scope.
+	/// @warning This function is locked during callbacks.
+	void SetThreadPool(b2ThreadPool* threadPool);
+
+	/// Get the registered thread pool, if any.
+	b2ThreadPool* GetThreadPool() const { return m_threadPool; }
+
+	/// Record the scopes of each step, per thread and per island, on a profiler.
+	/// The profiler is owned by you and must remain in scope. Pass NULL to stop.
+	void SetProfiler(b2Profiler* profiler);
+
+	/// Get the registered profiler, if any.
+	b2Profiler* GetProfiler() const { return m_profiler; }
+
+	/// Register a listener that receives the world checksum after every step.
+	/// The listener is owned by you and must remain in scope. Pass NULL to stop.
+	void SetChecksumListener(b2ChecksumListener* listener);
+
 	/// Create a rigid body given a definition. No reference to the definition
 	/// is retained.
 	/// @warning This function is locked during callbacks.
 	b2Body* CreateBody(const b2BodyDef* def);
 
+	/// Create many rigid bodies with their fixtures. The mass of each body is
+	/// computed once and all proxies are inserted into the broad-phase in bulk,
+	/// which is faster than CreateBody and CreateFixture for level loads and
+	/// bursts of debris. No reference to the definitions is retained.
+	/// @param bodyDefs the body definitions.
+	/// @param count the number of bodies.
+	/// @param fixtureDefs the fixture definitions of all bodies, in body order.
+	/// @param fixtureCounts the number of fixture definitions of each body.
+	/// @param bodies receives the new bodies, may be NULL.
+	/// @warning This function is locked during callbacks.
+	void CreateBodies(const b2BodyDef* bodyDefs, int32 count, const b2FixtureDef* fixtureDefs, const int32* fixtureCounts, b2Body** bodies = NULL);
+
 	/// Destroy a rigid body given a definition. No reference to the definition
 	/// is retained. This function is locked during callbacks.
 	/// @warning This automatically deletes all associated shapes and joints.
@@ -86,6 +173,14 @@ public:
 	/// @warning This function is locked during callbacks.
 	void DestroyJoint(b2Joint* joint);
 
+	/// Create a particle system. No reference to the definition is retained.
+	/// @warning This function is locked during callbacks.
+	b2ParticleSystem* CreateParticleSystem(const b2ParticleSystemDef* def);
+
+	/// Destroy a particle system and its particles.
+	/// @warning This function is locked during callbacks.
+	void DestroyParticleSystem(b2ParticleSystem* system);
+
 	/// Take a time step. This performs collision detection, integration,
 	/// and constraint solution.
 	/// @param timeStep the amount of time to simulate, this should not vary.
@@ -121,6 +216,22 @@ public:
 	/// @param point2 the ray ending point
 	void RayCast(b2RayCastCallback* callback, const b2Vec2& point1, const b2Vec2& point2) const;
 
+	/// Query the world for the fixtures that potentially overlap each of many AABBs.
+	/// This finds what QueryAABB finds, without a callback. The fixtures of aabbs[i]
+	/// are written to fixtures + i * maxFixtures and their number to counts[i]. If a
+	/// count is larger than maxFixtures, only the first maxFixtures were written.
+	/// The AABBs share tree walks b2_simdWidth at a time, and these groups run on
+	/// the thread pool if there is one.
+	void QueryAABBs(const b2AABB* aabbs, int32 count, const b2QueryFilter& filter,
+					b2Fixture** fixtures, int32 maxFixtures, int32* counts) const;
+
+	/// Ray-cast the world for the closest fixture hit by each of many rays, without
+	/// a callback. Ray i extends from rays[i].p1 to p1 + maxFraction * (p2 - p1) and
+	/// its closest hit is written to hits[i]. The rays run on the thread pool if
+	/// there is one.
+	void RayCasts(const b2RayCastInput* rays, int32 count, const b2QueryFilter& filter,
+				  b2RayCastHit* hits) const;
+
 	/// Get the world body list. With the returned body, use b2Body::GetNext to get
 	/// the next body in the world list. A NULL body indicates the end of the list.
 	/// @return the head of the world body list.
@@ -133,6 +244,11 @@ public:
 	b2Joint* GetJointList();
 	const b2Joint* GetJointList() const;
 
+	/// Get the world particle system list. With the returned system, use
+	/// b2ParticleSystem::GetNext to get the next system in the world list.
+	b2ParticleSystem* GetParticleSystemList() { return m_particleSystemList; }
+	const b2ParticleSystem* GetParticleSystemList() const { return m_particleSystemList; }
+
 	/// Get the world contact list. With the returned contact, use b2Contact::GetNext to get
 	/// the next contact in the world list. A NULL contact indicates the end of the list.
 	/// @return the head of the world contact list.
@@ -153,10 +269,75 @@ public:
 	void SetContinuousPhysics(bool flag) { m_continuousPhysics = flag; }
 	bool GetContinuousPhysics() const { return m_continuousPhysics; }
 
+	/// Enable/disable speculative contacts. Contact points are created for shapes
+	/// that the relative motion over the step could bring together, and the velocity
+	/// solver keeps them from closing the remaining gap. Time of impact events are
+	/// then only solved for bullets, so the step cost stays bounded. Contacts begin
+	/// before the shapes touch; use b2WorldManifold::separations to tell. Speculative
+	/// points do not bounce, so restitution only applies once shapes touch.
+	void SetSpeculativeContacts(bool flag) { m_speculativeContacts = flag; }
+	bool GetSpeculativeContacts() const { return m_speculativeContacts; }
+
 	/// Enable/disable single stepped continuous physics. For testing.
 	void SetSubStepping(bool flag) { m_subStepping = flag; }
 	bool GetSubStepping() const { return m_subStepping; }
 
+	/// Enable/disable batched pair finding in the broad-phase. Moved proxies are
+	/// queried in groups, on the thread pool if there is one, and new contacts are
+	/// created in a different order.
+	void SetBatchedBroadPhase(bool flag) { m_contactManager.m_broadPhase.SetBatchedPairs(flag); }
+	bool GetBatchedBroadPhase() const { return m_contactManager.m_broadPhase.GetBatchedPairs(); }
+
+	/// Enable/disable separate broad-phase trees for static, awake and sleeping
+	/// bodies. The static tree is built in bulk, so this helps levels with a lot
+	/// of static geometry. Existing proxies are recreated.
+	void SetSplitBroadPhase(bool flag);
+	bool GetSplitBroadPhase() const { return m_contactManager.m_broadPhase.GetSplitTrees(); }
+
+	/// Enable/disable the SIMD contact velocity solver. Contacts are batched so that
+	/// several of them are solved at once. The iteration order changes, so results
+	/// differ slightly from the default solver.
+	void SetSimdContactSolver(bool flag) { m_simdContactSolver = flag; }
+	bool GetSimdContactSolver() const { return m_simdContactSolver; }
+
+	/// Enable/disable batched joints. The joints of an island are grouped by type
+	/// and each group is solved with direct calls instead of a virtual call per
+	/// joint. The iteration order changes, so results differ slightly from the
+	/// default solver.
+	void SetBatchedJoints(bool flag) { m_batchedJoints = flag; }
+	bool GetBatchedJoints() const { return m_batchedJoints; }
+
+	/// Shift the world origin. Useful for large worlds. Every body, broad-phase
+	/// proxy and world space joint anchor is moved in one pass.
+	/// The body shift formula is: position -= newOrigin
+	/// @param newOrigin the new origin with respect to the old origin
+	/// @warning This function is locked during callbacks.
+	void ShiftOrigin(const b2Vec2& newOrigin);
+
+	/// Enable/disable sector streaming. The world is cut into square sectors and
+	/// only the bodies in sectors within a radius of the streaming focus are
+	/// active. The bodies of sectors that fall out of range are deactivated, which
+	/// removes their fixtures from the broad-phase, and they are activated again
+	/// when the focus comes back. Sectors are updated at the start of each step.
+	/// A body is in the sector of its origin. Bodies larger than a sector are
+	/// never streamed and bodies deactivated by the user stay inactive.
+	/// @param sectorSize the side length of a sector
+	/// @param radius the streaming radius, zero disables streaming and activates
+	/// the streamed bodies
+	/// @warning This function is locked during callbacks.
+	void SetStreaming(float32 sectorSize, float32 radius);
+	float32 GetStreamingRadius() const { return m_streamingRadius; }
+
+	/// Set the center of the streamed region, usually the player or the camera.
+	void SetStreamingFocus(const b2Vec2& focus) { m_streamingFocus = focus; }
+	const b2Vec2& GetStreamingFocus() const { return m_streamingFocus; }
+
+	/// Get the number of sectors, active and inactive.
+	int32 GetSectorCount() const { return m_sectors.m_sectorCount; }
+
+	/// Get the number of active sectors.
+	int32 GetActiveSectorCount() const { return m_sectors.m_activeCount; }
+
 	/// Get the number of broad-phase proxies.
 	int32 GetProxyCount() const;
 
@@ -169,6 +350,13 @@ public:
 	/// Get the number of contacts (each may have 0 or more contact points).
 	int32 GetContactCount() const;
 
+	/// Get the number of islands, awake and sleeping. Islands persist between
+	/// time steps.
+	int32 GetIslandCount() const;
+
+	/// Get the number of islands that were split and rebuilt in the last time step.
+	int32 GetRebuiltIslandCount() const;
+
 	/// Get the height of the dynamic tree.
 	int32 GetTreeHeight() const;
 
@@ -200,6 +388,48 @@ public:
 	/// Get the current profile.
 	const b2Profile& GetProfile() const;
 
+	/// Hash the transforms of all bodies, in body list order. Two worlds built
+	/// and stepped the same way have the same checksum, bit for bit, when Box2D
+	/// is compiled with B2_DETERMINISTIC on every machine.
+	uint64 GetChecksum() const;
+
+	/// Get the peak usage and the b2Alloc fallbacks of the allocators.
+	b2AllocatorStats GetAllocatorStats() const;
+
+	/// Write the state of the world to a snapshot: the bodies, fixtures and joints,
+	/// the contacts with their warm starting impulses, the islands and the
+	/// broad-phase. Shapes, listeners and the solver settings are not included.
+	/// @warning This function is locked during callbacks.
+	void Snapshot(b2Snapshot* snapshot);
+
+	/// Restore a snapshot of this world. Bodies, fixtures and joints keep their
+	/// addresses and the ones created after the snapshot are destroyed. Contacts
+	/// are recreated. No listener is called.
+	/// @return false, without changing the world, if a body, fixture or joint of
+	/// the snapshot has been destroyed.
+	/// @warning This function is locked during callbacks.
+	bool Restore(const b2Snapshot* snapshot);
+
+	/// Get the size in bytes of the binary world file written by Save.
+	int32 GetSaveSize() const;
+
+	/// Write the bodies, fixtures and joints in the binary world format, see
+	/// b2WorldFile.h. User data and mouse joints are not written.
+	/// @param data the file, 4 byte aligned
+	/// @param size the size of data, at least GetSaveSize()
+	/// @warning This function is locked during callbacks.
+	void Save(void* data, int32 size);
+
+	/// Create the bodies, fixtures and joints of a binary world file and set the
+	/// gravity. The new bodies are at the front of the body list, in the same
+	/// order as in the saved world.
+	/// @param referenceStaticGeometry if true, chain shapes on static bodies use
+	/// the vertices in the file instead of copies. The file must then stay in
+	/// memory (or mapped) as long as those fixtures exist.
+	/// @return false, without changing the world, if the data is not a valid file.
+	/// @warning This function is locked during callbacks.
+	bool Load(const void* data, int32 size, bool referenceStaticGeometry);
+
 	/// Dump the world into the log file.
 	/// @warning this should be called outside of a time step.
 	void Dump();
@@ -211,17 +441,41 @@ private:
 	{
 		e_newFixture	= 0x0001,
 		e_locked		= 0x0002,
-		e_clearForces	= 0x0004
+		e_clearForces	= 0x0004,
+		e_newSector		= 0x0008
 	};
 
 	friend class b2Body;
 	friend class b2Fixture;
 	friend class b2ContactManager;
 	friend class b2Controller;
+	friend class b2ParticleSystem;
 
 	void Solve(const b2TimeStep& step);
+	void SolveIslands(const b2TimeStep& step);
+	void SolveIslandsParallel(const b2TimeStep& step);
 	void SolveTOI(const b2TimeStep& step);
 
+	// Queue the TOI of every contact that needs one.
+	void FindTOIs();
+
+	// Queue the TOI of a contact whose cached TOI was invalidated.
+	void FindTOI(b2Contact* c);
+
+	// Returns false if the contact needs no TOI. Otherwise this puts the sweeps
+	// onto the same time interval and fills in the input.
+	bool PrepareTOI(b2Contact* c, b2TOIInput* input, float32* alpha0);
+
+	// Move bodies between sectors and activate/deactivate sectors around the
+	// streaming focus.
+	void UpdateSectors();
+
+	// Put a body into the sector of its origin, or into none if it is too large,
+	// and match its activity to the sector.
+	void StreamBody(b2Body* b, bool checkSize);
+
+	void SetSectorActive(int32 index, bool flag);
+
 	void DrawJoint(b2Joint* joint);
 	void DrawShape(b2Fixture* shape, const b2Transform& xf, const b2Color& color);
 
@@ -231,9 +485,18 @@ private:
 	int32 m_flags;
 
 	b2ContactManager m_contactManager;
+	b2IslandManager m_islandManager;
 
 	b2Body* m_bodyList;
 	b2Joint* m_jointList;
+	b2ParticleSystem* m_particleSystemList;
+
+	// The hot state of every body, indexed by b2Body::m_stateIndex.
+	b2BodyStates m_bodyStates;
+
+	b2Sectors m_sectors;
+	b2Vec2 m_streamingFocus;
+	float32 m_streamingRadius;
 
 	int32 m_bodyCount;
 	int32 m_jointCount;
@@ -244,6 +507,15 @@ private:
 	b2DestructionListener* m_destructionListener;
 	b2Draw* m_debugDraw;
 
+	// Tasks run on the thread pool allocate from the allocators of their thread.
+	b2ThreadPool* m_threadPool;
+	b2ThreadAllocator* m_threadAllocators;
+	int32 m_threadAllocatorCount;
+
+	b2Profiler* m_profiler;
+	b2ChecksumListener* m_checksumListener;
+	b2ContactEvents* m_contactEvents;
+
 	// This is used to compute the time step ratio to
 	// support a variable time step.
 	float32 m_inv_dt0;
@@ -252,9 +524,15 @@ private:
 	bool m_warmStarting;
 	bool m_continuousPhysics;
 	bool m_subStepping;
+	bool m_simdContactSolver;
+	bool m_batchedJoints;
+	bool m_speculativeContacts;
 
 	bool m_stepComplete;
 
+	// The TOI event queue and scratch buffers, kept between steps.
+	b2TOIScheduler* m_toiScheduler;
+
 	b2Profile m_profile;
 };
 
@@ -303,6 +581,16 @@ inline int32 b2World::GetContactCount() const
 	return m_contactManager.m_contactCount;
 }
 
+inline int32 b2World::GetIslandCount() const
+{
+	return m_islandManager.m_islandCount;
+}
+
+inline int32 b2World::GetRebuiltIslandCount() const
+{
+	return m_islandManager.m_splitCount;
+}
+
 inline void b2World::SetGravity(const b2Vec2& gravity)
 {
 	m_gravity = gravity;
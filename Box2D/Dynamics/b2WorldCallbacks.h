@@ -118,6 +118,18 @@ public:
 	}
 };
 
+/// Implement this class to verify that two runs stay identical, for example a
+/// replay against its recording. See b2World::SetChecksumListener
+class b2ChecksumListener
+{
+public:
+	virtual ~b2ChecksumListener() {}
+
+	/// Called at the end of each step with b2World::GetChecksum. The first step
+	/// whose checksum differs between two runs is where they diverged.
+	virtual void ReportChecksum(uint64 checksum) = 0;
+};
+
 /// Callback class for AABB queries.
 /// See b2World::Query
 class b2QueryCallback
@@ -0,0 +1,735 @@
+/*
+* Copyright (c) 2013 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/b2WorldFile.h>
+#include <Box2D/Dynamics/b2World.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Dynamics/Joints/b2DistanceJoint.h>
+#include <Box2D/Dynamics/Joints/b2FrictionJoint.h>
+#include <Box2D/Dynamics/Joints/b2GearJoint.h>
+#include <Box2D/Dynamics/Joints/b2PrismaticJoint.h>
+#include <Box2D/Dynamics/Joints/b2PulleyJoint.h>
+#include <Box2D/Dynamics/Joints/b2RevoluteJoint.h>
+#include <Box2D/Dynamics/Joints/b2RopeJoint.h>
+#include <Box2D/Dynamics/Joints/b2WeldJoint.h>
+#include <Box2D/Dynamics/Joints/b2WheelJoint.h>
+#include <Box2D/Collision/Shapes/b2CircleShape.h>
+#include <Box2D/Collision/Shapes/b2EdgeShape.h>
+#include <Box2D/Collision/Shapes/b2ChainShape.h>
+#include <Box2D/Collision/Shapes/b2PolygonShape.h>
+#include <cstring>
+
+// The number of vertex table entries used by a shape.
+static int32 b2GetVertexCount(const b2Shape* shape)
+{
+	switch (shape->GetType())
+	{
+	case b2Shape::e_circle:
+		return 0;
+
+	case b2Shape::e_edge:
+		return 4;
+
+	case b2Shape::e_polygon:
+		return 2 * ((b2PolygonShape*)shape)->m_vertexCount;
+
+	case b2Shape::e_chain:
+		return ((b2ChainShape*)shape)->m_count + 2;
+
+	default:
+		b2Assert(false);
+		return 0;
+	}
+}
+
+static bool b2IsTableValid(const b2WorldFileHeader* header, int32 offset, int32 count, int32 stride)
+{
+	if (count < 0 || offset < (int32)sizeof(b2WorldFileHeader) || (offset & 3) != 0)
+	{
+		return false;
+	}
+
+	return count <= (header->size - offset) / stride;
+}
+
+bool b2ValidateWorldFile(const void* data, int32 size)
+{
+	if (data == NULL || ((size_t)data & 3) != 0 || size < (int32)sizeof(b2WorldFileHeader))
+	{
+		return false;
+	}
+
+	const b2WorldFileHeader* header = (const b2WorldFileHeader*)data;
+	if (header->magic != b2_worldFileMagic || header->version != b2_worldFileVersion)
+	{
+		return false;
+	}
+
+	if (header->size > size ||
+		b2IsTableValid(header, header->bodyOffset, header->bodyCount, sizeof(b2WorldFileBody)) == false ||
+		b2IsTableValid(header, header->fixtureOffset, header->fixtureCount, sizeof(b2WorldFileFixture)) == false ||
+		b2IsTableValid(header, header->jointOffset, header->jointCount, sizeof(b2WorldFileJoint)) == false ||
+		b2IsTableValid(header, header->vertexOffset, header->vertexCount, sizeof(b2Vec2)) == false)
+	{
+		return false;
+	}
+
+	const char* base = (const char*)data;
+	const b2WorldFileBody* bodies = (const b2WorldFileBody*)(base + header->bodyOffset);
+	const b2WorldFileFixture* fixtures = (const b2WorldFileFixture*)(base + header->fixtureOffset);
+	const b2WorldFileJoint* joints = (const b2WorldFileJoint*)(base + header->jointOffset);
+
+	for (int32 i = 0; i < header->bodyCount; ++i)
+	{
+		const b2WorldFileBody* b = bodies + i;
+		if (b->type < b2_staticBody || b2_dynamicBody < b->type ||
+			b->fixtureIndex < 0 || b->fixtureCount < 0 ||
+			b->fixtureCount > header->fixtureCount - b->fixtureIndex)
+		{
+			return false;
+		}
+	}
+
+	for (int32 i = 0; i < header->fixtureCount; ++i)
+	{
+		const b2WorldFileFixture* f = fixtures + i;
+		if (f->vertexIndex < 0 || f->vertexCount < 0 ||
+			f->vertexCount > header->vertexCount - f->vertexIndex)
+		{
+			return false;
+		}
+
+		int32 vertexCount;
+		switch (f->shapeType)
+		{
+		case b2Shape::e_circle:
+			vertexCount = 0;
+			break;
+
+		case b2Shape::e_edge:
+			vertexCount = 4;
+			break;
+
+		case b2Shape::e_polygon:
+			if (f->count < 3 || b2_maxPolygonVertices < f->count)
+			{
+				return false;
+			}
+			vertexCount = 2 * f->count;
+			break;
+
+		case b2Shape::e_chain:
+			if (f->count < 2)
+			{
+				return false;
+			}
+			vertexCount = f->count + 2;
+			break;
+
+		default:
+			return false;
+		}
+
+		if (f->vertexCount != vertexCount)
+		{
+			return false;
+		}
+	}
+
+	for (int32 i = 0; i < header->jointCount; ++i)
+	{
+		const b2WorldFileJoint* j = joints + i;
+		if (j->bodyA < 0 || header->bodyCount <= j->bodyA ||
+			j->bodyB < 0 || header->bodyCount <= j->bodyB)
+		{
+			return false;
+		}
+
+		switch (j->type)
+		{
+		case e_revoluteJoint:
+		case e_prismaticJoint:
+		case e_distanceJoint:
+		case e_pulleyJoint:
+		case e_wheelJoint:
+		case e_weldJoint:
+		case e_frictionJoint:
+		case e_ropeJoint:
+			break;
+
+		case e_gearJoint:
+			// Gears refer to joints that come before them.
+			if (j->joint1 < 0 || i <= j->joint1 || j->joint2 < 0 || i <= j->joint2)
+			{
+				return false;
+			}
+
+			if ((joints[j->joint1].type != e_revoluteJoint && joints[j->joint1].type != e_prismaticJoint) ||
+				(joints[j->joint2].type != e_revoluteJoint && joints[j->joint2].type != e_prismaticJoint))
+			{
+				return false;
+			}
+			break;
+
+		default:
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int32 b2World::GetSaveSize() const
+{
+	int32 fixtureCount = 0;
+	int32 vertexCount = 0;
+	for (const b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		for (const b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			++fixtureCount;
+			vertexCount += b2GetVertexCount(f->m_shape);
+		}
+	}
+
+	int32 jointCount = 0;
+	for (const b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		if (j->m_type != e_mouseJoint)
+		{
+			++jointCount;
+		}
+	}
+
+	int32 size = sizeof(b2WorldFileHeader);
+	size += m_bodyCount * sizeof(b2WorldFileBody);
+	size += fixtureCount * sizeof(b2WorldFileFixture);
+	size += jointCount * sizeof(b2WorldFileJoint);
+	size += vertexCount * sizeof(b2Vec2);
+	return size;
+}
+
+void b2World::Save(void* data, int32 size)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	b2Assert(((size_t)data & 3) == 0);
+	b2Assert(size >= GetSaveSize());
+	B2_NOT_USED(size);
+
+	memset(data, 0, GetSaveSize());
+
+	// Count the tables.
+	b2WorldFileHeader* header = (b2WorldFileHeader*)data;
+	header->magic = b2_worldFileMagic;
+	header->version = b2_worldFileVersion;
+	header->size = GetSaveSize();
+	header->bodyCount = m_bodyCount;
+	header->gravity = m_gravity;
+
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			++header->fixtureCount;
+			header->vertexCount += b2GetVertexCount(f->m_shape);
+		}
+	}
+
+	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		if (j->m_type != e_mouseJoint)
+		{
+			++header->jointCount;
+		}
+	}
+
+	header->bodyOffset = sizeof(b2WorldFileHeader);
+	header->fixtureOffset = header->bodyOffset + header->bodyCount * sizeof(b2WorldFileBody);
+	header->jointOffset = header->fixtureOffset + header->fixtureCount * sizeof(b2WorldFileFixture);
+	header->vertexOffset = header->jointOffset + header->jointCount * sizeof(b2WorldFileJoint);
+
+	char* base = (char*)data;
+	b2WorldFileBody* bodies = (b2WorldFileBody*)(base + header->bodyOffset);
+	b2WorldFileFixture* fixtures = (b2WorldFileFixture*)(base + header->fixtureOffset);
+	b2WorldFileJoint* joints = (b2WorldFileJoint*)(base + header->jointOffset);
+	b2Vec2* vertices = (b2Vec2*)(base + header->vertexOffset);
+
+	// The lists are written back to front so that loading them in table order
+	// rebuilds the same lists. The body index is kept in m_islandIndex, like Dump.
+	int32 bodyIndex = header->bodyCount;
+	int32 fixtureIndex = header->fixtureCount;
+	int32 vertexIndex = header->vertexCount;
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		--bodyIndex;
+		b->m_islandIndex = bodyIndex;
+
+		b2WorldFileBody* bf = bodies + bodyIndex;
+		bf->type = b->m_type;
+		bf->position = b->Transform().p;
+		bf->angle = b->Sweep().a;
+		bf->linearVelocity = b->LinearVelocity();
+		bf->angularVelocity = b->AngularVelocity();
+		bf->linearDamping = b->m_linearDamping;
+		bf->angularDamping = b->m_angularDamping;
+		bf->gravityScale = b->m_gravityScale;
+		bf->flags = 0;
+		if (b->IsAwake())
+		{
+			bf->flags |= b2WorldFileBody::e_awakeFlag;
+		}
+		if (b->IsSleepingAllowed())
+		{
+			bf->flags |= b2WorldFileBody::e_allowSleepFlag;
+		}
+		if (b->IsFixedRotation())
+		{
+			bf->flags |= b2WorldFileBody::e_fixedRotationFlag;
+		}
+		if (b->IsBullet())
+		{
+			bf->flags |= b2WorldFileBody::e_bulletFlag;
+		}
+		if (b->IsActive())
+		{
+			bf->flags |= b2WorldFileBody::e_activeFlag;
+		}
+
+		fixtureIndex -= b->m_fixtureCount;
+		bf->fixtureIndex = fixtureIndex;
+		bf->fixtureCount = b->m_fixtureCount;
+
+		int32 i = fixtureIndex + b->m_fixtureCount;
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			--i;
+			b2WorldFileFixture* ff = fixtures + i;
+			ff->friction = f->m_friction;
+			ff->restitution = f->m_restitution;
+			ff->density = f->m_density;
+			ff->isSensor = f->m_isSensor;
+			ff->categoryBits = f->m_filter.categoryBits;
+			ff->maskBits = f->m_filter.maskBits;
+			ff->groupIndex = f->m_filter.groupIndex;
+
+			const b2Shape* shape = f->m_shape;
+			ff->shapeType = shape->m_type;
+			ff->radius = shape->m_radius;
+			ff->vertexCount = b2GetVertexCount(shape);
+			vertexIndex -= ff->vertexCount;
+			ff->vertexIndex = vertexIndex;
+
+			b2Vec2* v = vertices + vertexIndex;
+			switch (shape->m_type)
+			{
+			case b2Shape::e_circle:
+				{
+					const b2CircleShape* circle = (const b2CircleShape*)shape;
+					ff->center = circle->m_p;
+				}
+				break;
+
+			case b2Shape::e_edge:
+				{
+					const b2EdgeShape* edge = (const b2EdgeShape*)shape;
+					v[0] = edge->m_vertex1;
+					v[1] = edge->m_vertex2;
+					v[2] = edge->m_vertex0;
+					v[3] = edge->m_vertex3;
+					if (edge->m_hasVertex0)
+					{
+						ff->shapeFlags |= b2WorldFileFixture::e_hasVertex0Flag;
+					}
+					if (edge->m_hasVertex3)
+					{
+						ff->shapeFlags |= b2WorldFileFixture::e_hasVertex3Flag;
+					}
+				}
+				break;
+
+			case b2Shape::e_polygon:
+				{
+					const b2PolygonShape* poly = (const b2PolygonShape*)shape;
+					int32 count = poly->m_vertexCount;
+					ff->center = poly->m_centroid;
+					ff->count = count;
+					memcpy(v, poly->m_vertices, count * sizeof(b2Vec2));
+					memcpy(v + count, poly->m_normals, count * sizeof(b2Vec2));
+				}
+				break;
+
+			case b2Shape::e_chain:
+				{
+					const b2ChainShape* chain = (const b2ChainShape*)shape;
+					int32 count = chain->m_count;
+					ff->count = count;
+					memcpy(v, chain->m_vertices, count * sizeof(b2Vec2));
+					v[count] = chain->m_prevVertex;
+					v[count + 1] = chain->m_nextVertex;
+					if (chain->m_hasPrevVertex)
+					{
+						ff->shapeFlags |= b2WorldFileFixture::e_hasVertex0Flag;
+					}
+					if (chain->m_hasNextVertex)
+					{
+						ff->shapeFlags |= b2WorldFileFixture::e_hasVertex3Flag;
+					}
+				}
+				break;
+
+			default:
+				b2Assert(false);
+				break;
+			}
+		}
+	}
+
+	// Joints are created after the joints they refer to (gears), so writing
+	// them back to front also puts gears after their joints.
+	int32 jointIndex = header->jointCount;
+	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		if (j->m_type != e_mouseJoint)
+		{
+			j->m_index = --jointIndex;
+		}
+	}
+
+	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		if (j->m_type == e_mouseJoint)
+		{
+			continue;
+		}
+
+		b2WorldFileJoint* jf = joints + j->m_index;
+		jf->type = j->m_type;
+		jf->bodyA = j->m_bodyA->m_islandIndex;
+		jf->bodyB = j->m_bodyB->m_islandIndex;
+		jf->collideConnected = j->m_collideConnected;
+		j->Save(jf);
+	}
+}
+
+bool b2World::Load(const void* data, int32 size, bool referenceStaticGeometry)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return false;
+	}
+
+	if (b2ValidateWorldFile(data, size) == false)
+	{
+		return false;
+	}
+
+	const b2WorldFileHeader* header = (const b2WorldFileHeader*)data;
+	const char* base = (const char*)data;
+	const b2WorldFileBody* bodyTable = (const b2WorldFileBody*)(base + header->bodyOffset);
+	const b2WorldFileFixture* fixtureTable = (const b2WorldFileFixture*)(base + header->fixtureOffset);
+	const b2WorldFileJoint* jointTable = (const b2WorldFileJoint*)(base + header->jointOffset);
+	const b2Vec2* vertexTable = (const b2Vec2*)(base + header->vertexOffset);
+
+	SetGravity(header->gravity);
+
+	b2Body** bodies = (b2Body**)b2Alloc(header->bodyCount * sizeof(b2Body*));
+	b2Joint** joints = (b2Joint**)b2Alloc(header->jointCount * sizeof(b2Joint*));
+
+	// The proxies of all fixtures are inserted in bulk at the end.
+	b2Fixture** fixtures = (b2Fixture**)b2Alloc(header->fixtureCount * sizeof(b2Fixture*));
+	int32 fixtureCount = 0;
+
+	for (int32 i = 0; i < header->bodyCount; ++i)
+	{
+		const b2WorldFileBody* bf = bodyTable + i;
+
+		b2BodyDef bd;
+		bd.type = b2BodyType(bf->type);
+		bd.position = bf->position;
+		bd.angle = bf->angle;
+		bd.linearVelocity = bf->linearVelocity;
+		bd.angularVelocity = bf->angularVelocity;
+		bd.linearDamping = bf->linearDamping;
+		bd.angularDamping = bf->angularDamping;
+		bd.gravityScale = bf->gravityScale;
+		bd.awake = (bf->flags & b2WorldFileBody::e_awakeFlag) != 0;
+		bd.allowSleep = (bf->flags & b2WorldFileBody::e_allowSleepFlag) != 0;
+		bd.fixedRotation = (bf->flags & b2WorldFileBody::e_fixedRotationFlag) != 0;
+		bd.bullet = (bf->flags & b2WorldFileBody::e_bulletFlag) != 0;
+		bd.active = (bf->flags & b2WorldFileBody::e_activeFlag) != 0;
+		b2Body* body = CreateBody(&bd);
+		bodies[i] = body;
+
+		bool reference = referenceStaticGeometry && bd.type == b2_staticBody;
+		bool hasMass = false;
+
+		for (int32 k = 0; k < bf->fixtureCount; ++k)
+		{
+			const b2WorldFileFixture* ff = fixtureTable + bf->fixtureIndex + k;
+			const b2Vec2* v = vertexTable + ff->vertexIndex;
+
+			b2FixtureDef fd;
+			fd.friction = ff->friction;
+			fd.restitution = ff->restitution;
+			fd.density = ff->density;
+			fd.isSensor = ff->isSensor != 0;
+			fd.filter.categoryBits = uint16(ff->categoryBits);
+			fd.filter.maskBits = uint16(ff->maskBits);
+			fd.filter.groupIndex = int16(ff->groupIndex);
+
+			b2CircleShape circle;
+			b2EdgeShape edge;
+			b2PolygonShape poly;
+			b2ChainShape chain;
+
+			switch (ff->shapeType)
+			{
+			case b2Shape::e_circle:
+				circle.m_radius = ff->radius;
+				circle.m_p = ff->center;
+				fd.shape = &circle;
+				break;
+
+			case b2Shape::e_edge:
+				edge.m_radius = ff->radius;
+				edge.m_vertex1 = v[0];
+				edge.m_vertex2 = v[1];
+				edge.m_vertex0 = v[2];
+				edge.m_vertex3 = v[3];
+				edge.m_hasVertex0 = (ff->shapeFlags & b2WorldFileFixture::e_hasVertex0Flag) != 0;
+				edge.m_hasVertex3 = (ff->shapeFlags & b2WorldFileFixture::e_hasVertex3Flag) != 0;
+				fd.shape = &edge;
+				break;
+
+			case b2Shape::e_polygon:
+				poly.m_radius = ff->radius;
+				poly.m_centroid = ff->center;
+				poly.m_vertexCount = ff->count;
+				memcpy(poly.m_vertices, v, ff->count * sizeof(b2Vec2));
+				memcpy(poly.m_normals, v + ff->count, ff->count * sizeof(b2Vec2));
+				fd.shape = &poly;
+				break;
+
+			case b2Shape::e_chain:
+				if (reference)
+				{
+					chain.ReferenceChain(v, ff->count);
+				}
+				else
+				{
+					chain.CreateChain(v, ff->count);
+				}
+				chain.m_radius = ff->radius;
+				chain.m_prevVertex = v[ff->count];
+				chain.m_nextVertex = v[ff->count + 1];
+				chain.m_hasPrevVertex = (ff->shapeFlags & b2WorldFileFixture::e_hasVertex0Flag) != 0;
+				chain.m_hasNextVertex = (ff->shapeFlags & b2WorldFileFixture::e_hasVertex3Flag) != 0;
+				fd.shape = &chain;
+				break;
+			}
+
+			fixtures[fixtureCount++] = body->AddFixture(&fd);
+			hasMass = hasMass || fd.density > 0.0f;
+		}
+
+		if (hasMass)
+		{
+			body->ResetMassData();
+		}
+
+		// Adding fixtures moves the center of mass, which changes the velocity.
+		body->LinearVelocity() = bf->linearVelocity;
+	}
+
+	b2Fixture::CreateProxies(&m_contactManager.m_broadPhase, &m_stackAllocator, fixtures, fixtureCount);
+	b2Free(fixtures);
+	m_flags |= e_newFixture;
+
+	for (int32 i = 0; i < header->jointCount; ++i)
+	{
+		const b2WorldFileJoint* jf = jointTable + i;
+		b2Body* bodyA = bodies[jf->bodyA];
+		b2Body* bodyB = bodies[jf->bodyB];
+		bool collideConnected = jf->collideConnected != 0;
+		bool enableLimit = (jf->flags & b2WorldFileJoint::e_enableLimitFlag) != 0;
+		bool enableMotor = (jf->flags & b2WorldFileJoint::e_enableMotorFlag) != 0;
+		const float32* values = jf->values;
+
+		b2Joint* joint = NULL;
+		switch (jf->type)
+		{
+		case e_revoluteJoint:
+			{
+				b2RevoluteJointDef jd;
+				jd.bodyA = bodyA;
+				jd.bodyB = bodyB;
+				jd.collideConnected = collideConnected;
+				jd.localAnchorA = jf->localAnchorA;
+				jd.localAnchorB = jf->localAnchorB;
+				jd.referenceAngle = values[0];
+				jd.enableLimit = enableLimit;
+				jd.lowerAngle = values[1];
+				jd.upperAngle = values[2];
+				jd.enableMotor = enableMotor;
+				jd.motorSpeed = values[3];
+				jd.maxMotorTorque = values[4];
+				joint = CreateJoint(&jd);
+			}
+			break;
+
+		case e_prismaticJoint:
+			{
+				b2PrismaticJointDef jd;
+				jd.bodyA = bodyA;
+				jd.bodyB = bodyB;
+				jd.collideConnected = collideConnected;
+				jd.localAnchorA = jf->localAnchorA;
+				jd.localAnchorB = jf->localAnchorB;
+				jd.localAxisA = jf->vectorA;
+				jd.referenceAngle = values[0];
+				jd.enableLimit = enableLimit;
+				jd.lowerTranslation = values[1];
+				jd.upperTranslation = values[2];
+				jd.enableMotor = enableMotor;
+				jd.motorSpeed = values[3];
+				jd.maxMotorForce = values[4];
+				joint = CreateJoint(&jd);
+			}
+			break;
+
+		case e_distanceJoint:
+			{
+				b2DistanceJointDef jd;
+				jd.bodyA = bodyA;
+				jd.bodyB = bodyB;
+				jd.collideConnected = collideConnected;
+				jd.localAnchorA = jf->localAnchorA;
+				jd.localAnchorB = jf->localAnchorB;
+				jd.length = values[0];
+				jd.frequencyHz = values[1];
+				jd.dampingRatio = values[2];
+				joint = CreateJoint(&jd);
+			}
+			break;
+
+		case e_pulleyJoint:
+			{
+				b2PulleyJointDef jd;
+				jd.bodyA = bodyA;
+				jd.bodyB = bodyB;
+				jd.collideConnected = collideConnected;
+				jd.groundAnchorA = jf->vectorA;
+				jd.groundAnchorB = jf->vectorB;
+				jd.localAnchorA = jf->localAnchorA;
+				jd.localAnchorB = jf->localAnchorB;
+				jd.lengthA = values[0];
+				jd.lengthB = values[1];
+				jd.ratio = values[2];
+				joint = CreateJoint(&jd);
+			}
+			break;
+
+		case e_wheelJoint:
+			{
+				b2WheelJointDef jd;
+				jd.bodyA = bodyA;
+				jd.bodyB = bodyB;
+				jd.collideConnected = collideConnected;
+				jd.localAnchorA = jf->localAnchorA;
+				jd.localAnchorB = jf->localAnchorB;
+				jd.localAxisA = jf->vectorA;
+				jd.enableMotor = enableMotor;
+				jd.motorSpeed = values[0];
+				jd.maxMotorTorque = values[1];
+				jd.frequencyHz = values[2];
+				jd.dampingRatio = values[3];
+				joint = CreateJoint(&jd);
+			}
+			break;
+
+		case e_weldJoint:
+			{
+				b2WeldJointDef jd;
+				jd.bodyA = bodyA;
+				jd.bodyB = bodyB;
+				jd.collideConnected = collideConnected;
+				jd.localAnchorA = jf->localAnchorA;
+				jd.localAnchorB = jf->localAnchorB;
+				jd.referenceAngle = values[0];
+				jd.frequencyHz = values[1];
+				jd.dampingRatio = values[2];
+				joint = CreateJoint(&jd);
+			}
+			break;
+
+		case e_frictionJoint:
+			{
+				b2FrictionJointDef jd;
+				jd.bodyA = bodyA;
+				jd.bodyB = bodyB;
+				jd.collideConnected = collideConnected;
+				jd.localAnchorA = jf->localAnchorA;
+				jd.localAnchorB = jf->localAnchorB;
+				jd.maxForce = values[0];
+				jd.maxTorque = values[1];
+				joint = CreateJoint(&jd);
+			}
+			break;
+
+		case e_ropeJoint:
+			{
+				b2RopeJointDef jd;
+				jd.bodyA = bodyA;
+				jd.bodyB = bodyB;
+				jd.collideConnected = collideConnected;
+				jd.localAnchorA = jf->localAnchorA;
+				jd.localAnchorB = jf->localAnchorB;
+				jd.maxLength = values[0];
+				joint = CreateJoint(&jd);
+			}
+			break;
+
+		case e_gearJoint:
+			{
+				b2GearJointDef jd;
+				jd.bodyA = bodyA;
+				jd.bodyB = bodyB;
+				jd.collideConnected = collideConnected;
+				jd.joint1 = joints[jf->joint1];
+				jd.joint2 = joints[jf->joint2];
+				jd.ratio = values[0];
+				joint = CreateJoint(&jd);
+			}
+			break;
+		}
+
+		joints[i] = joint;
+	}
+
+	b2Free(joints);
+	b2Free(bodies);
+
+	return true;
+}
@@ -0,0 +1,131 @@
+/*
+* Copyright (c) 2013 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_WORLD_FILE_H
+#define B2_WORLD_FILE_H
+
+#include <Box2D/Common/b2Math.h>
+
+/// The binary world format written by b2World::Save and read by b2World::Load.
+/// A file is a header followed by four tables: bodies, fixtures, joints and
+/// vertices. Tables are located by byte offsets from the start of the file and
+/// every field is 4 bytes wide, so a file can be memory mapped and used in place.
+/// Numbers are stored in the byte order of the machine that wrote the file.
+/// User data and mouse joints are not stored.
+const uint32 b2_worldFileMagic = 0x46573262;	// "b2WF"
+const uint32 b2_worldFileVersion = 1;
+
+struct b2WorldFileHeader
+{
+	uint32 magic;
+	uint32 version;
+	int32 size;				///< total size of the file in bytes
+	int32 bodyCount;
+	int32 fixtureCount;
+	int32 jointCount;
+	int32 vertexCount;
+	int32 bodyOffset;
+	int32 fixtureOffset;
+	int32 jointOffset;
+	int32 vertexOffset;
+	b2Vec2 gravity;
+};
+
+struct b2WorldFileBody
+{
+	enum
+	{
+		e_awakeFlag				= 0x0001,
+		e_allowSleepFlag		= 0x0002,
+		e_fixedRotationFlag		= 0x0004,
+		e_bulletFlag			= 0x0008,
+		e_activeFlag			= 0x0010
+	};
+
+	int32 type;
+	b2Vec2 position;
+	float32 angle;
+	b2Vec2 linearVelocity;
+	float32 angularVelocity;
+	float32 linearDamping;
+	float32 angularDamping;
+	float32 gravityScale;
+	uint32 flags;
+	int32 fixtureIndex;		///< first fixture in the fixture table
+	int32 fixtureCount;
+};
+
+/// The points of a shape are in the vertex table:
+/// - circle: none, the center is the position
+/// - edge: vertex1, vertex2, vertex0, vertex3
+/// - polygon: count vertices followed by count normals, the center is the centroid
+/// - chain: count vertices followed by the previous and next vertex
+struct b2WorldFileFixture
+{
+	enum
+	{
+		e_hasVertex0Flag		= 0x0001,	///< edge vertex0, chain previous vertex
+		e_hasVertex3Flag		= 0x0002	///< edge vertex3, chain next vertex
+	};
+
+	int32 shapeType;
+	float32 radius;
+	b2Vec2 center;
+	int32 count;
+	uint32 shapeFlags;
+	int32 vertexIndex;		///< first point in the vertex table
+	int32 vertexCount;
+	float32 friction;
+	float32 restitution;
+	float32 density;
+	int32 isSensor;
+	uint32 categoryBits;
+	uint32 maskBits;
+	int32 groupIndex;
+};
+
+/// Joint fields are filled by b2Joint::Save. Bodies and joints are referred to
+/// by their index in the body and joint tables. The values hold the remaining
+/// float fields of the joint definition, in the order b2Joint::Dump writes them.
+struct b2WorldFileJoint
+{
+	enum
+	{
+		e_enableLimitFlag		= 0x0001,
+		e_enableMotorFlag		= 0x0002
+	};
+
+	int32 type;
+	int32 bodyA;
+	int32 bodyB;
+	int32 collideConnected;
+	b2Vec2 localAnchorA;
+	b2Vec2 localAnchorB;
+	b2Vec2 vectorA;			///< local axis A, or ground anchor A of a pulley
+	b2Vec2 vectorB;			///< ground anchor B of a pulley
+	float32 values[6];
+	uint32 flags;
+	int32 joint1;
+	int32 joint2;
+};
+
+/// Check that a block of memory holds a world file of this version with
+/// consistent tables. The data must be 4 byte aligned.
+bool b2ValidateWorldFile(const void* data, int32 size);
+
+#endif
@@ -0,0 +1,617 @@
+/*
+* Copyright (c) 2013 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Rope/b2RopeSystem.h>
+#include <Box2D/Common/b2Draw.h>
+#include <Box2D/Common/b2Simd.h>
+#include <Box2D/Common/b2ThreadPool.h>
+
+#include <algorithm>
+#include <cstring>
+
+// Up to b2_simdWidth ropes, one per lane. Lanes without a rope have a vertex
+// count of zero and never pass the lane masks.
+struct b2RopeBatch
+{
+	int32 offset;
+	int32 vertexCount;
+	float32 counts[b2_simdWidth];
+	float32 gravityX[b2_simdWidth];
+	float32 gravityY[b2_simdWidth];
+	float32 damping[b2_simdWidth];
+	float32 k2[b2_simdWidth];
+	float32 k3[b2_simdWidth];
+};
+
+// Where a rope lives in the batches.
+struct b2RopeLane
+{
+	int32 batch;
+	int32 lane;
+	int32 count;
+};
+
+// Longer ropes first, then by index, so ropes of a similar length share a
+// batch and the order does not depend on the sort implementation.
+struct b2RopeCountGreater
+{
+	bool operator()(int32 a, int32 b) const
+	{
+		if (counts[a] != counts[b])
+		{
+			return counts[a] > counts[b];
+		}
+		return a < b;
+	}
+
+	const int32* counts;
+};
+
+struct b2RopeStepTask : public b2ParallelTask
+{
+	void Execute(int32 index, int32 threadIndex)
+	{
+		B2_NOT_USED(threadIndex);
+		system->StepBatch(index, timeStep, iterations);
+	}
+
+	b2RopeSystem* system;
+	float32 timeStep;
+	int32 iterations;
+};
+
+b2RopeSystem::b2RopeSystem()
+{
+	m_ropes = NULL;
+	m_ropeCount = 0;
+	m_batches = NULL;
+	m_batchCount = 0;
+	m_slotCount = 0;
+	m_buffer = NULL;
+	m_px = NULL;
+	m_py = NULL;
+	m_p0x = NULL;
+	m_p0y = NULL;
+	m_vx = NULL;
+	m_vy = NULL;
+	m_ims = NULL;
+	m_Ls = NULL;
+	m_as = NULL;
+	m_threadPool = NULL;
+}
+
+b2RopeSystem::~b2RopeSystem()
+{
+	Clear();
+}
+
+void b2RopeSystem::Clear()
+{
+	b2Free(m_ropes);
+	b2Free(m_batches);
+	b2Free(m_buffer);
+	m_ropes = NULL;
+	m_ropeCount = 0;
+	m_batches = NULL;
+	m_batchCount = 0;
+	m_slotCount = 0;
+	m_buffer = NULL;
+	m_px = NULL;
+	m_py = NULL;
+	m_p0x = NULL;
+	m_p0y = NULL;
+	m_vx = NULL;
+	m_vy = NULL;
+	m_ims = NULL;
+	m_Ls = NULL;
+	m_as = NULL;
+}
+
+void b2RopeSystem::SetThreadPool(b2ThreadPool* threadPool)
+{
+	m_threadPool = threadPool;
+}
+
+int32 b2RopeSystem::CreateRope(const b2RopeDef* def)
+{
+	return CreateRopes(def, 1);
+}
+
+int32 b2RopeSystem::CreateRopes(const b2RopeDef* defs, int32 count)
+{
+	b2Assert(count > 0);
+	int32 first = m_ropeCount;
+	Repack(defs, count);
+	return first;
+}
+
+// Lay out the existing ropes and the new ones in fresh buffers. The existing
+// ropes keep their state.
+void b2RopeSystem::Repack(const b2RopeDef* defs, int32 count)
+{
+	const int32 width = b2_simdWidth;
+	int32 ropeCount = m_ropeCount + count;
+
+	int32* counts = (int32*)b2Alloc(ropeCount * sizeof(int32));
+	int32* order = (int32*)b2Alloc(ropeCount * sizeof(int32));
+	for (int32 i = 0; i < ropeCount; ++i)
+	{
+		if (i < m_ropeCount)
+		{
+			counts[i] = m_ropes[i].count;
+		}
+		else
+		{
+			const b2RopeDef* def = defs + (i - m_ropeCount);
+			b2Assert(def->count >= 3);
+			counts[i] = def->count;
+		}
+		order[i] = i;
+	}
+
+	b2RopeCountGreater greater;
+	greater.counts = counts;
+	std::sort(order, order + ropeCount, greater);
+
+	int32 batchCount = (ropeCount + width - 1) / width;
+	b2RopeBatch* batches = (b2RopeBatch*)b2Alloc(batchCount * sizeof(b2RopeBatch));
+	memset(batches, 0, batchCount * sizeof(b2RopeBatch));
+
+	int32 slotCount = 0;
+	for (int32 i = 0; i < batchCount; ++i)
+	{
+		// The first lane holds the longest rope of the batch.
+		batches[i].offset = slotCount;
+		batches[i].vertexCount = counts[order[i * width]];
+		slotCount += batches[i].vertexCount;
+	}
+
+	const int32 arrayCount = 9;
+	int32 stride = slotCount * width;
+	float32* buffer = (float32*)b2Alloc(arrayCount * stride * sizeof(float32));
+	memset(buffer, 0, arrayCount * stride * sizeof(float32));
+	float32* px = buffer;
+	float32* py = px + stride;
+	float32* p0x = py + stride;
+	float32* p0y = p0x + stride;
+	float32* vx = p0y + stride;
+	float32* vy = vx + stride;
+	float32* ims = vy + stride;
+	float32* Ls = ims + stride;
+	float32* as = Ls + stride;
+
+	b2RopeLane* ropes = (b2RopeLane*)b2Alloc(ropeCount * sizeof(b2RopeLane));
+
+	for (int32 slot = 0; slot < ropeCount; ++slot)
+	{
+		int32 index = order[slot];
+		int32 vertexCount = counts[index];
+		b2RopeBatch* batch = batches + slot / width;
+		int32 lane = slot % width;
+
+		ropes[index].batch = slot / width;
+		ropes[index].lane = lane;
+		ropes[index].count = vertexCount;
+		batch->counts[lane] = float32(vertexCount);
+
+		int32 base = batch->offset * width + lane;
+
+		if (index < m_ropeCount)
+		{
+			// Move an existing rope.
+			const b2RopeLane* old = m_ropes + index;
+			const b2RopeBatch* oldBatch = m_batches + old->batch;
+			int32 oldBase = oldBatch->offset * width + old->lane;
+
+			batch->gravityX[lane] = oldBatch->gravityX[old->lane];
+			batch->gravityY[lane] = oldBatch->gravityY[old->lane];
+			batch->damping[lane] = oldBatch->damping[old->lane];
+			batch->k2[lane] = oldBatch->k2[old->lane];
+			batch->k3[lane] = oldBatch->k3[old->lane];
+
+			for (int32 i = 0; i < vertexCount; ++i)
+			{
+				int32 j = base + i * width;
+				int32 oldj = oldBase + i * width;
+				px[j] = m_px[oldj];
+				py[j] = m_py[oldj];
+				p0x[j] = m_p0x[oldj];
+				p0y[j] = m_p0y[oldj];
+				vx[j] = m_vx[oldj];
+				vy[j] = m_vy[oldj];
+				ims[j] = m_ims[oldj];
+				Ls[j] = m_Ls[oldj];
+				as[j] = m_as[oldj];
+			}
+
+			continue;
+		}
+
+		// Initialize a new rope like b2Rope::Initialize.
+		const b2RopeDef* def = defs + (index - m_ropeCount);
+		batch->gravityX[lane] = def->gravity.x;
+		batch->gravityY[lane] = def->gravity.y;
+		batch->damping[lane] = def->damping;
+		batch->k2[lane] = def->k2;
+		batch->k3[lane] = def->k3;
+
+		for (int32 i = 0; i < vertexCount; ++i)
+		{
+			int32 j = base + i * width;
+			px[j] = def->vertices[i].x;
+			py[j] = def->vertices[i].y;
+			p0x[j] = def->vertices[i].x;
+			p0y[j] = def->vertices[i].y;
+
+			float32 m = def->masses[i];
+			ims[j] = m > 0.0f ? 1.0f / m : 0.0f;
+		}
+
+		for (int32 i = 0; i < vertexCount - 1; ++i)
+		{
+			Ls[base + i * width] = b2Distance(def->vertices[i], def->vertices[i + 1]);
+		}
+
+		for (int32 i = 0; i < vertexCount - 2; ++i)
+		{
+			b2Vec2 d1 = def->vertices[i + 1] - def->vertices[i];
+			b2Vec2 d2 = def->vertices[i + 2] - def->vertices[i + 1];
+			as[base + i * width] = b2Atan2(b2Cross(d1, d2), b2Dot(d1, d2));
+		}
+	}
+
+	b2Free(order);
+	b2Free(counts);
+	b2Free(m_ropes);
+	b2Free(m_batches);
+	b2Free(m_buffer);
+
+	m_ropes = ropes;
+	m_ropeCount = ropeCount;
+	m_batches = batches;
+	m_batchCount = batchCount;
+	m_slotCount = slotCount;
+	m_buffer = buffer;
+	m_px = px;
+	m_py = py;
+	m_p0x = p0x;
+	m_p0y = p0y;
+	m_vx = vx;
+	m_vy = vy;
+	m_ims = ims;
+	m_Ls = Ls;
+	m_as = as;
+}
+
+int32 b2RopeSystem::GetVertexCount(int32 index) const
+{
+	b2Assert(0 <= index && index < m_ropeCount);
+	return m_ropes[index].count;
+}
+
+b2Vec2 b2RopeSystem::GetVertex(int32 index, int32 vertex) const
+{
+	b2Assert(0 <= index && index < m_ropeCount);
+	const b2RopeLane* rope = m_ropes + index;
+	b2Assert(0 <= vertex && vertex < rope->count);
+	int32 j = (m_batches[rope->batch].offset + vertex) * b2_simdWidth + rope->lane;
+	return b2Vec2(m_px[j], m_py[j]);
+}
+
+void b2RopeSystem::SetAngle(int32 index, float32 angle)
+{
+	b2Assert(0 <= index && index < m_ropeCount);
+	const b2RopeLane* rope = m_ropes + index;
+	int32 base = m_batches[rope->batch].offset * b2_simdWidth + rope->lane;
+	for (int32 i = 0; i < rope->count - 2; ++i)
+	{
+		m_as[base + i * b2_simdWidth] = angle;
+	}
+}
+
+void b2RopeSystem::Step(float32 h, int32 iterations)
+{
+	if (h == 0.0f)
+	{
+		return;
+	}
+
+	if (m_threadPool != NULL && m_threadPool->GetThreadCount() > 1 && m_batchCount > 1)
+	{
+		b2RopeStepTask task;
+		task.system = this;
+		task.timeStep = h;
+		task.iterations = iterations;
+		m_threadPool->Run(&task, m_batchCount);
+		return;
+	}
+
+	for (int32 i = 0; i < m_batchCount; ++i)
+	{
+		StepBatch(i, h, iterations);
+	}
+}
+
+// b2Atan2 on every lane. This follows the deterministic b2Atan2 step for step,
+// so in B2_DETERMINISTIC builds both give the same bits.
+static b2FloatW b2Atan2W(b2FloatW y, b2FloatW x)
+{
+	b2FloatW zero = b2ZeroW();
+	b2FloatW one = b2SplatW(1.0f);
+
+	// Reduce to the arc tangent of a non-negative ratio.
+	b2FloatW t = y / x;
+	b2FloatW negative = b2GreaterW(zero, t);
+	t = b2SelectW(negative, -t, t);
+
+	// Reduce further to [0, tan(pi/8)].
+	b2FloatW big = b2GreaterW(t, b2SplatW(2.414213562373095f));
+	b2FloatW mid = b2GreaterW(t, b2SplatW(0.4142135623730950f));
+	b2FloatW base = b2SelectW(big, b2SplatW(0.5f * b2_pi), b2SelectW(mid, b2SplatW(0.25f * b2_pi), zero));
+	t = b2SelectW(big, b2SplatW(-1.0f) / t, b2SelectW(mid, (t - one) / (t + one), t));
+
+	b2FloatW z = t * t;
+	b2FloatW p = (((b2SplatW(8.05374449538e-2f) * z - b2SplatW(1.38776856032e-1f)) * z + b2SplatW(1.99777106478e-1f)) * z - b2SplatW(3.33329491539e-1f)) * z * t + t;
+	b2FloatW angle = base + p;
+	angle = b2SelectW(negative, -angle, angle);
+
+	// Move into the quadrant of (x, y).
+	b2FloatW yZero = b2AndW(b2GreaterEqualW(y, zero), b2GreaterEqualW(zero, y));
+	b2FloatW below = b2OrW(b2GreaterW(zero, y), b2AndW(yZero, b2GreaterW(zero, one / y)));
+	b2FloatW turn = b2SelectW(below, b2SplatW(-b2_pi), b2SplatW(b2_pi));
+	angle = b2SelectW(b2GreaterW(zero, x), angle + turn, angle);
+
+	// The y axis.
+	b2FloatW xZero = b2AndW(b2GreaterEqualW(x, zero), b2GreaterEqualW(zero, x));
+	b2FloatW axis = b2SelectW(b2GreaterW(y, zero), b2SplatW(0.5f * b2_pi), b2SelectW(b2GreaterW(zero, y), b2SplatW(-0.5f * b2_pi), zero));
+	return b2SelectW(xZero, axis, angle);
+}
+
+// b2Rope::SolveC2 on one rope per lane. Each vertex is loaded once and kept
+// in registers while the next constraint uses it.
+static void b2SolveRopeC2(float32* px, float32* py, const float32* ims, const float32* Ls,
+						  int32 vertexCount, b2FloatW counts, b2FloatW k2)
+{
+	const int32 width = b2_simdWidth;
+	b2FloatW zero = b2ZeroW();
+	b2FloatW one = b2SplatW(1.0f);
+	b2FloatW epsilon = b2SplatW(b2_epsilon);
+
+	b2FloatW p1x = b2LoadW(px), p1y = b2LoadW(py);
+	b2FloatW im1 = b2LoadW(ims);
+
+	for (int32 i = 0; i < vertexCount - 1; ++i)
+	{
+		int32 j = (i + 1) * width;
+		b2FloatW p2x = b2LoadW(px + j), p2y = b2LoadW(py + j);
+		b2FloatW im2 = b2LoadW(ims + j);
+
+		// Normalize, leaving short segments alone like b2Vec2::Normalize.
+		b2FloatW dx = p2x - p1x, dy = p2y - p1y;
+		b2FloatW L = b2SqrtW(dx * dx + dy * dy);
+		b2FloatW tiny = b2GreaterW(epsilon, L);
+		b2FloatW invL = one / L;
+		dx = b2SelectW(tiny, dx, dx * invL);
+		dy = b2SelectW(tiny, dy, dy * invL);
+		L = b2SelectW(tiny, zero, L);
+
+		b2FloatW sum = im1 + im2;
+		b2FloatW active = b2AndW(b2GreaterW(counts, b2SplatW(float32(i + 1))), b2GreaterW(sum, zero));
+
+		b2FloatW s1 = im1 / sum;
+		b2FloatW s2 = im2 / sum;
+		b2FloatW C = b2LoadW(Ls + i * width) - L;
+		b2FloatW c1 = k2 * s1 * C;
+		b2FloatW c2 = k2 * s2 * C;
+
+		p1x = b2SelectW(active, p1x - c1 * dx, p1x);
+		p1y = b2SelectW(active, p1y - c1 * dy, p1y);
+		p2x = b2SelectW(active, p2x + c2 * dx, p2x);
+		p2y = b2SelectW(active, p2y + c2 * dy, p2y);
+
+		b2StoreW(px + i * width, p1x);
+		b2StoreW(py + i * width, p1y);
+
+		p1x = p2x;
+		p1y = p2y;
+		im1 = im2;
+	}
+
+	b2StoreW(px + (vertexCount - 1) * width, p1x);
+	b2StoreW(py + (vertexCount - 1) * width, p1y);
+}
+
+// b2Rope::SolveC3 on one rope per lane.
+static void b2SolveRopeC3(float32* px, float32* py, const float32* ims, const float32* as,
+						  int32 vertexCount, b2FloatW counts, b2FloatW k3)
+{
+	const int32 width = b2_simdWidth;
+	b2FloatW zero = b2ZeroW();
+	b2FloatW one = b2SplatW(1.0f);
+	b2FloatW pi = b2SplatW(b2_pi);
+	b2FloatW twoPi = b2SplatW(2.0f * b2_pi);
+	b2FloatW negK3 = -k3;
+
+	b2FloatW p1x = b2LoadW(px), p1y = b2LoadW(py);
+	b2FloatW p2x = b2LoadW(px + width), p2y = b2LoadW(py + width);
+	b2FloatW m1 = b2LoadW(ims), m2 = b2LoadW(ims + width);
+
+	for (int32 i = 0; i < vertexCount - 2; ++i)
+	{
+		int32 j = (i + 2) * width;
+		b2FloatW p3x = b2LoadW(px + j), p3y = b2LoadW(py + j);
+		b2FloatW m3 = b2LoadW(ims + j);
+
+		b2FloatW d1x = p2x - p1x, d1y = p2y - p1y;
+		b2FloatW d2x = p3x - p2x, d2y = p3y - p2y;
+
+		b2FloatW L1sqr = d1x * d1x + d1y * d1y;
+		b2FloatW L2sqr = d2x * d2x + d2y * d2y;
+
+		b2FloatW active = b2AndW(b2GreaterW(counts, b2SplatW(float32(i + 2))), b2GreaterW(L1sqr * L2sqr, zero));
+
+		b2FloatW a = d1x * d2y - d1y * d2x;
+		b2FloatW b = d1x * d2x + d1y * d2y;
+		b2FloatW angle = b2Atan2W(a, b);
+
+		b2FloatW r1 = b2SplatW(-1.0f) / L1sqr;
+		b2FloatW r2 = one / L2sqr;
+		b2FloatW Jd1x = r1 * -d1y, Jd1y = r1 * d1x;
+		b2FloatW Jd2x = r2 * -d2y, Jd2y = r2 * d2x;
+
+		b2FloatW J1x = -Jd1x, J1y = -Jd1y;
+		b2FloatW J2x = Jd1x - Jd2x, J2y = Jd1y - Jd2y;
+		b2FloatW J3x = Jd2x, J3y = Jd2y;
+
+		b2FloatW mass = m1 * (J1x * J1x + J1y * J1y) + m2 * (J2x * J2x + J2y * J2y) + m3 * (J3x * J3x + J3y * J3y);
+		active = b2AndW(active, b2GreaterW(mass, zero));
+		mass = one / mass;
+
+		b2FloatW target = b2LoadW(as + i * width);
+		b2FloatW C = angle - target;
+
+		// Wrap into [-pi, pi], one turn at a time like the scalar loops.
+		for (;;)
+		{
+			b2FloatW wrap = b2GreaterW(C, pi);
+			if (b2MaskBitsW(wrap) == 0)
+			{
+				break;
+			}
+			angle = b2SelectW(wrap, angle - twoPi, angle);
+			C = angle - target;
+		}
+
+		for (;;)
+		{
+			b2FloatW wrap = b2GreaterW(-pi, C);
+			if (b2MaskBitsW(wrap) == 0)
+			{
+				break;
+			}
+			angle = b2SelectW(wrap, angle + twoPi, angle);
+			C = angle - target;
+		}
+
+		b2FloatW impulse = negK3 * mass * C;
+		b2FloatW i1 = m1 * impulse, i2 = m2 * impulse, i3 = m3 * impulse;
+
+		p1x = b2SelectW(active, p1x + i1 * J1x, p1x);
+		p1y = b2SelectW(active, p1y + i1 * J1y, p1y);
+		p2x = b2SelectW(active, p2x + i2 * J2x, p2x);
+		p2y = b2SelectW(active, p2y + i2 * J2y, p2y);
+		p3x = b2SelectW(active, p3x + i3 * J3x, p3x);
+		p3y = b2SelectW(active, p3y + i3 * J3y, p3y);
+
+		b2StoreW(px + i * width, p1x);
+		b2StoreW(py + i * width, p1y);
+
+		p1x = p2x;
+		p1y = p2y;
+		p2x = p3x;
+		p2y = p3y;
+		m1 = m2;
+		m2 = m3;
+	}
+
+	b2StoreW(px + (vertexCount - 2) * width, p1x);
+	b2StoreW(py + (vertexCount - 2) * width, p1y);
+	b2StoreW(px + (vertexCount - 1) * width, p2x);
+	b2StoreW(py + (vertexCount - 1) * width, p2y);
+}
+
+void b2RopeSystem::StepBatch(int32 index, float32 h, int32 iterations)
+{
+	const int32 width = b2_simdWidth;
+	const b2RopeBatch* batch = m_batches + index;
+	int32 first = batch->offset * width;
+	int32 vertexCount = batch->vertexCount;
+
+	float32* px = m_px + first;
+	float32* py = m_py + first;
+	float32* p0x = m_p0x + first;
+	float32* p0y = m_p0y + first;
+	float32* vx = m_vx + first;
+	float32* vy = m_vy + first;
+	const float32* ims = m_ims + first;
+	const float32* Ls = m_Ls + first;
+	const float32* as = m_as + first;
+
+	float32 damping[b2_simdWidth];
+	for (int32 i = 0; i < width; ++i)
+	{
+		damping[i] = expf(- h * batch->damping[i]);
+	}
+
+	b2FloatW hW = b2SplatW(h);
+	b2FloatW d = b2LoadW(damping);
+	b2FloatW gx = b2LoadW(batch->gravityX), gy = b2LoadW(batch->gravityY);
+	b2FloatW zero = b2ZeroW();
+
+	for (int32 i = 0; i < vertexCount; ++i)
+	{
+		int32 j = i * width;
+		b2FloatW x = b2LoadW(px + j), y = b2LoadW(py + j);
+		b2FloatW u = b2LoadW(vx + j), v = b2LoadW(vy + j);
+		b2StoreW(p0x + j, x);
+		b2StoreW(p0y + j, y);
+
+		b2FloatW hasMass = b2GreaterW(b2LoadW(ims + j), zero);
+		u = b2SelectW(hasMass, u + hW * gx, u) * d;
+		v = b2SelectW(hasMass, v + hW * gy, v) * d;
+
+		b2StoreW(vx + j, u);
+		b2StoreW(vy + j, v);
+		b2StoreW(px + j, x + hW * u);
+		b2StoreW(py + j, y + hW * v);
+	}
+
+	b2FloatW counts = b2LoadW(batch->counts);
+	b2FloatW k2 = b2LoadW(batch->k2), k3 = b2LoadW(batch->k3);
+	for (int32 i = 0; i < iterations; ++i)
+	{
+		b2SolveRopeC2(px, py, ims, Ls, vertexCount, counts, k2);
+		b2SolveRopeC3(px, py, ims, as, vertexCount, counts, k3);
+		b2SolveRopeC2(px, py, ims, Ls, vertexCount, counts, k2);
+	}
+
+	b2FloatW inv_h = b2SplatW(1.0f / h);
+	for (int32 i = 0; i < vertexCount; ++i)
+	{
+		int32 j = i * width;
+		b2StoreW(vx + j, inv_h * (b2LoadW(px + j) - b2LoadW(p0x + j)));
+		b2StoreW(vy + j, inv_h * (b2LoadW(py + j) - b2LoadW(p0y + j)));
+	}
+}
+
+void b2RopeSystem::Draw(b2Draw* draw) const
+{
+	b2Color c(0.4f, 0.5f, 0.7f);
+
+	for (int32 i = 0; i < m_ropeCount; ++i)
+	{
+		const b2RopeLane* rope = m_ropes + i;
+		int32 base = m_batches[rope->batch].offset * b2_simdWidth + rope->lane;
+		for (int32 j = 0; j < rope->count - 1; ++j)
+		{
+			int32 k1 = base + j * b2_simdWidth;
+			int32 k2 = k1 + b2_simdWidth;
+			draw->DrawSegment(b2Vec2(m_px[k1], m_py[k1]), b2Vec2(m_px[k2], m_py[k2]), c);
+		}
+	}
+}
@@ -0,0 +1,109 @@
+/*
+* Copyright (c) 2013 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_ROPE_SYSTEM_H
+#define B2_ROPE_SYSTEM_H
+
+#include <Box2D/Rope/b2Rope.h>
+
+class b2Draw;
+class b2ThreadPool;
+struct b2RopeBatch;
+struct b2RopeLane;
+
+/// Many ropes stepped together, for effects such as vines or hanging cloth
+/// strips. The vertices of b2_simdWidth ropes are interleaved in shared
+/// buffers so the stretching and bending passes work on one rope per lane,
+/// and these groups of ropes can be stepped on a b2ThreadPool. Every rope is
+/// solved like a b2Rope with the same definition.
+class b2RopeSystem
+{
+public:
+	b2RopeSystem();
+	~b2RopeSystem();
+
+	/// Add a rope. The definition is copied.
+	/// @return the index of the rope.
+	int32 CreateRope(const b2RopeDef* def);
+
+	/// Add count ropes. The buffers are repacked once for all of them, so
+	/// prefer this over many calls to CreateRope.
+	/// @return the index of the first rope, the others follow in order.
+	int32 CreateRopes(const b2RopeDef* defs, int32 count);
+
+	/// Remove all ropes.
+	void Clear();
+
+	/// Register a thread pool used to step the groups of ropes in parallel.
+	/// The pool is owned by you and must remain in scope. Pass NULL to step
+	/// everything on the calling thread.
+	void SetThreadPool(b2ThreadPool* threadPool);
+
+	/// Step all ropes.
+	void Step(float32 timeStep, int32 iterations);
+
+	/// Get the number of ropes.
+	int32 GetRopeCount() const
+	{
+		return m_ropeCount;
+	}
+
+	/// Get the number of vertices of a rope.
+	int32 GetVertexCount(int32 index) const;
+
+	/// Get a vertex of a rope.
+	b2Vec2 GetVertex(int32 index, int32 vertex) const;
+
+	/// Set the target bending angle of a rope, see b2Rope::SetAngle.
+	void SetAngle(int32 index, float32 angle);
+
+	/// Draw all ropes.
+	void Draw(b2Draw* draw) const;
+
+private:
+
+	friend struct b2RopeStepTask;
+
+	void Repack(const b2RopeDef* defs, int32 count);
+	void StepBatch(int32 index, float32 timeStep, int32 iterations);
+
+	b2RopeLane* m_ropes;
+	int32 m_ropeCount;
+
+	b2RopeBatch* m_batches;
+	int32 m_batchCount;
+
+	// Vertex i of the rope in lane k of a batch is at
+	// (batch.offset + i) * b2_simdWidth + k. Ls and as hold the rest length
+	// and angle of the constraints starting at that vertex.
+	int32 m_slotCount;
+	float32* m_buffer;
+	float32* m_px;
+	float32* m_py;
+	float32* m_p0x;
+	float32* m_p0y;
+	float32* m_vx;
+	float32* m_vy;
+	float32* m_ims;
+	float32* m_Ls;
+	float32* m_as;
+
+	b2ThreadPool* m_threadPool;
+};
+
+#endif
@@ -109,37 +109,40 @@ LuaLevel::~LuaLevel()
 	terminateSound();
 }
 
-void LuaLevel::PostSolve(b2Contact* contact, const b2ContactImpulse* impulse)
+// The world only records the solve events of the player fixtures, see init.
+void LuaLevel::processSolveEventsForGame()
 {
 	if (invincibility)
 		return;
 
-	short collision = contact->GetFixtureA()->GetFilterData().categoryBits | contact->GetFixtureB()->GetFilterData().categoryBits;
-
-	if (collision!=PLAYER_BODY_TOUCHING_DEBRIS && collision!=PLAYER_FEET_TOUCHING_DEBRIS)
-		return;
-	b2WorldManifold worldManifold;
-	contact->GetWorldManifold(&worldManifold);
-	b2Vec2 pos = playerBody->GetPosition();
-	bool aboveCenterOfMass = true;
-	for(int j = 0; j < contact->GetManifold()->pointCount; j++) {
-		aboveCenterOfMass &= (worldManifold.points[j].y > pos.y);
-	}
-	if (!aboveCenterOfMass)
-		return;
+	const b2ContactSolveEvent* events = m_contactEvents.GetSolveEvents();
+	int32 eventCount = m_contactEvents.GetSolveEventCount();
+	for (int32 e = 0; e < eventCount; ++e)
+	{
+		const b2ContactSolveEvent* event = events + e;
+		short collision = event->fixtureA->GetFilterData().categoryBits | event->fixtureB->GetFilterData().categoryBits;
 
-	// Should the player be killed?
-	int32 count = contact->GetManifold()->pointCount;
+		if (collision!=PLAYER_BODY_TOUCHING_DEBRIS && collision!=PLAYER_FEET_TOUCHING_DEBRIS)
+			continue;
+		b2Vec2 pos = playerBody->GetPosition();
+		bool aboveCenterOfMass = true;
+		for(int j = 0; j < event->pointCount; j++) {
+			aboveCenterOfMass &= (event->points[j].y > pos.y);
+		}
+		if (!aboveCenterOfMass)
+			continue;
 
-	float32 maxImpulse = 0.0f;
-	for (int32 i = 0; i < count; ++i)
-	{
-		maxImpulse = b2Max(maxImpulse, impulse->normalImpulses[i]);
-	}
+		// Should the player be killed?
+		float32 maxImpulse = 0.0f;
+		for (int32 i = 0; i < event->pointCount; ++i)
+		{
+			maxImpulse = b2Max(maxImpulse, event->normalImpulses[i]);
+		}
 
-	if (maxImpulse > 22.0f)
-	{
-		playerBody->SetUserData((void*)true);
+		if (maxImpulse > 22.0f)
+		{
+			playerBody->SetUserData((void*)true);
+		}
 	}
 }
 
@@ -152,6 +155,9 @@ void LuaLevel::init()
 		delete m_world;
 	m_world = new b2World(gravity);
 
+	// Levels are mostly static edges and boxes, keep them in their own tree.
+	m_world->SetSplitBroadPhase(true);
+
 	//~~LEVEL LOADING~~~~~~~~~~~~~~~~~~~~~~~~
 	b2BodyDef bodyDef;
 	bodyDef.type = b2_staticBody;
@@ -169,6 +175,9 @@ void LuaLevel::init()
 
 	unloadLevelGlobals(luaPState);
 
+	// Long levels only simulate the sectors around the player.
+	m_world->SetStreaming(streamingSectorSize, streamingRadius);
+
 	//~~~~~~PLAYER STUFF
 	//~~~~~~~~~~~~~~~~~~~~Sprites
 	vector<unsigned char> image;
@@ -273,7 +282,11 @@ void LuaLevel::init()
 	m_destructionListener.luaLevel = this;
 	m_world->SetDestructionListener(&m_destructionListener);
 	m_world->SetDebugDraw(&m_debugDraw);
-	m_world->SetContactListener(this);
+	// Only contacts of the player matter to the game. Buffer their events
+	// instead of taking a listener call for every contact in the world.
+	m_contactEvents.SetCategoryMask(playerBodyBits | playerFeetBits);
+	m_world->SetContactListener(NULL);
+	m_world->SetContactEvents(&m_contactEvents);
 }
 
 void LuaLevel::drawGame(Settings* settings, float32 timeStep)
@@ -290,7 +303,9 @@ void LuaLevel::drawGame(Settings* settings, float32 timeStep)
 		stepFunction(timeStep);
 	}
 
+	m_world->SetStreamingFocus(playerBody->GetPosition());
 	m_world->Step(timeStep, 8, 3);
+	processSolveEventsForGame();
 }
 
 void LuaLevel::processCollisionsForGame(Settings* settings)
@@ -1030,6 +1045,8 @@ void LuaLevel::loadLevelGlobals(LuaState *pstate)
 	metaTableObj.RegisterObjectDirect("createFrictionlessEdge", (LuaLevel *)nullptr, &LuaLevel::createFrictionlessEdge);
 	metaTableObj.RegisterObjectDirect("createBox", (LuaLevel *)nullptr, &LuaLevel::createBox);
 	metaTableObj.RegisterObjectDirect("createDebris", (LuaLevel *)nullptr, &LuaLevel::createDebris);
+	metaTableObj.RegisterObjectDirect("loadWorld", (LuaLevel *)nullptr, &LuaLevel::loadWorld);
+	metaTableObj.RegisterObjectDirect("saveWorld", (LuaLevel *)nullptr, &LuaLevel::saveWorld);
 
 	LuaObject box2DFactoryObject = pstate->BoxPointer(this);
 	box2DFactoryObject.SetMetaTable(metaTableObj);
@@ -1051,6 +1068,8 @@ void LuaLevel::loadLevelGlobals(LuaState *pstate)
 	globals.SetNumber("wizardPositionX",-50);
 	globals.SetNumber("wizardPositionY",-50);
 	globals.SetNumber("winHeight",60);
+	globals.SetNumber("streamingSectorSize",10);
+	globals.SetNumber("streamingRadius",0);
 
 
 
@@ -1108,6 +1127,14 @@ void LuaLevel::unloadLevelGlobals(LuaState *pstate)
 	{
 		winHeight = (float)pstate->GetGlobal("winHeight").GetNumber();
 	}
+	if (pstate->GetGlobal("streamingSectorSize").IsNumber())
+	{
+		streamingSectorSize = (float)pstate->GetGlobal("streamingSectorSize").GetNumber();
+	}
+	if (pstate->GetGlobal("streamingRadius").IsNumber())
+	{
+		streamingRadius = (float)pstate->GetGlobal("streamingRadius").GetNumber();
+	}
 
 	if (pstate->GetGlobal("wizardPositionX").IsNumber())
 	{
@@ -1261,6 +1288,54 @@ int LuaLevel::createDebris( float32 x, float32 y)
 	return 0;
 }
 
+// Load the bodies of a binary world file (see b2WorldFile.h) instead of running
+// hundreds of createEdge/createBox calls.
+int LuaLevel::loadWorld(const char* file)
+{
+	FILE* f = fopen(file, "rb");
+	if (f == NULL)
+	{
+		std::cout << "Could not open world file " << file << std::endl;
+		return 0;
+	}
+
+	fseek(f, 0, SEEK_END);
+	long size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	// int32 storage keeps the tables aligned.
+	vector<int32> data((size + 3) / 4);
+	bool ok = size > 0 && fread(&data[0], 1, size, f) == (size_t)size;
+	fclose(f);
+
+	if (ok == false || m_world->Load(&data[0], (int32)size, false) == false)
+	{
+		std::cout << "Invalid world file " << file << std::endl;
+		return 0;
+	}
+
+	return 1;
+}
+
+// Bake the current level, e.g. call it at the end of a level script once.
+int LuaLevel::saveWorld(const char* file)
+{
+	int32 size = m_world->GetSaveSize();
+	vector<int32> data((size + 3) / 4);
+	m_world->Save(&data[0], size);
+
+	FILE* f = fopen(file, "wb");
+	if (f == NULL)
+	{
+		std::cout << "Could not write world file " << file << std::endl;
+		return 0;
+	}
+
+	fwrite(&data[0], 1, size, f);
+	fclose(f);
+	return 1;
+}
+
 int LuaLevel::createButton(float x, float y, const char* file1, const char* file2, int state, LuaStackObject statesToShow)
 {
 	Graphics::Texture hovering,standard;
@@ -53,7 +53,7 @@ struct Button
 	vector<GameState> statesToShow;
 };
 
-class LuaLevel : b2ContactListener
+class LuaLevel
 {
 public:
 
@@ -81,22 +81,17 @@ public:
 	int createFrictionlessEdge(float32 x1, float32 y1, float32 x2, float32 y2);
 	int createBox( float32 x, float32 y, float32 hw, float32 hh);
 	int createDebris( float32 x, float32 y);
+	int loadWorld(const char* file);
+	int saveWorld(const char* file);
 	void init();
 	int createButton(float x, float y, const char* file1,const char* file2, int state, LuaStackObject statesToShow);
 
-	virtual void BeginContact(b2Contact* contact) { B2_NOT_USED(contact); }
-	virtual void EndContact(b2Contact* contact) { B2_NOT_USED(contact); }
-	virtual void PreSolve(b2Contact* contact, const b2Manifold* oldManifold) 
-	{
-		B2_NOT_USED(contact); 
-		B2_NOT_USED(oldManifold);
-	}
-	virtual void PostSolve(b2Contact* contact, const b2ContactImpulse* impulse);
 protected:
 	vector<Button> buttons;
 
 	//helper methods to break up code
 	inline void processCollisionsForGame(Settings* settings);
+	inline void processSolveEventsForGame();
 	inline void processInputForGame(Settings *settings, float32 timeStep);
 	
 	LuaState* luaPState;
@@ -111,6 +106,7 @@ protected:
 
 	b2World* m_world;
 	LuaLevelDestructionListener m_destructionListener;
+	b2ContactEvents m_contactEvents;
 	DebugDraw m_debugDraw;
 	GameState gameState;
 
@@ -160,6 +156,8 @@ protected:
 	bool wizardIsFacingRight;
 	float viewportMaximumX;
 	float winHeight;
+	float streamingSectorSize;
+	float streamingRadius;
 	bool secret;
 
 	int died;
@@ -406,6 +406,8 @@ int main(int argc, char** argv)
 	glui->add_checkbox("Warm Starting", &settings.enableWarmStarting);
 	glui->add_checkbox("Time of Impact", &settings.enableContinuous);
 	glui->add_checkbox("Sub-Stepping", &settings.enableSubStepping);
+	glui->add_checkbox("Speculative Contacts", &settings.enableSpeculative);
+	glui->add_checkbox("Batched Joints", &settings.enableBatchedJoints);
 
 	//glui->add_separator();
 
@@ -291,6 +291,8 @@ void Test::Step(Settings* settings)
 	m_world->SetWarmStarting(settings->enableWarmStarting > 0);
 	m_world->SetContinuousPhysics(settings->enableContinuous > 0);
 	m_world->SetSubStepping(settings->enableSubStepping > 0);
+	m_world->SetSpeculativeContacts(settings->enableSpeculative > 0);
+	m_world->SetBatchedJoints(settings->enableBatchedJoints > 0);
 
 	m_pointCount = 0;
 
@@ -311,12 +313,23 @@ void Test::Step(Settings* settings)
 		m_debugDraw.DrawString(5, m_textLine, "bodies/contacts/joints = %d/%d/%d", bodyCount, contactCount, jointCount);
 		m_textLine += 15;
 
+		int32 islandCount = m_world->GetIslandCount();
+		int32 rebuiltCount = m_world->GetRebuiltIslandCount();
+		m_debugDraw.DrawString(5, m_textLine, "islands/rebuilt = %d/%d", islandCount, rebuiltCount);
+		m_textLine += 15;
+
 		int32 proxyCount = m_world->GetProxyCount();
 		int32 height = m_world->GetTreeHeight();
 		int32 balance = m_world->GetTreeBalance();
 		float32 quality = m_world->GetTreeQuality();
 		m_debugDraw.DrawString(5, m_textLine, "proxies/height/balance/quality = %d/%d/%d/%g", proxyCount, height, balance, quality);
 		m_textLine += 15;
+
+		b2AllocatorStats allocatorStats = m_world->GetAllocatorStats();
+		m_debugDraw.DrawString(5, m_textLine, "stack peak/capacity/fallbacks = %d/%d/%d", allocatorStats.stackPeak, allocatorStats.stackCapacity, allocatorStats.stackFallbacks);
+		m_textLine += 15;
+		m_debugDraw.DrawString(5, m_textLine, "block peak/fallbacks = %d/%d", allocatorStats.blockPeak, allocatorStats.blockFallbacks);
+		m_textLine += 15;
 	}
 
 	// Track maximum profile times
@@ -329,6 +342,10 @@ void Test::Step(Settings* settings)
 		m_maxProfile.solveVelocity = b2Max(m_maxProfile.solveVelocity, p.solveVelocity);
 		m_maxProfile.solvePosition = b2Max(m_maxProfile.solvePosition, p.solvePosition);
 		m_maxProfile.solveTOI = b2Max(m_maxProfile.solveTOI, p.solveTOI);
+		m_maxProfile.solveTOISearch = b2Max(m_maxProfile.solveTOISearch, p.solveTOISearch);
+		m_maxProfile.toiCount = b2Max(m_maxProfile.toiCount, p.toiCount);
+		m_maxProfile.polygonCacheHits = b2Max(m_maxProfile.polygonCacheHits, p.polygonCacheHits);
+		m_maxProfile.polygonCacheMisses = b2Max(m_maxProfile.polygonCacheMisses, p.polygonCacheMisses);
 		m_maxProfile.broadphase = b2Max(m_maxProfile.broadphase, p.broadphase);
 
 		m_totalProfile.step += p.step;
@@ -338,6 +355,10 @@ void Test::Step(Settings* settings)
 		m_totalProfile.solveVelocity += p.solveVelocity;
 		m_totalProfile.solvePosition += p.solvePosition;
 		m_totalProfile.solveTOI += p.solveTOI;
+		m_totalProfile.solveTOISearch += p.solveTOISearch;
+		m_totalProfile.toiCount += p.toiCount;
+		m_totalProfile.polygonCacheHits += p.polygonCacheHits;
+		m_totalProfile.polygonCacheMisses += p.polygonCacheMisses;
 		m_totalProfile.broadphase += p.broadphase;
 	}
 
@@ -357,6 +378,7 @@ void Test::Step(Settings* settings)
 			aveProfile.solveVelocity = scale * m_totalProfile.solveVelocity;
 			aveProfile.solvePosition = scale * m_totalProfile.solvePosition;
 			aveProfile.solveTOI = scale * m_totalProfile.solveTOI;
+			aveProfile.solveTOISearch = scale * m_totalProfile.solveTOISearch;
 			aveProfile.broadphase = scale * m_totalProfile.broadphase;
 		}
 
@@ -374,6 +396,17 @@ void Test::Step(Settings* settings)
 		m_textLine += 15;
 		m_debugDraw.DrawString(5, m_textLine, "solveTOI [ave] (max) = %5.2f [%6.2f] (%6.2f)", p.solveTOI, aveProfile.solveTOI, m_maxProfile.solveTOI);
 		m_textLine += 15;
+		m_debugDraw.DrawString(5, m_textLine, "TOI search [ave] (max) = %5.2f [%6.2f] (%6.2f)", p.solveTOISearch, aveProfile.solveTOISearch, m_maxProfile.solveTOISearch);
+		m_textLine += 15;
+		float32 aveTOICount = m_stepCount > 0 ? float32(m_totalProfile.toiCount) / m_stepCount : 0.0f;
+		m_debugDraw.DrawString(5, m_textLine, "TOI events [ave] (max) = %d [%6.2f] (%d)", p.toiCount, aveTOICount, m_maxProfile.toiCount);
+		m_textLine += 15;
+		float32 aveCacheHits = m_stepCount > 0 ? float32(m_totalProfile.polygonCacheHits) / m_stepCount : 0.0f;
+		m_debugDraw.DrawString(5, m_textLine, "polygon cache hits [ave] (max) = %d [%6.2f] (%d)", p.polygonCacheHits, aveCacheHits, m_maxProfile.polygonCacheHits);
+		m_textLine += 15;
+		float32 aveCacheMisses = m_stepCount > 0 ? float32(m_totalProfile.polygonCacheMisses) / m_stepCount : 0.0f;
+		m_debugDraw.DrawString(5, m_textLine, "polygon cache misses [ave] (max) = %d [%6.2f] (%d)", p.polygonCacheMisses, aveCacheMisses, m_maxProfile.polygonCacheMisses);
+		m_textLine += 15;
 		m_debugDraw.DrawString(5, m_textLine, "broad-phase [ave] (max) = %5.2f [%6.2f] (%6.2f)", p.broadphase, aveProfile.broadphase, m_maxProfile.broadphase);
 		m_textLine += 15;
 	}
@@ -71,6 +71,8 @@ struct Settings
 		enableWarmStarting(1),
 		enableContinuous(1),
 		enableSubStepping(0),
+		enableSpeculative(0),
+		enableBatchedJoints(0),
 		pause(0),
 		singleStep(0)
 		{}
@@ -93,6 +95,8 @@ struct Settings
 	int32 enableWarmStarting;
 	int32 enableContinuous;
 	int32 enableSubStepping;
+	int32 enableSpeculative;
+	int32 enableBatchedJoints;
 	int32 pause;
 	int32 singleStep;
 };
@@ -0,0 +1,261 @@
+/*
+* Copyright (c) 2013 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef LEVEL_RESET_H
+#define LEVEL_RESET_H
+
+// A StepStone style level: a ground body made of edges and boxes, a player with
+// body and feet fixtures, and falling debris. The level is reset periodically,
+// alternating between rebuilding the world from scratch, like the level loader
+// does, and restoring a snapshot taken right after the level was built.
+// Press 's' to restore the snapshot and 'l' to rebuild the level.
+class LevelReset : public Test
+{
+public:
+
+	enum
+	{
+		e_columnCount = 400,
+		e_platformCount = 150,
+		e_debrisCount = 120,
+		e_resetInterval = 240
+	};
+
+	LevelReset()
+	{
+		// Like the level loader.
+		m_world->SetSplitBroadPhase(true);
+
+		BuildLevel();
+		m_world->Snapshot(&m_snapshot);
+
+		m_rebuildTime = 0.0f;
+		m_restoreTime = 0.0f;
+		m_rebuildCount = 0;
+		m_restoreCount = 0;
+		m_levelStepCount = 0;
+		m_nextReset = 0;
+	}
+
+	static Test* Create()
+	{
+		return new LevelReset;
+	}
+
+	void Keyboard(unsigned char key)
+	{
+		switch (key)
+		{
+		case 's':
+			RestoreLevel();
+			break;
+
+		case 'l':
+			RebuildLevel();
+			break;
+		}
+	}
+
+	void Step(Settings* settings)
+	{
+		if (m_levelStepCount == e_resetInterval)
+		{
+			if (m_nextReset == 0)
+			{
+				RebuildLevel();
+			}
+			else
+			{
+				RestoreLevel();
+			}
+
+			m_nextReset = 1 - m_nextReset;
+		}
+
+		if (settings->pause == 0 || settings->singleStep)
+		{
+			if (m_levelStepCount % 20 == 0)
+			{
+				CreateDebris(RandomFloat(-40.0f, 40.0f), 30.0f);
+			}
+
+			++m_levelStepCount;
+		}
+
+		Test::Step(settings);
+
+		m_debugDraw.DrawString(5, m_textLine, "bodies = %d, contacts = %d, snapshot = %d KB",
+			m_world->GetBodyCount(), m_world->GetContactCount(), m_snapshot.GetSize() / 1024);
+		m_textLine += 15;
+
+		m_debugDraw.DrawString(5, m_textLine, "rebuild: %6.3f ms (%d), restore: %6.3f ms (%d)",
+			m_rebuildCount > 0 ? m_rebuildTime / m_rebuildCount : 0.0f, m_rebuildCount,
+			m_restoreCount > 0 ? m_restoreTime / m_restoreCount : 0.0f, m_restoreCount);
+		m_textLine += 15;
+	}
+
+private:
+
+	void BuildLevel()
+	{
+		srand(1234);
+
+		// Terrain edges, like createEdge.
+		{
+			b2EdgeShape shape;
+			b2FixtureDef fd;
+			fd.shape = &shape;
+
+			float32 x = -0.5f * e_columnCount;
+			float32 y = 0.0f;
+			for (int32 i = 0; i < e_columnCount; ++i)
+			{
+				float32 y2 = b2Clamp(y + RandomFloat(-0.5f, 0.5f), -2.0f, 2.0f);
+				shape.Set(b2Vec2(x, y), b2Vec2(x + 1.0f, y2));
+				m_groundBody->CreateFixture(&fd);
+				x += 1.0f;
+				y = y2;
+			}
+		}
+
+		// Platforms, like createBox.
+		{
+			b2PolygonShape shape;
+			b2FixtureDef fd;
+			fd.shape = &shape;
+
+			for (int32 i = 0; i < e_platformCount; ++i)
+			{
+				float32 x = RandomFloat(-0.5f * e_columnCount, 0.5f * e_columnCount);
+				float32 y = RandomFloat(5.0f, 25.0f);
+				float32 w = RandomFloat(2.0f, 6.0f);
+				shape.SetAsBox(0.5f * w, 0.25f, b2Vec2(x + 0.5f * w, y + 0.25f), 0.0f);
+				m_groundBody->CreateFixture(&fd);
+			}
+		}
+
+		// The player.
+		{
+			b2BodyDef bd;
+			bd.type = b2_dynamicBody;
+			bd.position.Set(0.0f, 2.0f);
+			bd.fixedRotation = true;
+			b2Body* body = m_world->CreateBody(&bd);
+
+			b2PolygonShape shape;
+			b2FixtureDef fd;
+			fd.shape = &shape;
+			fd.friction = 0.0f;
+			fd.density = 1.0f;
+			shape.SetAsBox(0.6f, 1.28f);
+			body->CreateFixture(&fd);
+
+			shape.SetAsBox(0.6f, 0.2f, b2Vec2(0.0f, -1.28f), 0.0f);
+			fd.density = 0.0f;
+			body->CreateFixture(&fd);
+		}
+
+		for (int32 i = 0; i < e_debrisCount; ++i)
+		{
+			CreateDebris(RandomFloat(-40.0f, 40.0f), RandomFloat(3.0f, 30.0f));
+		}
+	}
+
+	void CreateDebris(float32 x, float32 y)
+	{
+		b2BodyDef bd;
+		bd.type = b2_dynamicBody;
+		bd.position.Set(x, y);
+		bd.angle = RandomFloat(-b2_pi, b2_pi);
+		b2Body* body = m_world->CreateBody(&bd);
+
+		b2PolygonShape shape;
+		shape.SetAsBox(RandomFloat(0.2f, 0.6f), RandomFloat(0.2f, 0.6f));
+
+		b2FixtureDef fd;
+		fd.shape = &shape;
+		fd.density = 1.0f;
+		fd.friction = 0.4f;
+		body->CreateFixture(&fd);
+	}
+
+	// What the level loader does: throw the world away and create everything again.
+	void RebuildLevel()
+	{
+		b2Timer timer;
+
+		delete m_world;
+		m_bomb = NULL;
+		m_mouseJoint = NULL;
+
+		m_world = new b2World(b2Vec2(0.0f, -10.0f));
+		m_world->SetDestructionListener(&m_destructionListener);
+		m_world->SetContactListener(this);
+		m_world->SetDebugDraw(&m_debugDraw);
+		m_world->SetSplitBroadPhase(true);
+
+		b2BodyDef bd;
+		m_groundBody = m_world->CreateBody(&bd);
+
+		BuildLevel();
+
+		m_rebuildTime += timer.GetMilliseconds();
+		++m_rebuildCount;
+
+		// The old snapshot refers to the old world.
+		m_world->Snapshot(&m_snapshot);
+		m_levelStepCount = 0;
+	}
+
+	void RestoreLevel()
+	{
+		// The restore does not call the destruction listener.
+		if (m_mouseJoint)
+		{
+			m_world->DestroyJoint(m_mouseJoint);
+			m_mouseJoint = NULL;
+		}
+
+		if (m_bomb)
+		{
+			m_world->DestroyBody(m_bomb);
+			m_bomb = NULL;
+		}
+
+		b2Timer timer;
+
+		bool ok = m_world->Restore(&m_snapshot);
+		b2Assert(ok);
+		B2_NOT_USED(ok);
+
+		m_restoreTime += timer.GetMilliseconds();
+		++m_restoreCount;
+
+		m_levelStepCount = 0;
+	}
+
+	b2Snapshot m_snapshot;
+	float32 m_rebuildTime;
+	float32 m_restoreTime;
+	int32 m_rebuildCount;
+	int32 m_restoreCount;
+	int32 m_levelStepCount;
+	int32 m_nextReset;
+};
+
+#endif
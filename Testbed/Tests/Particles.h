@@ -0,0 +1,128 @@
+/*
+* Copyright (c) 2013 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+/// A tank of particles stirred by a kinematic paddle. The particles collide
+/// with the fixtures through the broad-phase and push each other apart, but
+/// they have no bodies of their own.
+class Particles : public Test
+{
+public:
+	enum
+	{
+		e_maxCount = 4000
+	};
+
+	Particles()
+	{
+		{
+			b2BodyDef bd;
+			b2Body* ground = m_world->CreateBody(&bd);
+
+			b2Vec2 vs[4];
+			vs[0].Set(-20.0f, 40.0f);
+			vs[1].Set(-20.0f, 0.0f);
+			vs[2].Set(20.0f, 0.0f);
+			vs[3].Set(20.0f, 40.0f);
+			b2ChainShape chain;
+			chain.CreateChain(vs, 4);
+			ground->CreateFixture(&chain, 0.0f);
+
+			b2PolygonShape shape;
+			shape.SetAsBox(6.0f, 0.5f, b2Vec2(-10.0f, 20.0f), -0.4f);
+			ground->CreateFixture(&shape, 0.0f);
+
+			b2CircleShape circle;
+			circle.m_p.Set(10.0f, 12.0f);
+			circle.m_radius = 2.0f;
+			ground->CreateFixture(&circle, 0.0f);
+		}
+
+		{
+			b2BodyDef bd;
+			bd.type = b2_kinematicBody;
+			bd.position.Set(0.0f, 4.0f);
+			bd.angularVelocity = 1.0f;
+			b2Body* paddle = m_world->CreateBody(&bd);
+
+			b2PolygonShape shape;
+			shape.SetAsBox(3.0f, 0.25f);
+			paddle->CreateFixture(&shape, 0.0f);
+		}
+
+		{
+			b2BodyDef bd;
+			bd.type = b2_dynamicBody;
+			bd.position.Set(12.0f, 30.0f);
+			b2Body* body = m_world->CreateBody(&bd);
+
+			b2PolygonShape shape;
+			shape.SetAsBox(1.0f, 1.0f);
+			body->CreateFixture(&shape, 1.0f);
+		}
+
+		b2ParticleSystemDef def;
+		def.radius = 0.15f;
+		def.viscousStrength = 0.25f;
+		def.maxCount = e_maxCount;
+		m_particleSystem = m_world->CreateParticleSystem(&def);
+	}
+
+	void Keyboard(unsigned char key)
+	{
+		switch (key)
+		{
+		case 'c':
+			m_particleSystem->DestroyParticles();
+			break;
+		}
+	}
+
+	void Step(Settings* settings)
+	{
+		// Pour a few particles each step until the system is full.
+		if (settings->pause == 0 || settings->singleStep)
+		{
+			for (int32 i = 0; i < 8; ++i)
+			{
+				b2ParticleDef pd;
+				pd.position.Set(-14.0f + 0.3f * i, 36.0f);
+				pd.velocity.Set(2.0f, -5.0f);
+				m_particleSystem->CreateParticle(pd);
+			}
+		}
+
+		Test::Step(settings);
+
+		m_debugDraw.DrawString(5, m_textLine, "Press c to clear the particles");
+		m_textLine += 15;
+		m_debugDraw.DrawString(5, m_textLine, "particles = %d", m_particleSystem->GetParticleCount());
+		m_textLine += 15;
+	}
+
+	static Test* Create()
+	{
+		return new Particles;
+	}
+
+	b2ParticleSystem* m_particleSystem;
+};
+
+#endif
@@ -50,7 +50,9 @@ using namespace std;
 #include "EdgeShapes.h"
 #include "EdgeTest.h"
 #include "Gears.h"
+#include "LevelReset.h"
 #include "OneSidedPlatform.h"
+#include "Particles.h"
 #include "Pinball.h"
 #include "PolyCollision.h"
 #include "PolyShapes.h"
@@ -68,10 +70,12 @@ using namespace std;
 #include "TheoJansen.h"
 #include "Tiles.h"
 #include "TimeOfImpact.h"
+#include "TreeBenchmark.h"
 #include "Tumbler.h"
 #include "VaryingFriction.h"
 #include "VaryingRestitution.h"
 #include "VerticalStack.h"
+#include "Vines.h"
 #include "Web.h"
 
 TestEntry g_testEntries[] =
@@ -96,6 +100,8 @@ TestEntry g_testEntries[] =
 	{"Polygon Shapes", PolyShapes::Create},
 	//{"Rope", Rope::Create},
 	{"Web", Web::Create},
+	{"Vines", Vines::Create},
+	{"Particles", Particles::Create},
 	{"RopeJoint", RopeJoint::Create},
 	{"One-Sided Platform", OneSidedPlatform::Create},
 	{"Pinball", Pinball::Create},
@@ -117,6 +123,8 @@ TestEntry g_testEntries[] =
 	{"Distance Test", DistanceTest::Create},
 	{"Dominos", Dominos::Create},
 	{"Dynamic Tree", DynamicTreeTest::Create},
+	{"Tree Benchmark", TreeBenchmark::Create},
+	{"Level Reset", LevelReset::Create},
 	{"Sensor Test", SensorTest::Create},
 	{"Slider Crank", SliderCrank::Create},
 	{"Varying Friction", VaryingFriction::Create},
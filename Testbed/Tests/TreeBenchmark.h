@@ -0,0 +1,306 @@
+/*
+* Copyright (c) 2013 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef TREE_BENCHMARK_H
+#define TREE_BENCHMARK_H
+
+// The Dynamic Tree test workload at a larger scale, replayed on b2DynamicTree and
+// on b2WideTree. Both trees get the same random actions, queries and ray casts
+// each step and must agree on the results. The time spent in each tree is shown.
+class TreeBenchmark : public Test
+{
+public:
+
+	enum
+	{
+		e_actorCount = 2048,
+		e_actionCount = e_actorCount >> 2,
+		e_queryCount = 64
+	};
+
+	TreeBenchmark()
+	{
+		m_worldExtent = 60.0f;
+		m_proxyExtent = 0.5f;
+
+		srand(888);
+
+		for (int32 i = 0; i < e_actorCount; ++i)
+		{
+			GetRandomAABB(m_aabbs + i);
+			m_alive[i] = true;
+		}
+
+		m_binary.Create(m_aabbs);
+		m_wide.Create(m_aabbs);
+
+		m_stepCount = 0;
+		m_binaryTime = 0.0f;
+		m_wideTime = 0.0f;
+	}
+
+	static Test* Create()
+	{
+		return new TreeBenchmark;
+	}
+
+	void Step(Settings* settings)
+	{
+		B2_NOT_USED(settings);
+
+		// Script this step so that both trees see the same thing.
+		for (int32 i = 0; i < e_actionCount; ++i)
+		{
+			Action(m_actions + i);
+		}
+
+		for (int32 i = 0; i < e_queryCount; ++i)
+		{
+			b2Vec2 c(RandomFloat(-m_worldExtent, m_worldExtent), RandomFloat(0.0f, 2.0f * m_worldExtent));
+			m_queries[i].lowerBound = c - b2Vec2(4.0f, 5.0f);
+			m_queries[i].upperBound = c + b2Vec2(4.0f, 5.0f);
+
+			m_rays[i].p1 = c;
+			m_rays[i].p2 = c + b2Vec2(RandomFloat(-12.0f, 12.0f), RandomFloat(-9.0f, 9.0f));
+			m_rays[i].maxFraction = 1.0f;
+		}
+
+		b2Timer timer;
+		m_binary.Replay(m_actions, e_actionCount, m_queries, m_rays, e_queryCount);
+		m_binaryTime += timer.GetMilliseconds();
+
+		timer.Reset();
+		m_wide.Replay(m_actions, e_actionCount, m_queries, m_rays, e_queryCount);
+		m_wideTime += timer.GetMilliseconds();
+
+		b2Assert(m_binary.m_overlapCount == m_wide.m_overlapCount);
+		b2Assert(m_binary.m_rayFraction == m_wide.m_rayFraction);
+
+		++m_stepCount;
+
+		for (int32 i = 0; i < e_actorCount; ++i)
+		{
+			if (m_alive[i])
+			{
+				m_debugDraw.DrawAABB(m_aabbs + i, b2Color(0.9f, 0.9f, 0.9f));
+			}
+		}
+
+		m_debugDraw.DrawString(5, m_textLine, "overlaps = %d, ray fractions = %6.2f",
+			m_binary.m_overlapCount, m_binary.m_rayFraction);
+		m_textLine += 15;
+
+		m_debugDraw.DrawString(5, m_textLine, "binary tree: %6.3f ms/step, height = %d, quality = %4.2f",
+			m_binaryTime / m_stepCount, m_binary.m_tree.GetHeight(), m_binary.m_tree.GetAreaRatio());
+		m_textLine += 15;
+
+		m_debugDraw.DrawString(5, m_textLine, "wide tree:   %6.3f ms/step, height = %d, quality = %4.2f",
+			m_wideTime / m_stepCount, m_wide.m_tree.GetHeight(), m_wide.m_tree.GetAreaRatio());
+		m_textLine += 15;
+	}
+
+private:
+
+	enum ActionType
+	{
+		e_none,
+		e_create,
+		e_destroy,
+		e_move
+	};
+
+	struct ScriptedAction
+	{
+		ActionType type;
+		int32 actor;
+		b2Vec2 displacement;
+	};
+
+	// One tree and its proxies.
+	template <typename T>
+	struct Run
+	{
+		void Create(b2AABB* aabbs)
+		{
+			m_aabbs = aabbs;
+			for (int32 i = 0; i < e_actorCount; ++i)
+			{
+				m_proxyIds[i] = m_tree.CreateProxy(aabbs[i], aabbs + i);
+			}
+		}
+
+		void Replay(const ScriptedAction* actions, int32 actionCount,
+			const b2AABB* queries, const b2RayCastInput* rays, int32 queryCount)
+		{
+			for (int32 i = 0; i < actionCount; ++i)
+			{
+				const ScriptedAction* action = actions + i;
+				int32 j = action->actor;
+				switch (action->type)
+				{
+				case e_create:
+					m_proxyIds[j] = m_tree.CreateProxy(m_aabbs[j], m_aabbs + j);
+					break;
+
+				case e_destroy:
+					m_tree.DestroyProxy(m_proxyIds[j]);
+					m_proxyIds[j] = b2_nullNode;
+					break;
+
+				case e_move:
+					m_tree.MoveProxy(m_proxyIds[j], m_aabbs[j], action->displacement);
+					break;
+
+				default:
+					break;
+				}
+			}
+
+			m_overlapCount = 0;
+			m_rayFraction = 0.0f;
+			for (int32 i = 0; i < queryCount; ++i)
+			{
+				m_queryAABB = queries[i];
+				m_tree.Query(this, m_queryAABB);
+
+				m_rayHit = 1.0f;
+				m_tree.RayCast(this, rays[i]);
+				m_rayFraction += m_rayHit;
+			}
+		}
+
+		bool QueryCallback(int32 proxyId)
+		{
+			const b2AABB* aabb = (const b2AABB*)m_tree.GetUserData(proxyId);
+			if (b2TestOverlap(m_queryAABB, *aabb))
+			{
+				++m_overlapCount;
+			}
+			return true;
+		}
+
+		float32 RayCastCallback(const b2RayCastInput& input, int32 proxyId)
+		{
+			const b2AABB* aabb = (const b2AABB*)m_tree.GetUserData(proxyId);
+
+			b2RayCastOutput output;
+			bool hit = aabb->RayCast(&output, input);
+
+			if (hit)
+			{
+				m_rayHit = output.fraction;
+				return output.fraction;
+			}
+
+			return input.maxFraction;
+		}
+
+		T m_tree;
+		b2AABB* m_aabbs;
+		int32 m_proxyIds[e_actorCount];
+		b2AABB m_queryAABB;
+		int32 m_overlapCount;
+		float32 m_rayHit;
+		float32 m_rayFraction;
+	};
+
+	void GetRandomAABB(b2AABB* aabb)
+	{
+		b2Vec2 w; w.Set(2.0f * m_proxyExtent, 2.0f * m_proxyExtent);
+		aabb->lowerBound.x = RandomFloat(-m_worldExtent, m_worldExtent);
+		aabb->lowerBound.y = RandomFloat(0.0f, 2.0f * m_worldExtent);
+		aabb->upperBound = aabb->lowerBound + w;
+	}
+
+	void MoveAABB(b2AABB* aabb)
+	{
+		b2Vec2 d;
+		d.x = RandomFloat(-0.5f, 0.5f);
+		d.y = RandomFloat(-0.5f, 0.5f);
+		aabb->lowerBound += d;
+		aabb->upperBound += d;
+
+		b2Vec2 c0 = 0.5f * (aabb->lowerBound + aabb->upperBound);
+		b2Vec2 min; min.Set(-m_worldExtent, 0.0f);
+		b2Vec2 max; max.Set(m_worldExtent, 2.0f * m_worldExtent);
+		b2Vec2 c = b2Clamp(c0, min, max);
+
+		aabb->lowerBound += c - c0;
+		aabb->upperBound += c - c0;
+	}
+
+	// Same odds as the Dynamic Tree test: mostly moves, some creates and destroys.
+	void Action(ScriptedAction* action)
+	{
+		int32 choice = rand() % 20;
+		ActionType type = choice == 0 ? e_create : (choice == 1 ? e_destroy : e_move);
+
+		for (int32 i = 0; i < e_actorCount; ++i)
+		{
+			int32 j = rand() % e_actorCount;
+			if (m_alive[j] == (type == e_create))
+			{
+				continue;
+			}
+
+			action->type = type;
+			action->actor = j;
+			action->displacement.SetZero();
+
+			if (type == e_create)
+			{
+				GetRandomAABB(m_aabbs + j);
+				m_alive[j] = true;
+			}
+			else if (type == e_destroy)
+			{
+				m_alive[j] = false;
+			}
+			else
+			{
+				b2AABB aabb0 = m_aabbs[j];
+				MoveAABB(m_aabbs + j);
+				action->displacement = m_aabbs[j].GetCenter() - aabb0.GetCenter();
+			}
+			return;
+		}
+
+		action->type = e_none;
+		action->actor = 0;
+		action->displacement.SetZero();
+	}
+
+	float32 m_worldExtent;
+	float32 m_proxyExtent;
+
+	b2AABB m_aabbs[e_actorCount];
+	bool m_alive[e_actorCount];
+
+	ScriptedAction m_actions[e_actionCount];
+	b2AABB m_queries[e_queryCount];
+	b2RayCastInput m_rays[e_queryCount];
+
+	Run<b2DynamicTree> m_binary;
+	Run<b2WideTree> m_wide;
+
+	int32 m_stepCount;
+	float32 m_binaryTime;
+	float32 m_wideTime;
+};
+
+#endif
@@ -0,0 +1,141 @@
+/*
+* Copyright (c) 2013 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef VINES_H
+#define VINES_H
+
+#include <Box2D/Rope/b2RopeSystem.h>
+
+/// A curtain of ropes stepped together by b2RopeSystem. The ropes are
+/// independent of the world, so they step in SIMD lanes on the world's
+/// thread pool.
+class Vines : public Test
+{
+public:
+	enum
+	{
+		e_ropeCount = 256,
+		e_vertexCount = 40
+	};
+
+	Vines()
+	{
+		{
+			b2BodyDef bd;
+			b2Body* ground = m_world->CreateBody(&bd);
+
+			b2EdgeShape shape;
+			shape.Set(b2Vec2(-40.0f, 30.0f), b2Vec2(40.0f, 30.0f));
+			ground->CreateFixture(&shape, 0.0f);
+		}
+
+		b2Vec2* vertices = (b2Vec2*)b2Alloc(e_ropeCount * e_vertexCount * sizeof(b2Vec2));
+		float32 masses[e_vertexCount];
+		b2RopeDef defs[e_ropeCount];
+
+		for (int32 i = 0; i < e_vertexCount; ++i)
+		{
+			masses[i] = 1.0f;
+		}
+		masses[0] = 0.0f;
+		masses[1] = 0.0f;
+
+		for (int32 i = 0; i < e_ropeCount; ++i)
+		{
+			float32 x = -38.0f + 76.0f * i / (e_ropeCount - 1);
+			int32 count = e_vertexCount - (i * 7) % 17;
+			b2Vec2* ropeVertices = vertices + i * e_vertexCount;
+			for (int32 j = 0; j < count; ++j)
+			{
+				ropeVertices[j].Set(x + 0.05f * j, 30.0f - 0.25f * j);
+			}
+
+			b2RopeDef& def = defs[i];
+			def.vertices = ropeVertices;
+			def.count = count;
+			def.gravity.Set(0.0f, -10.0f);
+			def.masses = masses;
+			def.damping = 0.1f;
+			def.k2 = 1.0f;
+			def.k3 = 0.5f;
+		}
+
+		// Batch creation packs the lanes once instead of once per rope.
+		m_ropes.CreateRopes(defs, e_ropeCount);
+		b2Free(vertices);
+
+		m_angle = 0.0f;
+		SetAngle(m_angle);
+	}
+
+	void SetAngle(float32 angle)
+	{
+		for (int32 i = 0; i < m_ropes.GetRopeCount(); ++i)
+		{
+			m_ropes.SetAngle(i, angle);
+		}
+	}
+
+	void Keyboard(unsigned char key)
+	{
+		switch (key)
+		{
+		case 'q':
+			m_angle = b2Max(-b2_pi, m_angle - 0.05f * b2_pi);
+			SetAngle(m_angle);
+			break;
+
+		case 'e':
+			m_angle = b2Min(b2_pi, m_angle + 0.05f * b2_pi);
+			SetAngle(m_angle);
+			break;
+		}
+	}
+
+	void Step(Settings* settings)
+	{
+		float32 dt = settings->hz > 0.0f ? 1.0f / settings->hz : 0.0f;
+
+		if (settings->pause == 1 && settings->singleStep == 0)
+		{
+			dt = 0.0f;
+		}
+
+		m_ropes.SetThreadPool(m_world->GetThreadPool());
+		m_ropes.Step(dt, 1);
+
+		Test::Step(settings);
+
+		m_ropes.Draw(&m_debugDraw);
+
+		m_debugDraw.DrawString(5, m_textLine, "Press (q,e) to adjust target angle");
+		m_textLine += 15;
+		m_debugDraw.DrawString(5, m_textLine, "Target angle = %g degrees", m_angle * 180.0f / b2_pi);
+		m_textLine += 15;
+	}
+
+	static Test* Create()
+	{
+		return new Vines;
+	}
+
+	b2RopeSystem m_ropes;
+	float32 m_angle;
+};
+
+#endif